@@ -28,6 +28,7 @@
 //  Constants
 // =================================================================================================
 
+static const char* kCodecBenchmarkCmd       = "--codec-benchmark";
 static const char* kColorCycleExampleCmd    = "--color-cycle-example";
 static const char* kCompassExampleCmd       = "--compass-example";
 static const char* kEnvironmentCmd          = "--environment";
@@ -161,6 +162,8 @@ static void FlipVertical (bool flip);
 static void GetHeading (void);
 static void GetEnvironment (void);
 static void WaitForEvent (tSenseHAT_JoystickDirection direction);
+static void CodecBenchmark (char* directory);
+static double GetElapsedSeconds (const struct timespec* start);
 
 // =================================================================================================
 //  SimpleSignalHandler
@@ -202,6 +205,7 @@ void SimpleSignalHandler (int signo)
 void PrintCmdLineHelp (void)
 {
     printf("Available command line arguments are:\n\n");
+    printf("--codec-benchmark=<directory>               Benchmark the telemetry codec on a recorded log.\n");
     printf("--color-cycle-example                       Color cycle example.\n");
     printf("--compass-example                           Compass example.\n");
     printf("--environment                               Get environmental conditions.\n");
@@ -296,6 +300,15 @@ int main(int argc, const char * argv[])
             {
                 Flash();
             }
+            else if (strncmp(argv[1], kCodecBenchmarkCmd, (cmdLen > strlen(kCodecBenchmarkCmd) ? strlen(kCodecBenchmarkCmd) : cmdLen)) == 0)
+            {
+                optionLen = strlen(kCodecBenchmarkCmd) + 1;
+                option = (char*)&((argv[1])[optionLen]);
+                if (strlen(option) > 0)
+                {
+                    CodecBenchmark(option);
+                }
+            }
             else if (strncmp(argv[1], kColorCycleExampleCmd, (cmdLen > strlen(kColorCycleExampleCmd) ? strlen(kColorCycleExampleCmd) : cmdLen)) == 0)
             {
                 ColorCycleExample();
@@ -763,25 +776,27 @@ void RainbowExample (void)
     result = SenseHAT_LEDClear(gInstance, NULL);
     if (result == 0)
     {
-        useconds_t sleepTime = 2;
-        tSenseHAT_LEDPixelArray pixels;
-        uint32_t index = 0;
-        int32_t red = 0;
-        int32_t green = 0;
-        int32_t blue = 0;
-
-        memcpy((void*)pixels, (void*)kRainbowSeedArray, sizeof(tSenseHAT_LEDPixelArray));
-
-        result = SenseHAT_LEDSetPixels(gInstance, pixels);
-        if (result == 0)
+        // One trip around the color wheel, played back at 60 frames per second
+        uint32_t frameCount = 1530;
+        tSenseHAT_AnimationFrame* frames = (tSenseHAT_AnimationFrame*)malloc(frameCount * sizeof(tSenseHAT_AnimationFrame));
+        if (frames != NULL)
         {
-            while (!gDone)
+            tSenseHAT_AnimationStatistics statistics;
+            uint32_t frame = 0;
+            uint32_t index = 0;
+            int32_t red = 0;
+            int32_t green = 0;
+            int32_t blue = 0;
+
+            memcpy((void*)(frames[0].pixels), (void*)kRainbowSeedArray, sizeof(tSenseHAT_LEDPixelArray));
+            frames[0].duration = 1.0 / 60.0;
+            for (frame = 1; frame < frameCount; frame++)
             {
                 for (index = 0; index < 64; index++)
                 {
-                    red = pixels[index].red;
-                    green = pixels[index].green;
-                    blue = pixels[index].blue;
+                    red = frames[frame - 1].pixels[index].red;
+                    green = frames[frame - 1].pixels[index].green;
+                    blue = frames[frame - 1].pixels[index].blue;
 
                     if ((red == 255) && (green < 255) && (blue == 0))
                         green += 1;
@@ -796,24 +811,44 @@ void RainbowExample (void)
                     if ((red == 255) && (blue > 0) && (green == 0))
                         blue -= 1;
 
-                    pixels[index].red = red;
-                    pixels[index].green = green;
-                    pixels[index].blue = blue;
+                    frames[frame].pixels[index].red = red;
+                    frames[frame].pixels[index].green = green;
+                    frames[frame].pixels[index].blue = blue;
                 }
-                result = SenseHAT_LEDSetPixels(gInstance, pixels);
-                usleep(sleepTime);
+                frames[frame].duration = 1.0 / 60.0;
             }
 
+            result = SenseHAT_AnimationStart(gInstance, frames, frameCount, true);
             if (result == 0)
             {
+                while (!gDone)
+                {
+                    usleep(100000);
+                }
+                (void)SenseHAT_AnimationStop(gInstance);
+
+                result = SenseHAT_AnimationGetStatistics(gInstance, &statistics);
+                if (result == 0)
+                {
+                    printf("%.1f fps, %llu frames shown, %llu late, %llu dropped\n",
+                           statistics.fps,
+                           (unsigned long long)(statistics.framesShown),
+                           (unsigned long long)(statistics.framesLate),
+                           (unsigned long long)(statistics.framesDropped));
+                }
                 result = SenseHAT_LEDClear(gInstance, NULL);
             }
+            else    // SenseHAT_AnimationStart failed
+            {
+                printf("SenseHAT_AnimationStart failed!\n");
+            }
+            free((void*)frames);
 
             gDone = false;
         }
-        else    // SenseHAT_LEDSetPixels failed
+        else    // malloc failed
         {
-            printf("SenseHAT_LEDSetPixels failed!\n");
+            printf("Couldn't allocate animation frames!\n");
         }
     }
     else    // SenseHAT_LEDClear failed
@@ -1130,7 +1165,8 @@ void CompassExample (void)
             int32_t offset = 0;
             int32_t x = 0;
             int32_t y = 0;
-            tSenseHAT_LEDPixel color = kBlueColor;
+            tSenseHAT_LEDPixelUpdate updates[2] = {{0, 0, {0,0,0}}, {0, 0, kBlueColor}};
+            uint32_t updateCount = 0;
 
             printf("Tracking compass... Enter ctrl-c to stop.\n");
             while (!gDone)
@@ -1145,29 +1181,23 @@ void CompassExample (void)
                     y = offset / 8;
                     x = offset % 8;
 
-                    if ((x != prevX) || (y != prevY))
-                    {
-                        result = SenseHAT_LEDSetPixel(gInstance, prevX, prevY, NULL);
-                        if (result != 0)
-                        {
-                            printf("SenseHAT_LEDSetPixel failed!\n");
-                            gDone = true;
-                        }
-                    }
+                    // Erase the old position and draw the new one in one update
+                    updates[0].xPosition = prevX;
+                    updates[0].yPosition = prevY;
+                    updates[1].xPosition = x;
+                    updates[1].yPosition = y;
+                    updateCount = ((x != prevX) || (y != prevY)) ? 2 : 1;
 
-                    if (!gDone)
+                    result = SenseHAT_LEDSetPixelBatch(gInstance, updates + (2 - updateCount), updateCount);
+                    if (result == 0)
+                    {   
+                        prevX = x; 
+                        prevY = y;
+                    }
+                    else
                     {
-                        result = SenseHAT_LEDSetPixel(gInstance, x, y, &color);
-                        if (result == 0)
-                        {   
-                            prevX = x; 
-                            prevY = y;
-                        }
-                        else
-                        {
-                            printf("SenseHAT_LEDSetPixel failed!\n");
-                            gDone = true;
-                        }
+                        printf("SenseHAT_LEDSetPixelBatch failed!\n");
+                        gDone = true;
                     }
                 }
             }
@@ -1223,4 +1253,153 @@ void TextScrollExample (void)
     }
     return;
 }
+
+// =================================================================================================
+//  CodecBenchmark
+// =================================================================================================
+void CodecBenchmark (char* directory)
+{
+    tSenseHAT_Reader reader = NULL;
+    tSenseHAT_Record* records = NULL;
+    uint64_t count = 0;
+    int32_t result = 0;
+
+    // Load the log
+    result = SenseHAT_ReaderOpen(directory, &reader);
+    if (result == 0)
+    {
+        const tSenseHAT_Record* segmentRecords = NULL;
+        uint64_t segmentCount = 0;
+
+        while ((result = SenseHAT_ReaderNextSegment(reader, &segmentRecords, &segmentCount)) == 0)
+        {
+            tSenseHAT_Record* newRecords = (tSenseHAT_Record*)realloc(records, (count + segmentCount) * sizeof(tSenseHAT_Record));
+            if (newRecords != NULL)
+            {
+                records = newRecords;
+                memcpy(&(records[count]), segmentRecords, segmentCount * sizeof(tSenseHAT_Record));
+                count += segmentCount;
+            }
+            else
+            {
+                printf("realloc failed!\n");
+                break;
+            }
+        }
+        (void)SenseHAT_ReaderClose(&reader);
+    }
+    else
+    {
+        printf("SenseHAT_ReaderOpen failed!\n");
+    }
+
+    if (count > 0)
+    {
+        // Encode in blocks of 1024 records, as the recorder does
+        uint64_t blockCount = (count + 1023) / 1024;
+        uint8_t* encoded = (uint8_t*)malloc(count * kSenseHAT_EncodedRecordSizeMax);
+        size_t* blockLengths = (size_t*)malloc(blockCount * sizeof(size_t));
+        tSenseHAT_Record* decoded = (tSenseHAT_Record*)malloc(count * sizeof(tSenseHAT_Record));
+        if ((encoded != NULL) && (blockLengths != NULL) && (decoded != NULL))
+        {
+            double rawSize = (double)(count * sizeof(tSenseHAT_Record));
+            double encodedSize = 0.0;
+            double elapsed = 0.0;
+            uint32_t passes = 0;
+            struct timespec start;
+            bool valid = true;
+
+            // Time encoding; repeat for at least a second
+            (void)clock_gettime(CLOCK_MONOTONIC, &start);
+            do
+            {
+                uint8_t* next = encoded;
+                uint64_t block = 0;
+
+                for (block = 0; block < blockCount; block++)
+                {
+                    tSenseHAT_Encoder encoder;
+                    uint64_t first = block * 1024;
+                    uint64_t last = ((first + 1024) < count) ? (first + 1024) : count;
+                    uint64_t index = 0;
+                    uint32_t blockRecords = 0;
+
+                    (void)SenseHAT_EncoderInitialize(&encoder, next, (size_t)(last - first) * kSenseHAT_EncodedRecordSizeMax);
+                    for (index = first; index < last; index++)
+                    {
+                        (void)SenseHAT_EncoderAppend(&encoder, &(records[index]));
+                    }
+                    (void)SenseHAT_EncoderGetLength(&encoder, &(blockLengths[block]), &blockRecords);
+                    next += blockLengths[block];
+                }
+                encodedSize = (double)(next - encoded);
+                passes++;
+                elapsed = GetElapsedSeconds(&start);
+            }
+            while (elapsed < 1.0);
+            printf("Records:            %llu\n", (unsigned long long)count);
+            printf("Raw size:           %.0f bytes\n", rawSize);
+            printf("Encoded size:       %.0f bytes (%.2f bits per record)\n", encodedSize, (encodedSize * 8.0) / (double)count);
+            printf("Compression ratio:  %.2f\n", rawSize / encodedSize);
+            printf("Encoding:           %.1f MB/s of records\n", (rawSize * passes) / (elapsed * 1000000.0));
+
+            // Time decoding; repeat for at least a second
+            passes = 0;
+            (void)clock_gettime(CLOCK_MONOTONIC, &start);
+            do
+            {
+                const uint8_t* next = encoded;
+                uint64_t block = 0;
+
+                for (block = 0; block < blockCount; block++)
+                {
+                    tSenseHAT_Decoder decoder;
+                    uint64_t index = block * 1024;
+                    uint64_t last = ((index + 1024) < count) ? (index + 1024) : count;
+
+                    (void)SenseHAT_DecoderInitialize(&decoder, next, blockLengths[block], (uint32_t)(last - index));
+                    while (SenseHAT_DecoderNext(&decoder, &(decoded[index])) == 0)
+                    {
+                        index++;
+                    }
+                    valid = valid && (index == last);
+                    next += blockLengths[block];
+                }
+                passes++;
+                elapsed = GetElapsedSeconds(&start);
+            }
+            while (elapsed < 1.0);
+            printf("Decoding:           %.1f MB/s of records\n", (rawSize * passes) / (elapsed * 1000000.0));
+
+            // Check the round trip
+            valid = valid && (memcmp(records, decoded, count * sizeof(tSenseHAT_Record)) == 0);
+            printf("Round trip:         %s\n", (valid ? "exact" : "MISMATCH"));
+        }
+        else
+        {
+            printf("malloc failed!\n");
+        }
+        free((void*)decoded);
+        free((void*)blockLengths);
+        free((void*)encoded);
+    }
+    else
+    {
+        printf("No records found in %s!\n", directory);
+    }
+    free((void*)records);
+    return;
+}
+
+// =================================================================================================
+//  GetElapsedSeconds
+// =================================================================================================
+double GetElapsedSeconds (const struct timespec* start)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + ((double)(now.tv_nsec - start->tv_nsec) / 1000000000.0);
+}
+
 // =================================================================================================
@@ -45,6 +45,13 @@
 #define PY_FINALIZE Py_FinalizeEx
 #endif
 
+// Python 3.7 and later create the GIL in Py_Initialize
+#if (PY_MAJOR_VERSION == 2) || (PY_MINOR_VERSION < 7)
+#define PY_INIT_THREADS() PyEval_InitThreads()
+#else
+#define PY_INIT_THREADS()
+#endif
+
 // =================================================================================================
 //  Prototypes
 // =================================================================================================
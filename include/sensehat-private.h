@@ -0,0 +1,801 @@
+// =================================================================================================
+//
+//  sensehat-private.h
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains private constants, types and function prototypes shared by the
+//      source files of the Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-private.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains private constants, types and function prototypes shared by the
+//! source files of the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//! 
+//  Includes
+// =================================================================================================
+#ifdef __cplusplus
+    #pragma once
+#endif
+
+#ifndef __SENSEHATPRIVATE_H__
+#define __SENSEHATPRIVATE_H__
+
+#include "python-support.h"
+#include "sensehat.h"
+#include <pthread.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Maximum number of joystick events retained between calls to SenseHAT_GetEventsInto
+#define kSenseHAT_MaxPendingEvents  64
+
+// Number of channels in tSenseHAT_Channel
+#define kSenseHAT_ChannelCount      8
+
+// Number of channels a telemetry record can hold, including eSenseHAT_ChannelJoystick
+#define kSenseHAT_RecordChannelCount    9
+
+// Largest number of records in a compressed segment block
+#define kSenseHAT_BlockRecordsMax   1024
+
+// Number of records a segment index entry covers (the last entry of a segment may cover fewer)
+#define kSenseHAT_IndexRecords      1024
+
+// Number of channels with rollups (humidity, temperature and pressure)
+#define kSenseHAT_RollupChannelCount    3
+
+// Number of rollup resolutions in tSenseHAT_RollupResolution
+#define kSenseHAT_RollupResolutionCount 3
+
+// Maximum rollup file path length
+#define kSenseHAT_RollupPathSize    1024
+
+// Number of motion events the sampler queues for SenseHAT_SamplerGetMotionEvents
+#define kSenseHAT_MotionQueueLength 32
+
+// Number of notifications the sampler queues for SenseHAT_SamplerGetNotifications
+#define kSenseHAT_NotificationQueueLength   64
+
+// Number of readings a rate subscription keeps to fit its slope
+#define kSenseHAT_SubscriptionHistory   16
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+//! @brief Compressed segment block header.
+//!
+//! In a compressed segment, each block header is followed by the encoded records.
+//!
+typedef struct
+{
+    uint32_t    length;         //!< Length of the encoded records in bytes.
+    uint32_t    recordCount;    //!< Number of encoded records.
+}
+tSenseHAT_BlockHeader;
+
+//! @brief Segment index entry.
+//!
+//! The recorder writes a sparse index next to each segment; each entry summarizes a run of
+//! consecutive records (whole blocks, in a compressed segment).
+//!
+typedef struct
+{
+    uint64_t    offset;                                         //!< File offset of the first record or block.
+    uint64_t    length;                                         //!< Length of the records or blocks in bytes.
+    uint32_t    recordCount;                                    //!< Number of records.
+    uint32_t    channels;                                       //!< tSenseHAT_Channel flags of the records.
+    double      minimumTime;                                    //!< Earliest timestamp.
+    double      maximumTime;                                    //!< Latest timestamp.
+    double      minimum[kSenseHAT_RecordChannelCount][3];       //!< Smallest values of each channel index.
+    double      maximum[kSenseHAT_RecordChannelCount][3];       //!< Largest values of each channel index.
+}
+tSenseHAT_IndexEntry;
+
+//! @brief Replay log segment.
+//!
+//! This structure describes one mapped segment of a replay log.
+//!
+typedef struct
+{
+    void*                       mapping;        //!< Segment mapping.
+    size_t                      mappingLength;  //!< Length of the segment mapping.
+    const tSenseHAT_Record*     records;        //!< Records in the segment.
+    uint64_t                    recordCount;    //!< Number of records in the segment.
+}
+tSenseHAT_ReplaySegment;
+
+//! @brief Replay log position.
+//!
+//! This structure identifies a record in a replay log.
+//!
+typedef struct
+{
+    uint32_t    segment;    //!< Segment index.
+    uint64_t    index;      //!< Record index within the segment.
+}
+tSenseHAT_ReplayCursor;
+
+//! @brief Replay state.
+//!
+//! This structure holds the state of an instance that is driven from a recorded log. The 
+//! mutex protects every member.
+//!
+typedef struct
+{
+    pthread_mutex_t             mutex;                              //!< Lock protecting the replay state.
+    double                      speed;                              //!< Playback speed (0 plays as fast as possible).
+    tSenseHAT_ReplaySegment*    segments;                           //!< Mapped segments, in order.
+    uint32_t                    segmentCount;                       //!< Number of segments.
+    double                      logStart;                           //!< Timestamp of the first record.
+    double                      logEnd;                             //!< Timestamp of the last record.
+    double                      wallStart;                          //!< Monotonic time playback started.
+    double                      virtualTime;                        //!< Log time reached when playing as fast as possible.
+    tSenseHAT_ReplayCursor      cursors[kSenseHAT_ChannelCount];    //!< Next record to examine for each channel.
+    const tSenseHAT_Record*     latest[kSenseHAT_ChannelCount];     //!< Latest record played for each channel.
+    tSenseHAT_ReplayCursor      eventCursor;                        //!< Next record to examine for joystick events.
+}
+tSenseHAT_Replay;
+
+//! @brief Sensor value cache.
+//!
+//! This structure holds the most recent value read for each channel along with the time it was
+//! read. The mutex protects every member.
+//!
+typedef struct
+{
+    pthread_mutex_t             mutex;                                  //!< Lock protecting the cache.
+    double                      maxAge;                                 //!< Instance max-age policy in fractional seconds (0 disables the cache).
+    tSenseHAT_Sample            values;                                 //!< Cached values; channels flags the valid ones.
+    double                      readTimes[kSenseHAT_ChannelCount];      //!< Monotonic time each channel was read.
+    double                      timestamps[kSenseHAT_ChannelCount];     //!< Timestamp of each channel's reading.
+    uint64_t                    hits;                                   //!< Number of channel reads served from the cache.
+    uint64_t                    misses;                                 //!< Number of channel reads that went to the sensors.
+    tSenseHAT_Recorder          recorder;                               //!< Recorder for sensor readings and joystick events (NULL if none).
+    bool                        magCalibrated;                          //!< Whether compass raw readings are corrected.
+    tSenseHAT_MagCalibration    magCalibration;                         //!< Magnetometer calibration.
+    double                      magBias[3];                             //!< Correction bias, -matrix * offset, precomputed for the correction.
+}
+tSenseHAT_Cache;
+
+//! @brief Rollup accumulator.
+//!
+//! This structure holds the running aggregates of one rollup bucket, updated with Welford's 
+//! method.
+//!
+typedef struct
+{
+    double      startTime;  //!< Start of the bucket.
+    uint64_t    count;      //!< Number of readings (0 if the bucket is unused).
+    double      minimum;    //!< Smallest reading.
+    double      maximum;    //!< Largest reading.
+    double      mean;       //!< Running mean.
+    double      m2;         //!< Running sum of squared differences from the mean.
+}
+tSenseHAT_RollupAccumulator;
+
+//! @brief Rollups.
+//!
+//! This structure holds a ring of buckets for each rollup channel and resolution.
+//!
+typedef struct
+{
+    tSenseHAT_RollupAccumulator buckets[kSenseHAT_RollupChannelCount][kSenseHAT_RollupResolutionCount][kSenseHAT_RollupBuckets];
+                                                                                    //!< Bucket rings.
+    uint32_t                    newest[kSenseHAT_RollupChannelCount][kSenseHAT_RollupResolutionCount];
+                                                                                    //!< Ring index of the newest bucket.
+}
+tSenseHAT_Rollups;
+
+//! @brief Subscription state.
+//!
+//! This structure holds a subscription and the state needed to evaluate it.
+//!
+typedef struct
+{
+    uint32_t                        id;                                         //!< Identifier (0 if the slot is free).
+    tSenseHAT_Subscription          subscription;                               //!< The subscription.
+    tSenseHAT_SubscriptionCallback  callback;                                   //!< Callback (NULL if none).
+    void*                           context;                                    //!< Callback context.
+    bool                            primed;                                     //!< Whether a reading has been seen.
+    bool                            armed;                                      //!< Whether the condition can be reported.
+    double                          reference;                                  //!< Last reading reported, for changes.
+    double                          times[kSenseHAT_SubscriptionHistory];       //!< Times of the readings kept for rates.
+    double                          values[kSenseHAT_SubscriptionHistory];      //!< Readings kept for rates.
+    uint32_t                        historyIndex;                               //!< Index of the oldest reading kept.
+    uint32_t                        historyCount;                               //!< Number of readings kept.
+}
+tSenseHAT_SubscriptionState;
+
+//! @brief Subscription delivery.
+//!
+//! This structure pairs a notification with the callback it's delivered to.
+//!
+typedef struct
+{
+    tSenseHAT_Notification          notification;   //!< The notification.
+    tSenseHAT_SubscriptionCallback  callback;       //!< Callback (NULL if none).
+    void*                           context;        //!< Callback context.
+}
+tSenseHAT_SubscriptionDelivery;
+
+//! @brief Sampler state.
+//!
+//! This structure holds the state of the background sampler. The mutex protects every member
+//! except thread, which is only touched by SenseHAT_SamplerStart and SenseHAT_SamplerStop.
+//!
+typedef struct
+{
+    pthread_t           thread;         //!< Sampler thread.
+    pthread_mutex_t     mutex;          //!< Lock protecting the sampler state.
+    pthread_cond_t      condition;      //!< Signalled to wake the sampler thread early.
+    bool                running;        //!< Whether the sampler thread is running.
+    bool                stopRequested;  //!< Whether the sampler thread has been asked to stop.
+    uint32_t            channels;       //!< tSenseHAT_Channel flags of the channels to sample.
+    double              interval;       //!< Sampling interval in fractional seconds.
+    tSenseHAT_Sample    latest;         //!< Most recent sample.
+    int32_t             eventFd;        //!< eventfd signalled for every new sample (-1 if unavailable).
+    tSenseHAT_Rollups   rollups;        //!< Rollups of the acquired readings.
+    char                rollupPath[kSenseHAT_RollupPathSize];   //!< File the rollups are saved to (empty if none).
+    uint32_t            filteredChannels;                       //!< tSenseHAT_Channel flags of the channels with filter chains.
+    tSenseHAT_Filter    filters[kSenseHAT_ChannelCount][6];     //!< Filter chain of each value of each channel (the sine and cosine of each angle).
+    tSenseHAT_Sample    filtered;                               //!< Most recent sample, filtered.
+    bool                        motionEnabled;                                  //!< Whether the motion detector runs.
+    tSenseHAT_MotionDetector    motionDetector;                                 //!< Motion detector.
+    tSenseHAT_MotionCallback    motionCallback;                                 //!< Motion event callback (NULL if none).
+    void*                       motionContext;                                  //!< Motion event callback context.
+    tSenseHAT_MotionEvent       motionEvents[kSenseHAT_MotionQueueLength];      //!< Motion events not yet retrieved.
+    uint32_t                    motionEventIndex;                               //!< Index of the oldest queued motion event.
+    uint32_t                    motionEventCount;                               //!< Number of queued motion events.
+    int32_t                     motionFd;                                       //!< eventfd signalled while motion events are queued (-1 if unavailable).
+    tSenseHAT_SubscriptionState subscriptions[kSenseHAT_SubscriptionsMax];      //!< Subscriptions.
+    uint32_t                    lastSubscriptionId;                             //!< Identifier of the last subscription made.
+    tSenseHAT_Notification      notifications[kSenseHAT_NotificationQueueLength];   //!< Notifications not yet retrieved.
+    uint32_t                    notificationIndex;                              //!< Index of the oldest queued notification.
+    uint32_t                    notificationCount;                              //!< Number of queued notifications.
+    int32_t                     subscriptionFd;                                 //!< eventfd signalled while notifications are queued (-1 if unavailable).
+}
+tSenseHAT_Sampler;
+
+//! @brief Animation player.
+//!
+//! This structure holds the state of the animation thread of an instance. The mutex protects 
+//! every member except the frames, which the thread only reads while it runs.
+//!
+typedef struct
+{
+    pthread_t                       thread;         //!< Animation thread.
+    pthread_mutex_t                 mutex;          //!< Lock protecting the animation state.
+    pthread_cond_t                  condition;      //!< Signalled to wake the animation thread early.
+    bool                            running;        //!< Whether the animation thread has been started and not yet joined.
+    bool                            stopRequested;  //!< Whether the animation thread has been asked to stop.
+    bool                            finished;       //!< Whether the animation thread has played its last frame.
+    tSenseHAT_AnimationFrame*       frames;         //!< Frames (NULL if none).
+    uint32_t                        frameCount;     //!< Number of frames.
+    bool                            loop;           //!< Whether the animation loops.
+    double                          startTime;      //!< Monotonic time the animation started.
+    double                          endTime;        //!< Monotonic time the animation finished or stopped.
+    tSenseHAT_AnimationStatistics   statistics;     //!< Statistics; fps and playing are filled in on request.
+}
+tSenseHAT_Animation;
+
+//! @brief Stream player.
+//!
+//! This structure holds the state of the stream threads of an instance: a reader that fills a 
+//! ring of raw frames from a file descriptor, and a presenter that takes them out at a fixed 
+//! rate. The mutex protects every member except the file descriptors and the format, which are 
+//! fixed while the threads run.
+//!
+typedef struct
+{
+    pthread_t                   reader;         //!< Reader thread.
+    pthread_t                   presenter;      //!< Presenter thread.
+    pthread_mutex_t             mutex;          //!< Lock protecting the stream state.
+    pthread_cond_t              condition;      //!< Signalled to wake the presenter early.
+    pthread_cond_t              space;          //!< Signalled when a frame leaves the ring.
+    int32_t                     wakeFd;         //!< eventfd signalled to wake the reader (-1 when not running).
+    int32_t                     fd;             //!< Stream file descriptor.
+    tSenseHAT_StreamFormat      format;         //!< Frame format.
+    uint32_t                    frameSize;      //!< Frame size in bytes.
+    bool                        waitForSpace;   //!< Whether the reader waits for room instead of dropping frames.
+    bool                        running;        //!< Whether the stream threads have been started and not yet joined.
+    bool                        stopRequested;  //!< Whether the stream threads have been asked to stop.
+    bool                        finished;       //!< Whether the presenter has shown the last frame.
+    double                      period;         //!< Time between frames in fractional seconds.
+    uint8_t*                    frames;         //!< Frame ring (NULL if none).
+    uint32_t                    bufferFrames;   //!< Ring size in frames.
+    uint32_t                    head;           //!< Ring index of the oldest frame.
+    uint32_t                    count;          //!< Number of frames in the ring.
+    double                      startTime;      //!< Monotonic time the stream started.
+    double                      endTime;        //!< Monotonic time the stream finished or stopped.
+    tSenseHAT_StreamStatistics  statistics;     //!< Statistics; fps and playing are filled in on request.
+}
+tSenseHAT_Stream;
+
+//! @brief LED matrix framebuffer.
+//!
+//! This structure holds the native LED matrix backend of an instance: the mapped RGB565 
+//! framebuffer of the Sense HAT driver, which frames are written to directly instead of through
+//! Python. Pixels are compared against the mapped device memory itself, so only the ones that 
+//! differ from what the LED matrix shows are written. The mutex protects every member.
+//!
+typedef struct
+{
+    pthread_mutex_t         mutex;          //!< Lock serializing writes to the framebuffer.
+    int32_t                 fd;             //!< Framebuffer device file descriptor (-1 if unavailable).
+    uint16_t*               pixels;         //!< Mapped framebuffer pixels (NULL if unavailable).
+    tSenseHAT_LEDRotation   rotation;       //!< Rotation applied to frames as they're written.
+}
+tSenseHAT_Framebuffer;
+
+//! @brief Private instance data.
+//! 
+//! This structure represents the private instance data required by the Raspberry Pi Sense HAT
+//! C library.
+//! 
+typedef struct
+{
+    PyObject*   senseHATModule;                     //!< Top level Python module reference. 
+    PyObject*   self;                               //!< Python object instance.
+
+    PyObject*   senseHATSubModule;                  //!< Sense HAT Python submodule reference. 
+    PyObject*   clearFunction;                      //!< clear Python function reference. 
+    PyObject*   flipHorizontalFunction;             //!< flip_h Python function reference.
+    PyObject*   flipVerticalFunction;               //!< flip_v Python function reference.
+    PyObject*   gammaResetFunction;                 //!< gamma_reset Python function reference.
+    PyObject*   getAccelerometerFunction;           //!< get_accelerometer Python function reference.
+    PyObject*   getAccelerometerRawFunction;        //!< get_accelerometer_raw Python function reference.
+    PyObject*   getCompassFunction;                 //!< get_compass Python function reference.
+    PyObject*   getCompassRawFunction;              //!< get_compass_raw Python function reference.
+    PyObject*   getGyroscopeFunction;               //!< get_gyroscope Python function reference.
+    PyObject*   getGyroscopeRawFunction;            //!< get_gyroscope_raw Python function reference.
+    PyObject*   getHumidityFunction;                //!< get_humidity Python function reference.
+    PyObject*   getOrientationFunction;             //!< get_orientation Python function reference.
+    PyObject*   getOrientationDegreesFunction;      //!< get_orientation_degrees Python function reference.
+    PyObject*   getOrientationRadiansFunction;      //!< get_orientation_radians Python function reference.
+    PyObject*   getPixelFunction;                   //!< get_pixel Python function reference.
+    PyObject*   getPixelsFunction;                  //!< get_pixels Python function reference.
+    PyObject*   getPressureFunction;                //!< get_pressure Python function reference.
+    PyObject*   getTemperatureFunction;             //!< get_temperature Python function reference.
+    PyObject*   getTemperatureFromHumidityFunction; //!< get_temperature_from_humidity Python function reference.
+    PyObject*   getTemperatureFromPressureFunction; //!< get_temperature_from_pressure Python function reference.
+    PyObject*   loadImageFunction;                  //!< load_image Python function reference.
+    PyObject*   setIMUConfigFunction;               //!< set_imu_config Python function reference.
+    PyObject*   setPixelFunction;                   //!< set_pixel Python function reference.
+    PyObject*   setPixelsFunction;                  //!< set_pixels Python function reference.
+    PyObject*   setRotationFunction;                //!< set_rotation Python function reference.
+    PyObject*   showLetterFunction;                 //!< show_letter Python function reference.
+    PyObject*   showMessageFunction;                //!< show_message Python function reference.
+
+    PyObject*   stickSubModule;                     //!< Joystick Python submodule reference.
+    PyObject*   getEventsFunction;                  //!< get_events Python function reference.
+    PyObject*   waitForEventFunction;               //!< wait_for_event Python function reference.
+
+    PyThreadState*          mainThreadState;    //!< Python thread state saved while the GIL is released.
+
+    int32_t                 joystickFd;         //!< Joystick input device file descriptor (-1 if unavailable).
+    tSenseHAT_JoystickEvent pendingEvents[kSenseHAT_MaxPendingEvents];  //!< Joystick events retrieved but not yet delivered.
+    int32_t                 pendingEventIndex;  //!< Index of the oldest pending joystick event.
+    int32_t                 pendingEventCount;  //!< Number of pending joystick events.
+    uint64_t                droppedEventCount;  //!< Number of pending joystick events dropped because the queue was full.
+
+    tSenseHAT_Sampler       sampler;            //!< Sampler state.
+    tSenseHAT_Cache         cache;              //!< Sensor value cache.
+    tSenseHAT_Animation     animation;          //!< Animation player.
+    tSenseHAT_Stream        stream;             //!< Stream player.
+    tSenseHAT_Framebuffer   framebuffer;        //!< Native LED matrix backend.
+
+    int32_t                 notificationFd;     //!< Notification descriptor (-1 until first requested).
+
+    tSenseHAT_Replay*       replay;             //!< Replay state (NULL unless opened with SenseHAT_OpenReplay).
+}
+tSenseHAT_InstancePrivate;
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    //! @brief Call SenseHAT_SamplerInitialize to initialize the sampler state of an instance.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_SamplerInitialize  (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_SamplerRelease to stop the sampler and release its resources.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_SamplerRelease     (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_AnimationInitialize to initialize the animation player of an instance.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_AnimationInitialize    (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_AnimationRelease to stop the animation player and release its 
+    //! resources.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_AnimationRelease       (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_FramebufferInitialize to initialize the native LED matrix backend of an
+    //! instance, without opening it.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_FramebufferInitialize  (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_FramebufferOpen to find and map the Sense HAT framebuffer device.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODEV indicates that there's no Sense HAT 
+    //! framebuffer device.
+    //!
+    int32_t SenseHAT_FramebufferOpen        (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_FramebufferWrite to write a frame to the Sense HAT framebuffer.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] pixels The frame. Pass NULL in this argument to turn every LED off.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODEV indicates that the framebuffer isn't open.
+    //!
+    int32_t SenseHAT_FramebufferWrite       (tSenseHAT_InstancePrivate*    instancePrivate,
+                                             const tSenseHAT_LEDPixelArray pixels);
+
+    //! @brief Call SenseHAT_FramebufferWriteRGB565 to write a frame that's already in the RGB565 
+    //! format of the Sense HAT framebuffer.
+    //!
+    //! Only the pixels that differ from the device memory are written, and if there are none the 
+    //! device isn't written at all.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] pixels The frame, 64 RGB565 pixels. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODEV indicates that the framebuffer isn't open.
+    //!
+    int32_t SenseHAT_FramebufferWriteRGB565 (tSenseHAT_InstancePrivate*    instancePrivate,
+                                             const uint16_t*               pixels);
+
+    //! @brief Call SenseHAT_FramebufferPatchRGB565 to write some pixels of the LED matrix and 
+    //! leave the rest as they are.
+    //!
+    //! Pixels outside the mask are never looked at. Pixels that match the device memory are 
+    //! skipped, and if none are left the device isn't written at all.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] pixels 64 RGB565 pixels, of which only the masked ones are used. This argument 
+    //! must not be NULL.
+    //! @param[in] changed The pixels to write, one bit each.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODEV indicates that the framebuffer isn't open.
+    //!
+    int32_t SenseHAT_FramebufferPatchRGB565  (tSenseHAT_InstancePrivate*    instancePrivate,
+                                              const uint16_t*               pixels,
+                                              uint64_t                      changed);
+
+    //! @brief Call SenseHAT_FramebufferSetRotation to set the rotation applied to frames written
+    //! to the Sense HAT framebuffer.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] rotation The rotation.
+    //!
+    void    SenseHAT_FramebufferSetRotation (tSenseHAT_InstancePrivate*    instancePrivate,
+                                             tSenseHAT_LEDRotation         rotation);
+
+    //! @brief Call SenseHAT_FramebufferRelease to unmap and close the Sense HAT framebuffer.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_FramebufferRelease     (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_ColorExpandRGB565 to widen RGB565 pixels back to LED pixels, for 
+    //! frames that have to go through Python.
+    //!
+    //! @param[in] pixels The RGB565 pixels. This argument must not be NULL.
+    //! @param[in] pixelCount The number of pixels.
+    //! @param[out] output The LED pixels. This argument must not be NULL.
+    //!
+    void    SenseHAT_ColorExpandRGB565      (const uint16_t*               pixels,
+                                             uint32_t                      pixelCount,
+                                             tSenseHAT_LEDPixel*           output);
+
+    //! @brief Call SenseHAT_StreamInitialize to initialize the stream player of an instance.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_StreamInitialize       (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_StreamRelease to stop the stream player and release its resources.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_StreamRelease          (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_RollupAdd to add the readings of a sample to the rollups.
+    //!
+    //! @param[in,out] rollups The rollups.
+    //! @param[in] sample The sample.
+    //! @return bool Whether a minute bucket was completed.
+    //!
+    bool    SenseHAT_RollupAdd          (tSenseHAT_Rollups*            rollups,
+                                         const tSenseHAT_Sample*       sample);
+
+    //! @brief Call SenseHAT_RollupSave to save the rollups of a sampler to its rollup file, if
+    //! it has one. The sampler mutex must not be held.
+    //!
+    //! @param[in] sampler The sampler.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_RollupSave         (tSenseHAT_Sampler*            sampler);
+
+    //! @brief Call SenseHAT_FilterSample to run a sample through the filter chains of a sampler.
+    //! The sampler mutex must be held.
+    //!
+    //! @param[in,out] sampler The sampler.
+    //! @param[in] sample The raw sample; the filtered copy is left in sampler->filtered.
+    //!
+    void    SenseHAT_FilterSample       (tSenseHAT_Sampler*            sampler,
+                                         const tSenseHAT_Sample*       sample);
+
+    //! @brief Call SenseHAT_MotionSample to run a sample through the motion detector of a 
+    //! sampler and queue the events it produces. The sampler mutex must be held.
+    //!
+    //! @param[in,out] sampler The sampler.
+    //! @param[in] sample The raw sample.
+    //! @param[out] events Array of kSenseHAT_MaxMotionEvents entries that receives the events, 
+    //! for the callback.
+    //! @return uint32_t The number of events produced.
+    //!
+    uint32_t SenseHAT_MotionSample      (tSenseHAT_Sampler*            sampler,
+                                         const tSenseHAT_Sample*       sample,
+                                         tSenseHAT_MotionEvent*        events);
+
+    //! @brief Call SenseHAT_SubscriptionSample to evaluate the subscriptions of a sampler 
+    //! against a sample and queue the notifications they produce. The sampler mutex must be 
+    //! held.
+    //!
+    //! @param[in,out] sampler The sampler.
+    //! @param[in] sample The raw sample.
+    //! @param[out] deliveries Array of kSenseHAT_SubscriptionsMax entries that receives the 
+    //! notifications and their callbacks.
+    //! @return uint32_t The number of notifications produced.
+    //!
+    uint32_t SenseHAT_SubscriptionSample    (tSenseHAT_Sampler*                 sampler,
+                                             const tSenseHAT_Sample*            sample,
+                                             tSenseHAT_SubscriptionDelivery*    deliveries);
+
+    //! @brief Call SenseHAT_CompassCorrect to apply the magnetometer calibration of a cache to a
+    //! sample. The cache mutex must be held.
+    //!
+    //! @param[in] cache The cache.
+    //! @param[in,out] sample The sample.
+    //!
+    void    SenseHAT_CompassCorrect     (const tSenseHAT_Cache*        cache,
+                                         tSenseHAT_Sample*             sample);
+
+    //! @brief Call SenseHAT_CacheInitialize to initialize the sensor value cache of an instance.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_CacheInitialize    (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_CacheRelease to release the resources of the sensor value cache.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_CacheRelease       (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_ReadChannels to read channels from the sensors, bypassing the cache.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] channels The tSenseHAT_Channel flags of the channels to read.
+    //! @param[out] sample The readings; channels that couldn't be read are left out of 
+    //! sample->channels. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success; otherwise the status of the first channel that failed.
+    //!
+    int32_t SenseHAT_ReadChannels       (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         uint32_t                      channels,
+                                         tSenseHAT_Sample*             sample);
+
+    //! @brief Call SenseHAT_ListSegments to list the telemetry segments in a directory.
+    //!
+    //! @param[in] directory The directory holding the segments.
+    //! @param[out] segments The segment indices in ascending order; free with free(). 
+    //! @param[out] segmentCount The number of segments.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_ListSegments       (const char*                   directory,
+                                         uint32_t**                    segments,
+                                         uint32_t*                     segmentCount);
+
+    //! @brief Call SenseHAT_MapSegment to map a telemetry segment into memory.
+    //!
+    //! @param[in] directory The directory holding the segment.
+    //! @param[in] segmentIndex The index of the segment.
+    //! @param[out] mapping The mapping; release with munmap (it may be set even on failure).
+    //! @param[out] mappingLength The length of the mapping.
+    //! @param[out] records The records of the segment.
+    //! @param[out] recordCount The number of records in the segment.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to EPROTO indicates an unsupported segment.
+    //!
+    int32_t SenseHAT_MapSegment         (const char*                   directory,
+                                         uint32_t                      segmentIndex,
+                                         void**                        mapping,
+                                         size_t*                       mappingLength,
+                                         const tSenseHAT_Record**      records,
+                                         uint64_t*                     recordCount);
+
+    //! @brief Call SenseHAT_MapSegmentFile to map a telemetry segment file into memory as it is,
+    //! without decoding it.
+    //!
+    //! @param[in] directory The directory holding the segment.
+    //! @param[in] segmentIndex The index of the segment.
+    //! @param[out] mapping The mapping; release with munmap (it may be set even on failure).
+    //! @param[out] mappingLength The length of the mapping.
+    //! @param[out] dataOffset The offset of the first record or block in the mapping.
+    //! @param[out] compressed Whether the segment holds compressed blocks.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to EPROTO indicates an unsupported segment.
+    //!
+    int32_t SenseHAT_MapSegmentFile     (const char*                   directory,
+                                         uint32_t                      segmentIndex,
+                                         void**                        mapping,
+                                         size_t*                       mappingLength,
+                                         size_t*                       dataOffset,
+                                         bool*                         compressed);
+
+    //! @brief Call SenseHAT_ReadSegmentIndex to read the index of a telemetry segment.
+    //!
+    //! @param[in] directory The directory holding the segment.
+    //! @param[in] segmentIndex The index of the segment.
+    //! @param[out] entries The index entries, in file order; free with free().
+    //! @param[out] entryCount The number of index entries.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENOENT indicates that the segment has no index.
+    //! A value equal to EPROTO indicates an unsupported index.
+    //!
+    int32_t SenseHAT_ReadSegmentIndex   (const char*                   directory,
+                                         uint32_t                      segmentIndex,
+                                         tSenseHAT_IndexEntry**        entries,
+                                         uint32_t*                     entryCount);
+
+    //! @brief Call SenseHAT_ReplayInitialize to load a replay log for an instance.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] directory The directory holding the log.
+    //! @param[in] speed The playback speed (0 plays as fast as possible).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_ReplayInitialize   (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         const char*                   directory,
+                                         double                        speed);
+
+    //! @brief Call SenseHAT_ReplayRelease to release the replay log of an instance, if any.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //!
+    void    SenseHAT_ReplayRelease      (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_ReplayReadChannels to read channels from the replay log.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] channels The tSenseHAT_Channel flags of the channels to read.
+    //! @param[out] sample The readings. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODATA indicates that a channel has no reading at
+    //! this point of the log, or that the log is finished.
+    //!
+    int32_t SenseHAT_ReplayReadChannels (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         uint32_t                      channels,
+                                         tSenseHAT_Sample*             sample);
+
+    //! @brief Call SenseHAT_ReplayReadEvents to read the joystick events that are due from the
+    //! replay log.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[out] events Caller allocated array that receives the events.
+    //! @param[in] capacity The number of entries in events.
+    //! @param[out] eventCount The number of events written to events.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that more events are due. A 
+    //! value equal to ENODATA indicates that the log holds no more joystick events.
+    //!
+    int32_t SenseHAT_ReplayReadEvents   (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         tSenseHAT_JoystickEvent*      events,
+                                         int32_t                       capacity,
+                                         int32_t*                      eventCount);
+
+    //! @brief Call SenseHAT_ReplayGetEvents to read the joystick events that are due from the 
+    //! replay log into an allocated list, as SenseHAT_GetEvents does.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[out] eventCount The number of events.
+    //! @param[out] events The allocated list of events, or NULL to discard them.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t SenseHAT_ReplayGetEvents    (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         int32_t*                      eventCount,
+                                         tSenseHAT_JoystickEvent**     events);
+
+    //! @brief Call SenseHAT_ReplayWaitForEvent to wait for the next joystick event in the 
+    //! replay log.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @param[in] flushPendingEvents Set to true to skip the events that are already due.
+    //! @param[out] event The event.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODATA indicates that the log holds no more
+    //! joystick events.
+    //!
+    int32_t SenseHAT_ReplayWaitForEvent (tSenseHAT_InstancePrivate*    instancePrivate,
+                                         bool                          flushPendingEvents,
+                                         tSenseHAT_JoystickEvent*      event);
+
+    //! @brief Call SenseHAT_ReplayGetTime to get the current time of the replay log, in the same
+    //! time base as its joystick event timestamps.
+    //!
+    //! @param[in] instancePrivate Private instance data. This argument must not be NULL.
+    //! @return double The replay time in fractional seconds.
+    //!
+    double  SenseHAT_ReplayGetTime      (tSenseHAT_InstancePrivate*    instancePrivate);
+
+    //! @brief Call SenseHAT_GetTimestamp to get the current time in fractional seconds, using
+    //! the same clock as joystick event timestamps.
+    //!
+    //! @return double The current time in fractional seconds.
+    //!
+    double  SenseHAT_GetTimestamp       (void);
+
+    //! @brief Call SenseHAT_GetMonotonicTime to get the time in fractional seconds from a clock
+    //! that isn't affected by changes to the system time.
+    //!
+    //! @return double The monotonic time in fractional seconds.
+    //!
+    double  SenseHAT_GetMonotonicTime   (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+// =================================================================================================
+#endif	// __SENSEHATPRIVATE_H__
+// =================================================================================================
@@ -33,9 +33,87 @@
 #ifndef __SENSEHAT_H__
 #define __SENSEHAT_H__
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//! @brief The largest number of gestures a single call to SenseHAT_GestureProcessEvent,
+//! SenseHAT_GestureAdvance or SenseHAT_GetGestures can produce.
+#define kSenseHAT_MaxGestures   16
+
+//! @brief Pass as the maxAgeSeconds argument of SenseHAT_GetChannels to use the instance's
+//! max-age policy (see SenseHAT_SetCacheMaxAge).
+#define kSenseHAT_CacheMaxAgeDefault    (-1.0)
+
+//! @brief The version of the telemetry record format written by the recorder.
+#define kSenseHAT_RecordVersion     1
+
+//! @brief Pass as the speed argument of SenseHAT_OpenReplay to play a log as fast as possible.
+#define kSenseHAT_ReplayAsFastAsPossible    0.0
+
+//! @brief The most bytes SenseHAT_EncoderAppend can need to encode one record, so an encoder 
+//! buffer of n times this size always holds at least n records.
+#define kSenseHAT_EncodedRecordSizeMax      40
+
+//! @brief The number of buckets the sampler keeps for each rollup resolution.
+#define kSenseHAT_RollupBuckets     60
+
+//! @brief The largest number of stages in a filter chain.
+#define kSenseHAT_FilterStagesMax   4
+
+//! @brief The largest window of a median filter stage, and the most taps of an FIR filter stage.
+#define kSenseHAT_FilterTapsMax     16
+
+//! @brief The shortest window SenseHAT_SpectrumOpen accepts.
+#define kSenseHAT_SpectrumLengthMin 64
+
+//! @brief The longest window SenseHAT_SpectrumOpen accepts.
+#define kSenseHAT_SpectrumLengthMax 4096
+
+//! @brief The most peaks a spectrum reports.
+#define kSenseHAT_SpectrumPeaksMax  8
+
+//! @brief The number of frequency bands a spectrum reports.
+#define kSenseHAT_SpectrumBands     32
+
+//! @brief The largest number of motion events a single call to SenseHAT_MotionProcess can 
+//! produce.
+#define kSenseHAT_MaxMotionEvents   4
+
+//! @brief The most strokes a shake can be configured to need.
+#define kSenseHAT_MotionShakeStrokesMax 8
+
+//! @brief The most subscriptions the sampler can hold.
+#define kSenseHAT_SubscriptionsMax  16
+
+//! @brief The fewest magnetometer readings SenseHAT_MagCalibratorSolve fits an ellipsoid to.
+#define kSenseHAT_MagCalibrationSamplesMin  50
+
+//! @brief The most frames a sprite atlas can hold.
+#define kSenseHAT_SpriteAtlasFramesMax  1024
+
+//! @brief How late, in fractional seconds, an animation frame can be shown before it counts as late.
+#define kSenseHAT_AnimationLateThreshold    0.002
+
+//! @brief The most layers a compositor can hold.
+#define kSenseHAT_CompositorLayersMax   16
+
+//! @brief The number of entries in an LED matrix gamma table.
+#define kSenseHAT_GammaTableSize    32
+
+//! @brief The most colors a palette can hold.
+#define kSenseHAT_PaletteColorsMax  256
+
+//! @brief The most frames a stream can buffer.
+#define kSenseHAT_StreamBufferFramesMax 64
+
+//! @brief The highest frame rate a stream can be presented at.
+#define kSenseHAT_StreamFrameRateMax    1000.0
+
 // =================================================================================================
 //  Types
 // =================================================================================================
@@ -99,6 +177,165 @@ tSenseHAT_LEDPixel;
 //! 
 typedef tSenseHAT_LEDPixel tSenseHAT_LEDPixelArray[64];
 
+//! @brief LED pixel update.
+//!
+//! This structure defines one pixel change for SenseHAT_LEDSetPixelBatch.
+//!
+typedef struct
+{
+    int32_t             xPosition;  //!< X coordinate, 0 (left) to 7 (right).
+    int32_t             yPosition;  //!< Y coordinate, 0 (top) to 7 (bottom).
+    tSenseHAT_LEDPixel  color;      //!< LED pixel color.
+}
+tSenseHAT_LEDPixelUpdate;
+
+//! @brief A sprite atlas.
+//!
+//! An atlas holds every 8x8 frame of a sprite sheet, decoded once by SenseHAT_SpriteAtlasOpen.
+//! Frames are numbered left to right, then top to bottom. An atlas is never modified once open,
+//! so any number of threads can use it at once.
+//!
+typedef uint8_t* tSenseHAT_SpriteAtlas;
+
+//! @brief Animation frame.
+//!
+//! This structure defines one frame of an animation and how long it stays on the LED matrix.
+//!
+typedef struct
+{
+    tSenseHAT_LEDPixelArray pixels;     //!< The frame.
+    double                  duration;   //!< Time the frame is shown for in fractional seconds.
+}
+tSenseHAT_AnimationFrame;
+
+//! @brief Animation statistics.
+//!
+//! This structure reports how closely an animation kept to its schedule. A frame is late when it
+//! reaches the LED matrix more than kSenseHAT_AnimationLateThreshold after it was due, and is 
+//! dropped when its whole slot has passed before it could be shown.
+//!
+typedef struct
+{
+    bool        playing;        //!< Whether the animation is playing.
+    uint32_t    frameIndex;     //!< Index of the frame shown most recently.
+    uint64_t    framesShown;    //!< Number of frames shown.
+    uint64_t    framesLate;     //!< Number of frames shown late.
+    uint64_t    framesDropped;  //!< Number of frames dropped.
+    double      fps;            //!< Frames shown per second since the animation started.
+    double      maxLateness;    //!< Latest a frame has been shown in fractional seconds.
+    int32_t     lastError;      //!< Status of the most recent LED matrix update that failed (0 if none).
+}
+tSenseHAT_AnimationStatistics;
+
+//! @brief RGBA pixel.
+//!
+//! This structure represents a compositor layer pixel as red, green and blue color components and
+//! an alpha component, where 0 is fully transparent and 255 is fully opaque.
+//!
+typedef struct
+{
+    uint8_t red;    //!< The value of the red color component of the pixel.
+    uint8_t green;  //!< The value of the green color component of the pixel.
+    uint8_t blue;   //!< The value of the blue color component of the pixel.
+    uint8_t alpha;  //!< The opacity of the pixel.
+}
+tSenseHAT_RGBAPixel;
+
+//! @brief RGBA pixel array.
+//!
+//! This array represents one compositor layer, indexed the same way as tSenseHAT_LEDPixelArray.
+//!
+typedef tSenseHAT_RGBAPixel tSenseHAT_RGBAPixelArray[64];
+
+//! @brief A compositor.
+//!
+//! A compositor blends a stack of RGBA layers over a black background into a single LED frame.
+//! Each layer can be updated on its own, from any thread.
+//!
+typedef uint8_t* tSenseHAT_Compositor;
+
+//! @brief Color conversion table.
+//!
+//! This structure holds the lookup tables SenseHAT_ColorTableInitialize precomputes to convert 
+//! 8-bit color components to the RGB565 pixels of the LED matrix framebuffer, with brightness and
+//! gamma folded in. It is allocated by the caller. Treat it as opaque.
+//!
+typedef struct
+{
+    uint16_t    red[256];   //!< Red contribution to the RGB565 pixel for each red value.
+    uint16_t    green[256]; //!< Green contribution to the RGB565 pixel for each green value.
+    uint16_t    blue[256];  //!< Blue contribution to the RGB565 pixel for each blue value.
+    uint16_t    scale;      //!< Brightness in 8.8 fixed point.
+    bool        linear;     //!< Whether there's no gamma curve, so the conversion is arithmetic.
+}
+tSenseHAT_ColorTable;
+
+//! @brief Palette index size enumerations.
+//!
+//! These enumerations identify how many bits each pixel of a palette-indexed frame takes. A 
+//! frame of 4-bit indices is 32 bytes, with the even pixel of each pair in the low nibble; a 
+//! frame of 8-bit indices is 64 bytes.
+//!
+typedef enum
+{
+    eSenseHAT_PaletteIndex4Bit  = 4,    //!< 4-bit indices, for palettes of up to 16 colors.
+    eSenseHAT_PaletteIndex8Bit  = 8     //!< 8-bit indices, for palettes of up to 256 colors.
+}
+tSenseHAT_PaletteIndexSize;
+
+//! @brief Palette.
+//!
+//! This structure holds the colors shared by a set of palette-indexed frames, along with their
+//! RGB565 form, so frames can be expanded with a single table lookup per pixel. It is allocated
+//! by the caller and initialized with SenseHAT_PaletteInitialize. Treat it as opaque.
+//!
+typedef struct
+{
+    uint32_t            colorCount;                             //!< Number of colors.
+    tSenseHAT_LEDPixel  colors[kSenseHAT_PaletteColorsMax];     //!< Colors.
+    uint16_t            device[kSenseHAT_PaletteColorsMax];     //!< RGB565 colors (0 past the last color).
+}
+tSenseHAT_Palette;
+
+//! @brief An animation clip.
+//!
+//! A clip is a file of LED frames written with SenseHAT_ClipWrite, stored as keyframes and the
+//! pixels that changed in between, and mapped rather than read when it's opened with 
+//! SenseHAT_ClipOpen. Frames are decoded one at a time as they're shown.
+//!
+typedef uint8_t* tSenseHAT_Clip;
+
+//! @brief Stream format enumerations.
+//!
+//! These enumerations identify the raw frame format read by SenseHAT_StreamStart. Each frame is
+//! 64 pixels in LED pixel array order with no header: 192 bytes of red, green and blue for 
+//! RGB888, or 128 bytes of native-endian 16-bit values for RGB565.
+//!
+typedef enum
+{
+    eSenseHAT_StreamFormatRGB888    = 0,    //!< 24-bit pixels, as from ffmpeg -pix_fmt rgb24.
+    eSenseHAT_StreamFormatRGB565    = 1     //!< 16-bit pixels, as from ffmpeg -pix_fmt rgb565le.
+}
+tSenseHAT_StreamFormat;
+
+//! @brief Stream statistics.
+//!
+//! This structure reports how a stream has kept up. A frame is dropped when the ring is full and
+//! a newer frame arrives; an underrun is a frame slot that came due with no frame to show.
+//!
+typedef struct
+{
+    bool        playing;        //!< Whether the stream is playing.
+    bool        endOfStream;    //!< Whether the reader has reached the end of the stream.
+    uint64_t    framesRead;     //!< Number of frames read.
+    uint64_t    framesShown;    //!< Number of frames shown.
+    uint64_t    framesDropped;  //!< Number of frames dropped.
+    uint64_t    underruns;      //!< Number of frame slots with no frame to show.
+    double      fps;            //!< Frames shown per second since the stream started.
+    int32_t     lastError;      //!< Status of the most recent read or LED matrix update that failed (0 if none).
+}
+tSenseHAT_StreamStatistics;
+
 //! @brief Orientation.
 //!
 //! This structure defines orientation in terms of pitch, roll, and yaw.
@@ -166,437 +403,2819 @@ typedef struct
 }
 tSenseHAT_JoystickEvent;
 
-// =================================================================================================
-//  Prototypes
-// =================================================================================================
+//! @brief Sensor channel enumerations.
+//!
+//! These enumerations identify the sensor readings that the sampler can acquire. They are bit
+//! flags, so they can be combined to select several channels at once.
+//!
+typedef enum
+{
+    eSenseHAT_ChannelNone               = 0x0000,   //!< No channel.
+    eSenseHAT_ChannelHumidity           = 0x0001,   //!< Humidity (see SenseHAT_GetHumidity).
+    eSenseHAT_ChannelTemperature        = 0x0002,   //!< Temperature (see SenseHAT_GetTemperature).
+    eSenseHAT_ChannelPressure           = 0x0004,   //!< Pressure (see SenseHAT_GetPressure).
+    eSenseHAT_ChannelCompass            = 0x0008,   //!< Compass heading (see SenseHAT_GetCompass).
+    eSenseHAT_ChannelAccelerometerRaw   = 0x0010,   //!< Raw accelerometer data (see SenseHAT_GetAccelerometerRaw).
+    eSenseHAT_ChannelGyroscopeRaw       = 0x0020,   //!< Raw gyroscope data (see SenseHAT_GetGyroscopeRaw).
+    eSenseHAT_ChannelCompassRaw         = 0x0040,   //!< Raw magnetometer data (see SenseHAT_GetCompassRaw).
+    eSenseHAT_ChannelOrientation        = 0x0080,   //!< Orientation in degrees (see SenseHAT_GetOrientation).
+    eSenseHAT_ChannelAll                = 0x00FF,   //!< All channels.
+    eSenseHAT_ChannelJoystick           = 0x0100    //!< Joystick events (recorder only; not part of eSenseHAT_ChannelAll).
+}
+tSenseHAT_Channel;
 
-#ifdef __cplusplus
-extern "C"
+//! @brief Sensor sample.
+//!
+//! This structure holds one set of readings acquired by the sampler. Only the members that
+//! correspond to the channels flagged in the channels member are valid.
+//!
+typedef struct
 {
-#endif
+    double                  timestamp;          //!< The time the sample was acquired; expressed in fractional seconds.
+    uint64_t                sequence;           //!< Sample sequence number; incremented for every sample.
+    uint32_t                channels;           //!< The tSenseHAT_Channel flags of the valid readings.
+    double                  humidity;           //!< Humidity in percent relative humidity.
+    double                  temperature;        //!< Temperature in degrees Celsius.
+    double                  pressure;           //!< Pressure in millibars.
+    double                  compass;            //!< Compass heading in degrees.
+    tSenseHAT_RawData       accelerometerRaw;   //!< Raw accelerometer data in G's.
+    tSenseHAT_RawData       gyroscopeRaw;       //!< Raw gyroscope data in radians/second.
+    tSenseHAT_RawData       compassRaw;         //!< Raw magnetometer data in microteslas (µT).
+    tSenseHAT_Orientation   orientation;        //!< Orientation in degrees.
+}
+tSenseHAT_Sample;
 
-    // =============================================================================================
-    //  Base functions
-    // =============================================================================================
+//! @brief Rollup resolution enumerations.
+//!
+//! These enumerations select the bucket duration of the rollups returned by 
+//! SenseHAT_SamplerGetRollups.
+//!
+typedef enum
+{
+    eSenseHAT_RollupSecond  = 0,    //!< One second buckets.
+    eSenseHAT_RollupMinute  = 1,    //!< One minute buckets.
+    eSenseHAT_RollupHour    = 2     //!< One hour buckets.
+}
+tSenseHAT_RollupResolution;
 
-    //! @brief Call SenseHAT_Version to get the version of the Sense HAT C library.
-    //! 
-    //! @return uint32_t The version of the Sense HAT C library. Note this is not the same as 
-    //! the version of the underlying Sense HAT Python library. The value returned is formatted
-    //! as follows:
-    //!
-    //! Bytes 0 and 1: Major version
-    //!        Byte 2: Minor version
-    //!        Byte 3: Revision
-    //!
-    //! For example, a value of 0x00010000 translates to a version of 1.0.0.
-    //!
-    uint32_t    SenseHAT_Version    (void);
+//! @brief Rollup bucket.
+//!
+//! This structure holds the aggregates of one channel's readings over one bucket. Buckets are
+//! aligned to whole seconds, minutes or hours of the sample timestamps.
+//!
+typedef struct
+{
+    double      startTime;          //!< The start of the bucket; expressed in fractional seconds.
+    uint64_t    count;              //!< The number of readings in the bucket.
+    double      minimum;            //!< The smallest reading.
+    double      maximum;            //!< The largest reading.
+    double      mean;               //!< The mean of the readings.
+    double      standardDeviation;  //!< The population standard deviation of the readings.
+}
+tSenseHAT_RollupBucket;
 
-    //! @brief Call SenseHAT_Open to create an instance of the Sense HAT C library.
-    //! 
-    //! All Sense HAT C functions require an instance as their first argument. This function 
-    //! initializes an instance for use with the other Sense HAT C functions. Note that
-    //! SenseHAT_Open must not be called multiple times in a single program.
-    //! 
-    //! @param[out] instance A pointer to an instance of the Sense HAT C library. This argument
-    //! must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_Open       (tSenseHAT_Instance*    instance);
+//! @brief Subscription type enumerations.
+//!
+//! These enumerations define the conditions a subscription watches for.
+//!
+typedef enum
+{
+    eSenseHAT_SubscriptionAbove     = 0,    //!< The reading rose above the threshold.
+    eSenseHAT_SubscriptionBelow     = 1,    //!< The reading fell below the threshold.
+    eSenseHAT_SubscriptionChange    = 2,    //!< The reading moved more than the threshold away from the last reading reported.
+    eSenseHAT_SubscriptionRiseRate  = 3,    //!< The reading rose faster than the threshold per hour.
+    eSenseHAT_SubscriptionFallRate  = 4     //!< The reading fell faster than the threshold per hour.
+}
+tSenseHAT_SubscriptionType;
 
-    //! @brief Call SenseHAT_Close to close an instance of the Sense HAT C library.
-    //! 
-    //! This function is responsible for releasing all resources reserved by the Sense HAT C 
-    //! library instance, including memory and references to Python functions.
-    //! 
-    //! @param[in] instance A pointer to an instance of the Sense HAT C library. This argument
-    //! must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_Close      (tSenseHAT_Instance*    instance);
+//! @brief Subscription.
+//!
+//! This structure defines a condition on the readings of an environmental channel, e.g. 
+//! "temperature rose above 30", "humidity changed by more than 5" or "pressure is falling 
+//! faster than 2 millibars per hour". Once reported, an above, below or rate condition isn't 
+//! reported again until it has cleared by the hysteresis, so a noisy reading near the threshold
+//! produces a single notification.
+//!
+typedef struct
+{
+    uint32_t                    channel;    //!< eSenseHAT_ChannelHumidity, eSenseHAT_ChannelTemperature or eSenseHAT_ChannelPressure.
+    tSenseHAT_SubscriptionType  type;       //!< The condition.
+    double                      threshold;  //!< Level, change or rate per hour, in the units of the channel; changes and rates must be greater than 0.
+    double                      hysteresis; //!< Amount, in the same units as the threshold, by which a reported condition must clear before it's reported again; must not be negative.
+    double                      window;     //!< Rates: time the rate is measured over in fractional seconds, which must be greater than 0; ignored otherwise.
+}
+tSenseHAT_Subscription;
 
-    // =============================================================================================
-    //  High level LED matrix functions
-    // =============================================================================================
+//! @brief Subscription notification.
+//!
+//! This structure describes a reading that met the condition of a subscription.
+//!
+typedef struct
+{
+    double                      timestamp;      //!< The time of the reading; expressed in fractional seconds.
+    uint32_t                    subscriptionId; //!< The identifier returned by SenseHAT_SamplerSubscribe.
+    uint32_t                    channel;        //!< The channel of the subscription.
+    tSenseHAT_SubscriptionType  type;           //!< The condition of the subscription.
+    double                      value;          //!< The reading.
+    double                      change;         //!< eSenseHAT_SubscriptionChange: the change since the last reading reported; rates: the rate per hour; 0 otherwise.
+}
+tSenseHAT_Notification;
 
-    //! @brief Call SenseHAT_LEDSetRotation to rotate the LED matrix.
-    //!
-    //! Use this function to adjust the orientation of the LED matrix in the event your Raspberry
-    //! Pi is upside down or sideways.
-    //!
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] rotation The angle in degrees to rotate the LED matrix through. The only 
-    //! valid values are those defined in the tSenseHAT_LEDRotation enumeration.
-    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_LEDSetRotation     (const tSenseHAT_Instance      instance,
-                                             tSenseHAT_LEDRotation         rotation,
-                                             bool                          redraw);
+//! @brief Subscription callback.
+//!
+//! The sampler calls this function on its own thread for every notification of the 
+//! subscription, without holding any library lock. It should return quickly, since sampling 
+//! waits for it.
+//!
+//! @param[in] notification The notification.
+//! @param[in] context The context passed to SenseHAT_SamplerSubscribe.
+//!
+typedef void (*tSenseHAT_SubscriptionCallback) (const tSenseHAT_Notification* notification, void* context);
 
-    //! @brief Call SenseHAT_LEDFlipHorizontal to flip the LED matrix horizontally.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
-    //! @param[out] pixels An LED pixel array containing the flipped pixels. If you don't need 
-    //! this array, pass NULL in this argument.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_LEDFlipHorizontal  (const tSenseHAT_Instance      instance,
-                                             bool                          redraw,
-                                             tSenseHAT_LEDPixelArray       pixels);
+//! @brief Filter type enumerations.
+//!
+//! These enumerations define the kinds of filter stage.
+//!
+typedef enum
+{
+    eSenseHAT_FilterEMA     = 0,    //!< Exponential moving average: y += alpha * (x - y).
+    eSenseHAT_FilterMedian  = 1,    //!< Median of the last length inputs.
+    eSenseHAT_FilterFIR     = 2,    //!< FIR filter: y = sum of coefficients[k] times the input k samples ago, for k < length.
+    eSenseHAT_FilterBiquad  = 3     //!< Biquad IIR filter with coefficients b0, b1, b2, a1 and a2 (a0 is 1).
+}
+tSenseHAT_FilterType;
 
-    //! @brief Call SenseHAT_LEDFlipVertical to flip the LED matrix vertically.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
-    //! @param[out] pixels An LED pixel array containing the flipped pixels. If you don't need 
-    //! this array, pass NULL in this argument.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_LEDFlipVertical    (const tSenseHAT_Instance      instance,
-                                             bool                          redraw,
-                                             tSenseHAT_LEDPixelArray       pixels);
+//! @brief Filter stage.
+//!
+//! This structure defines one stage of a filter chain. Only the members used by its type are
+//! examined.
+//!
+typedef struct
+{
+    tSenseHAT_FilterType    type;                                   //!< The kind of stage.
+    double                  alpha;                                  //!< eSenseHAT_FilterEMA: smoothing factor, greater than 0 and at most 1.
+    uint32_t                length;                                 //!< eSenseHAT_FilterMedian and eSenseHAT_FilterFIR: window length, from 1 to kSenseHAT_FilterTapsMax.
+    double                  coefficients[kSenseHAT_FilterTapsMax];  //!< eSenseHAT_FilterFIR: taps; eSenseHAT_FilterBiquad: b0, b1, b2, a1, a2.
+}
+tSenseHAT_FilterStage;
 
-    //! @brief Call SenseHAT_LEDSetPixels to set the color of every LED in the LED matrix.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] pixels An array containing 64 LED pixels. If you pass NULL for this argument,
-    //! then the LED matrix will be cleared (all LED pixels colors set to red:green:blue equal to
-    //! 0:0:0 (off)).
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_LEDSetPixels       (const tSenseHAT_Instance      instance,
-                                             const tSenseHAT_LEDPixelArray pixels);
+//! @brief Filter stage state.
+//!
+//! This structure holds the state of one filter stage. Treat it as opaque.
+//!
+typedef struct
+{
+    double      history[2 * kSenseHAT_FilterTapsMax];   //!< Recent inputs, stored twice so every window is contiguous.
+    uint32_t    position;                               //!< Index of the newest input in history.
+    bool        primed;                                 //!< Whether the stage has seen an input.
+    double      output;                                 //!< Previous output.
+    double      z1;                                     //!< First biquad delay element.
+    double      z2;                                     //!< Second biquad delay element.
+}
+tSenseHAT_FilterStageState;
 
-    //! @brief Call SenseHAT_LEDGetPixels to get the color of every LED in the display.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] pixels An LED pixel array containing the current state of the pixels in the
-    //! LED matrix. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
-    //!
-    int32_t     SenseHAT_LEDGetPixels       (const tSenseHAT_Instance      instance,
-                                             tSenseHAT_LEDPixelArray       pixels);
+//! @brief Filter.
+//!
+//! This structure holds a filter chain for one stream of values and its complete state. It is 
+//! allocated by the caller and initialized with SenseHAT_FilterInitialize; filters never 
+//! allocate memory. Treat it as opaque.
+//!
+typedef struct
+{
+    uint32_t                    stageCount;                         //!< Number of stages.
+    tSenseHAT_FilterStage       stages[kSenseHAT_FilterStagesMax];  //!< Stages, in the order they're applied.
+    tSenseHAT_FilterStageState  states[kSenseHAT_FilterStagesMax];  //!< State of each stage.
+}
+tSenseHAT_Filter;
 
-    //! @brief Call SenseHAT_LEDSetPixel to set the color of a specific LED in the LED matrix.
+//! @brief Wait source enumerations.
+//!
+//! These enumerations identify the sources that SenseHAT_WaitForSources can wait on. They are 
+//! bit flags, so they can be combined to wait on several sources at once.
+//!
+typedef enum
+{
+    eSenseHAT_WaitSourceNone            = 0x00,     //!< No source.
+    eSenseHAT_WaitSourceJoystick        = 0x01,     //!< Joystick events are available.
+    eSenseHAT_WaitSourceSampler         = 0x02,     //!< A new sample is available.
+    eSenseHAT_WaitSourceUser            = 0x04,     //!< A caller supplied file descriptor is readable.
+    eSenseHAT_WaitSourceMotion          = 0x08,     //!< Motion events are available.
+    eSenseHAT_WaitSourceSubscription    = 0x10      //!< Subscription notifications are available.
+}
+tSenseHAT_WaitSource;
+
+//! @brief Sensor value cache statistics.
+//!
+//! This structure holds the sensor value cache counters. Each channel read counts once.
+//!
+typedef struct
+{
+    uint64_t    hits;   //!< Number of channel reads served from the cache.
+    uint64_t    misses; //!< Number of channel reads that went to the sensors.
+}
+tSenseHAT_CacheStatistics;
+
+//! @brief A telemetry recorder.
+//!
+//! A recorder is created with SenseHAT_RecorderOpen and is required to invoke any of the 
+//! recorder functions.
+//!
+typedef uint8_t* tSenseHAT_Recorder;
+
+//! @brief A telemetry reader.
+//!
+//! A reader is created with SenseHAT_ReaderOpen and is required to invoke any of the reader
+//! functions.
+//!
+typedef uint8_t* tSenseHAT_Reader;
+
+//! @brief Telemetry record.
+//!
+//! This structure defines the fixed size record written by the recorder; one record holds one
+//! channel's reading. Scalar channels use values[0]. Raw data channels use values[0..2] for x, y 
+//! and z, and eSenseHAT_ChannelOrientation uses them for pitch, roll and yaw. 
+//! eSenseHAT_ChannelJoystick uses values[0] for the tSenseHAT_JoystickDirection and values[1]
+//! for the tSenseHAT_JoystickAction.
+//!
+typedef struct
+{
+    double      timestamp;  //!< The time of the reading; expressed in fractional seconds.
+    uint32_t    channel;    //!< The tSenseHAT_Channel of the reading.
+    uint32_t    reserved;   //!< Reserved; always 0.
+    double      values[3];  //!< The reading.
+}
+tSenseHAT_Record;
+
+//! @brief Telemetry recorder statistics.
+//!
+//! This structure holds the recorder counters.
+//!
+typedef struct
+{
+    uint64_t    written;    //!< Number of records written to disk.
+    uint64_t    dropped;    //!< Number of records dropped because the buffer was full or a write failed.
+    uint32_t    segments;   //!< Number of segments created.
+    int32_t     lastError;  //!< The last write error (an errno value), or 0.
+    uint64_t    bytes;      //!< Number of bytes written to segments, including their headers.
+}
+tSenseHAT_RecorderStatistics;
+
+//! @brief A telemetry query.
+//!
+//! A query is created with SenseHAT_QueryOpen and is required to invoke any of the query 
+//! functions.
+//!
+typedef uint8_t* tSenseHAT_Query;
+
+//! @brief Telemetry query parameters.
+//!
+//! This structure defines the records a query matches: those of the given channels with
+//! timestamps in [startTime, endTime] and values[valueIndex] in [minimumValue, maximumValue].
+//! Use -INFINITY and INFINITY to leave either end of a range open.
+//!
+typedef struct
+{
+    uint32_t    channels;       //!< The tSenseHAT_Channel mask of the channels to match.
+    double      startTime;      //!< The earliest timestamp to match.
+    double      endTime;        //!< The latest timestamp to match.
+    uint32_t    valueIndex;     //!< The index (0 to 2) of the value to compare against the value range.
+    double      minimumValue;   //!< The smallest value to match.
+    double      maximumValue;   //!< The largest value to match.
+}
+tSenseHAT_QueryParameters;
+
+//! @brief Telemetry query statistics.
+//!
+//! This structure holds the query counters. A block is the run of records described by one
+//! entry of a segment index, or the unindexed remainder of a segment.
+//!
+typedef struct
+{
+    uint64_t    blocksRead;         //!< Number of blocks read.
+    uint64_t    blocksSkipped;      //!< Number of blocks skipped because their index entry ruled them out.
+    uint64_t    recordsRead;        //!< Number of records examined.
+    uint32_t    segmentsUnindexed;  //!< Number of segments read in full because they have no usable index.
+}
+tSenseHAT_QueryStatistics;
+
+//! @brief Telemetry codec history.
+//!
+//! This structure holds the per-channel history shared by the telemetry encoder and decoder. 
+//! Treat it as opaque.
+//!
+typedef struct
+{
+    double      timestamp;      //!< Timestamp of the previous record.
+    int32_t     channel;        //!< Channel index of the previous record, or -1.
+    uint64_t    ticks[9];       //!< Last timestamp of each channel index, in codec ticks.
+    uint64_t    deltas[9];      //!< Difference between the last two timestamps of each channel index, in codec ticks.
+    uint64_t    values[9][3];   //!< Last values of each channel index.
+    uint8_t     leading[9][3];  //!< Leading zero bits of the last window of each value.
+    uint8_t     length[9][3];   //!< Meaningful bits of the last window of each value, or 0 if none.
+}
+tSenseHAT_CodecHistory;
+
+//! @brief Telemetry encoder.
+//!
+//! This structure holds the complete state of a telemetry encoder. It is allocated by the 
+//! caller and initialized with SenseHAT_EncoderInitialize; the encoder never allocates memory.
+//! Treat it as opaque.
+//!
+typedef struct
+{
+    uint8_t*                buffer;         //!< Caller allocated output buffer.
+    size_t                  capacity;       //!< Size of buffer in bytes.
+    uint64_t                bitCount;       //!< Number of bits written.
+    uint32_t                recordCount;    //!< Number of records encoded.
+    tSenseHAT_CodecHistory  history;        //!< Channel history.
+}
+tSenseHAT_Encoder;
+
+//! @brief Telemetry decoder.
+//!
+//! This structure holds the complete state of a telemetry decoder. It is allocated by the 
+//! caller and initialized with SenseHAT_DecoderInitialize; the decoder never allocates memory.
+//! Treat it as opaque.
+//!
+typedef struct
+{
+    const uint8_t*          buffer;         //!< Caller allocated input buffer.
+    size_t                  length;         //!< Size of buffer in bytes.
+    uint64_t                bitCount;       //!< Number of bits read.
+    uint32_t                recordCount;    //!< Number of records left to decode.
+    tSenseHAT_CodecHistory  history;        //!< Channel history.
+}
+tSenseHAT_Decoder;
+
+//! @brief Joystick gesture enumerations.
+//!
+//! These are the enumerations for the gestures produced by the joystick gesture recognizer.
+//!
+typedef enum
+{
+    eSenseHAT_GestureNone           = 0,    //!< Invalid value.
+    eSenseHAT_GestureClick          = 1,    //!< Pressed and released once.
+    eSenseHAT_GestureDoubleClick    = 2,    //!< Pressed and released twice in quick succession.
+    eSenseHAT_GestureLongPress      = 3,    //!< Pressed and held for the long press duration.
+    eSenseHAT_GestureRepeat         = 4     //!< Key repeat while held.
+}
+tSenseHAT_GestureType;
+
+//! @brief Joystick gesture.
+//!
+//! This structure defines a gesture, which consists of a timestamp, a direction, a gesture type,
+//! and (for repeats) the number of repeats so far.
+//!
+typedef struct
+{
+    double                      timestamp;      //!< The time the gesture was recognized; expressed in fractional seconds.
+    tSenseHAT_JoystickDirection direction;      //!< The direction of the gesture.
+    tSenseHAT_GestureType       type;           //!< The gesture type.
+    uint32_t                    repeatCount;    //!< For eSenseHAT_GestureRepeat, the repeat number (starting at 1); 0 otherwise.
+}
+tSenseHAT_Gesture;
+
+//! @brief Joystick gesture timing configuration.
+//!
+//! All times are expressed in fractional seconds. Setting doubleClickInterval to 0 reports every
+//! click immediately, setting longPressDuration to 0 disables long presses, and setting
+//! repeatDelay to 0 disables key repeat.
+//!
+//! A press that starts repeating before longPressDuration doesn't also report a long press. So
+//! with repeatDelay shorter than longPressDuration (as in the defaults), holding a direction 
+//! only repeats; to get long presses, set repeatDelay to 0, or longer than longPressDuration so
+//! the repeats follow the long press.
+//!
+typedef struct
+{
+    double  doubleClickInterval;    //!< Maximum time between a release and the next press for a double click.
+    double  longPressDuration;      //!< Time a direction must be held to report a long press.
+    double  repeatDelay;            //!< Time a direction must be held before the first repeat.
+    double  repeatInterval;         //!< Initial time between repeats.
+    double  repeatMinimumInterval;  //!< Shortest time between repeats once accelerated.
+    double  repeatAcceleration;     //!< Factor applied to the repeat interval after every repeat (0 < factor <= 1).
+}
+tSenseHAT_GestureConfiguration;
+
+//! @brief Joystick gesture recognizer direction state.
+//!
+//! This structure holds the recognizer state for a single joystick direction. Treat it as
+//! opaque.
+//!
+typedef struct
+{
+    bool        pressed;            //!< Whether the direction is down.
+    bool        secondPress;        //!< Whether the current press may complete a double click.
+    bool        clickPending;       //!< Whether a click is waiting for the double click interval to expire.
+    bool        consumed;           //!< Whether the current press already produced a long press or a repeat.
+    bool        longPressReported;  //!< Whether the current press already produced a long press.
+    double      pressTime;          //!< Time of the current press.
+    double      releaseTime;        //!< Time of the last release.
+    double      nextRepeatTime;     //!< Time the next repeat is due.
+    double      repeatInterval;     //!< Current time between repeats.
+    uint32_t    repeatCount;        //!< Number of repeats produced by the current press.
+}
+tSenseHAT_GestureDirectionState;
+
+//! @brief Joystick gesture recognizer.
+//!
+//! This structure holds the complete state of a gesture recognizer. It is allocated by the
+//! caller and initialized with SenseHAT_GestureInitialize; the recognizer never allocates
+//! memory. Treat it as opaque.
+//!
+typedef struct
+{
+    tSenseHAT_GestureConfiguration  configuration;  //!< Timing configuration.
+    tSenseHAT_GestureDirectionState directions[5];  //!< State for each tSenseHAT_JoystickDirection (less one).
+}
+tSenseHAT_GestureRecognizer;
+
+//! @brief Motion event enumerations.
+//!
+//! These are the enumerations for the events produced by the motion detector. They are bit 
+//! flags, so they can be combined to select the detectors to run.
+//!
+typedef enum
+{
+    eSenseHAT_MotionNone        = 0x00, //!< No event.
+    eSenseHAT_MotionTap         = 0x01, //!< A sudden change in acceleration.
+    eSenseHAT_MotionShake       = 0x02, //!< Several strong strokes in quick succession.
+    eSenseHAT_MotionFreeFall    = 0x04, //!< Total acceleration close to zero for a while.
+    eSenseHAT_MotionTilt        = 0x08, //!< The z axis tilted away from vertical past a threshold.
+    eSenseHAT_MotionAll         = 0x0F  //!< All detectors.
+}
+tSenseHAT_MotionType;
+
+//! @brief Motion event.
+//!
+//! This structure defines a motion event. Free-fall and tilt are states, so they produce one 
+//! event when entered and another when left; taps and shakes are always active.
+//!
+typedef struct
+{
+    double                  timestamp;      //!< The time of the reading that produced the event; expressed in fractional seconds.
+    tSenseHAT_MotionType    type;           //!< The event type.
+    bool                    active;         //!< Whether the state was entered (true) or left (false).
+    double                  magnitude;      //!< Tap: change in acceleration in G's; shake: strongest stroke in G's; free-fall: time spent falling in seconds; tilt: angle from vertical in degrees.
+    tSenseHAT_RawData       acceleration;   //!< The reading that produced the event, in G's.
+}
+tSenseHAT_MotionEvent;
+
+//! @brief Motion detector configuration.
+//!
+//! Detection works on the readings it's given, so the sampling interval bounds what can be 
+//! seen: taps in particular need readings every 10 to 20 ms. Once a reading crosses a 
+//! threshold, the detector doesn't fire again until the readings fall back past the threshold
+//! by the hysteresis fraction, so a noisy reading near the threshold produces a single event.
+//!
+typedef struct
+{
+    uint32_t    detectors;              //!< tSenseHAT_MotionType flags of the detectors to run.
+    double      tapThreshold;           //!< Change in acceleration between consecutive readings that counts as a tap, in G's.
+    double      tapQuietTime;           //!< Minimum time between taps in fractional seconds.
+    double      shakeThreshold;         //!< Acceleration, less gravity, that counts as a shake stroke, in G's.
+    uint32_t    shakeStrokes;           //!< Strokes needed for a shake; from 1 to kSenseHAT_MotionShakeStrokesMax.
+    double      shakeWindow;            //!< Time the strokes of a shake must fall within, in fractional seconds.
+    double      freeFallThreshold;      //!< Total acceleration below which the device is falling, in G's.
+    double      freeFallTime;           //!< Time the device must fall before free-fall is reported, in fractional seconds.
+    double      tiltThreshold;          //!< Angle between the z axis and gravity that counts as tilted, in degrees (0 to 180).
+    double      hysteresis;             //!< Fraction of each threshold the readings must fall back by to re-arm a detector (0 <= fraction < 1).
+    double      gravityTimeConstant;    //!< Time constant of the low pass filter that estimates gravity, in fractional seconds.
+}
+tSenseHAT_MotionConfiguration;
+
+//! @brief Motion event callback.
+//!
+//! The sampler calls this function on its own thread for every motion event, without holding
+//! any library lock. It should return quickly, since sampling waits for it.
+//!
+//! @param[in] event The motion event.
+//! @param[in] context The context passed to SenseHAT_SamplerSetMotionDetection.
+//!
+typedef void (*tSenseHAT_MotionCallback) (const tSenseHAT_MotionEvent* event, void* context);
+
+//! @brief Motion detector.
+//!
+//! This structure holds the complete state of a motion detector. It is allocated by the caller
+//! and initialized with SenseHAT_MotionInitialize; the detector never allocates memory. Treat 
+//! it as opaque.
+//!
+typedef struct
+{
+    tSenseHAT_MotionConfiguration   configuration;                                  //!< Configuration.
+    bool                            primed;                                         //!< Whether the detector has seen a reading.
+    double                          lastTime;                                       //!< Time of the previous reading.
+    tSenseHAT_RawData               previous;                                       //!< Previous reading.
+    tSenseHAT_RawData               gravity;                                        //!< Gravity estimate.
+    bool                            tapArmed;                                       //!< Whether a tap can be detected.
+    double                          tapTime;                                        //!< Time of the last tap.
+    bool                            shakeArmed;                                     //!< Whether a shake stroke can be detected.
+    double                          strokeTimes[kSenseHAT_MotionShakeStrokesMax];   //!< Times of the recent strokes.
+    uint32_t                        strokeIndex;                                    //!< Index of the oldest stroke time.
+    uint32_t                        strokeCount;                                    //!< Number of strokes since the last shake.
+    double                          strokePeak;                                     //!< Strongest stroke since the last shake.
+    bool                            falling;                                        //!< Whether the acceleration is below the free-fall threshold.
+    bool                            fallReported;                                   //!< Whether the current fall has been reported.
+    double                          fallTime;                                       //!< Time the current fall started.
+    bool                            tilted;                                         //!< Whether the device is tilted.
+}
+tSenseHAT_MotionDetector;
+
+//! @brief Magnetometer calibration.
+//!
+//! This structure holds a hard and soft iron correction for the magnetometer. A raw reading r 
+//! is corrected to matrix * (r - offset), which maps the ellipsoid the raw readings lie on back
+//! onto a sphere centred on the origin.
+//!
+typedef struct
+{
+    tSenseHAT_RawData   offset;         //!< Hard iron offset in microteslas (µT).
+    double              matrix[3][3];   //!< Soft iron correction, row major.
+    double              fieldStrength;  //!< Radius of the corrected sphere in microteslas (µT).
+    double              fitError;       //!< RMS residual of the ellipsoid fit, relative to the field strength; lower is better.
+}
+tSenseHAT_MagCalibration;
+
+//! @brief Magnetometer calibrator.
+//!
+//! This structure accumulates the sums an ellipsoid fit needs, so readings can be collected 
+//! for as long as needed in constant memory. It is allocated by the caller and initialized with
+//! SenseHAT_MagCalibratorInitialize. Treat it as opaque.
+//!
+typedef struct
+{
+    double      sums[9][9]; //!< Sums of the products of the fit terms.
+    double      rhs[9];     //!< Sums of the fit terms.
+    uint64_t    count;      //!< Number of readings.
+}
+tSenseHAT_MagCalibrator;
+
+//! @brief A spectrum plan.
+//!
+//! A plan is created with SenseHAT_SpectrumOpen and is required to invoke 
+//! SenseHAT_SpectrumCompute.
+//!
+typedef uint8_t* tSenseHAT_SpectrumPlan;
+
+//! @brief Spectrum window enumerations.
+//!
+//! These enumerations define the window applied to the samples before the transform.
+//!
+typedef enum
+{
+    eSenseHAT_SpectrumWindowRectangular = 0,    //!< No window.
+    eSenseHAT_SpectrumWindowHann        = 1,    //!< Hann window.
+    eSenseHAT_SpectrumWindowHamming     = 2,    //!< Hamming window.
+    eSenseHAT_SpectrumWindowBlackman    = 3     //!< Blackman window.
+}
+tSenseHAT_SpectrumWindow;
+
+//! @brief Spectrum peak.
+//!
+//! This structure defines a local maximum of a power spectrum.
+//!
+typedef struct
+{
+    float   frequency;  //!< Frequency in Hz, interpolated between bins.
+    float   power;      //!< Power of the peak bin, in squared units of the samples.
+}
+tSenseHAT_SpectrumPeak;
+
+//! @brief Axis spectrum.
+//!
+//! This structure holds the compact spectrum of one window of samples. Powers are scaled so
+//! that a sine of amplitude A centred on a bin has power A * A / 2 in that bin, whatever the
+//! window.
+//!
+typedef struct
+{
+    float                   mean;                               //!< Mean of the samples, removed before the transform.
+    float                   rms;                                //!< RMS of the samples about their mean.
+    uint32_t                peakCount;                          //!< Number of peaks.
+    tSenseHAT_SpectrumPeak  peaks[kSenseHAT_SpectrumPeaksMax];  //!< Strongest peaks, strongest first.
+    float                   bands[kSenseHAT_SpectrumBands];     //!< Total power of equal width bands from DC (excluded) to the Nyquist frequency.
+}
+tSenseHAT_AxisSpectrum;
+
+//! @brief A vibration capture.
+//!
+//! A capture is created with SenseHAT_VibrationOpen and is required to invoke any of the 
+//! vibration functions.
+//!
+typedef uint8_t* tSenseHAT_VibrationCapture;
+
+//! @brief Vibration capture configuration.
+//!
+//! This structure defines how a vibration capture samples and analyses the accelerometer.
+//!
+typedef struct
+{
+    uint32_t                    windowLength;   //!< Samples per spectrum; a power of two from kSenseHAT_SpectrumLengthMin to kSenseHAT_SpectrumLengthMax.
+    tSenseHAT_SpectrumWindow    window;         //!< Window applied to each block of samples.
+    uint32_t                    fullScale;      //!< Accelerometer range in G's: 2, 4, 8 or 16.
+    uint32_t                    peakCount;      //!< Number of peaks to report per axis, at most kSenseHAT_SpectrumPeaksMax.
+}
+tSenseHAT_VibrationConfiguration;
+
+//! @brief Vibration spectrum.
+//!
+//! This structure holds the spectra of the x, y and z axes of one window of accelerometer 
+//! samples, in G's.
+//!
+typedef struct
+{
+    double                  timestamp;      //!< The time of the first sample; expressed in fractional seconds.
+    double                  sampleRate;     //!< The measured sample rate in Hz.
+    uint32_t                windowLength;   //!< Number of samples in the window.
+    uint32_t                overruns;       //!< Number of times the IMU FIFO overflowed during the window, losing samples.
+    tSenseHAT_AxisSpectrum  axes[3];        //!< Spectra of the x, y and z axes.
+}
+tSenseHAT_VibrationSpectrum;
+
+//! @brief Vibration capture statistics.
+//!
+//! This structure holds the vibration capture counters.
+//!
+typedef struct
+{
+    uint64_t    samples;        //!< Number of samples read from the IMU FIFO.
+    uint64_t    spectra;        //!< Number of spectra computed.
+    uint64_t    dropped;        //!< Number of spectra dropped because they weren't retrieved in time.
+    uint64_t    overruns;       //!< Number of times the IMU FIFO overflowed.
+    int32_t     lastError;      //!< The last I2C error (an errno value), or 0.
+}
+tSenseHAT_VibrationStatistics;
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // =============================================================================================
+    //  Base functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_Version to get the version of the Sense HAT C library.
+    //! 
+    //! @return uint32_t The version of the Sense HAT C library. Note this is not the same as 
+    //! the version of the underlying Sense HAT Python library. The value returned is formatted
+    //! as follows:
+    //!
+    //! Bytes 0 and 1: Major version
+    //!        Byte 2: Minor version
+    //!        Byte 3: Revision
+    //!
+    //! For example, a value of 0x00010000 translates to a version of 1.0.0.
+    //!
+    uint32_t    SenseHAT_Version    (void);
+
+    //! @brief Call SenseHAT_Open to create an instance of the Sense HAT C library.
+    //! 
+    //! All Sense HAT C functions require an instance as their first argument. This function 
+    //! initializes an instance for use with the other Sense HAT C functions. Only one instance 
+    //! can be open at a time (replay instances from SenseHAT_OpenReplay don't count); close it 
+    //! before opening another.
+    //! 
+    //! @param[out] instance A pointer to an instance of the Sense HAT C library. This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to EBUSY indicates that another instance is open.
+    //!
+    int32_t     SenseHAT_Open       (tSenseHAT_Instance*    instance);
+
+    //! @brief Call SenseHAT_OpenReplay to create an instance that is driven from a recorded 
+    //! telemetry log instead of the Sense HAT.
+    //!
+    //! A replay instance doesn't use Python or the hardware, so it works on any build machine.
+    //! SenseHAT_GetHumidity, SenseHAT_GetTemperature, SenseHAT_GetPressure, SenseHAT_GetCompass,
+    //! SenseHAT_GetAccelerometerRaw, SenseHAT_GetGyroscopeRaw, SenseHAT_GetCompassRaw, 
+    //! SenseHAT_GetOrientation (and the degrees/radians variants), 
+    //! SenseHAT_GetTemperatureFromHumidity, SenseHAT_GetTemperatureFromPressure, 
+    //! SenseHAT_GetChannels, the sampler, SenseHAT_GetEvents, SenseHAT_GetEventsInto and
+    //! SenseHAT_WaitForEvent serve the recorded values; the other functions fail.
+    //!
+    //! When speed is greater than 0, the log plays against the clock, starting at the first 
+    //! record when the instance is opened: each call returns the latest recorded value at that
+    //! point of the log. A speed of 1.0 plays in real time, and a speed of 10.0 plays ten times 
+    //! faster. With kSenseHAT_ReplayAsFastAsPossible, each read of a channel returns the next
+    //! recorded value of that channel, and SenseHAT_WaitForEvent never sleeps. Either way, 
+    //! reads return ENODATA once the log is finished.
+    //!
+    //! @param[in] directory The directory holding the log segments written by the recorder. 
+    //! This argument must not be NULL.
+    //! @param[in] speed The playback speed, or kSenseHAT_ReplayAsFastAsPossible. This argument
+    //! must not be negative.
+    //! @param[out] instance A pointer to an instance of the Sense HAT C library. This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to ENODATA indicates that the log is empty.
+    //!
+    int32_t     SenseHAT_OpenReplay (const char*            directory,
+                                     double                 speed,
+                                     tSenseHAT_Instance*    instance);
+
+    //! @brief Call SenseHAT_Close to close an instance of the Sense HAT C library.
+    //! 
+    //! This function is responsible for releasing all resources reserved by the Sense HAT C 
+    //! library instance, including memory and references to Python functions.
+    //! 
+    //! @param[in] instance A pointer to an instance of the Sense HAT C library. This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_Close      (tSenseHAT_Instance*    instance);
+
+    // =============================================================================================
+    //  High level LED matrix functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_LEDSetRotation to rotate the LED matrix.
+    //!
+    //! Use this function to adjust the orientation of the LED matrix in the event your Raspberry
+    //! Pi is upside down or sideways.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] rotation The angle in degrees to rotate the LED matrix through. The only 
+    //! valid values are those defined in the tSenseHAT_LEDRotation enumeration.
+    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDSetRotation     (const tSenseHAT_Instance      instance,
+                                             tSenseHAT_LEDRotation         rotation,
+                                             bool                          redraw);
+
+    //! @brief Call SenseHAT_LEDFlipHorizontal to flip the LED matrix horizontally.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
+    //! @param[out] pixels An LED pixel array containing the flipped pixels. If you don't need 
+    //! this array, pass NULL in this argument.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDFlipHorizontal  (const tSenseHAT_Instance      instance,
+                                             bool                          redraw,
+                                             tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_LEDFlipVertical to flip the LED matrix vertically.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
+    //! @param[out] pixels An LED pixel array containing the flipped pixels. If you don't need 
+    //! this array, pass NULL in this argument.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDFlipVertical    (const tSenseHAT_Instance      instance,
+                                             bool                          redraw,
+                                             tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_LEDSetPixels to set the color of every LED in the LED matrix.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] pixels An array containing 64 LED pixels. If you pass NULL for this argument,
+    //! then the LED matrix will be cleared (all LED pixels colors set to red:green:blue equal to
+    //! 0:0:0 (off)).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDSetPixels       (const tSenseHAT_Instance      instance,
+                                             const tSenseHAT_LEDPixelArray pixels);
+
+    //! @brief Call SenseHAT_LEDGetPixels to get the color of every LED in the display.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] pixels An LED pixel array containing the current state of the pixels in the
+    //! LED matrix. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDGetPixels       (const tSenseHAT_Instance      instance,
+                                             tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_LEDSetPixel to set the color of a specific LED in the LED matrix.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] xPosition X coordinate in the LED matrix. Valid values are between 0 and 7
+    //! (inclusive); 0 is on the left, 7 is on the right.
+    //! @param[in] yPosition Y coordinate in the LED matrix. Valid values are between 0 and 7
+    //! (inclusive); 0 is at the top, 7 is on the bottom.
+    //! @param[in] color LED pixel color. Pass NULL in this argument to set the LED pixel
+    //! color to red:green:blue equal to 0:0:0 (off).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDSetPixel        (const tSenseHAT_Instance      instance,
+                                             int32_t                       xPosition,
+                                             int32_t                       yPosition,
+                                             const tSenseHAT_LEDPixel*     color);
+
+    //! @brief Call SenseHAT_LEDSetPixelBatch to set the colors of several LEDs in the LED matrix
+    //! at once.
+    //!
+    //! Every update is checked before any is applied. Updates are applied in order, so a later 
+    //! update of the same LED wins. With the LED matrix framebuffer available, the LEDs are set 
+    //! with a single write that skips those already showing their new color; otherwise the LED 
+    //! matrix is read, changed and written back through Python in one pass.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] updates The updates. Every coordinate and color must be valid. This argument 
+    //! must not be NULL.
+    //! @param[in] updateCount The number of updates.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDSetPixelBatch   (const tSenseHAT_Instance          instance,
+                                             const tSenseHAT_LEDPixelUpdate*   updates,
+                                             uint32_t                          updateCount);
+
+    //! @brief Call SenseHAT_LEDGetPixel to get the color of a specific LED in the display.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] xPosition X coordinate in the LED matrix. Valid values are between 0 and 7
+    //! (inclusive); 0 is on the left, 7 is on the right.
+    //! @param[in] yPosition Y coordinate in the LED matrix. Valid values are between 0 and 7
+    //! (inclusive); 0 is at the top, 7 is at the bottom.
+    //! @param[out] color LED pixel color. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDGetPixel        (const tSenseHAT_Instance      instance,
+                                             int32_t                       xPosition,
+                                             int32_t                       yPosition,
+                                             tSenseHAT_LEDPixel*           color);
+
+    //! @brief Call SenseHAT_LEDDecodeImage to decode an 8x8 pixel image file into an LED pixel 
+    //! array.
+    //!
+    //! PNG (non-interlaced, any bit depth and color type), binary and ASCII PPM/PGM, and 
+    //! uncompressed 1, 4, 8, 24 and 32 bit BMP files are decoded natively; alpha channels are
+    //! dropped. Decoded images are kept in a process-wide cache keyed by path and modification
+    //! time, so decoding an unchanged file again costs a stat() and a copy.
+    //!
+    //! @param[in] imageFilePath File path to image file. This argument must not be NULL.
+    //! @param[out] pixels An LED pixel array that receives the image. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success. A value equal to EINVAL also indicates that the image is not 8x8
+    //! pixels in size. A value equal to ENOTSUP indicates that the file is not in a supported 
+    //! format, and EPROTO that it is corrupt.
+    //!
+    int32_t     SenseHAT_LEDDecodeImage     (const char*                   imageFilePath,
+                                             tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_LEDLoadImage to display a 8x8 pixel images on the LED display.
+    //! 
+    //! The image is decoded with SenseHAT_LEDDecodeImage; files in other formats are handed to
+    //! the Python library, which decodes them with PIL.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] imageFilePath File path to image file. The image must be 8x8 pixels in size.
+    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
+    //! @param[out] pixels An LED pixel array containing the image. If you don't need this
+    //! array, pass NULL in this argument.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDLoadImage       (const tSenseHAT_Instance      instance,
+                                             const char*                   imageFilePath,
+                                             bool                          redraw,
+                                             tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_SpriteAtlasOpen to load a sprite sheet into a sprite atlas.
+    //!
+    //! The sheet is decoded once, in any of the formats SenseHAT_LEDDecodeImage supports, and cut
+    //! into contiguous packed 8x8 frames.
+    //!
+    //! @param[in] imageFilePath File path to the sprite sheet. Its width and height must be
+    //! multiples of 8, holding at most kSenseHAT_SpriteAtlasFramesMax frames. This argument must 
+    //! not be NULL.
+    //! @param[out] atlas The sprite atlas. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EINVAL also indicates that the sheet has the wrong
+    //! size.
+    //!
+    int32_t     SenseHAT_SpriteAtlasOpen            (const char*                   imageFilePath,
+                                                     tSenseHAT_SpriteAtlas*        atlas);
+
+    //! @brief Call SenseHAT_SpriteAtlasGetFrameCount to get the number of frames in a sprite 
+    //! atlas.
+    //!
+    //! @param[in] atlas The sprite atlas.
+    //! @param[out] frameCount The number of frames. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SpriteAtlasGetFrameCount   (const tSenseHAT_SpriteAtlas   atlas,
+                                                     uint32_t*                     frameCount);
+
+    //! @brief Call SenseHAT_SpriteAtlasGetFrame to get a frame of a sprite atlas.
+    //!
+    //! @param[in] atlas The sprite atlas.
+    //! @param[in] frameIndex The frame index. This argument must be less than the frame count.
+    //! @param[out] pixels An LED pixel array that receives the frame. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SpriteAtlasGetFrame        (const tSenseHAT_SpriteAtlas   atlas,
+                                                     uint32_t                      frameIndex,
+                                                     tSenseHAT_LEDPixelArray       pixels);
+
+    //! @brief Call SenseHAT_SpriteAtlasClose to release a sprite atlas.
+    //!
+    //! @param[in,out] atlas The sprite atlas; set to NULL on return. This argument must not be 
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SpriteAtlasClose           (tSenseHAT_SpriteAtlas*        atlas);
+
+    //! @brief Call SenseHAT_LEDShowSprite to display a frame of a sprite atlas on the LED display.
+    //!
+    //! The frame is read straight from the atlas; nothing is decoded or copied ahead of the LED
+    //! matrix update.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] atlas The sprite atlas.
+    //! @param[in] frameIndex The frame index. This argument must be less than the frame count.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDShowSprite              (const tSenseHAT_Instance      instance,
+                                                     const tSenseHAT_SpriteAtlas   atlas,
+                                                     uint32_t                      frameIndex);
+
+    //! @brief Call SenseHAT_LEDClear to reset all the pixels of the LED display to a specific color.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] color LED color. Pass NULL in this argument to clear the LED matrix with 
+    //! red:green:blue equal to 0:0:0 (off).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDClear           (const tSenseHAT_Instance      instance,
+                                             const tSenseHAT_LEDPixel*     color);
+
+    //! @brief Call SenseHAT_LEDShowMessage to scroll a message from right to left on the LED 
+    //! display at the specified speed, with the specified text and background colors.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] message Message to show.
+    //! @param[in] scrollSpeed Scroll speed in fractional seconds.
+    //! @param[in] textColor Color of text. Pass NULL in this argument to use a text color of
+    //! red:green:blue equal to 255:255:255 (white).
+    //! @param[in] backColor Color of background. Pass NULL in this argument to use a back color
+    //! of red:green:blue equal to 0:0:0 (off).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDShowMessage     (const tSenseHAT_Instance      instance,
+                                             const char*                   message,
+                                             double                        scrollSpeed,
+                                             const tSenseHAT_LEDPixel*     textColor,
+                                             const tSenseHAT_LEDPixel*     backColor);
+
+    //! @brief Call SenseHAT_LEDShowLetter to show a letter on the LED display with the specified
+    //! text and background colors.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] letter Letter to show. This must be a single ASCII character - multiple
+    //! characters are not allowed.
+    //! @param[in] textColor Color of text. Pass NULL in this argument to use a text color of
+    //! red:green:blue equal to 255:255:255 (white).
+    //! @param[in] backColor Color of background. Pass NULL in this argument to use a back color
+    //! of red:green:blue equal to 0:0:0 (off).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDShowLetter      (const tSenseHAT_Instance      instance,
+                                             const char*                   letter,
+                                             const tSenseHAT_LEDPixel*     textColor,
+                                             const tSenseHAT_LEDPixel*     backColor);
+
+    // =============================================================================================
+    //  Low level LED matrix functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_LEDGammaReset to reset the LED matrix gamma lookup table to
+    //! its default configuration.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDGammaReset     (const tSenseHAT_Instance   instance);
+
+    //! @brief Call SenseHAT_LEDGammaGet to get the LED matrix gamma lookup table.
+    //!
+    //! The LED matrix driver maps the 5-bit level of each color component through this table 
+    //! to the brightness the LED is driven at, from 0 to 31.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] gamma The gamma table, kSenseHAT_GammaTableSize entries. This argument must 
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODEV indicates that the LED matrix framebuffer
+    //! isn't available.
+    //!
+    int32_t     SenseHAT_LEDGammaGet       (const tSenseHAT_Instance   instance,
+                                            uint8_t*                   gamma);
+
+    //! @brief Call SenseHAT_LEDGammaSet to replace the LED matrix gamma lookup table.
+    //!
+    //! The table takes effect in the driver, so it changes the whole LED matrix at once and 
+    //! costs nothing per frame.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] gamma The gamma table, kSenseHAT_GammaTableSize entries, each between 0 and 31
+    //! (inclusive). This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODEV indicates that the LED matrix framebuffer
+    //! isn't available.
+    //!
+    int32_t     SenseHAT_LEDGammaSet       (const tSenseHAT_Instance   instance,
+                                            const uint8_t*             gamma);
+
+    //! @brief Call SenseHAT_LEDSetLowLight to switch the LED matrix between the driver's default
+    //! and low light gamma lookup tables.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] lowLight Whether to use the low light gamma table.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODEV indicates that the LED matrix framebuffer
+    //! isn't available.
+    //!
+    int32_t     SenseHAT_LEDSetLowLight    (const tSenseHAT_Instance   instance,
+                                            bool                       lowLight);
+
+    //! @brief Call SenseHAT_LEDSetBrightness to dim the whole LED matrix.
+    //!
+    //! The driver's default gamma lookup table is scaled by the brightness and set with 
+    //! SenseHAT_LEDGammaSet, so frames don't need to be scaled in software. Levels that are lit
+    //! at full brightness stay lit at the lowest drive level while the brightness is above 0.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] brightness The brightness, between 0.0 (off) and 1.0 (inclusive).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODEV indicates that the LED matrix framebuffer
+    //! isn't available.
+    //!
+    int32_t     SenseHAT_LEDSetBrightness  (const tSenseHAT_Instance   instance,
+                                            double                     brightness);
+
+    // =============================================================================================
+    //  Animation functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_AnimationStart to play an animation on the LED matrix.
+    //!
+    //! The frames are copied and played by a dedicated thread, which schedules each frame against
+    //! absolute deadlines on the monotonic clock, so a slow LED update delays one frame rather 
+    //! than the rest of the sequence. Frames whose slot has passed are dropped. A finished 
+    //! animation leaves its last frame on the LED matrix.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] frames The frames. Every frame must have valid pixels and a duration greater 
+    //! than 0. This argument must not be NULL.
+    //! @param[in] frameCount The number of frames. This argument must be greater than 0.
+    //! @param[in] loop Whether to start again from the first frame after the last.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EBUSY indicates that an animation is already 
+    //! playing.
+    //!
+    int32_t     SenseHAT_AnimationStart             (const tSenseHAT_Instance           instance,
+                                                     const tSenseHAT_AnimationFrame*    frames,
+                                                     uint32_t                           frameCount,
+                                                     bool                               loop);
+
+    //! @brief Call SenseHAT_AnimationStop to stop the animation playing on the LED matrix.
+    //!
+    //! The frame being shown is left on the LED matrix. Stopping an animation that has finished,
+    //! or that was never started, succeeds.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_AnimationStop              (const tSenseHAT_Instance           instance);
+
+    //! @brief Call SenseHAT_AnimationGetStatistics to find out how closely the current or most 
+    //! recent animation kept to its schedule.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] statistics The statistics. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_AnimationGetStatistics     (const tSenseHAT_Instance           instance,
+                                                     tSenseHAT_AnimationStatistics*     statistics);
+
+    // =============================================================================================
+    //  Compositor functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_CompositorOpen to create a compositor for the LED matrix.
+    //!
+    //! Layers start out fully transparent, with an opacity of 1.0, and stacked in index order 
+    //! with layer 0 at the bottom. Whenever a layer change alters the composited frame, the frame
+    //! is written to the LED matrix; changes that leave it as it was cost nothing more.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library. Pass NULL in this argument to
+    //! composite off screen, and read the result with SenseHAT_CompositorGetFrame.
+    //! @param[in] layerCount The number of layers. This argument must be between 1 and 
+    //! kSenseHAT_CompositorLayersMax (inclusive).
+    //! @param[out] compositor The compositor. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_CompositorOpen             (const tSenseHAT_Instance       instance,
+                                                     uint32_t                       layerCount,
+                                                     tSenseHAT_Compositor*          compositor);
+
+    //! @brief Call SenseHAT_CompositorSetLayer to replace the contents of a compositor layer.
+    //!
+    //! @param[in] compositor The compositor.
+    //! @param[in] layer The layer index. This argument must be less than the layer count.
+    //! @param[in] pixels The layer contents. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. Other values are from the LED matrix update.
+    //!
+    int32_t     SenseHAT_CompositorSetLayer         (const tSenseHAT_Compositor     compositor,
+                                                     uint32_t                       layer,
+                                                     const tSenseHAT_RGBAPixelArray pixels);
+
+    //! @brief Call SenseHAT_CompositorSetLayerOpacity to change the opacity of a compositor layer.
+    //!
+    //! The opacity scales the alpha of every pixel in the layer.
+    //!
+    //! @param[in] compositor The compositor.
+    //! @param[in] layer The layer index. This argument must be less than the layer count.
+    //! @param[in] opacity The opacity, between 0.0 (hidden) and 1.0 (inclusive).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. Other values are from the LED matrix update.
+    //!
+    int32_t     SenseHAT_CompositorSetLayerOpacity  (const tSenseHAT_Compositor     compositor,
+                                                     uint32_t                       layer,
+                                                     double                         opacity);
+
+    //! @brief Call SenseHAT_CompositorSetLayerOrder to change where a layer sits in the stack.
+    //!
+    //! Layers are drawn from the lowest order to the highest; layers with equal orders are drawn
+    //! in index order.
+    //!
+    //! @param[in] compositor The compositor.
+    //! @param[in] layer The layer index. This argument must be less than the layer count.
+    //! @param[in] order The z-order of the layer.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. Other values are from the LED matrix update.
+    //!
+    int32_t     SenseHAT_CompositorSetLayerOrder    (const tSenseHAT_Compositor     compositor,
+                                                     uint32_t                       layer,
+                                                     int32_t                        order);
+
+    //! @brief Call SenseHAT_CompositorGetFrame to get the composited frame.
+    //!
+    //! @param[in] compositor The compositor.
+    //! @param[out] pixels An LED pixel array that receives the frame. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_CompositorGetFrame         (const tSenseHAT_Compositor     compositor,
+                                                     tSenseHAT_LEDPixelArray        pixels);
+
+    //! @brief Call SenseHAT_CompositorClose to release a compositor. The LED matrix is left as it
+    //! is.
+    //!
+    //! @param[in,out] compositor The compositor; set to NULL on return. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_CompositorClose            (tSenseHAT_Compositor*          compositor);
+
+    // =============================================================================================
+    //  Color conversion functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_ColorTableInitialize to precompute a color conversion table.
+    //!
+    //! Each component is scaled by the brightness, quantized to the 5 (red and blue) or 6 (green) 
+    //! bits of an RGB565 pixel, and then, if there's a gamma table, mapped through it the same 
+    //! way the LED matrix driver does. Green is mapped at 5 bits and widened back to 6.
+    //!
+    //! @param[out] table The color conversion table. This argument must not be NULL.
+    //! @param[in] gamma A gamma table of kSenseHAT_GammaTableSize entries, each between 0 and 31 
+    //! (inclusive). Pass NULL in this argument for none; the LED matrix driver applies its own 
+    //! gamma table, so most content shouldn't have one applied in software too.
+    //! @param[in] brightness The brightness, between 0.0 and 1.0 (inclusive).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ColorTableInitialize       (tSenseHAT_ColorTable*          table,
+                                                     const uint8_t*                 gamma,
+                                                     double                         brightness);
+
+    //! @brief Call SenseHAT_ColorConvertFrames to convert LED pixel arrays to RGB565 pixels.
+    //!
+    //! Tables without a gamma table are converted eight pixels at a time with NEON or SSE2 where
+    //! available; the rest are converted through the lookup tables.
+    //!
+    //! @param[in] table The color conversion table. Pass NULL in this argument to convert at full
+    //! brightness without a gamma table, as the Python library does.
+    //! @param[in] frames The LED pixel arrays. Every pixel must be valid. This argument must not
+    //! be NULL.
+    //! @param[in] frameCount The number of LED pixel arrays.
+    //! @param[out] output 64 RGB565 pixels for each LED pixel array, in the same order. This 
+    //! argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ColorConvertFrames         (const tSenseHAT_ColorTable*    table,
+                                                     const tSenseHAT_LEDPixelArray* frames,
+                                                     uint32_t                       frameCount,
+                                                     uint16_t*                      output);
+
+    //! @brief Call SenseHAT_ColorConvertRGB888 to convert packed RGB888 pixels to RGB565 pixels.
+    //!
+    //! @param[in] table The color conversion table. Pass NULL in this argument to convert at full
+    //! brightness without a gamma table.
+    //! @param[in] rgb The pixels, as red, green and blue bytes. This argument must not be NULL.
+    //! @param[in] pixelCount The number of pixels.
+    //! @param[out] output The RGB565 pixels. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ColorConvertRGB888         (const tSenseHAT_ColorTable*    table,
+                                                     const uint8_t*                 rgb,
+                                                     uint32_t                       pixelCount,
+                                                     uint16_t*                      output);
+
+    // =============================================================================================
+    //  Palette functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_PaletteInitialize to set up a palette for palette-indexed frames.
+    //!
+    //! @param[out] palette The palette. This argument must not be NULL.
+    //! @param[in] colors The colors. Every color must be valid. This argument must not be NULL.
+    //! @param[in] colorCount The number of colors. This argument must be between 1 and 
+    //! kSenseHAT_PaletteColorsMax (inclusive).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_PaletteInitialize          (tSenseHAT_Palette*             palette,
+                                                     const tSenseHAT_LEDPixel*      colors,
+                                                     uint32_t                       colorCount);
+
+    //! @brief Call SenseHAT_PaletteEncodeFrame to convert an LED pixel array to a palette-indexed
+    //! frame.
+    //!
+    //! @param[in] palette The palette.
+    //! @param[in] pixels The LED pixel array. This argument must not be NULL.
+    //! @param[in] indexSize The index size of the frame.
+    //! @param[out] indices The frame, 32 or 64 bytes depending on the index size. This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EINVAL also indicates that a pixel's color isn't 
+    //! one of the palette colors the index size can reach.
+    //!
+    int32_t     SenseHAT_PaletteEncodeFrame         (const tSenseHAT_Palette*       palette,
+                                                     const tSenseHAT_LEDPixelArray  pixels,
+                                                     tSenseHAT_PaletteIndexSize     indexSize,
+                                                     uint8_t*                       indices);
+
+    //! @brief Call SenseHAT_PaletteExpandFrame to convert a palette-indexed frame to an LED pixel
+    //! array. Indices past the last palette color are expanded to off.
+    //!
+    //! @param[in] palette The palette.
+    //! @param[in] indices The frame. This argument must not be NULL.
+    //! @param[in] indexSize The index size of the frame.
+    //! @param[out] pixels The LED pixel array. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_PaletteExpandFrame         (const tSenseHAT_Palette*       palette,
+                                                     const uint8_t*                 indices,
+                                                     tSenseHAT_PaletteIndexSize     indexSize,
+                                                     tSenseHAT_LEDPixelArray        pixels);
+
+    //! @brief Call SenseHAT_PaletteExpandRGB565 to convert palette-indexed frames to the RGB565 
+    //! pixels of the LED matrix framebuffer. Indices past the last palette color are expanded to
+    //! off.
+    //!
+    //! @param[in] palette The palette.
+    //! @param[in] indices The frames, one after another. This argument must not be NULL.
+    //! @param[in] indexSize The index size of the frames.
+    //! @param[in] frameCount The number of frames.
+    //! @param[out] output 64 RGB565 pixels for each frame, in the same order. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_PaletteExpandRGB565        (const tSenseHAT_Palette*       palette,
+                                                     const uint8_t*                 indices,
+                                                     tSenseHAT_PaletteIndexSize     indexSize,
+                                                     uint32_t                       frameCount,
+                                                     uint16_t*                      output);
+
+    //! @brief Call SenseHAT_LEDShowPaletteFrame to display a palette-indexed frame on the LED 
+    //! display.
+    //!
+    //! With the LED matrix framebuffer available, the frame is expanded straight to RGB565 and 
+    //! written without ever being an LED pixel array.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] palette The palette.
+    //! @param[in] indices The frame. This argument must not be NULL.
+    //! @param[in] indexSize The index size of the frame.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_LEDShowPaletteFrame        (const tSenseHAT_Instance       instance,
+                                                     const tSenseHAT_Palette*       palette,
+                                                     const uint8_t*                 indices,
+                                                     tSenseHAT_PaletteIndexSize     indexSize);
+
+    // =============================================================================================
+    //  Clip functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_ClipWrite to write an animation to a clip file.
+    //!
+    //! Each frame is stored as the run-length encoded pixels that changed since the frame before
+    //! it, unless a keyframe is due or a whole run-length encoded frame would be smaller. Frames
+    //! are stored as RGB565 pixels, so colors are rounded the same way as on the LED matrix. The
+    //! file is written alongside the path and renamed into place once it's complete.
+    //!
+    //! @param[in] path The path of the clip file. This argument must not be NULL.
+    //! @param[in] frames The frames. Every pixel must be valid, and every duration must be greater
+    //! than 0 and less than 4294 seconds. This argument must not be NULL.
+    //! @param[in] frameCount The number of frames. This argument must be greater than 0.
+    //! @param[in] keyframeInterval How often, in frames, a keyframe is stored regardless. Pass 0 
+    //! in this argument to store only the first frame as a keyframe; random access to later
+    //! frames then decodes everything before them.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ClipWrite                  (const char*                        path,
+                                                     const tSenseHAT_AnimationFrame*    frames,
+                                                     uint32_t                           frameCount,
+                                                     uint32_t                           keyframeInterval);
+
+    //! @brief Call SenseHAT_ClipOpen to open a clip file.
+    //!
+    //! @param[in] path The path of the clip file. This argument must not be NULL.
+    //! @param[out] clip The clip. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EPROTO indicates that the file isn't a clip file, 
+    //! or is truncated.
+    //!
+    int32_t     SenseHAT_ClipOpen                   (const char*                        path,
+                                                     tSenseHAT_Clip*                    clip);
+
+    //! @brief Call SenseHAT_ClipGetFrameCount to find out how many frames a clip holds.
+    //!
+    //! @param[in] clip The clip.
+    //! @param[out] frameCount The number of frames. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ClipGetFrameCount          (const tSenseHAT_Clip               clip,
+                                                     uint32_t*                          frameCount);
+
+    //! @brief Call SenseHAT_ClipGetFrame to decode a frame of a clip.
+    //!
+    //! Getting the frame after the last one decoded only decodes the pixels that changed; any 
+    //! other frame is decoded from the keyframe before it.
+    //!
+    //! @param[in] clip The clip.
+    //! @param[in] frameIndex The index of the frame. This argument must be less than the number of
+    //! frames.
+    //! @param[out] pixels The frame, 64 RGB565 pixels. This argument must not be NULL.
+    //! @param[out] duration How long the frame is shown, in fractional seconds. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EPROTO indicates that the frame is corrupt.
+    //!
+    int32_t     SenseHAT_ClipGetFrame               (const tSenseHAT_Clip               clip,
+                                                     uint32_t                           frameIndex,
+                                                     uint16_t*                          pixels,
+                                                     double*                            duration);
+
+    //! @brief Call SenseHAT_LEDShowClipFrame to display a frame of a clip on the LED display.
+    //!
+    //! With the LED matrix framebuffer available, only the pixels that differ from what the LED 
+    //! matrix shows are written, and a frame that matches it isn't written at all. Otherwise the
+    //! whole frame is written through Python.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] clip The clip.
+    //! @param[in] frameIndex The index of the frame. This argument must be less than the number of
+    //! frames.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EPROTO indicates that the frame is corrupt.
+    //!
+    int32_t     SenseHAT_LEDShowClipFrame           (const tSenseHAT_Instance           instance,
+                                                     const tSenseHAT_Clip               clip,
+                                                     uint32_t                           frameIndex);
+
+    //! @brief Call SenseHAT_ClipClose to close a clip.
+    //!
+    //! @param[in,out] clip The clip; set to NULL on return. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ClipClose                  (tSenseHAT_Clip*                    clip);
+
+    // =============================================================================================
+    //  Stream functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_StreamStart to show raw frames read from a file descriptor on the LED
+    //! matrix at a fixed frame rate.
+    //!
+    //! A reader thread reads whole frames into a ring of bufferFrames frames, and a presenter 
+    //! thread takes the oldest out at every frame slot, scheduled against absolute deadlines on 
+    //! the monotonic clock. When the ring is full, a new frame replaces the oldest one, so a 
+    //! producer running ahead of the display never holds it back; regular files are the 
+    //! exception, and are read only as fast as they're shown. With the LED matrix framebuffer 
+    //! available, frames are written without Python. The stream finishes once the end of the 
+    //! stream is reached and the ring is empty; a trailing partial frame is ignored.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] fd The file descriptor, such as 0 for stdin, a FIFO or a file. It stays open, 
+    //! and must not be closed until the stream finishes or is stopped.
+    //! @param[in] format The frame format.
+    //! @param[in] fps The frame rate. This argument must be greater than 0 and no greater than
+    //! kSenseHAT_StreamFrameRateMax.
+    //! @param[in] bufferFrames The number of frames to buffer. This argument must be between 1 and
+    //! kSenseHAT_StreamBufferFramesMax (inclusive).
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EBUSY indicates that a stream is already playing.
+    //!
+    int32_t     SenseHAT_StreamStart                (const tSenseHAT_Instance           instance,
+                                                     int32_t                            fd,
+                                                     tSenseHAT_StreamFormat             format,
+                                                     double                             fps,
+                                                     uint32_t                           bufferFrames);
+
+    //! @brief Call SenseHAT_StreamStop to stop the stream playing on the LED matrix.
+    //!
+    //! Frames still buffered are discarded, and the frame being shown is left on the LED matrix.
+    //! Stopping a stream that has finished, or that was never started, succeeds.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_StreamStop                 (const tSenseHAT_Instance           instance);
+
+    //! @brief Call SenseHAT_StreamGetStatistics to find out how the current or most recent stream
+    //! has kept up.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] statistics The statistics. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_StreamGetStatistics        (const tSenseHAT_Instance           instance,
+                                                     tSenseHAT_StreamStatistics*        statistics);
+
+    // =============================================================================================
+    //  High level environmental functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_GetHumidity to read the humidity in percent relative humidity.
     //! 
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] xPosition X coordinate in the LED matrix. Valid values are between 0 and 7
-    //! (inclusive); 0 is on the left, 7 is on the right.
-    //! @param[in] yPosition Y coordinate in the LED matrix. Valid values are between 0 and 7
-    //! (inclusive); 0 is at the top, 7 is on the bottom.
-    //! @param[in] color LED pixel color. Pass NULL in this argument to set the LED pixel
-    //! color to red:green:blue equal to 0:0:0 (off).
+    //! @param[out] percentRelativeHumidity Humidity in percent relative humidity. This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetHumidity    (const tSenseHAT_Instance   instance,
+                                         double*                    percentRelativeHumidity);
+
+    //! @brief Call SenseHAT_GetTemperature to read the temperature in degrees Celsius.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetTemperature (const tSenseHAT_Instance   instance,
+                                         double*                    degreesCelsius);
+
+    //! @brief Call SenseHAT_GetPressure to read the pressure in millibars.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] millibars Pressure in millibars. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetPressure    (const tSenseHAT_Instance   instance,
+                                         double*                    millibars);
+
+    //! @brief Call SenseHAT_GetCompass to read the compass heading in degrees.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] degrees Heading in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetCompass     (const tSenseHAT_Instance   instance,
+                                         double*                    degrees);
+
+    // =============================================================================================
+    //  Low level environmental functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_GetAccelerometer to get the current orientation from the accelerometer
+    //! only by disabling the magnetometer and the gyroscope.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetAccelerometer           (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_Orientation*     orientation);
+
+    //! @brief Call SenseHAT_GetAccelerometerRaw to get the raw x, y and z accelerometer data.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] rawData Raw x, y and z accelerometer data in G's. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetAccelerometerRaw        (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_RawData*         rawData);
+
+    //! @brief Call SenseHAT_GetCompassRaw to get the raw x, y and z magnetometer data.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] rawData Raw x, y and z magnetometer data in microteslas (µT). This argument
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetCompassRaw              (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_RawData*         rawData);
+
+    //! @brief Call SenseHAT_GetGyroscope to get the current orientation from the gyroscope
+    //! only by disabling the magnetometer and the accelerometer.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetGyroscope               (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_Orientation*     orientation);
+
+    //! @brief Call SenseHAT_GetGyroscopeRaw to get the raw x, y, and z gyroscope data.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] rawData Raw x, y and z gyroscope data in radians/second. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetGyroscopeRaw            (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_RawData*         rawData);
+
+    //! @brief Call SenseHAT_GetOrientation to get the current orientation in degrees.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetOrientation             (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_Orientation*     orientation);
+
+    //! @brief Call SenseHAT_GetOrientationDegrees to get the current orientation in degrees
+    //! using the aircraft principal axes of pitch, roll, and yaw.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetOrientationDegrees      (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_Orientation*     orientation);
+
+    //! @brief Call SenseHAT_GetOrientationRadians to get the current orientation in radians
+    //! using the aircraft principal axes of pitch, roll, and yaw.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetOrientationRadians      (const tSenseHAT_Instance   instance,
+                                                     tSenseHAT_Orientation*     orientation);
+
+    //! @brief Call SenseHAT_GetTemperatureFromHumidity to read the temperature in degrees Celsius
+    //! from the humidity sensor.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetTemperatureFromHumidity (const tSenseHAT_Instance   instance,
+                                                     double*                    degreesCelsius);
+
+    //! @brief Call SenseHAT_GetTemperatureFromPressure to read the temperature in degrees Celsius
+    //! from the pressure sensor.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetTemperatureFromPressure (const tSenseHAT_Instance   instance,
+                                                     double*                    degreesCelsius);
+
+    //! @brief Call SenseHAT_SetIMUConfiguration to enable and/or disable the magnetometer,
+    //! gyroscope, and accelerometer contributions to the "get orientation" functions.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] enableCompass Enable the magnetometer's contribution to orientation.
+    //! @param[in] enableGyroscope Enable the gyroscope's contribution to orientation.
+    //! @param[in] enableAccelerometer Enable the accelerometer's contribution to orientation.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SetIMUConfiguration        (const tSenseHAT_Instance   instance,
+                                                     bool                       enableCompass,
+                                                     bool                       enableGyroscope,
+                                                     bool                       enableAccelerometer);
+
+    // =============================================================================================
+    //  Event functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_GetEvents to get the queue of events that have occurred since the
+    //! last call to SenseHAT_GetEvents or SenseHAT_WaitForEvent.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] eventCount Number of events in queue. This argument must not be NULL.
+    //! @param[out] events Events in event queue.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetEvents      (const tSenseHAT_Instance   instance,
+							             int32_t*                   eventCount,
+                                         tSenseHAT_JoystickEvent**  events);
+
+    //! @brief Call SenseHAT_GetEventsInto to copy the queue of events that have occurred since
+    //! the last call into a caller supplied buffer.
+    //!
+    //! Unlike SenseHAT_GetEvents, this function doesn't allocate memory, so it's suitable for
+    //! input loops that poll at a high rate. When the Sense HAT joystick input device is
+    //! available, events are read from it directly; otherwise they are retrieved through Python.
+    //! Events that don't fit in the buffer are returned by the next call. Python hands over all
+    //! of its events at once, so those that don't fit are held in a queue of 64; if that fills,
+    //! the oldest are dropped and counted by SenseHAT_GetDroppedEventCount.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] events Buffer to receive the events. This argument must not be NULL.
+    //! @param[in] capacity Number of events the buffer can hold. This argument must be greater
+    //! than 0.
+    //! @param[out] eventCount Number of events copied into the buffer. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success, and that no more events are waiting. A value equal to ENOBUFS 
+    //! indicates that the buffer was filled, so more events may be waiting; in this case 
+    //! eventCount is still valid.
+    //!
+    int32_t     SenseHAT_GetEventsInto  (const tSenseHAT_Instance   instance,
+                                         tSenseHAT_JoystickEvent*   events,
+                                         int32_t                    capacity,
+                                         int32_t*                   eventCount);
+
+    //! @brief Call SenseHAT_GetDroppedEventCount to get the number of events SenseHAT_GetEventsInto
+    //! had to drop because they were neither delivered nor queued.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] droppedCount Number of events dropped since the instance was opened. This 
+    //! argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetDroppedEventCount   (const tSenseHAT_Instance   instance,
+                                                 uint64_t*                  droppedCount);
+
+    //! @brief Call SenseHAT_WaitForEvent to block and wait for an event to occur.
+    //! 
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] flushPendingEvents Set to true to flush any pending events.
+    //! @param[out] event The first event that occurs after making this function call.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
     //! to 0 indicates success.
+    //! 
+    int32_t     SenseHAT_WaitForEvent   (const tSenseHAT_Instance   instance,
+                                         bool                       flushPendingEvents,
+                                         tSenseHAT_JoystickEvent*   event);
+
+    //! @brief Call SenseHAT_GetNotificationFd to get a file descriptor that becomes readable when
+    //! joystick events, a new sample, motion events or subscription notifications are available.
     //!
-    int32_t     SenseHAT_LEDSetPixel        (const tSenseHAT_Instance      instance,
-                                             int32_t                       xPosition,
-                                             int32_t                       yPosition,
-                                             const tSenseHAT_LEDPixel*     color);
+    //! Add the descriptor to an epoll, libuv or io_uring event loop for EPOLLIN/POLLIN. Readiness is
+    //! level triggered: the descriptor stays readable until the joystick events have been retrieved
+    //! with SenseHAT_GetEventsInto, the sample has been retrieved with SenseHAT_SamplerGetLatest, 
+    //! and the motion events and notifications have been retrieved with 
+    //! SenseHAT_SamplerGetMotionEvents and SenseHAT_SamplerGetNotifications.
+    //! No library threads are involved. Joystick events are only signalled when the joystick input
+    //! device is available. The descriptor belongs to the instance and is closed by SenseHAT_Close;
+    //! don't close it or read from it.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] notificationFd The notification file descriptor. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetNotificationFd  (const tSenseHAT_Instance   instance,
+                                             int32_t*                   notificationFd);
 
-    //! @brief Call SenseHAT_LEDGetPixel to get the color of a specific LED in the display.
-    //! 
+    //! @brief Call SenseHAT_WaitForSources to block until joystick events, a new sample, motion 
+    //! events, subscription notifications or a caller supplied file descriptor becomes ready, or
+    //! until a timeout expires.
+    //!
+    //! This function sleeps in the kernel; it doesn't poll. It doesn't consume anything - use
+    //! SenseHAT_GetEventsInto to retrieve joystick events, SenseHAT_SamplerGetLatest to retrieve
+    //! the new sample, SenseHAT_SamplerGetMotionEvents to retrieve motion events, 
+    //! SenseHAT_SamplerGetNotifications to retrieve notifications, and read the caller supplied 
+    //! file descriptor (e.g. an eventfd used to signal shutdown) yourself.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] xPosition X coordinate in the LED matrix. Valid values are between 0 and 7
-    //! (inclusive); 0 is on the left, 7 is on the right.
-    //! @param[in] yPosition Y coordinate in the LED matrix. Valid values are between 0 and 7
-    //! (inclusive); 0 is at the top, 7 is at the bottom.
-    //! @param[out] color LED pixel color. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[in] sources The tSenseHAT_WaitSource flags of the sources to wait on. This argument
+    //! must not be eSenseHAT_WaitSourceNone.
+    //! @param[in] userFd File descriptor to wait on when eSenseHAT_WaitSourceUser is set; 
+    //! ignored otherwise.
+    //! @param[in] timeoutMilliseconds Maximum time to wait in milliseconds. Pass a negative value
+    //! to wait indefinitely, or 0 to check the sources without blocking.
+    //! @param[out] readySources The tSenseHAT_WaitSource flags of the sources that are ready. This
+    //! argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ETIMEDOUT indicates that no source became ready
+    //! before the timeout expired. A value equal to ENOTSUP indicates that joystick events were
+    //! requested but the joystick input device isn't available.
+    //!
+    int32_t     SenseHAT_WaitForSources (const tSenseHAT_Instance   instance,
+                                         uint32_t                   sources,
+                                         int32_t                    userFd,
+                                         int32_t                    timeoutMilliseconds,
+                                         uint32_t*                  readySources);
+
+    // =============================================================================================
+    //  Sampler functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_SamplerStart to start acquiring sensor readings on a background 
+    //! thread at a fixed interval.
+    //!
+    //! The sampler calls the corresponding SenseHAT_Get* function for every selected channel and
+    //! publishes the readings as a single sample. Note that sampling eSenseHAT_ChannelCompass
+    //! reconfigures the IMU in the same way that SenseHAT_GetCompass does.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] channels The tSenseHAT_Channel flags of the channels to sample. This argument
+    //! must not be eSenseHAT_ChannelNone.
+    //! @param[in] intervalSeconds Sampling interval in fractional seconds. This argument must be
+    //! greater than 0.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EBUSY indicates that the sampler is already
+    //! running.
+    //!
+    int32_t     SenseHAT_SamplerStart       (const tSenseHAT_Instance   instance,
+                                             uint32_t                   channels,
+                                             double                     intervalSeconds);
+
+    //! @brief Call SenseHAT_SamplerStop to stop the sampler.
+    //!
+    //! This function waits for the sampler thread to finish. It's safe to call it when the 
+    //! sampler isn't running.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDGetPixel        (const tSenseHAT_Instance      instance,
-                                             int32_t                       xPosition,
-                                             int32_t                       yPosition,
-                                             tSenseHAT_LEDPixel*           color);
+    int32_t     SenseHAT_SamplerStop        (const tSenseHAT_Instance   instance);
 
-    //! @brief Call SenseHAT_LEDLoadImage to display a 8x8 pixel images on the LED display.
-    //! 
+    //! @brief Call SenseHAT_SamplerGetLatest to get the most recent sample.
+    //!
+    //! Calling this function also acknowledges the sample, so eSenseHAT_WaitSourceSampler won't
+    //! be reported as ready again until the next sample is acquired.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] imageFilePath File path to image file. The image must be 8x8 pixels in size.
-    //! @param[in] redraw Whether to redraw what is already being displayed on the LED matrix.
-    //! @param[out] pixels An LED pixel array containing the image. If you don't need this
-    //! array, pass NULL in this argument.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[out] sample The most recent sample. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that no sample has been 
+    //! acquired yet.
+    //!
+    int32_t     SenseHAT_SamplerGetLatest   (const tSenseHAT_Instance   instance,
+                                             tSenseHAT_Sample*          sample);
+
+    //! @brief Call SenseHAT_SamplerGetRollups to get the rollups of a channel.
+    //!
+    //! The sampler keeps one, minute and hour rollups of the humidity, temperature and pressure 
+    //! readings it acquires. Each reading updates them in constant time, and the last 
+    //! kSenseHAT_RollupBuckets buckets of each resolution are kept, so history can be read 
+    //! without going back to the raw readings. The newest bucket is still being filled.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] channel The channel; must be eSenseHAT_ChannelHumidity, 
+    //! eSenseHAT_ChannelTemperature or eSenseHAT_ChannelPressure.
+    //! @param[in] resolution The bucket duration.
+    //! @param[out] buckets Caller allocated array that receives the newest buckets, oldest first.
+    //! This argument must not be NULL.
+    //! @param[in] capacity The number of buckets that fit in buckets.
+    //! @param[out] bucketCount The number of buckets returned. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDLoadImage       (const tSenseHAT_Instance      instance,
-                                             const char*                   imageFilePath,
-                                             bool                          redraw,
-                                             tSenseHAT_LEDPixelArray       pixels);
+    int32_t     SenseHAT_SamplerGetRollups  (const tSenseHAT_Instance   instance,
+                                             uint32_t                   channel,
+                                             tSenseHAT_RollupResolution resolution,
+                                             tSenseHAT_RollupBucket*    buckets,
+                                             uint32_t                   capacity,
+                                             uint32_t*                  bucketCount);
 
-    //! @brief Call SenseHAT_LEDClear to reset all the pixels of the LED display to a specific color.
-    //! 
+    //! @brief Call SenseHAT_SamplerSetRollupFile to persist the rollups in a file.
+    //!
+    //! If the file exists, the rollups are loaded from it, replacing the current ones. From then
+    //! on, the sampler saves the rollups to the file whenever a minute bucket is complete and 
+    //! when it stops, so a restarted dashboard keeps its history.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] color LED color. Pass NULL in this argument to clear the LED matrix with 
-    //! red:green:blue equal to 0:0:0 (off).
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[in] path The file; NULL stops persisting the rollups.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EPROTO indicates that the file exists but doesn't
+    //! hold rollups; persistence is not enabled.
+    //!
+    int32_t     SenseHAT_SamplerSetRollupFile   (const tSenseHAT_Instance   instance,
+                                                 const char*                path);
+
+    //! @brief Call SenseHAT_SamplerSetFilter to set the filter chain of a channel.
+    //!
+    //! The sampler runs every reading of the channel through the chain; each value of a raw 
+    //! data or orientation reading gets a filter of its own. SenseHAT_SamplerGetLatest still 
+    //! returns the raw readings, and SenseHAT_SamplerGetFiltered the filtered ones. Setting a 
+    //! chain restarts it. Compass and orientation angles are filtered as unit vectors (their
+    //! sine and cosine, each through its own chain) and converted back, so that they wrap 
+    //! around: a heading going from 359 to 1 degree passes through 0, not 180.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] channel The channel; a single tSenseHAT_Channel other than 
+    //! eSenseHAT_ChannelJoystick.
+    //! @param[in] stages The stages of the chain, in the order they're applied. This argument 
+    //! must not be NULL unless stageCount is 0.
+    //! @param[in] stageCount The number of stages, at most kSenseHAT_FilterStagesMax; 0 removes 
+    //! the chain.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDClear           (const tSenseHAT_Instance      instance,
-                                             const tSenseHAT_LEDPixel*     color);
+    int32_t     SenseHAT_SamplerSetFilter   (const tSenseHAT_Instance       instance,
+                                             uint32_t                       channel,
+                                             const tSenseHAT_FilterStage*   stages,
+                                             uint32_t                       stageCount);
 
-    //! @brief Call SenseHAT_LEDShowMessage to scroll a message from right to left on the LED 
-    //! display at the specified speed, with the specified text and background colors.
-    //! 
+    //! @brief Call SenseHAT_SamplerGetFiltered to get the most recent sample, filtered.
+    //!
+    //! The sample is the one SenseHAT_SamplerGetLatest returns, with the readings of every 
+    //! channel that has a filter chain replaced by the filtered values. Unlike 
+    //! SenseHAT_SamplerGetLatest, this function doesn't acknowledge the sample.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] message Message to show.
-    //! @param[in] scrollSpeed Scroll speed in fractional seconds.
-    //! @param[in] textColor Color of text. Pass NULL in this argument to use a text color of
-    //! red:green:blue equal to 255:255:255 (white).
-    //! @param[in] backColor Color of background. Pass NULL in this argument to use a back color
-    //! of red:green:blue equal to 0:0:0 (off).
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[out] sample The most recent filtered sample. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that no sample has been 
+    //! acquired yet.
+    //!
+    int32_t     SenseHAT_SamplerGetFiltered (const tSenseHAT_Instance   instance,
+                                             tSenseHAT_Sample*          sample);
+
+    //! @brief Call SenseHAT_SamplerSetMotionDetection to run a motion detector on the readings
+    //! the sampler acquires.
+    //!
+    //! The detector sees every eSenseHAT_ChannelAccelerometerRaw reading, so the sampler must be
+    //! sampling that channel. Each event is passed to the callback, if there is one, and queued
+    //! for SenseHAT_SamplerGetMotionEvents, which makes eSenseHAT_WaitSourceMotion ready. An 
+    //! application can therefore sleep in SenseHAT_WaitForSources, or on the notification 
+    //! descriptor, until something happens instead of polling the accelerometer. Setting a 
+    //! detector restarts it and discards the queued events.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] configuration The detector configuration; NULL uses the defaults (see 
+    //! SenseHAT_MotionInitialize). Pass a configuration whose detectors member is 
+    //! eSenseHAT_MotionNone to stop detecting.
+    //! @param[in] callback Function called for every event, or NULL.
+    //! @param[in] context Value passed to the callback.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDShowMessage     (const tSenseHAT_Instance      instance,
-                                             const char*                   message,
-                                             double                        scrollSpeed,
-                                             const tSenseHAT_LEDPixel*     textColor,
-                                             const tSenseHAT_LEDPixel*     backColor);
+    int32_t     SenseHAT_SamplerSetMotionDetection  (const tSenseHAT_Instance               instance,
+                                                     const tSenseHAT_MotionConfiguration*   configuration,
+                                                     tSenseHAT_MotionCallback               callback,
+                                                     void*                                  context);
 
-    //! @brief Call SenseHAT_LEDShowLetter to show a letter on the LED display with the specified
-    //! text and background colors.
-    //! 
+    //! @brief Call SenseHAT_SamplerGetMotionEvents to retrieve the queued motion events.
+    //!
+    //! This function doesn't block. The sampler queues up to 32 events; if they aren't retrieved
+    //! in time, the oldest are discarded. Once the queue is empty, eSenseHAT_WaitSourceMotion 
+    //! isn't reported as ready until the next event.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] letter Letter to show. This must be a single ASCII character - multiple
-    //! characters are not allowed.
-    //! @param[in] textColor Color of text. Pass NULL in this argument to use a text color of
-    //! red:green:blue equal to 255:255:255 (white).
-    //! @param[in] backColor Color of background. Pass NULL in this argument to use a back color
-    //! of red:green:blue equal to 0:0:0 (off).
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[out] events Caller allocated array that receives the events, oldest first. This 
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of entries in events. This argument must be greater than 0.
+    //! @param[out] eventCount The number of events written to events. This argument must not be 
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that events was filled and 
+    //! more events are waiting; in this case eventCount is still valid.
+    //!
+    int32_t     SenseHAT_SamplerGetMotionEvents     (const tSenseHAT_Instance               instance,
+                                                     tSenseHAT_MotionEvent*                 events,
+                                                     int32_t                                capacity,
+                                                     int32_t*                               eventCount);
+
+    //! @brief Call SenseHAT_SamplerSubscribe to be notified when the readings of an 
+    //! environmental channel meet a condition.
+    //!
+    //! The sampler evaluates every subscription against each reading it acquires, so any number
+    //! of watchers share one set of sensor reads; the sampler must be sampling the channel. Each 
+    //! notification is passed to the subscription's callback, if it has one, and queued for 
+    //! SenseHAT_SamplerGetNotifications, which makes eSenseHAT_WaitSourceSubscription ready.
+    //! Crossings are relative to the previous reading, so a reading that is already above the
+    //! threshold when the subscription starts isn't reported. Rates are the least squares slope
+    //! of readings spread over the window, and are only reported once the window has filled.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] subscription The subscription. This argument must not be NULL.
+    //! @param[in] callback Function called for every notification of the subscription, or NULL.
+    //! @param[in] context Value passed to the callback.
+    //! @param[out] subscriptionId The identifier of the subscription. This argument must not be 
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOSPC indicates that kSenseHAT_SubscriptionsMax 
+    //! subscriptions already exist.
+    //!
+    int32_t     SenseHAT_SamplerSubscribe           (const tSenseHAT_Instance               instance,
+                                                     const tSenseHAT_Subscription*          subscription,
+                                                     tSenseHAT_SubscriptionCallback         callback,
+                                                     void*                                  context,
+                                                     uint32_t*                              subscriptionId);
+
+    //! @brief Call SenseHAT_SamplerUnsubscribe to remove a subscription.
+    //!
+    //! Notifications of the subscription that are already queued are still delivered by 
+    //! SenseHAT_SamplerGetNotifications. The callback may still be running, or about to run for
+    //! the current sample, when this function returns; stop the sampler first if its context is
+    //! about to be freed.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] subscriptionId The identifier returned by SenseHAT_SamplerSubscribe.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOENT indicates that there's no such 
+    //! subscription.
+    //!
+    int32_t     SenseHAT_SamplerUnsubscribe         (const tSenseHAT_Instance               instance,
+                                                     uint32_t                               subscriptionId);
+
+    //! @brief Call SenseHAT_SamplerGetNotifications to retrieve the queued subscription 
+    //! notifications.
+    //!
+    //! This function doesn't block. The sampler queues up to 64 notifications; if they aren't 
+    //! retrieved in time, the oldest are discarded. Once the queue is empty, 
+    //! eSenseHAT_WaitSourceSubscription isn't reported as ready until the next notification.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[out] notifications Caller allocated array that receives the notifications, oldest
+    //! first. This argument must not be NULL.
+    //! @param[in] capacity The number of entries in notifications. This argument must be greater
+    //! than 0.
+    //! @param[out] notificationCount The number of notifications written to notifications. This
+    //! argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that notifications was filled 
+    //! and more notifications are waiting; in this case notificationCount is still valid.
+    //!
+    int32_t     SenseHAT_SamplerGetNotifications    (const tSenseHAT_Instance               instance,
+                                                     tSenseHAT_Notification*                notifications,
+                                                     int32_t                                capacity,
+                                                     int32_t*                               notificationCount);
+
+    // =============================================================================================
+    //  Filter functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_FilterInitialize to initialize a filter chain.
+    //!
+    //! The first input of each stage fills its history, so a chain starts without a transient.
+    //! Biquad stages are not checked for stability.
+    //!
+    //! @param[out] filter The filter to initialize. This argument must not be NULL.
+    //! @param[in] stages The stages of the chain, in the order they're applied. This argument 
+    //! must not be NULL unless stageCount is 0.
+    //! @param[in] stageCount The number of stages, at most kSenseHAT_FilterStagesMax. A chain 
+    //! without stages passes its input through.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_FilterInitialize   (tSenseHAT_Filter*              filter,
+                                             const tSenseHAT_FilterStage*   stages,
+                                             uint32_t                       stageCount);
+
+    //! @brief Call SenseHAT_FilterReset to forget the inputs a filter chain has seen.
+    //!
+    //! @param[in,out] filter The filter. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_FilterReset        (tSenseHAT_Filter*              filter);
+
+    //! @brief Call SenseHAT_FilterProcess to run a block of values through a filter chain.
+    //!
+    //! Each stage processes the whole block before the next one starts, which keeps its state in
+    //! registers and lets the FIR stages vectorize. Processing a block gives the same results as
+    //! processing its values one at a time.
+    //!
+    //! @param[in,out] filter The filter. This argument must not be NULL.
+    //! @param[in] input The values to filter, oldest first. This argument must not be NULL.
+    //! @param[out] output Caller allocated array that receives the filtered values; it may be the
+    //! same as input. This argument must not be NULL.
+    //! @param[in] count The number of values.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_FilterProcess      (tSenseHAT_Filter*              filter,
+                                             const double*                  input,
+                                             double*                        output,
+                                             uint32_t                       count);
+
+    // =============================================================================================
+    //  Cache functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_SetCacheMaxAge to set the instance's max-age policy for sensor values.
+    //!
+    //! When the policy is greater than 0, SenseHAT_GetHumidity, SenseHAT_GetTemperature,
+    //! SenseHAT_GetPressure, SenseHAT_GetCompass, SenseHAT_GetAccelerometerRaw, 
+    //! SenseHAT_GetGyroscopeRaw, SenseHAT_GetCompassRaw and SenseHAT_GetOrientation return the 
+    //! cached value if it was read no more than maxAgeSeconds ago, instead of going to the 
+    //! sensors. Values read by the sampler also fill the cache. The default policy is 0, which
+    //! always reads the sensors.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] maxAgeSeconds The maximum age of a cached value in fractional seconds. This 
+    //! argument must not be negative.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SetCacheMaxAge         (const tSenseHAT_Instance   instance,
+                                                 double                     maxAgeSeconds);
+
+    //! @brief Call SenseHAT_GetCacheStatistics to get the sensor value cache counters.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] reset Set to true to reset the counters after retrieving them.
+    //! @param[out] statistics The cache counters. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_GetCacheStatistics     (const tSenseHAT_Instance   instance,
+                                                 bool                       reset,
+                                                 tSenseHAT_CacheStatistics* statistics);
+
+    //! @brief Call SenseHAT_GetChannels to get one or more sensor values with a per call max-age
+    //! policy.
+    //!
+    //! Each channel is served from the cache if its value is fresh enough, and read from the
+    //! sensors otherwise. All the channels that need reading are read in a single Python call
+    //! sequence.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! @param[in] channels The tSenseHAT_Channel flags of the values to get. This argument must 
+    //! not be eSenseHAT_ChannelNone.
+    //! @param[in] maxAgeSeconds The maximum age of a cached value in fractional seconds. Pass 0 
+    //! to always read the sensors, or kSenseHAT_CacheMaxAgeDefault to use the instance's policy.
+    //! @param[out] sample The values. Channels that couldn't be read are left out of 
+    //! sample->channels, and sample->timestamp is the time of the oldest value. This argument 
+    //! must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success; otherwise the status of the first channel that couldn't be read.
+    //!
+    int32_t     SenseHAT_GetChannels            (const tSenseHAT_Instance   instance,
+                                                 uint32_t                   channels,
+                                                 double                     maxAgeSeconds,
+                                                 tSenseHAT_Sample*          sample);
+
+    // =============================================================================================
+    //  Recorder functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_RecorderOpen to create a telemetry recorder.
+    //!
+    //! The recorder appends tSenseHAT_Record records to segment files named 
+    //! telemetry-NNNNNNNN.shl in a directory. Appending only copies the record into a memory 
+    //! buffer; a background thread writes the buffer to disk in large batches, so recording 
+    //! never blocks the caller. If the directory already holds segments, recording continues 
+    //! with a new segment after the last one. Each segment gets an index file named 
+    //! telemetry-NNNNNNNN.shi, used by SenseHAT_QueryOpen.
+    //!
+    //! @param[in] directory The directory to write segments to. It must already exist. This 
+    //! argument must not be NULL.
+    //! @param[in] recordsPerSegment The number of records after which a new segment is started.
+    //! This argument must be greater than 0.
+    //! @param[out] recorder The new recorder. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_RecorderOpen           (const char*                    directory,
+                                                 uint32_t                       recordsPerSegment,
+                                                 tSenseHAT_Recorder*            recorder);
+
+    //! @brief Call SenseHAT_RecorderClose to write any buffered records and dispose of a recorder.
+    //!
+    //! A recorder can't be closed while an instance records to it; detach it first with 
+    //! SenseHAT_SetRecorder(instance, NULL), or close the instance.
+    //!
+    //! @param[in,out] recorder The recorder to close. This argument must not be NULL. On return,
+    //! it is set to NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EBUSY indicates that an instance still records to
+    //! the recorder; it is left open.
+    //!
+    int32_t     SenseHAT_RecorderClose          (tSenseHAT_Recorder*            recorder);
+
+    //! @brief Call SenseHAT_RecorderSetCompression to choose whether new segments are compressed.
+    //!
+    //! Compressed segments hold blocks of records encoded with the telemetry encoder (see 
+    //! SenseHAT_EncoderAppend) instead of tSenseHAT_Record records, which typically makes them
+    //! several times smaller. The reader and SenseHAT_OpenReplay decode them transparently. The
+    //! setting takes effect with the next batch written; segments are never mixed.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @param[in] compressed Whether to compress new segments. Recorders start uncompressed.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_RecorderSetCompression (tSenseHAT_Recorder             recorder,
+                                                 bool                           compressed);
+
+    //! @brief Call SenseHAT_RecorderAppend to append a record.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @param[in] record The record to append. This argument must not be NULL, and its channel 
+    //! must be a single tSenseHAT_Channel.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that the buffer was full and the
+    //! record was dropped.
+    //!
+    int32_t     SenseHAT_RecorderAppend         (tSenseHAT_Recorder             recorder,
+                                                 const tSenseHAT_Record*        record);
+
+    //! @brief Call SenseHAT_RecorderAppendSample to append one record for every valid channel of a
+    //! sample.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @param[in] sample The sample to append. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that some records were dropped.
+    //!
+    int32_t     SenseHAT_RecorderAppendSample   (tSenseHAT_Recorder             recorder,
+                                                 const tSenseHAT_Sample*        sample);
+
+    //! @brief Call SenseHAT_RecorderAppendEvent to append a joystick event.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @param[in] event The joystick event to append. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that the record was dropped.
+    //!
+    int32_t     SenseHAT_RecorderAppendEvent    (tSenseHAT_Recorder             recorder,
+                                                 const tSenseHAT_JoystickEvent* event);
+
+    //! @brief Call SenseHAT_RecorderFlush to wait until every record appended so far has been 
+    //! written to disk.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_RecorderFlush          (tSenseHAT_Recorder             recorder);
+
+    //! @brief Call SenseHAT_RecorderGetStatistics to get the recorder counters.
+    //!
+    //! @param[in] recorder The recorder.
+    //! @param[out] statistics The recorder counters. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_RecorderGetStatistics  (tSenseHAT_Recorder             recorder,
+                                                 tSenseHAT_RecorderStatistics*  statistics);
+
+    //! @brief Call SenseHAT_SetRecorder to record every sensor reading and joystick event of an
+    //! instance.
+    //!
+    //! Once set, every value read from the sensors (by the SenseHAT_Get* functions, 
+    //! SenseHAT_GetChannels or the sampler; values served from the cache aren't recorded again)
+    //! and every joystick event returned by SenseHAT_GetEventsInto is appended to the recorder.
+    //!
+    //! @param[in] instance An instance of the Sense HAT C library.
+    //! The instance holds on to the recorder until it's replaced, set to NULL or the instance is
+    //! closed; until then SenseHAT_RecorderClose refuses to close it.
+    //!
+    //! @param[in] recorder The recorder to use, or NULL to stop recording.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_SetRecorder            (const tSenseHAT_Instance       instance,
+                                                 tSenseHAT_Recorder             recorder);
+
+    //! @brief Call SenseHAT_ReaderOpen to create a reader for the segments in a directory.
+    //!
+    //! @param[in] directory The directory holding the segments. This argument must not be NULL.
+    //! @param[out] reader The new reader. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ReaderOpen             (const char*                    directory,
+                                                 tSenseHAT_Reader*              reader);
+
+    //! @brief Call SenseHAT_ReaderNextSegment to map the next segment into memory.
+    //!
+    //! Segments are returned in the order they were written. The records are not copied; they 
+    //! remain valid until the next call to SenseHAT_ReaderNextSegment or SenseHAT_ReaderClose.
+    //!
+    //! @param[in] reader The reader.
+    //! @param[out] records The records of the segment. This argument must not be NULL.
+    //! @param[out] recordCount The number of records in the segment. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that there are no more segments.
+    //! A value equal to EPROTO indicates that the segment has an unsupported version or layout.
+    //!
+    int32_t     SenseHAT_ReaderNextSegment      (tSenseHAT_Reader               reader,
+                                                 const tSenseHAT_Record**       records,
+                                                 uint64_t*                      recordCount);
+
+    //! @brief Call SenseHAT_ReaderClose to dispose of a reader.
+    //!
+    //! @param[in,out] reader The reader to close. This argument must not be NULL. On return, it
+    //! is set to NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_ReaderClose            (tSenseHAT_Reader*              reader);
+
+    // =============================================================================================
+    //  Query functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_QueryOpen to create a range query over the segments in a directory.
+    //!
+    //! The recorder writes an index next to each segment, with the time and value ranges of every
+    //! thousand or so records. A query uses it to read only the parts of a segment that may hold
+    //! matching records; segments without a usable index are read in full.
+    //!
+    //! @param[in] directory The directory holding the segments. This argument must not be NULL.
+    //! @param[in] parameters The records to match. This argument must not be NULL; its channels
+    //! must not be 0, and its valueIndex must be less than 3.
+    //! @param[out] query The new query. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDShowLetter      (const tSenseHAT_Instance      instance,
-                                             const char*                   letter,
-                                             const tSenseHAT_LEDPixel*     textColor,
-                                             const tSenseHAT_LEDPixel*     backColor);
+    int32_t     SenseHAT_QueryOpen              (const char*                        directory,
+                                                 const tSenseHAT_QueryParameters*   parameters,
+                                                 tSenseHAT_Query*                   query);
+
+    //! @brief Call SenseHAT_QueryNext to get the next matching records.
+    //!
+    //! Records are returned in the order they were written. Fewer than capacity records may be 
+    //! returned even when more remain; call again until ENODATA is returned.
+    //!
+    //! @param[in] query The query.
+    //! @param[out] records Caller allocated array that receives the matching records. This 
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of records that fit in records. This argument must not be 0.
+    //! @param[out] recordCount The number of records returned. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that there are no more matching
+    //! records. A value equal to EPROTO indicates that a segment has an unsupported version or 
+    //! layout or is corrupt; the next call continues with the next segment.
+    //!
+    int32_t     SenseHAT_QueryNext              (tSenseHAT_Query                    query,
+                                                 tSenseHAT_Record*                  records,
+                                                 uint32_t                           capacity,
+                                                 uint32_t*                          recordCount);
 
-    // =============================================================================================
-    //  Low level LED matrix functions
-    // =============================================================================================
+    //! @brief Call SenseHAT_QueryGetStatistics to get the counters of a query.
+    //!
+    //! @param[in] query The query.
+    //! @param[out] statistics The counters. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_QueryGetStatistics     (tSenseHAT_Query                    query,
+                                                 tSenseHAT_QueryStatistics*         statistics);
 
-    //! @brief Call SenseHAT_LEDGammaReset to reset the LED matrix gamma lookup table to
-    //! its default configuration.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_QueryClose to dispose of a query.
+    //!
+    //! @param[in,out] query The query to close. This argument must not be NULL. On return, it is
+    //! set to NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_LEDGammaReset  (const tSenseHAT_Instance   instance);
+    int32_t     SenseHAT_QueryClose             (tSenseHAT_Query*                   query);
 
     // =============================================================================================
-    //  High level environmental functions
+    //  Codec functions
     // =============================================================================================
 
-    //! @brief Call SenseHAT_GetHumidity to read the humidity in percent relative humidity.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] percentRelativeHumidity Humidity in percent relative humidity. This argument
+    //! @brief Call SenseHAT_EncoderInitialize to initialize a telemetry encoder.
+    //!
+    //! The encoder compresses a stream of records into a caller allocated buffer. Timestamps are
+    //! stored as deltas-of-deltas against the previous timestamps of the same channel, and values
+    //! as the XOR against the previous value of the same channel, so the slowly changing readings
+    //! of a sampled stream take a few bits each. The encoding is lossless, except that the 
+    //! reserved member of the records is not kept.
+    //!
+    //! @param[out] encoder The encoder to initialize. This argument must not be NULL.
+    //! @param[in] buffer Caller allocated buffer that receives the encoded records. This argument
     //! must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[in] capacity The size of buffer in bytes.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetHumidity    (const tSenseHAT_Instance   instance,
-                                         double*                    percentRelativeHumidity);
+    int32_t     SenseHAT_EncoderInitialize  (tSenseHAT_Encoder*         encoder,
+                                             uint8_t*                   buffer,
+                                             size_t                     capacity);
 
-    //! @brief Call SenseHAT_GetTemperature to read the temperature in degrees Celsius.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
-    //! to 0 indicates success.
+    //! @brief Call SenseHAT_EncoderAppend to encode a record.
     //!
-    int32_t     SenseHAT_GetTemperature (const tSenseHAT_Instance   instance,
-                                         double*                    degreesCelsius);
+    //! @param[in,out] encoder The encoder. This argument must not be NULL.
+    //! @param[in] record The record to encode. This argument must not be NULL, and its channel
+    //! must be a single tSenseHAT_Channel.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that fewer than 
+    //! kSenseHAT_EncodedRecordSizeMax bytes are left in the buffer; the record was not encoded.
+    //!
+    int32_t     SenseHAT_EncoderAppend      (tSenseHAT_Encoder*         encoder,
+                                             const tSenseHAT_Record*    record);
 
-    //! @brief Call SenseHAT_GetPressure to read the pressure in millibars.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] millibars Pressure in millibars. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_EncoderGetLength to get the length of the encoded records.
+    //!
+    //! @param[in] encoder The encoder. This argument must not be NULL.
+    //! @param[out] length The number of bytes of the buffer used so far. This argument must not be
+    //! NULL.
+    //! @param[out] recordCount The number of records encoded so far, which the decoder needs. This 
+    //! argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetPressure    (const tSenseHAT_Instance   instance,
-                                         double*                    millibars);
+    int32_t     SenseHAT_EncoderGetLength   (const tSenseHAT_Encoder*   encoder,
+                                             size_t*                    length,
+                                             uint32_t*                  recordCount);
 
-    //! @brief Call SenseHAT_GetCompass to read the compass heading in degrees.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] degrees Heading in degrees. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_DecoderInitialize to initialize a telemetry decoder.
+    //!
+    //! @param[out] decoder The decoder to initialize. This argument must not be NULL.
+    //! @param[in] buffer The encoded records. This argument must not be NULL unless length is 0.
+    //! @param[in] length The size of buffer in bytes.
+    //! @param[in] recordCount The number of records encoded in buffer.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetCompass     (const tSenseHAT_Instance   instance,
-                                         double*                    degrees);
+    int32_t     SenseHAT_DecoderInitialize  (tSenseHAT_Decoder*         decoder,
+                                             const uint8_t*             buffer,
+                                             size_t                     length,
+                                             uint32_t                   recordCount);
+
+    //! @brief Call SenseHAT_DecoderNext to decode the next record.
+    //!
+    //! @param[in,out] decoder The decoder. This argument must not be NULL.
+    //! @param[out] record The decoded record. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that every record has been
+    //! decoded. A value equal to EPROTO indicates that the encoded records are corrupt or 
+    //! truncated.
+    //!
+    int32_t     SenseHAT_DecoderNext        (tSenseHAT_Decoder*         decoder,
+                                             tSenseHAT_Record*          record);
 
     // =============================================================================================
-    //  Low level environmental functions
+    //  Gesture functions
     // =============================================================================================
 
-    //! @brief Call SenseHAT_GetAccelerometer to get the current orientation from the accelerometer
-    //! only by disabling the magnetometer and the gyroscope.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @brief Call SenseHAT_GestureInitialize to initialize a joystick gesture recognizer.
+    //!
+    //! @param[out] recognizer The gesture recognizer to initialize. This argument must not be 
+    //! NULL.
+    //! @param[in] configuration The timing configuration to use, or NULL to use the defaults (a 
+    //! 0.3 second double click interval, a 0.8 second long press, and repeats starting after 0.5
+    //! seconds at 0.2 second intervals, accelerating by 0.85 per repeat down to 0.04 seconds; 
+    //! since repeats start first, the defaults never report a long press).
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetAccelerometer           (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_Orientation*     orientation);
+    int32_t     SenseHAT_GestureInitialize      (tSenseHAT_GestureRecognizer*           recognizer,
+                                                 const tSenseHAT_GestureConfiguration*  configuration);
 
-    //! @brief Call SenseHAT_GetAccelerometerRaw to get the raw x, y and z accelerometer data.
-    //! 
+    //! @brief Call SenseHAT_GestureProcessEvent to feed a joystick event to a gesture recognizer.
+    //!
+    //! Gestures that become due before the event's timestamp are produced first, followed by any
+    //! gesture the event completes. Held events are only used to advance time; repeats are 
+    //! computed by the recognizer.
+    //!
+    //! @param[in,out] recognizer The gesture recognizer. This argument must not be NULL.
+    //! @param[in] event The joystick event. This argument must not be NULL.
+    //! @param[out] gestures Caller allocated array that receives the gestures produced. This
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of entries in gestures. Pass kSenseHAT_MaxGestures to
+    //! never lose a gesture. This argument must be greater than 0.
+    //! @param[out] gestureCount The number of gestures written to gestures. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that gestures didn't have room
+    //! for every gesture produced; the gestures that didn't fit are lost.
+    //!
+    int32_t     SenseHAT_GestureProcessEvent    (tSenseHAT_GestureRecognizer*           recognizer,
+                                                 const tSenseHAT_JoystickEvent*         event,
+                                                 tSenseHAT_Gesture*                     gestures,
+                                                 int32_t                                capacity,
+                                                 int32_t*                               gestureCount);
+
+    //! @brief Call SenseHAT_GestureAdvance to produce the gestures that are due by a given time.
+    //!
+    //! Long presses, repeats and single clicks (once the double click interval has expired) only 
+    //! depend on the passage of time; this function produces them. If it's called late, missed
+    //! repeats are collapsed into a single repeat.
+    //!
+    //! @param[in,out] recognizer The gesture recognizer. This argument must not be NULL.
+    //! @param[in] timestamp The current time, in the same time base as tSenseHAT_JoystickEvent 
+    //! timestamps (seconds since the epoch).
+    //! @param[out] gestures Caller allocated array that receives the gestures produced. This
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of entries in gestures. This argument must be greater than 0.
+    //! @param[out] gestureCount The number of gestures written to gestures. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that gestures didn't have room
+    //! for every gesture produced; the gestures that didn't fit are lost.
+    //!
+    int32_t     SenseHAT_GestureAdvance         (tSenseHAT_GestureRecognizer*           recognizer,
+                                                 double                                 timestamp,
+                                                 tSenseHAT_Gesture*                     gestures,
+                                                 int32_t                                capacity,
+                                                 int32_t*                               gestureCount);
+
+    //! @brief Call SenseHAT_GestureGetDeadline to get the time at which the next time based 
+    //! gesture becomes due.
+    //!
+    //! Use the deadline as the timeout when waiting for joystick events (e.g. with 
+    //! SenseHAT_WaitForSources), so the application only wakes when a gesture can be produced.
+    //!
+    //! @param[in] recognizer The gesture recognizer. This argument must not be NULL.
+    //! @param[out] deadline The time the next gesture becomes due, in the same time base as 
+    //! tSenseHAT_JoystickEvent timestamps. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that nothing is due until the 
+    //! next joystick event.
+    //!
+    int32_t     SenseHAT_GestureGetDeadline     (const tSenseHAT_GestureRecognizer*     recognizer,
+                                                 double*                                deadline);
+
+    //! @brief Call SenseHAT_GetGestures to retrieve pending joystick events, feed them to a 
+    //! gesture recognizer, and advance it to the current time.
+    //!
+    //! For an instance opened with SenseHAT_OpenReplay, the current time is the replay time, so
+    //! time based gestures follow the log rather than the wall clock.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] rawData Raw x, y and z accelerometer data in G's. This argument must not be
-    //! NULL.
+    //! @param[in,out] recognizer The gesture recognizer. This argument must not be NULL.
+    //! @param[out] gestures Caller allocated array that receives the gestures produced. This
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of entries in gestures. This argument must be greater than 0.
+    //! @param[out] gestureCount The number of gestures written to gestures. This argument must
+    //! not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that gestures didn't have room
+    //! for every gesture produced.
+    //!
+    int32_t     SenseHAT_GetGestures            (const tSenseHAT_Instance               instance,
+                                                 tSenseHAT_GestureRecognizer*           recognizer,
+                                                 tSenseHAT_Gesture*                     gestures,
+                                                 int32_t                                capacity,
+                                                 int32_t*                               gestureCount);
+
+    // =============================================================================================
+    //  Motion functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_MotionInitialize to initialize a motion detector.
+    //!
+    //! @param[out] detector The motion detector to initialize. This argument must not be NULL.
+    //! @param[in] configuration The configuration to use, or NULL to use the defaults (every 
+    //! detector; 1 G taps at least 0.2 seconds apart; shakes of 4 strokes over 1.2 G within 1 
+    //! second; free-fall below 0.3 G for 0.1 seconds; tilt past 30 degrees; 20% hysteresis; and a
+    //! 0.5 second gravity time constant).
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetAccelerometerRaw        (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_RawData*         rawData);
+    int32_t     SenseHAT_MotionInitialize       (tSenseHAT_MotionDetector*              detector,
+                                                 const tSenseHAT_MotionConfiguration*   configuration);
 
-    //! @brief Call SenseHAT_GetCompassRaw to get the raw x, y and z magnetometer data.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] rawData Raw x, y and z magnetometer data in microteslas (µT). This argument
+    //! @brief Call SenseHAT_MotionProcess to feed an accelerometer reading to a motion detector.
+    //!
+    //! The first reading only sets the detector up, although it can report free-fall or tilt.
+    //!
+    //! @param[in,out] detector The motion detector. This argument must not be NULL.
+    //! @param[in] timestamp The time of the reading in fractional seconds; readings must be fed
+    //! in order.
+    //! @param[in] acceleration The reading in G's. This argument must not be NULL.
+    //! @param[out] events Caller allocated array that receives the events produced. This argument
     //! must not be NULL.
+    //! @param[in] capacity The number of entries in events. Pass kSenseHAT_MaxMotionEvents to 
+    //! never lose an event. This argument must be greater than 0.
+    //! @param[out] eventCount The number of events written to events. This argument must not be
+    //! NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENOBUFS indicates that events didn't have room 
+    //! for every event produced; the events that didn't fit are lost.
+    //!
+    int32_t     SenseHAT_MotionProcess          (tSenseHAT_MotionDetector*              detector,
+                                                 double                                 timestamp,
+                                                 const tSenseHAT_RawData*               acceleration,
+                                                 tSenseHAT_MotionEvent*                 events,
+                                                 int32_t                                capacity,
+                                                 int32_t*                               eventCount);
+
+    // =============================================================================================
+    //  Compass functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_MagCalibratorInitialize to initialize a magnetometer calibrator.
+    //!
+    //! @param[out] calibrator The calibrator to initialize. This argument must not be NULL.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetCompassRaw              (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_RawData*         rawData);
+    int32_t     SenseHAT_MagCalibratorInitialize    (tSenseHAT_MagCalibrator*           calibrator);
 
-    //! @brief Call SenseHAT_GetGyroscope to get the current orientation from the gyroscope
-    //! only by disabling the magnetometer and the accelerometer.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @brief Call SenseHAT_MagCalibratorAdd to add an uncorrected magnetometer reading to a 
+    //! calibrator.
+    //!
+    //! @param[in,out] calibrator The calibrator. This argument must not be NULL.
+    //! @param[in] reading The reading in microteslas (µT). This argument must not be NULL.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetGyroscope               (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_Orientation*     orientation);
+    int32_t     SenseHAT_MagCalibratorAdd           (tSenseHAT_MagCalibrator*           calibrator,
+                                                     const tSenseHAT_RawData*           reading);
 
-    //! @brief Call SenseHAT_GetGyroscopeRaw to get the raw x, y, and z gyroscope data.
-    //! 
+    //! @brief Call SenseHAT_MagCalibratorSolve to fit an ellipsoid to the readings of a 
+    //! calibrator.
+    //!
+    //! The readings should cover as many orientations as possible; turn the device slowly 
+    //! through a figure of eight about every axis while collecting them. The correction matrix is
+    //! scaled to preserve the average field strength.
+    //!
+    //! @param[in] calibrator The calibrator. This argument must not be NULL.
+    //! @param[out] calibration The calibration. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODATA indicates that there are fewer than 
+    //! kSenseHAT_MagCalibrationSamplesMin readings. A value equal to EDOM indicates that the 
+    //! readings don't determine an ellipsoid, usually because the device wasn't turned enough.
+    //!
+    int32_t     SenseHAT_MagCalibratorSolve         (const tSenseHAT_MagCalibrator*     calibrator,
+                                                     tSenseHAT_MagCalibration*          calibration);
+
+    //! @brief Call SenseHAT_SetMagCalibration to set the magnetometer calibration of an instance.
+    //!
+    //! Once set, every eSenseHAT_ChannelCompassRaw reading returned by the instance (including
+    //! those of SenseHAT_GetCompassRaw, SenseHAT_GetChannels and the sampler) is corrected. The 
+    //! cache and the recorder keep the uncorrected readings, so recorded logs can be replayed with
+    //! a different calibration. SenseHAT_GetCompass still returns RTIMULib's heading.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] rawData Raw x, y and z gyroscope data in radians/second. This argument must
-    //! not be NULL.
+    //! @param[in] calibration The calibration, or NULL to stop correcting readings.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetGyroscopeRaw            (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_RawData*         rawData);
+    int32_t     SenseHAT_SetMagCalibration          (const tSenseHAT_Instance           instance,
+                                                     const tSenseHAT_MagCalibration*    calibration);
 
-    //! @brief Call SenseHAT_GetOrientation to get the current orientation in degrees.
-    //! 
+    //! @brief Call SenseHAT_GetMagCalibration to get the magnetometer calibration of an instance.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @param[out] calibration The calibration. This argument must not be NULL.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
-    //! to 0 indicates success.
+    //! to 0 indicates success. A value equal to ENODATA indicates that the instance has no 
+    //! calibration.
     //!
-    int32_t     SenseHAT_GetOrientation             (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_Orientation*     orientation);
+    int32_t     SenseHAT_GetMagCalibration          (const tSenseHAT_Instance           instance,
+                                                     tSenseHAT_MagCalibration*          calibration);
 
-    //! @brief Call SenseHAT_GetOrientationDegrees to get the current orientation in degrees
-    //! using the aircraft principal axes of pitch, roll, and yaw.
-    //! 
+    //! @brief Call SenseHAT_CalibrateCompass to calibrate the magnetometer while the device is 
+    //! turned.
+    //!
+    //! This function removes the instance's calibration, collects uncorrected readings for the 
+    //! given time, fits an ellipsoid to them, and sets the result as the instance's calibration.
+    //! If the fit fails, the previous calibration is restored. Turn the device slowly through a 
+    //! figure of eight about every axis while it runs.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @param[in] durationSeconds Time to collect readings for in fractional seconds. This 
+    //! argument must be greater than 0.
+    //! @param[in] intervalSeconds Time between readings in fractional seconds. This argument must
+    //! be greater than 0.
+    //! @param[out] calibration The new calibration. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. See SenseHAT_MagCalibratorSolve for the fit failures.
+    //!
+    int32_t     SenseHAT_CalibrateCompass           (const tSenseHAT_Instance           instance,
+                                                     double                             durationSeconds,
+                                                     double                             intervalSeconds,
+                                                     tSenseHAT_MagCalibration*          calibration);
+
+    //! @brief Call SenseHAT_SaveMagCalibration to save a magnetometer calibration to a file.
+    //!
+    //! @param[in] path The file. This argument must not be NULL.
+    //! @param[in] calibration The calibration. This argument must not be NULL.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetOrientationDegrees      (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_Orientation*     orientation);
+    int32_t     SenseHAT_SaveMagCalibration         (const char*                        path,
+                                                     const tSenseHAT_MagCalibration*    calibration);
 
-    //! @brief Call SenseHAT_GetOrientationRadians to get the current orientation in radians
-    //! using the aircraft principal axes of pitch, roll, and yaw.
-    //! 
+    //! @brief Call SenseHAT_LoadMagCalibration to load a magnetometer calibration from a file 
+    //! written by SenseHAT_SaveMagCalibration.
+    //!
+    //! @param[in] path The file. This argument must not be NULL.
+    //! @param[out] calibration The calibration. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EPROTO indicates that the file doesn't hold a 
+    //! calibration.
+    //!
+    int32_t     SenseHAT_LoadMagCalibration         (const char*                        path,
+                                                     tSenseHAT_MagCalibration*          calibration);
+
+    //! @brief Call SenseHAT_ComputeHeading to compute a tilt compensated compass heading.
+    //!
+    //! The accelerometer reading gives the roll and pitch of the device, which are used to 
+    //! project the magnetometer reading onto the horizontal plane, following RTIMULib's pose 
+    //! conventions. No fusion is involved, so the heading follows the readings instantly, noise 
+    //! included.
+    //!
+    //! @param[in] acceleration Accelerometer reading in G's. This argument must not be NULL.
+    //! @param[in] magneticField Corrected magnetometer reading in microteslas (µT). This argument
+    //! must not be NULL.
+    //! @param[out] heading Heading in degrees, from 0 up to 360. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to EDOM indicates that a reading is zero.
+    //!
+    int32_t     SenseHAT_ComputeHeading             (const tSenseHAT_RawData*           acceleration,
+                                                     const tSenseHAT_RawData*           magneticField,
+                                                     double*                            heading);
+
+    //! @brief Call SenseHAT_GetHeading to get a tilt compensated compass heading from the 
+    //! accelerometer and the calibrated magnetometer.
+    //!
+    //! Both readings are acquired in a single call sequence, subject to the instance's max-age 
+    //! policy, and combined with SenseHAT_ComputeHeading.
+    //!
     //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] orientation Orientation in degrees. This argument must not be NULL.
+    //! @param[out] heading Heading in degrees, from 0 up to 360. This argument must not be NULL.
     //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetOrientationRadians      (const tSenseHAT_Instance   instance,
-                                                     tSenseHAT_Orientation*     orientation);
+    int32_t     SenseHAT_GetHeading                 (const tSenseHAT_Instance           instance,
+                                                     double*                            heading);
 
-    //! @brief Call SenseHAT_GetTemperatureFromHumidity to read the temperature in degrees Celsius
-    //! from the humidity sensor.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    // =============================================================================================
+    //  Spectrum functions
+    // =============================================================================================
+
+    //! @brief Call SenseHAT_SpectrumOpen to create a spectrum plan.
+    //!
+    //! A plan holds the window, twiddle factors and aligned work buffers for one transform 
+    //! length, so computing a spectrum never allocates memory. A plan must not be used by 
+    //! several threads at once.
+    //!
+    //! @param[in] length The number of samples per spectrum; a power of two from 
+    //! kSenseHAT_SpectrumLengthMin to kSenseHAT_SpectrumLengthMax.
+    //! @param[in] window The window applied to the samples.
+    //! @param[out] plan The new plan. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetTemperatureFromHumidity (const tSenseHAT_Instance   instance,
-                                                     double*                    degreesCelsius);
+    int32_t     SenseHAT_SpectrumOpen       (uint32_t                   length,
+                                             tSenseHAT_SpectrumWindow   window,
+                                             tSenseHAT_SpectrumPlan*    plan);
 
-    //! @brief Call SenseHAT_GetTemperatureFromPressure to read the temperature in degrees Celsius
-    //! from the pressure sensor.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] degreesCelsius Temperature in degrees Celsius. This argument must not be NULL.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_SpectrumCompute to compute the spectrum of a block of samples.
+    //!
+    //! The mean of the samples is removed, the window applied, and a real FFT computed. The 
+    //! result is summarized as the RMS, the strongest peaks and band powers.
+    //!
+    //! @param[in] plan The plan.
+    //! @param[in] samples The samples; as many as the length of the plan. This argument must not
+    //! be NULL.
+    //! @param[in] sampleRate The sample rate in Hz. This argument must be greater than 0.
+    //! @param[in] peakCount The number of peaks to report, at most kSenseHAT_SpectrumPeaksMax.
+    //! @param[out] spectrum The spectrum. This argument must not be NULL.
+    //! @param[out] power Caller allocated array that receives the power of every bin from DC to 
+    //! the Nyquist frequency (length / 2 + 1 values), or NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetTemperatureFromPressure (const tSenseHAT_Instance   instance,
-                                                     double*                    degreesCelsius);
+    int32_t     SenseHAT_SpectrumCompute    (tSenseHAT_SpectrumPlan     plan,
+                                             const float*               samples,
+                                             double                     sampleRate,
+                                             uint32_t                   peakCount,
+                                             tSenseHAT_AxisSpectrum*    spectrum,
+                                             float*                     power);
 
-    //! @brief Call SenseHAT_SetIMUConfiguration to enable and/or disable the magnetometer,
-    //! gyroscope, and accelerometer contributions to the "get orientation" functions.
+    //! @brief Call SenseHAT_SpectrumClose to dispose of a spectrum plan.
     //!
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] enableCompass Enable the magnetometer's contribution to orientation.
-    //! @param[in] enableGyroscope Enable the gyroscope's contribution to orientation.
-    //! @param[in] enableAccelerometer Enable the accelerometer's contribution to orientation.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @param[in,out] plan The plan to close. This argument must not be NULL. On return, it is 
+    //! set to NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_SetIMUConfiguration        (const tSenseHAT_Instance   instance,
-                                                     bool                       enableCompass,
-                                                     bool                       enableGyroscope,
-                                                     bool                       enableAccelerometer);
+    int32_t     SenseHAT_SpectrumClose      (tSenseHAT_SpectrumPlan*    plan);
 
     // =============================================================================================
-    //  Event functions
+    //  Vibration functions
     // =============================================================================================
 
-    //! @brief Call SenseHAT_GetEvents to get the queue of events that have occurred since the
-    //! last call to SenseHAT_GetEvents or SenseHAT_WaitForEvent.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[out] eventCount Number of events in queue. This argument must not be NULL.
-    //! @param[out] events Events in event queue.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_VibrationOpen to start capturing accelerometer spectra.
+    //!
+    //! The capture talks to the LSM9DS1 IMU directly over I2C, rather than through Python. It 
+    //! puts the accelerometer in accelerometer-only mode at its top output data rate (952 Hz),
+    //! and a background thread drains the IMU FIFO into blocks of windowLength samples and 
+    //! computes a spectrum for each block. While a capture is open, the gyroscope is powered 
+    //! down and the IMU readings of the other functions are not valid; closing the capture 
+    //! restores the IMU configuration.
+    //!
+    //! @param[in] configuration The capture configuration. This argument must not be NULL.
+    //! @param[out] capture The new capture. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success. A value equal to ENODEV indicates that the IMU wasn't found.
+    //!
+    int32_t     SenseHAT_VibrationOpen          (const tSenseHAT_VibrationConfiguration*    configuration,
+                                                 tSenseHAT_VibrationCapture*                capture);
+
+    //! @brief Call SenseHAT_VibrationGetSpectra to retrieve the spectra computed so far.
+    //!
+    //! The capture keeps the most recent spectra; older ones are dropped if they aren't 
+    //! retrieved in time. This function doesn't block.
+    //!
+    //! @param[in] capture The capture.
+    //! @param[out] spectra Caller allocated array that receives the spectra, oldest first. This
+    //! argument must not be NULL.
+    //! @param[in] capacity The number of spectra that fit in spectra.
+    //! @param[out] spectrumCount The number of spectra returned. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
     //!
-    int32_t     SenseHAT_GetEvents      (const tSenseHAT_Instance   instance,
-							             int32_t*                   eventCount,
-                                         tSenseHAT_JoystickEvent**  events);
+    int32_t     SenseHAT_VibrationGetSpectra    (tSenseHAT_VibrationCapture                 capture,
+                                                 tSenseHAT_VibrationSpectrum*               spectra,
+                                                 uint32_t                                   capacity,
+                                                 uint32_t*                                  spectrumCount);
 
-    //! @brief Call SenseHAT_WaitForEvent to block and wait for an event to occur.
-    //! 
-    //! @param[in] instance An instance of the Sense HAT C library.
-    //! @param[in] flushPendingEvents Set to true to flush any pending events.
-    //! @param[out] event The first event that occurs after making this function call.
-    //! @return int32_t A status code indicating whether the function call succeeded. A value equal 
+    //! @brief Call SenseHAT_VibrationGetStatistics to get the counters of a capture.
+    //!
+    //! @param[in] capture The capture.
+    //! @param[out] statistics The counters. This argument must not be NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
     //! to 0 indicates success.
-    //! 
-    int32_t     SenseHAT_WaitForEvent   (const tSenseHAT_Instance   instance,
-                                         bool                       flushPendingEvents,
-                                         tSenseHAT_JoystickEvent*   event);
+    //!
+    int32_t     SenseHAT_VibrationGetStatistics (tSenseHAT_VibrationCapture                 capture,
+                                                 tSenseHAT_VibrationStatistics*             statistics);
+
+    //! @brief Call SenseHAT_VibrationClose to stop a capture and restore the IMU configuration.
+    //!
+    //! @param[in,out] capture The capture to close. This argument must not be NULL. On return, 
+    //! it is set to NULL.
+    //! @return int32_t A status code indicating whether the function call succeeded. A value equal
+    //! to 0 indicates success.
+    //!
+    int32_t     SenseHAT_VibrationClose         (tSenseHAT_VibrationCapture*                capture);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,402 @@
+// ==================================================================================================
+//
+//  sensehat-animation.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the animation player of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-animation.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the animation player of the Raspberry
+//! Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <stdlib.h>
+#include <time.h>
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_AnimationThread
+static void* SenseHAT_AnimationThread (void* argument);
+
+// SenseHAT_AnimationWaitUntil
+static void SenseHAT_AnimationWaitUntil (tSenseHAT_Animation* animation,
+                                         double wakeTime);
+
+// SenseHAT_AnimationJoin
+static void SenseHAT_AnimationJoin (tSenseHAT_Animation* animation);
+
+// =================================================================================================
+//  SenseHAT_AnimationStart
+// =================================================================================================
+int32_t SenseHAT_AnimationStart (const tSenseHAT_Instance instance,
+                                 const tSenseHAT_AnimationFrame* frames,
+                                 uint32_t frameCount,
+                                 bool loop)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (frames != NULL) &&
+        (frameCount > 0))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Animation* animation = &(instancePrivate->animation);
+        tSenseHAT_AnimationFrame* copy = NULL;
+        uint32_t frame = 0;
+        uint32_t index = 0;
+
+        // Check the frames up front, so the thread never meets a bad one
+        for (frame = 0; (frame < frameCount) && (result == 0); frame++)
+        {
+            if (frames[frame].duration > 0.0)
+            {
+                for (index = 0; (index < 64) && (result == 0); index++)
+                {
+                    const tSenseHAT_LEDPixel* pixel = &(frames[frame].pixels[index]);
+                    if ((pixel->red < 0) || (pixel->red > 255) ||
+                        (pixel->green < 0) || (pixel->green > 255) ||
+                        (pixel->blue < 0) || (pixel->blue > 255))
+                    {
+                        result = EINVAL;
+                    }
+                }
+            }
+            else    // Invalid duration
+            {
+                result = EINVAL;
+            }
+        }
+
+        // Copy the frames
+        if (result == 0)
+        {
+            copy = (tSenseHAT_AnimationFrame*)malloc(frameCount * sizeof(tSenseHAT_AnimationFrame));
+            if (copy != NULL)
+            {
+                memcpy((void*)copy, (const void*)frames, frameCount * sizeof(tSenseHAT_AnimationFrame));
+            }
+            else    // malloc failed
+            {
+                result = ENOMEM;
+            }
+        }
+
+        if (result == 0)
+        {
+            // Get a lock
+            (void)pthread_mutex_lock(&(animation->mutex));
+
+            // Clear away an animation that has finished by itself
+            if (animation->running && animation->finished)
+            {
+                (void)pthread_mutex_unlock(&(animation->mutex));
+                SenseHAT_AnimationJoin(animation);
+                (void)pthread_mutex_lock(&(animation->mutex));
+            }
+
+            // Is an animation already playing?
+            if (!animation->running)
+            {
+                free((void*)(animation->frames));
+                animation->frames = copy;
+                animation->frameCount = frameCount;
+                animation->loop = loop;
+                animation->stopRequested = false;
+                animation->finished = false;
+                animation->startTime = SenseHAT_GetMonotonicTime();
+                animation->endTime = animation->startTime;
+                memset(&(animation->statistics), 0, sizeof(tSenseHAT_AnimationStatistics));
+                animation->running = true;
+                copy = NULL;
+
+                // Start the animation thread
+                result = pthread_create(&(animation->thread), NULL, SenseHAT_AnimationThread, instancePrivate);
+                if (result != 0)
+                {
+                    // pthread_create failed
+                    animation->running = false;
+                }
+            }
+            else    // Already playing
+            {
+                result = EBUSY;
+            }
+
+            // Release our lock
+            (void)pthread_mutex_unlock(&(animation->mutex));
+        }
+        free((void*)copy);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationStop
+// =================================================================================================
+int32_t SenseHAT_AnimationStop (const tSenseHAT_Instance instance)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Animation* animation = &(instancePrivate->animation);
+        bool running = false;
+
+        // Ask the animation thread to stop
+        (void)pthread_mutex_lock(&(animation->mutex));
+        running = animation->running;
+        if (running)
+        {
+            animation->stopRequested = true;
+            (void)pthread_cond_signal(&(animation->condition));
+        }
+        (void)pthread_mutex_unlock(&(animation->mutex));
+
+        // Wait for it to finish
+        if (running)
+        {
+            SenseHAT_AnimationJoin(animation);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationGetStatistics
+// =================================================================================================
+int32_t SenseHAT_AnimationGetStatistics (const tSenseHAT_Instance instance,
+                                         tSenseHAT_AnimationStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Animation* animation = &(instancePrivate->animation);
+        double elapsed = 0.0;
+
+        (void)pthread_mutex_lock(&(animation->mutex));
+        *statistics = animation->statistics;
+        statistics->playing = animation->running && !(animation->finished);
+        elapsed = (statistics->playing ? SenseHAT_GetMonotonicTime() : animation->endTime) - animation->startTime;
+        statistics->fps = (elapsed > 0.0) ? ((double)(statistics->framesShown) / elapsed) : 0.0;
+        (void)pthread_mutex_unlock(&(animation->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationInitialize
+// =================================================================================================
+int32_t SenseHAT_AnimationInitialize (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Animation* animation = &(instancePrivate->animation);
+        pthread_condattr_t conditionAttributes;
+
+        // Setup
+        memset(animation, 0, sizeof(tSenseHAT_Animation));
+
+        // The animation thread paces itself against the monotonic clock
+        (void)pthread_mutex_init(&(animation->mutex), NULL);
+        (void)pthread_condattr_init(&conditionAttributes);
+        (void)pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+        (void)pthread_cond_init(&(animation->condition), &conditionAttributes);
+        (void)pthread_condattr_destroy(&conditionAttributes);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationRelease
+// =================================================================================================
+void SenseHAT_AnimationRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Animation* animation = &(instancePrivate->animation);
+
+        // Make sure the animation thread is gone
+        (void)SenseHAT_AnimationStop((tSenseHAT_Instance)instancePrivate);
+
+        // Clean up
+        free((void*)(animation->frames));
+        animation->frames = NULL;
+        (void)pthread_cond_destroy(&(animation->condition));
+        (void)pthread_mutex_destroy(&(animation->mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationThread
+// =================================================================================================
+void* SenseHAT_AnimationThread (void* argument)
+{
+    tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)argument;
+    tSenseHAT_Animation* animation = &(instancePrivate->animation);
+    uint32_t frame = 0;
+    double due = 0.0;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(animation->mutex));
+    due = animation->startTime;
+
+    // Frame deadlines are accumulated from the start time, so lateness never compounds
+    while (!animation->stopRequested)
+    {
+        const tSenseHAT_AnimationFrame* current = &(animation->frames[frame]);
+        bool lastFrame = ((frame + 1) == animation->frameCount) && !(animation->loop);
+        double now = 0.0;
+
+        SenseHAT_AnimationWaitUntil(animation, due);
+        if (animation->stopRequested)
+        {
+            break;
+        }
+
+        // Drop the frame if its slot has passed; the last frame of a sequence is always shown
+        now = SenseHAT_GetMonotonicTime();
+        if ((now >= (due + current->duration)) && !lastFrame)
+        {
+            animation->statistics.framesDropped++;
+        }
+        else
+        {
+            int32_t status = 0;
+            double lateness = 0.0;
+
+            // Update the LED matrix without holding up statistics requests
+            (void)pthread_mutex_unlock(&(animation->mutex));
+            status = SenseHAT_LEDSetPixels((tSenseHAT_Instance)instancePrivate, current->pixels);
+            (void)pthread_mutex_lock(&(animation->mutex));
+
+            lateness = SenseHAT_GetMonotonicTime() - due;
+            animation->statistics.frameIndex = frame;
+            animation->statistics.framesShown++;
+            if (lateness > kSenseHAT_AnimationLateThreshold)
+            {
+                animation->statistics.framesLate++;
+            }
+            if (lateness > animation->statistics.maxLateness)
+            {
+                animation->statistics.maxLateness = lateness;
+            }
+            if (status != 0)
+            {
+                animation->statistics.lastError = status;
+            }
+        }
+
+        // Move on to the next frame
+        due += current->duration;
+        frame++;
+        if (frame == animation->frameCount)
+        {
+            if (animation->loop)
+            {
+                frame = 0;
+            }
+            else
+            {
+                // Hold the last frame for its duration before finishing
+                SenseHAT_AnimationWaitUntil(animation, due);
+                break;
+            }
+        }
+    }
+    animation->endTime = SenseHAT_GetMonotonicTime();
+    animation->finished = true;
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(animation->mutex));
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationWaitUntil
+// =================================================================================================
+void SenseHAT_AnimationWaitUntil (tSenseHAT_Animation* animation,
+                                  double wakeTime)
+{
+    struct timespec deadline;
+
+    // Sleep until the deadline, or until we're asked to stop
+    deadline.tv_sec = (time_t)wakeTime;
+    deadline.tv_nsec = (long)((wakeTime - (double)(deadline.tv_sec)) * 1000000000.0);
+    while (!animation->stopRequested)
+    {
+        if (pthread_cond_timedwait(&(animation->condition),
+                                   &(animation->mutex),
+                                   &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_AnimationJoin
+// =================================================================================================
+void SenseHAT_AnimationJoin (tSenseHAT_Animation* animation)
+{
+    (void)pthread_join(animation->thread, NULL);
+
+    (void)pthread_mutex_lock(&(animation->mutex));
+    animation->running = false;
+    animation->stopRequested = false;
+    (void)pthread_mutex_unlock(&(animation->mutex));
+    return;
+}
+
+// =================================================================================================
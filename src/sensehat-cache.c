@@ -0,0 +1,286 @@
+// ==================================================================================================
+//
+//  sensehat-cache.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the sensor value cache of the Raspberry
+//      Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-cache.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the sensor value cache of the 
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_CacheCopyChannel
+static void SenseHAT_CacheCopyChannel (tSenseHAT_Sample* destination,
+                                       const tSenseHAT_Sample* source,
+                                       uint32_t channel);
+
+// =================================================================================================
+//  SenseHAT_SetCacheMaxAge
+// =================================================================================================
+int32_t SenseHAT_SetCacheMaxAge (const tSenseHAT_Instance instance,
+                                 double maxAgeSeconds)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (maxAgeSeconds >= 0.0))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+        instancePrivate->cache.maxAge = maxAgeSeconds;
+        (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetCacheStatistics
+// =================================================================================================
+int32_t SenseHAT_GetCacheStatistics (const tSenseHAT_Instance instance,
+                                     bool reset,
+                                     tSenseHAT_CacheStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+        statistics->hits = instancePrivate->cache.hits;
+        statistics->misses = instancePrivate->cache.misses;
+        if (reset)
+        {
+            instancePrivate->cache.hits = 0;
+            instancePrivate->cache.misses = 0;
+        }
+        (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetChannels
+// =================================================================================================
+int32_t SenseHAT_GetChannels (const tSenseHAT_Instance instance,
+                              uint32_t channels,
+                              double maxAgeSeconds,
+                              tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (channels != eSenseHAT_ChannelNone) &&
+        ((channels & ~eSenseHAT_ChannelAll) == 0) &&
+        (sample != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Cache* cache = &(instancePrivate->cache);
+        uint32_t missing = eSenseHAT_ChannelNone;
+        double oldest = 0.0;
+        double now = SenseHAT_GetMonotonicTime();
+        int32_t index = 0;
+
+        // Setup
+        memset(sample, 0, sizeof(tSenseHAT_Sample));
+
+        // Serve what we can from the cache
+        (void)pthread_mutex_lock(&(cache->mutex));
+        if (maxAgeSeconds < 0.0)
+        {
+            maxAgeSeconds = cache->maxAge;
+        }
+        for (index = 0; index < kSenseHAT_ChannelCount; index++)
+        {
+            uint32_t channel = (uint32_t)1 << index;
+            if ((channels & channel) != 0)
+            {
+                if ((maxAgeSeconds > 0.0) &&
+                    ((cache->values.channels & channel) != 0) &&
+                    ((now - cache->readTimes[index]) <= maxAgeSeconds))
+                {
+                    SenseHAT_CacheCopyChannel(sample, &(cache->values), channel);
+                    if ((sample->timestamp == 0.0) || (cache->timestamps[index] < sample->timestamp))
+                    {
+                        sample->timestamp = cache->timestamps[index];
+                    }
+                    cache->hits++;
+                }
+                else
+                {
+                    missing |= channel;
+                    cache->misses++;
+                }
+            }
+        }
+        (void)pthread_mutex_unlock(&(cache->mutex));
+        oldest = sample->timestamp;
+
+        // Read the rest from the sensors
+        if (missing != eSenseHAT_ChannelNone)
+        {
+            tSenseHAT_Sample fresh;
+
+            result = SenseHAT_ReadChannels(instancePrivate, missing, &fresh);
+            now = SenseHAT_GetMonotonicTime();
+
+            // Update the cache with whatever was read
+            (void)pthread_mutex_lock(&(cache->mutex));
+            for (index = 0; index < kSenseHAT_ChannelCount; index++)
+            {
+                uint32_t channel = (uint32_t)1 << index;
+                if ((fresh.channels & channel) != 0)
+                {
+                    SenseHAT_CacheCopyChannel(&(cache->values), &fresh, channel);
+                    cache->readTimes[index] = now;
+                    cache->timestamps[index] = fresh.timestamp;
+                    SenseHAT_CacheCopyChannel(sample, &fresh, channel);
+                }
+            }
+
+            // Record the readings
+            if ((cache->recorder != NULL) && (fresh.channels != eSenseHAT_ChannelNone))
+            {
+                (void)SenseHAT_RecorderAppendSample(cache->recorder, &fresh);
+            }
+            (void)pthread_mutex_unlock(&(cache->mutex));
+
+            // The freshly read values are newer than anything from the cache
+            if ((oldest == 0.0) && (fresh.channels != eSenseHAT_ChannelNone))
+            {
+                oldest = fresh.timestamp;
+            }
+        }
+        sample->timestamp = oldest;
+
+        // Correct the magnetometer readings; the cache and the recorder keep them raw
+        if ((sample->channels & eSenseHAT_ChannelCompassRaw) != 0)
+        {
+            (void)pthread_mutex_lock(&(cache->mutex));
+            SenseHAT_CompassCorrect(cache, sample);
+            (void)pthread_mutex_unlock(&(cache->mutex));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CacheInitialize
+// =================================================================================================
+int32_t SenseHAT_CacheInitialize (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        // Setup
+        memset(&(instancePrivate->cache), 0, sizeof(tSenseHAT_Cache));
+        result = pthread_mutex_init(&(instancePrivate->cache.mutex), NULL);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CacheRelease
+// =================================================================================================
+void SenseHAT_CacheRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        (void)pthread_mutex_destroy(&(instancePrivate->cache.mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_CacheCopyChannel
+// =================================================================================================
+void SenseHAT_CacheCopyChannel (tSenseHAT_Sample* destination,
+                                const tSenseHAT_Sample* source,
+                                uint32_t channel)
+{
+    switch (channel)
+    {
+        case eSenseHAT_ChannelHumidity:
+            destination->humidity = source->humidity;
+            break;
+        case eSenseHAT_ChannelTemperature:
+            destination->temperature = source->temperature;
+            break;
+        case eSenseHAT_ChannelPressure:
+            destination->pressure = source->pressure;
+            break;
+        case eSenseHAT_ChannelCompass:
+            destination->compass = source->compass;
+            break;
+        case eSenseHAT_ChannelAccelerometerRaw:
+            destination->accelerometerRaw = source->accelerometerRaw;
+            break;
+        case eSenseHAT_ChannelGyroscopeRaw:
+            destination->gyroscopeRaw = source->gyroscopeRaw;
+            break;
+        case eSenseHAT_ChannelCompassRaw:
+            destination->compassRaw = source->compassRaw;
+            break;
+        case eSenseHAT_ChannelOrientation:
+            destination->orientation = source->orientation;
+            break;
+        default:
+            break;
+    }
+    destination->channels |= channel;
+    return;
+}
+
+// =================================================================================================
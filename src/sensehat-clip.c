@@ -0,0 +1,627 @@
+// ==================================================================================================
+//
+//  sensehat-clip.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the animation clip files of the Raspberry
+//      Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-clip.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the animation clip files of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Clip file magic number
+static const char kClipMagic[4] = { 'S', 'H', 'A', 'C' };
+
+// Clip file version
+#define kClipVersion            1
+
+// Number of pixels in a frame
+#define kClipPixels             64
+
+// Frame types
+#define kClipKeyframe           0   // Runs of { count, color } covering the whole frame
+#define kClipDelta              1   // Runs of { skip, count, color } over the previous frame
+
+// Run sizes, in bytes
+#define kClipKeyframeRunSize    3
+#define kClipDeltaRunSize       4
+
+// The largest encoding of a frame, in bytes
+#define kClipFrameSizeMax       (kClipPixels * kClipDeltaRunSize)
+
+// Size of a temporary file path
+#define kClipPathSize           1024
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Clip file header; the frame index follows it, then the frames
+typedef struct
+{
+    char        magic[4];       // kClipMagic
+    uint16_t    version;        // kClipVersion
+    uint16_t    entrySize;      // sizeof(tSenseHAT_ClipIndexEntry)
+    uint32_t    headerSize;     // sizeof(tSenseHAT_ClipHeader)
+    uint32_t    frameCount;     // Number of frames
+}
+tSenseHAT_ClipHeader;
+
+// Clip file index entry
+typedef struct
+{
+    uint32_t    offset;         // Offset of the frame from the start of the file
+    uint32_t    length;         // Length of the frame in bytes
+    uint32_t    duration;       // How long the frame is shown, in microseconds
+    uint8_t     type;           // kClipKeyframe or kClipDelta
+    uint8_t     reserved[3];    // Always 0
+}
+tSenseHAT_ClipIndexEntry;
+
+// Clip
+typedef struct
+{
+    pthread_mutex_t                 mutex;                  // Guards everything below
+    uint8_t*                        mapping;                // Mapped clip file
+    size_t                          mappingLength;          // Length of the mapping
+    const tSenseHAT_ClipIndexEntry* index;                  // Frame index, in the mapping
+    uint32_t                        frameCount;             // Number of frames
+    uint16_t                        pixels[kClipPixels];    // Last decoded frame, RGB565
+    uint32_t                        frameIndex;             // Index of the last decoded frame
+    bool                            decoded;                // Whether pixels holds a frame
+}
+tSenseHAT_ClipPrivate;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_ClipEncode
+static uint32_t SenseHAT_ClipEncode (const uint16_t* previous,
+                                     const uint16_t* pixels,
+                                     uint8_t* output);
+
+// SenseHAT_ClipSeek
+static int32_t SenseHAT_ClipSeek (tSenseHAT_ClipPrivate* clipPrivate,
+                                  uint32_t frameIndex);
+
+// SenseHAT_ClipDecode
+static int32_t SenseHAT_ClipDecode (tSenseHAT_ClipPrivate* clipPrivate,
+                                    uint32_t frameIndex);
+
+// =================================================================================================
+//  SenseHAT_ClipWrite
+// =================================================================================================
+int32_t SenseHAT_ClipWrite (const char* path,
+                            const tSenseHAT_AnimationFrame* frames,
+                            uint32_t frameCount,
+                            uint32_t keyframeInterval)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((path != NULL) &&
+        (frames != NULL) &&
+        (frameCount > 0) &&
+        (frameCount <= ((UINT32_MAX - sizeof(tSenseHAT_ClipHeader)) / (sizeof(tSenseHAT_ClipIndexEntry) + kClipFrameSizeMax))))
+    {
+        size_t dataOffset = sizeof(tSenseHAT_ClipHeader) + (frameCount * sizeof(tSenseHAT_ClipIndexEntry));
+        uint8_t* buffer = (uint8_t*)malloc(dataOffset + (frameCount * kClipFrameSizeMax));
+
+        if (buffer != NULL)
+        {
+            uint16_t pixels[2][kClipPixels];
+            tSenseHAT_ClipHeader* header = (tSenseHAT_ClipHeader*)buffer;
+            tSenseHAT_ClipIndexEntry* index = (tSenseHAT_ClipIndexEntry*)(buffer + sizeof(tSenseHAT_ClipHeader));
+            size_t length = dataOffset;
+            uint32_t frame = 0;
+
+            memset(buffer, 0, dataOffset);
+            memcpy(header->magic, kClipMagic, sizeof(kClipMagic));
+            header->version = kClipVersion;
+            header->entrySize = sizeof(tSenseHAT_ClipIndexEntry);
+            header->headerSize = sizeof(tSenseHAT_ClipHeader);
+            header->frameCount = frameCount;
+
+            // Encode each frame against the one before it, falling back to a keyframe when it's
+            // due or when it would be smaller anyway
+            for (frame = 0; (frame < frameCount) && (result == 0); frame++)
+            {
+                uint16_t* current = pixels[frame % 2];
+                const uint16_t* previous = pixels[(frame + 1) % 2];
+                bool keyframeDue = (frame == 0) || ((keyframeInterval > 0) && ((frame % keyframeInterval) == 0));
+
+                if ((frames[frame].duration > 0.0) && (frames[frame].duration < 4294.0))
+                {
+                    result = SenseHAT_ColorConvertFrames(NULL, &(frames[frame].pixels), 1, current);
+                }
+                else    // Invalid duration
+                {
+                    result = EINVAL;
+                }
+
+                if (result == 0)
+                {
+                    uint8_t keyframe[kClipFrameSizeMax];
+                    uint32_t keyframeLength = SenseHAT_ClipEncode(NULL, current, keyframe);
+                    uint32_t deltaLength = 0;
+
+                    index[frame].offset = (uint32_t)length;
+                    index[frame].duration = (uint32_t)((frames[frame].duration * 1000000.0) + 0.5);
+                    if (index[frame].duration == 0)
+                    {
+                        index[frame].duration = 1;
+                    }
+                    if (!keyframeDue)
+                    {
+                        deltaLength = SenseHAT_ClipEncode(previous, current, buffer + length);
+                    }
+                    if (!keyframeDue && (deltaLength < keyframeLength))
+                    {
+                        index[frame].type = kClipDelta;
+                        index[frame].length = deltaLength;
+                    }
+                    else
+                    {
+                        memcpy(buffer + length, keyframe, keyframeLength);
+                        index[frame].type = kClipKeyframe;
+                        index[frame].length = keyframeLength;
+                    }
+                    length += index[frame].length;
+                }
+            }
+
+            // Write the clip next to its final path, and move it into place once it's complete
+            if (result == 0)
+            {
+                char temporaryPath[kClipPathSize];
+
+                if (snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path) < (int)sizeof(temporaryPath))
+                {
+                    int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                    if (fd >= 0)
+                    {
+                        size_t written = 0;
+
+                        while ((written < length) && (result == 0))
+                        {
+                            ssize_t count = write(fd, buffer + written, length - written);
+                            if (count > 0)
+                            {
+                                written += (size_t)count;
+                            }
+                            else if ((count < 0) && (errno != EINTR))
+                            {
+                                // write failed
+                                result = errno;
+                            }
+                        }
+                        if ((close(fd) != 0) && (result == 0))
+                        {
+                            // close failed
+                            result = errno;
+                        }
+                        if ((result == 0) && (rename(temporaryPath, path) != 0))
+                        {
+                            // rename failed
+                            result = errno;
+                        }
+                        if (result != 0)
+                        {
+                            (void)unlink(temporaryPath);
+                        }
+                    }
+                    else    // open failed
+                    {
+                        result = errno;
+                    }
+                }
+                else    // Path too long
+                {
+                    result = ENAMETOOLONG;
+                }
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+        free((void*)buffer);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipOpen
+// =================================================================================================
+int32_t SenseHAT_ClipOpen (const char* path,
+                           tSenseHAT_Clip* clip)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((path != NULL) && (clip != NULL))
+    {
+        // Setup
+        *clip = NULL;
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            struct stat status;
+
+            if ((fstat(fd, &status) == 0) &&
+                ((size_t)status.st_size >= sizeof(tSenseHAT_ClipHeader)) &&
+                ((uint64_t)status.st_size <= UINT32_MAX))
+            {
+                // Map it; frames are only read as they're decoded
+                void* address = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (address != MAP_FAILED)
+                {
+                    const tSenseHAT_ClipHeader* header = (const tSenseHAT_ClipHeader*)address;
+                    size_t length = (size_t)status.st_size;
+
+                    // Check the header and the index
+                    if ((memcmp(header->magic, kClipMagic, sizeof(kClipMagic)) == 0) &&
+                        (header->version == kClipVersion) &&
+                        (header->entrySize == sizeof(tSenseHAT_ClipIndexEntry)) &&
+                        (header->headerSize == sizeof(tSenseHAT_ClipHeader)) &&
+                        (header->frameCount > 0) &&
+                        (header->frameCount <= ((length - sizeof(tSenseHAT_ClipHeader)) / sizeof(tSenseHAT_ClipIndexEntry))))
+                    {
+                        const tSenseHAT_ClipIndexEntry* index =
+                            (const tSenseHAT_ClipIndexEntry*)((const uint8_t*)address + sizeof(tSenseHAT_ClipHeader));
+                        size_t dataOffset = sizeof(tSenseHAT_ClipHeader) + (header->frameCount * sizeof(tSenseHAT_ClipIndexEntry));
+                        uint32_t frame = 0;
+
+                        for (frame = 0; (frame < header->frameCount) && (result == 0); frame++)
+                        {
+                            if ((index[frame].offset < dataOffset) ||
+                                (index[frame].offset > length) ||
+                                (index[frame].length > (length - index[frame].offset)) ||
+                                (index[frame].duration == 0) ||
+                                ((index[frame].type != kClipKeyframe) && (index[frame].type != kClipDelta)) ||
+                                ((frame == 0) && (index[frame].type != kClipKeyframe)))
+                            {
+                                result = EPROTO;
+                            }
+                        }
+
+                        if (result == 0)
+                        {
+                            tSenseHAT_ClipPrivate* clipPrivate = (tSenseHAT_ClipPrivate*)malloc(sizeof(tSenseHAT_ClipPrivate));
+                            if (clipPrivate != NULL)
+                            {
+                                memset(clipPrivate, 0, sizeof(tSenseHAT_ClipPrivate));
+                                (void)pthread_mutex_init(&(clipPrivate->mutex), NULL);
+                                clipPrivate->mapping = (uint8_t*)address;
+                                clipPrivate->mappingLength = length;
+                                clipPrivate->index = index;
+                                clipPrivate->frameCount = header->frameCount;
+                                *clip = (tSenseHAT_Clip)clipPrivate;
+                            }
+                            else    // malloc failed
+                            {
+                                result = ENOMEM;
+                            }
+                        }
+                    }
+                    else    // Unsupported clip
+                    {
+                        result = EPROTO;
+                    }
+
+                    if (result != 0)
+                    {
+                        (void)munmap(address, length);
+                    }
+                }
+                else    // mmap failed
+                {
+                    result = errno;
+                }
+            }
+            else    // Truncated clip
+            {
+                result = EPROTO;
+            }
+            (void)close(fd);
+        }
+        else    // open failed
+        {
+            result = errno;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipGetFrameCount
+// =================================================================================================
+int32_t SenseHAT_ClipGetFrameCount (const tSenseHAT_Clip clip,
+                                    uint32_t* frameCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((clip != NULL) && (frameCount != NULL))
+    {
+        *frameCount = ((tSenseHAT_ClipPrivate*)clip)->frameCount;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipGetFrame
+// =================================================================================================
+int32_t SenseHAT_ClipGetFrame (const tSenseHAT_Clip clip,
+                               uint32_t frameIndex,
+                               uint16_t* pixels,
+                               double* duration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((clip != NULL) &&
+        (frameIndex < ((tSenseHAT_ClipPrivate*)clip)->frameCount) &&
+        (pixels != NULL) &&
+        (duration != NULL))
+    {
+        tSenseHAT_ClipPrivate* clipPrivate = (tSenseHAT_ClipPrivate*)clip;
+
+        (void)pthread_mutex_lock(&(clipPrivate->mutex));
+        result = SenseHAT_ClipSeek(clipPrivate, frameIndex);
+        if (result == 0)
+        {
+            memcpy(pixels, clipPrivate->pixels, sizeof(clipPrivate->pixels));
+            *duration = (double)(clipPrivate->index[frameIndex].duration) / 1000000.0;
+        }
+        (void)pthread_mutex_unlock(&(clipPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDShowClipFrame
+// =================================================================================================
+int32_t SenseHAT_LEDShowClipFrame (const tSenseHAT_Instance instance,
+                                   const tSenseHAT_Clip clip,
+                                   uint32_t frameIndex)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (clip != NULL) &&
+        (frameIndex < ((tSenseHAT_ClipPrivate*)clip)->frameCount))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_ClipPrivate* clipPrivate = (tSenseHAT_ClipPrivate*)clip;
+
+        (void)pthread_mutex_lock(&(clipPrivate->mutex));
+        result = SenseHAT_ClipSeek(clipPrivate, frameIndex);
+        if (result == 0)
+        {
+            if (instancePrivate->framebuffer.pixels != NULL)
+            {
+                // The whole frame is checked against the device memory, so whatever else wrote
+                // the LED matrix since the last frame, only the pixels that differ are written
+                result = SenseHAT_FramebufferWriteRGB565(instancePrivate, clipPrivate->pixels);
+            }
+            else
+            {
+                tSenseHAT_LEDPixelArray frame;
+
+                // Widen the frame back out for Python
+                SenseHAT_ColorExpandRGB565(clipPrivate->pixels, kClipPixels, frame);
+                result = SenseHAT_LEDSetPixels(instance, frame);
+            }
+        }
+        (void)pthread_mutex_unlock(&(clipPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipClose
+// =================================================================================================
+int32_t SenseHAT_ClipClose (tSenseHAT_Clip* clip)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((clip != NULL) && (*clip != NULL))
+    {
+        tSenseHAT_ClipPrivate* clipPrivate = (tSenseHAT_ClipPrivate*)(*clip);
+
+        (void)munmap(clipPrivate->mapping, clipPrivate->mappingLength);
+        (void)pthread_mutex_destroy(&(clipPrivate->mutex));
+        free((void*)clipPrivate);
+        *clip = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipEncode
+// =================================================================================================
+uint32_t SenseHAT_ClipEncode (const uint16_t* previous,
+                              const uint16_t* pixels,
+                              uint8_t* output)
+{
+    uint32_t length = 0;
+    uint32_t index = 0;
+
+    while (index < kClipPixels)
+    {
+        uint32_t skip = 0;
+        uint32_t count = 1;
+
+        // Deltas skip over the pixels that didn't change
+        if (previous != NULL)
+        {
+            while (((index + skip) < kClipPixels) && (pixels[index + skip] == previous[index + skip]))
+            {
+                skip++;
+            }
+            if ((index + skip) == kClipPixels)
+            {
+                break;
+            }
+        }
+
+        // Then take as many pixels of the same color as there are; a delta run stops at the next
+        // unchanged pixel
+        while (((index + skip + count) < kClipPixels) &&
+               (pixels[index + skip + count] == pixels[index + skip]) &&
+               ((previous == NULL) || (pixels[index + skip + count] != previous[index + skip + count])))
+        {
+            count++;
+        }
+
+        if (previous != NULL)
+        {
+            output[length++] = (uint8_t)skip;
+        }
+        output[length++] = (uint8_t)count;
+        output[length++] = (uint8_t)(pixels[index + skip] & 0xFF);
+        output[length++] = (uint8_t)(pixels[index + skip] >> 8);
+        index += skip + count;
+    }
+    return length;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipSeek
+// =================================================================================================
+int32_t SenseHAT_ClipSeek (tSenseHAT_ClipPrivate* clipPrivate,
+                           uint32_t frameIndex)
+{
+    int32_t result = 0;
+
+    if (!(clipPrivate->decoded) || (frameIndex != clipPrivate->frameIndex))
+    {
+        uint32_t frame = frameIndex;
+
+        // Playing forward decodes one frame; anything else replays from the nearest keyframe
+        if (!(clipPrivate->decoded) || (frameIndex != (clipPrivate->frameIndex + 1)))
+        {
+            while (clipPrivate->index[frame].type != kClipKeyframe)
+            {
+                frame--;
+            }
+        }
+
+        for (; (frame <= frameIndex) && (result == 0); frame++)
+        {
+            result = SenseHAT_ClipDecode(clipPrivate, frame);
+        }
+
+        // A bad frame leaves nothing to build on
+        clipPrivate->decoded = (result == 0);
+        clipPrivate->frameIndex = frameIndex;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ClipDecode
+// =================================================================================================
+int32_t SenseHAT_ClipDecode (tSenseHAT_ClipPrivate* clipPrivate,
+                             uint32_t frameIndex)
+{
+    int32_t result = 0;
+    const tSenseHAT_ClipIndexEntry* entry = &(clipPrivate->index[frameIndex]);
+    const uint8_t* run = clipPrivate->mapping + entry->offset;
+    const uint8_t* end = run + entry->length;
+    uint32_t runSize = (entry->type == kClipKeyframe) ? kClipKeyframeRunSize : kClipDeltaRunSize;
+    uint32_t pixel = 0;
+
+    // Write the runs straight over the last frame
+    while (((run + runSize) <= end) && (result == 0))
+    {
+        uint32_t skip = (entry->type == kClipKeyframe) ? 0 : *run++;
+        uint32_t count = run[0];
+        uint16_t color = (uint16_t)(run[1] | (run[2] << 8));
+
+        run += 3;
+        pixel += skip;
+        if ((pixel < kClipPixels) && (count > 0) && (count <= (kClipPixels - pixel)))
+        {
+            for (; count > 0; count--, pixel++)
+            {
+                clipPrivate->pixels[pixel] = color;
+            }
+        }
+        else    // Run out of bounds
+        {
+            result = EPROTO;
+        }
+    }
+
+    // Keyframes cover every pixel, and nothing is left over
+    if ((result == 0) &&
+        ((run != end) || ((entry->type == kClipKeyframe) && (pixel != kClipPixels))))
+    {
+        result = EPROTO;
+    }
+    return result;
+}
+
+// =================================================================================================
@@ -0,0 +1,702 @@
+// ==================================================================================================
+//
+//  sensehat-codec.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the telemetry encoder and decoder of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-codec.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the telemetry encoder and decoder of
+//! the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <math.h>
+#include <memory.h>
+
+// =================================================================================================
+//  Notes
+// =================================================================================================
+//
+//  Each record is encoded as a bit stream, most significant bit first:
+//
+//  Channel:
+//      '0'                 The channel after the one of the previous record (the order
+//                          SenseHAT_RecorderAppendSample appends them in)
+//      '1' + 4 bits        The channel index
+//
+//  Timestamp, as a delta-of-delta against the previous two timestamps of the same channel, in
+//  ticks of 2^-24 seconds (every timestamp after 1978 is a whole number of ticks):
+//      '0'                 The same timestamp as the previous record
+//      '10' + 7 bits       Delta-of-delta in [-64, 63]
+//      '110' + 12 bits     Delta-of-delta in [-2048, 2047]
+//      '1110' + 24 bits    Delta-of-delta in [-2^23, 2^23 - 1]
+//      '11110' + 64 bits   Any other delta-of-delta
+//      '11111' + 64 bits   The timestamp itself, when it isn't a whole number of ticks
+//
+//  Each of the three values, XORed with the previous value of the same channel:
+//      '0'                 The same value
+//      '10' + n bits       The meaningful bits, when they fit the previous window
+//      '11' + 5 bits + 6 bits + n bits
+//                          The number of leading zeros, n - 1, and the meaningful bits
+//
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Codec ticks per second, as a power of two
+#define kCodecTickShift         24
+
+// Timestamps are only encoded as ticks below this magnitude, so that ticks can't overflow
+static const double kCodecTickLimit = 274877906944.0;   // 2^38
+
+// Number of channel indices
+#define kCodecChannelCount      9
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_CodecInitializeHistory
+static void SenseHAT_CodecInitializeHistory (tSenseHAT_CodecHistory* history);
+
+// SenseHAT_CodecGetChannelIndex
+static int32_t SenseHAT_CodecGetChannelIndex (uint32_t channel);
+
+// SenseHAT_CodecGetTicks
+static bool SenseHAT_CodecGetTicks (double timestamp,
+                                    uint64_t* ticks);
+
+// SenseHAT_CodecUpdateTimestamp
+static void SenseHAT_CodecUpdateTimestamp (tSenseHAT_CodecHistory* history,
+                                           int32_t channel,
+                                           double timestamp,
+                                           uint64_t ticks);
+
+// SenseHAT_CodecDoubleToBits
+static uint64_t SenseHAT_CodecDoubleToBits (double value);
+
+// SenseHAT_CodecBitsToDouble
+static double SenseHAT_CodecBitsToDouble (uint64_t bits);
+
+// SenseHAT_CodecSignExtend
+static int64_t SenseHAT_CodecSignExtend (uint64_t value,
+                                         uint32_t bitCount);
+
+// SenseHAT_EncoderWriteBits
+static void SenseHAT_EncoderWriteBits (tSenseHAT_Encoder* encoder,
+                                       uint64_t value,
+                                       uint32_t bitCount);
+
+// SenseHAT_EncoderWriteTimestamp
+static void SenseHAT_EncoderWriteTimestamp (tSenseHAT_Encoder* encoder,
+                                            int32_t channel,
+                                            double timestamp);
+
+// SenseHAT_EncoderWriteValue
+static void SenseHAT_EncoderWriteValue (tSenseHAT_Encoder* encoder,
+                                        int32_t channel,
+                                        int32_t index,
+                                        double value);
+
+// SenseHAT_DecoderReadBits
+static bool SenseHAT_DecoderReadBits (tSenseHAT_Decoder* decoder,
+                                      uint32_t bitCount,
+                                      uint64_t* value);
+
+// SenseHAT_DecoderReadTimestamp
+static bool SenseHAT_DecoderReadTimestamp (tSenseHAT_Decoder* decoder,
+                                           int32_t channel,
+                                           double* timestamp);
+
+// SenseHAT_DecoderReadValue
+static bool SenseHAT_DecoderReadValue (tSenseHAT_Decoder* decoder,
+                                       int32_t channel,
+                                       int32_t index,
+                                       double* value);
+
+// =================================================================================================
+//  SenseHAT_EncoderInitialize
+// =================================================================================================
+int32_t SenseHAT_EncoderInitialize (tSenseHAT_Encoder* encoder,
+                                    uint8_t* buffer,
+                                    size_t capacity)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((encoder != NULL) &&
+        (buffer != NULL))
+    {
+        memset(encoder, 0, sizeof(tSenseHAT_Encoder));
+        encoder->buffer = buffer;
+        encoder->capacity = capacity;
+        SenseHAT_CodecInitializeHistory(&(encoder->history));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_EncoderAppend
+// =================================================================================================
+int32_t SenseHAT_EncoderAppend (tSenseHAT_Encoder* encoder,
+                                const tSenseHAT_Record* record)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((encoder != NULL) &&
+        (record != NULL) &&
+        (SenseHAT_CodecGetChannelIndex(record->channel) >= 0))
+    {
+        // Leave room for the worst case, so a record is never written partially
+        uint64_t bitsLeft = ((uint64_t)(encoder->capacity) * 8) - encoder->bitCount;
+        if (bitsLeft >= (kSenseHAT_EncodedRecordSizeMax * 8))
+        {
+            tSenseHAT_CodecHistory* history = &(encoder->history);
+            int32_t channel = SenseHAT_CodecGetChannelIndex(record->channel);
+            int32_t index = 0;
+
+            // Write the channel
+            if (channel == (history->channel + 1))
+            {
+                SenseHAT_EncoderWriteBits(encoder, 0x0, 1);
+            }
+            else
+            {
+                SenseHAT_EncoderWriteBits(encoder, 0x1, 1);
+                SenseHAT_EncoderWriteBits(encoder, (uint64_t)channel, 4);
+            }
+            history->channel = channel;
+
+            // Write the timestamp and values
+            SenseHAT_EncoderWriteTimestamp(encoder, channel, record->timestamp);
+            for (index = 0; index < 3; index++)
+            {
+                SenseHAT_EncoderWriteValue(encoder, channel, index, record->values[index]);
+            }
+            encoder->recordCount++;
+        }
+        else    // Buffer full
+        {
+            result = ENOBUFS;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_EncoderGetLength
+// =================================================================================================
+int32_t SenseHAT_EncoderGetLength (const tSenseHAT_Encoder* encoder,
+                                   size_t* length,
+                                   uint32_t* recordCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((encoder != NULL) &&
+        (length != NULL) &&
+        (recordCount != NULL))
+    {
+        // The last byte is padded with zeros
+        *length = (size_t)((encoder->bitCount + 7) / 8);
+        *recordCount = encoder->recordCount;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_DecoderInitialize
+// =================================================================================================
+int32_t SenseHAT_DecoderInitialize (tSenseHAT_Decoder* decoder,
+                                    const uint8_t* buffer,
+                                    size_t length,
+                                    uint32_t recordCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((decoder != NULL) &&
+        ((buffer != NULL) || (length == 0)))
+    {
+        memset(decoder, 0, sizeof(tSenseHAT_Decoder));
+        decoder->buffer = buffer;
+        decoder->length = length;
+        decoder->recordCount = recordCount;
+        SenseHAT_CodecInitializeHistory(&(decoder->history));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_DecoderNext
+// =================================================================================================
+int32_t SenseHAT_DecoderNext (tSenseHAT_Decoder* decoder,
+                              tSenseHAT_Record* record)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((decoder != NULL) &&
+        (record != NULL))
+    {
+        // Any records left?
+        if (decoder->recordCount > 0)
+        {
+            tSenseHAT_CodecHistory* history = &(decoder->history);
+            int32_t channel = history->channel + 1;
+            uint64_t bits = 0;
+            bool valid = SenseHAT_DecoderReadBits(decoder, 1, &bits);
+            int32_t index = 0;
+
+            // Read the channel
+            if (valid && (bits != 0))
+            {
+                valid = SenseHAT_DecoderReadBits(decoder, 4, &bits);
+                channel = (int32_t)bits;
+            }
+            valid = valid && (channel < kCodecChannelCount);
+
+            // Read the timestamp and values
+            memset(record, 0, sizeof(tSenseHAT_Record));
+            if (valid)
+            {
+                history->channel = channel;
+                record->channel = (uint32_t)1 << channel;
+                valid = SenseHAT_DecoderReadTimestamp(decoder, channel, &(record->timestamp));
+            }
+            for (index = 0; valid && (index < 3); index++)
+            {
+                valid = SenseHAT_DecoderReadValue(decoder, channel, index, &(record->values[index]));
+            }
+
+            // Check for success
+            if (valid)
+            {
+                decoder->recordCount--;
+            }
+            else    // Corrupt or truncated stream
+            {
+                decoder->recordCount = 0;
+                result = EPROTO;
+            }
+        }
+        else    // No more records
+        {
+            result = ENODATA;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecInitializeHistory
+// =================================================================================================
+void SenseHAT_CodecInitializeHistory (tSenseHAT_CodecHistory* history)
+{
+    memset(history, 0, sizeof(tSenseHAT_CodecHistory));
+    history->channel = -1;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecGetChannelIndex
+// =================================================================================================
+int32_t SenseHAT_CodecGetChannelIndex (uint32_t channel)
+{
+    int32_t index = -1;
+
+    // A record holds exactly one channel
+    if ((channel != 0) &&
+        ((channel & (channel - 1)) == 0) &&
+        (channel <= eSenseHAT_ChannelJoystick))
+    {
+        index = __builtin_ctz(channel);
+    }
+    return index;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecGetTicks
+// =================================================================================================
+bool SenseHAT_CodecGetTicks (double timestamp,
+                             uint64_t* ticks)
+{
+    bool exact = false;
+
+    // Setup
+    *ticks = 0;
+
+    // Convert to ticks, and check that nothing was lost
+    if (fabs(timestamp) < kCodecTickLimit)
+    {
+        int64_t value = llround(ldexp(timestamp, kCodecTickShift));
+
+        *ticks = (uint64_t)value;
+        exact = (ldexp((double)value, -kCodecTickShift) == timestamp);
+    }
+    return exact;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecUpdateTimestamp
+// =================================================================================================
+void SenseHAT_CodecUpdateTimestamp (tSenseHAT_CodecHistory* history,
+                                    int32_t channel,
+                                    double timestamp,
+                                    uint64_t ticks)
+{
+    // Deltas wrap around rather than overflow, the same way in the encoder and the decoder
+    history->deltas[channel] = ticks - history->ticks[channel];
+    history->ticks[channel] = ticks;
+    history->timestamp = timestamp;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecDoubleToBits
+// =================================================================================================
+uint64_t SenseHAT_CodecDoubleToBits (double value)
+{
+    uint64_t bits = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecBitsToDouble
+// =================================================================================================
+double SenseHAT_CodecBitsToDouble (uint64_t bits)
+{
+    double value = 0.0;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// =================================================================================================
+//  SenseHAT_CodecSignExtend
+// =================================================================================================
+int64_t SenseHAT_CodecSignExtend (uint64_t value,
+                                  uint32_t bitCount)
+{
+    if ((bitCount < 64) && ((value & ((uint64_t)1 << (bitCount - 1))) != 0))
+    {
+        value |= ~(((uint64_t)1 << bitCount) - 1);
+    }
+    return (int64_t)value;
+}
+
+// =================================================================================================
+//  SenseHAT_EncoderWriteBits
+// =================================================================================================
+void SenseHAT_EncoderWriteBits (tSenseHAT_Encoder* encoder,
+                                uint64_t value,
+                                uint32_t bitCount)
+{
+    // Fill the current byte, then whole bytes
+    while (bitCount > 0)
+    {
+        size_t byteIndex = (size_t)(encoder->bitCount >> 3);
+        uint32_t room = 8 - (uint32_t)(encoder->bitCount & 0x7);
+        uint32_t count = (bitCount < room) ? bitCount : room;
+        uint8_t bits = (uint8_t)((value >> (bitCount - count)) & ((1u << count) - 1));
+
+        if (room == 8)
+        {
+            encoder->buffer[byteIndex] = 0;
+        }
+        encoder->buffer[byteIndex] |= (uint8_t)(bits << (room - count));
+        encoder->bitCount += count;
+        bitCount -= count;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_EncoderWriteTimestamp
+// =================================================================================================
+void SenseHAT_EncoderWriteTimestamp (tSenseHAT_Encoder* encoder,
+                                     int32_t channel,
+                                     double timestamp)
+{
+    tSenseHAT_CodecHistory* history = &(encoder->history);
+    uint64_t bits = SenseHAT_CodecDoubleToBits(timestamp);
+    uint64_t ticks = 0;
+    bool exact = SenseHAT_CodecGetTicks(timestamp, &ticks);
+
+    if (bits == SenseHAT_CodecDoubleToBits(history->timestamp))
+    {
+        // Same as the previous record
+        SenseHAT_EncoderWriteBits(encoder, 0x0, 1);
+    }
+    else if (exact)
+    {
+        uint64_t deltaOfDelta = (ticks - history->ticks[channel]) - history->deltas[channel];
+        int64_t value = (int64_t)deltaOfDelta;
+
+        // Use the smallest bucket that fits
+        if ((value >= -64) && (value <= 63))
+        {
+            SenseHAT_EncoderWriteBits(encoder, 0x2, 2);
+            SenseHAT_EncoderWriteBits(encoder, deltaOfDelta, 7);
+        }
+        else if ((value >= -2048) && (value <= 2047))
+        {
+            SenseHAT_EncoderWriteBits(encoder, 0x6, 3);
+            SenseHAT_EncoderWriteBits(encoder, deltaOfDelta, 12);
+        }
+        else if ((value >= -8388608) && (value <= 8388607))
+        {
+            SenseHAT_EncoderWriteBits(encoder, 0xE, 4);
+            SenseHAT_EncoderWriteBits(encoder, deltaOfDelta, 24);
+        }
+        else
+        {
+            SenseHAT_EncoderWriteBits(encoder, 0x1E, 5);
+            SenseHAT_EncoderWriteBits(encoder, deltaOfDelta, 64);
+        }
+    }
+    else    // Not a whole number of ticks
+    {
+        SenseHAT_EncoderWriteBits(encoder, 0x1F, 5);
+        SenseHAT_EncoderWriteBits(encoder, bits, 64);
+    }
+    SenseHAT_CodecUpdateTimestamp(history, channel, timestamp, ticks);
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_EncoderWriteValue
+// =================================================================================================
+void SenseHAT_EncoderWriteValue (tSenseHAT_Encoder* encoder,
+                                 int32_t channel,
+                                 int32_t index,
+                                 double value)
+{
+    tSenseHAT_CodecHistory* history = &(encoder->history);
+    uint64_t bits = SenseHAT_CodecDoubleToBits(value);
+    uint64_t difference = bits ^ history->values[channel][index];
+
+    if (difference == 0)
+    {
+        // Same as the previous value
+        SenseHAT_EncoderWriteBits(encoder, 0x0, 1);
+    }
+    else
+    {
+        uint32_t leading = (uint32_t)__builtin_clzll(difference);
+        uint32_t trailing = (uint32_t)__builtin_ctzll(difference);
+        uint32_t previousLeading = history->leading[channel][index];
+        uint32_t previousLength = history->length[channel][index];
+
+        if ((previousLength != 0) &&
+            (leading >= previousLeading) &&
+            (trailing >= (64 - previousLeading - previousLength)))
+        {
+            // The meaningful bits fit the previous window
+            SenseHAT_EncoderWriteBits(encoder, 0x2, 2);
+            SenseHAT_EncoderWriteBits(encoder, difference >> (64 - previousLeading - previousLength),
+                                      previousLength);
+        }
+        else
+        {
+            uint32_t length = 0;
+
+            // Start a new window
+            if (leading > 31)
+            {
+                leading = 31;
+            }
+            length = 64 - leading - trailing;
+            SenseHAT_EncoderWriteBits(encoder, 0x3, 2);
+            SenseHAT_EncoderWriteBits(encoder, leading, 5);
+            SenseHAT_EncoderWriteBits(encoder, length - 1, 6);
+            SenseHAT_EncoderWriteBits(encoder, difference >> trailing, length);
+            history->leading[channel][index] = (uint8_t)leading;
+            history->length[channel][index] = (uint8_t)length;
+        }
+    }
+    history->values[channel][index] = bits;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_DecoderReadBits
+// =================================================================================================
+bool SenseHAT_DecoderReadBits (tSenseHAT_Decoder* decoder,
+                               uint32_t bitCount,
+                               uint64_t* value)
+{
+    bool valid = false;
+
+    // Setup
+    *value = 0;
+
+    // Check for overrun
+    if ((decoder->bitCount + bitCount) <= ((uint64_t)(decoder->length) * 8))
+    {
+        // Empty the current byte, then whole bytes
+        while (bitCount > 0)
+        {
+            size_t byteIndex = (size_t)(decoder->bitCount >> 3);
+            uint32_t room = 8 - (uint32_t)(decoder->bitCount & 0x7);
+            uint32_t count = (bitCount < room) ? bitCount : room;
+            uint32_t bits = ((uint32_t)(decoder->buffer[byteIndex]) >> (room - count)) & ((1u << count) - 1);
+
+            *value = (*value << count) | bits;
+            decoder->bitCount += count;
+            bitCount -= count;
+        }
+        valid = true;
+    }
+    return valid;
+}
+
+// =================================================================================================
+//  SenseHAT_DecoderReadTimestamp
+// =================================================================================================
+bool SenseHAT_DecoderReadTimestamp (tSenseHAT_Decoder* decoder,
+                                    int32_t channel,
+                                    double* timestamp)
+{
+    tSenseHAT_CodecHistory* history = &(decoder->history);
+    uint64_t bits = 0;
+    uint64_t ticks = 0;
+    uint32_t prefix = 0;
+    bool valid = true;
+
+    // Count the leading ones of the prefix
+    while (valid && (prefix < 5))
+    {
+        valid = SenseHAT_DecoderReadBits(decoder, 1, &bits);
+        if (valid && (bits == 0))
+        {
+            break;
+        }
+        prefix++;
+    }
+
+    if (valid)
+    {
+        if (prefix == 0)
+        {
+            // Same as the previous record
+            *timestamp = history->timestamp;
+            (void)SenseHAT_CodecGetTicks(*timestamp, &ticks);
+        }
+        else if (prefix == 5)
+        {
+            // Not a whole number of ticks
+            valid = SenseHAT_DecoderReadBits(decoder, 64, &bits);
+            *timestamp = SenseHAT_CodecBitsToDouble(bits);
+            (void)SenseHAT_CodecGetTicks(*timestamp, &ticks);
+        }
+        else
+        {
+            static const uint32_t kBucketSizes[4] = { 7, 12, 24, 64 };
+            uint32_t bitCount = kBucketSizes[prefix - 1];
+
+            // Delta-of-delta
+            valid = SenseHAT_DecoderReadBits(decoder, bitCount, &bits);
+            ticks = history->ticks[channel] + history->deltas[channel] +
+                    (uint64_t)SenseHAT_CodecSignExtend(bits, bitCount);
+            *timestamp = ldexp((double)(int64_t)ticks, -kCodecTickShift);
+        }
+    }
+    if (valid)
+    {
+        SenseHAT_CodecUpdateTimestamp(history, channel, *timestamp, ticks);
+    }
+    return valid;
+}
+
+// =================================================================================================
+//  SenseHAT_DecoderReadValue
+// =================================================================================================
+bool SenseHAT_DecoderReadValue (tSenseHAT_Decoder* decoder,
+                                int32_t channel,
+                                int32_t index,
+                                double* value)
+{
+    tSenseHAT_CodecHistory* history = &(decoder->history);
+    uint64_t difference = 0;
+    uint64_t bits = 0;
+    bool valid = SenseHAT_DecoderReadBits(decoder, 1, &bits);
+
+    if (valid && (bits != 0))
+    {
+        valid = SenseHAT_DecoderReadBits(decoder, 1, &bits);
+        if (valid && (bits == 0))
+        {
+            uint32_t leading = history->leading[channel][index];
+            uint32_t length = history->length[channel][index];
+
+            // The meaningful bits fit the previous window
+            valid = (length != 0) && SenseHAT_DecoderReadBits(decoder, length, &bits);
+            difference = bits << (64 - leading - length);
+        }
+        else if (valid)
+        {
+            uint64_t leading = 0;
+            uint64_t length = 0;
+
+            // A new window
+            valid = SenseHAT_DecoderReadBits(decoder, 5, &leading) &&
+                    SenseHAT_DecoderReadBits(decoder, 6, &length);
+            length++;
+            valid = valid && ((leading + length) <= 64) &&
+                    SenseHAT_DecoderReadBits(decoder, (uint32_t)length, &bits);
+            if (valid)
+            {
+                difference = bits << (64 - leading - length);
+                history->leading[channel][index] = (uint8_t)leading;
+                history->length[channel][index] = (uint8_t)length;
+            }
+        }
+    }
+    history->values[channel][index] ^= difference;
+    *value = SenseHAT_CodecBitsToDouble(history->values[channel][index]);
+    return valid;
+}
+
+// =================================================================================================
@@ -0,0 +1,322 @@
+// ==================================================================================================
+//
+//  sensehat-color.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the color conversion functions of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-color.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the color conversion functions of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <pthread.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define kColorNEON  1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define kColorSSE2  1
+#endif
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Number of pixels split into planes at a time
+#define kColorChunkPixels   64
+
+// =================================================================================================
+//  Globals
+// =================================================================================================
+
+// Full brightness, no gamma table
+static tSenseHAT_ColorTable gColorTableDefault;
+static pthread_once_t gColorTableDefaultOnce = PTHREAD_ONCE_INIT;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_ColorTableDefault
+static void SenseHAT_ColorTableDefault (void);
+
+// SenseHAT_ColorPack
+static void SenseHAT_ColorPack (const tSenseHAT_ColorTable* table,
+                                const uint8_t* red,
+                                const uint8_t* green,
+                                const uint8_t* blue,
+                                uint32_t count,
+                                uint16_t* output);
+
+// =================================================================================================
+//  SenseHAT_ColorTableInitialize
+// =================================================================================================
+int32_t SenseHAT_ColorTableInitialize (tSenseHAT_ColorTable* table,
+                                       const uint8_t* gamma,
+                                       double brightness)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((table != NULL) &&
+        (brightness >= 0.0) &&
+        (brightness <= 1.0))
+    {
+        uint32_t index = 0;
+
+        // Check the gamma table
+        if (gamma != NULL)
+        {
+            for (index = 0; index < kSenseHAT_GammaTableSize; index++)
+            {
+                if (gamma[index] > 31)
+                {
+                    result = EINVAL;
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            // The vector kernels compute exactly what these tables hold
+            table->scale = (uint16_t)((brightness * 256.0) + 0.5);
+            table->linear = (gamma == NULL);
+            for (index = 0; index < 256; index++)
+            {
+                uint32_t value = ((index * table->scale) + 128) >> 8;
+                uint32_t red = value >> 3;
+                uint32_t green = value >> 2;
+                uint32_t blue = value >> 3;
+
+                if (gamma != NULL)
+                {
+                    red = gamma[red];
+                    green = gamma[green >> 1];
+                    green = (green << 1) | (green >> 4);
+                    blue = gamma[blue];
+                }
+                table->red[index] = (uint16_t)(red << 11);
+                table->green[index] = (uint16_t)(green << 5);
+                table->blue[index] = (uint16_t)blue;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ColorConvertFrames
+// =================================================================================================
+int32_t SenseHAT_ColorConvertFrames (const tSenseHAT_ColorTable* table,
+                                     const tSenseHAT_LEDPixelArray* frames,
+                                     uint32_t frameCount,
+                                     uint16_t* output)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((frames != NULL) && (output != NULL))
+    {
+        uint8_t red[kColorChunkPixels];
+        uint8_t green[kColorChunkPixels];
+        uint8_t blue[kColorChunkPixels];
+        uint32_t frame = 0;
+        uint32_t index = 0;
+
+        if (table == NULL)
+        {
+            (void)pthread_once(&gColorTableDefaultOnce, SenseHAT_ColorTableDefault);
+            table = &gColorTableDefault;
+        }
+
+        for (frame = 0; (frame < frameCount) && (result == 0); frame++)
+        {
+            int32_t bits = 0;
+
+            // Split the frame into planes; any component outside 0 to 255 sets a bit above the
+            // low byte
+            for (index = 0; index < kColorChunkPixels; index++)
+            {
+                bits |= frames[frame][index].red | frames[frame][index].green | frames[frame][index].blue;
+                red[index] = (uint8_t)(frames[frame][index].red);
+                green[index] = (uint8_t)(frames[frame][index].green);
+                blue[index] = (uint8_t)(frames[frame][index].blue);
+            }
+            if ((bits & ~0xFF) == 0)
+            {
+                SenseHAT_ColorPack(table, red, green, blue, kColorChunkPixels, output + (frame * kColorChunkPixels));
+            }
+            else    // Invalid pixel
+            {
+                result = EINVAL;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ColorConvertRGB888
+// =================================================================================================
+int32_t SenseHAT_ColorConvertRGB888 (const tSenseHAT_ColorTable* table,
+                                     const uint8_t* rgb,
+                                     uint32_t pixelCount,
+                                     uint16_t* output)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((rgb != NULL) && (output != NULL))
+    {
+        uint8_t red[kColorChunkPixels];
+        uint8_t green[kColorChunkPixels];
+        uint8_t blue[kColorChunkPixels];
+        uint32_t start = 0;
+        uint32_t index = 0;
+
+        if (table == NULL)
+        {
+            (void)pthread_once(&gColorTableDefaultOnce, SenseHAT_ColorTableDefault);
+            table = &gColorTableDefault;
+        }
+
+        // Split the pixels into planes a chunk at a time
+        for (start = 0; start < pixelCount; start += kColorChunkPixels)
+        {
+            uint32_t count = pixelCount - start;
+            if (count > kColorChunkPixels)
+            {
+                count = kColorChunkPixels;
+            }
+            for (index = 0; index < count; index++)
+            {
+                red[index] = rgb[((start + index) * 3) + 0];
+                green[index] = rgb[((start + index) * 3) + 1];
+                blue[index] = rgb[((start + index) * 3) + 2];
+            }
+            SenseHAT_ColorPack(table, red, green, blue, count, output + start);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ColorExpandRGB565
+// =================================================================================================
+void SenseHAT_ColorExpandRGB565 (const uint16_t* pixels,
+                                 uint32_t pixelCount,
+                                 tSenseHAT_LEDPixel* output)
+{
+    uint32_t index = 0;
+
+    // Replicate the high bits into the low ones, so full scale stays full scale
+    for (index = 0; index < pixelCount; index++)
+    {
+        uint32_t pixel = pixels[index];
+        output[index].red = (int32_t)(((pixel >> 11) << 3) | (pixel >> 13));
+        output[index].green = (int32_t)((((pixel >> 5) & 0x3F) << 2) | ((pixel >> 9) & 0x03));
+        output[index].blue = (int32_t)(((pixel & 0x1F) << 3) | ((pixel >> 2) & 0x07));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_ColorTableDefault
+// =================================================================================================
+void SenseHAT_ColorTableDefault (void)
+{
+    (void)SenseHAT_ColorTableInitialize(&gColorTableDefault, NULL, 1.0);
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_ColorPack
+// =================================================================================================
+void SenseHAT_ColorPack (const tSenseHAT_ColorTable* table,
+                         const uint8_t* red,
+                         const uint8_t* green,
+                         const uint8_t* blue,
+                         uint32_t count,
+                         uint16_t* output)
+{
+    uint32_t index = 0;
+
+    // Without a gamma curve each component is just scaled by the brightness and truncated to
+    // its field, which vectorizes; (value * scale + 128) >> 8 never exceeds 16 bits
+    if (table->linear)
+    {
+#if defined(kColorNEON)
+        uint16x8_t scale = vdupq_n_u16(table->scale);
+        uint16x8_t bias = vdupq_n_u16(128);
+        for (; (index + 8) <= count; index += 8)
+        {
+            uint16x8_t r = vshrq_n_u16(vmlaq_u16(bias, vmovl_u8(vld1_u8(red + index)), scale), 8);
+            uint16x8_t g = vshrq_n_u16(vmlaq_u16(bias, vmovl_u8(vld1_u8(green + index)), scale), 8);
+            uint16x8_t b = vshrq_n_u16(vmlaq_u16(bias, vmovl_u8(vld1_u8(blue + index)), scale), 8);
+
+            vst1q_u16(output + index, vorrq_u16(vorrq_u16(vshlq_n_u16(vshrq_n_u16(r, 3), 11),
+                                                          vshlq_n_u16(vshrq_n_u16(g, 2), 5)),
+                                                vshrq_n_u16(b, 3)));
+        }
+#elif defined(kColorSSE2)
+        __m128i zero = _mm_setzero_si128();
+        __m128i scale = _mm_set1_epi16((int16_t)(table->scale));
+        __m128i bias = _mm_set1_epi16(128);
+        for (; (index + 8) <= count; index += 8)
+        {
+            __m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(red + index)), zero);
+            __m128i g = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(green + index)), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(blue + index)), zero);
+
+            r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, scale), bias), 8);
+            g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, scale), bias), 8);
+            b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, scale), bias), 8);
+            _mm_storeu_si128((__m128i*)(output + index),
+                             _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(r, 3), 11),
+                                                       _mm_slli_epi16(_mm_srli_epi16(g, 2), 5)),
+                                          _mm_srli_epi16(b, 3)));
+        }
+#endif
+    }
+
+    // Gamma curves, and whatever the vector loop left
+    for (; index < count; index++)
+    {
+        output[index] = table->red[red[index]] | table->green[green[index]] | table->blue[blue[index]];
+    }
+    return;
+}
+
+// =================================================================================================
@@ -0,0 +1,797 @@
+// ==================================================================================================
+//
+//  sensehat-compass.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the magnetometer calibration and compass
+//      heading of the Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-compass.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the magnetometer calibration and
+//! compass heading of the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Calibration file magic number and version
+static const char kCalibrationMagic[4] = { 'S', 'H', 'M', 'C' };
+#define kCalibrationVersion 1
+
+// Readings are scaled to about unit size before fitting, which keeps the fourth powers in the
+// normal equations well conditioned
+static const double kFitScale           = 0.01;
+
+// Smallest Cholesky pivot, relative to the largest diagonal term, accepted as nonsingular
+static const double kPivotTolerance     = 1.0e-12;
+
+// Smallest |k| in (x - centre)' A (x - centre) = k accepted; k is near 1 with the origin at the
+// centre of the readings, and goes through 0 (changing sign) as the origin crosses their surface
+static const double kQuadricTolerance   = 1.0e-9;
+
+// Jacobi sweeps before giving up on convergence (3x3 matrices converge in a handful)
+#define kJacobiSweepsMax    32
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+// Calibration file header
+typedef struct
+{
+    char        magic[4];       // kCalibrationMagic
+    uint16_t    version;        // kCalibrationVersion
+    uint16_t    reserved;
+    uint32_t    size;           // sizeof(tSenseHAT_MagCalibration)
+}
+tSenseHAT_CalibrationHeader;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_CompassSymmetricEigen
+static void SenseHAT_CompassSymmetricEigen (double matrix[3][3],
+                                            double eigenvalues[3],
+                                            double eigenvectors[3][3]);
+
+// SenseHAT_CompassSetCalibration
+static void SenseHAT_CompassSetCalibration (tSenseHAT_Cache* cache,
+                                            const tSenseHAT_MagCalibration* calibration);
+
+// =================================================================================================
+//  SenseHAT_MagCalibratorInitialize
+// =================================================================================================
+int32_t SenseHAT_MagCalibratorInitialize (tSenseHAT_MagCalibrator* calibrator)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (calibrator != NULL)
+    {
+        memset(calibrator, 0, sizeof(tSenseHAT_MagCalibrator));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MagCalibratorAdd
+// =================================================================================================
+int32_t SenseHAT_MagCalibratorAdd (tSenseHAT_MagCalibrator* calibrator,
+                                   const tSenseHAT_RawData* reading)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((calibrator != NULL) &&
+        (reading != NULL) &&
+        isfinite(reading->x) && isfinite(reading->y) && isfinite(reading->z))
+    {
+        double x = reading->x * kFitScale;
+        double y = reading->y * kFitScale;
+        double z = reading->z * kFitScale;
+        double terms[9];
+        int32_t row = 0;
+        int32_t column = 0;
+
+        // The ellipsoid is a x² + b y² + c z² + 2h xy + 2g xz + 2f yz + 2p x + 2q y + 2r z = 1
+        terms[0] = x * x;
+        terms[1] = y * y;
+        terms[2] = z * z;
+        terms[3] = 2.0 * x * y;
+        terms[4] = 2.0 * x * z;
+        terms[5] = 2.0 * y * z;
+        terms[6] = 2.0 * x;
+        terms[7] = 2.0 * y;
+        terms[8] = 2.0 * z;
+
+        // Accumulate the lower triangle of the normal equations
+        for (row = 0; row < 9; row++)
+        {
+            for (column = 0; column <= row; column++)
+            {
+                calibrator->sums[row][column] += terms[row] * terms[column];
+            }
+            calibrator->rhs[row] += terms[row];
+        }
+        calibrator->count++;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MagCalibratorSolve
+// =================================================================================================
+int32_t SenseHAT_MagCalibratorSolve (const tSenseHAT_MagCalibrator* calibrator,
+                                     tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((calibrator != NULL) && (calibration != NULL))
+    {
+        if (calibrator->count >= kSenseHAT_MagCalibrationSamplesMin)
+        {
+            double lower[9][9];
+            double solution[9];
+            double largest = 0.0;
+            int32_t row = 0;
+            int32_t column = 0;
+            int32_t index = 0;
+
+            // Cholesky factor the normal equations
+            for (row = 0; row < 9; row++)
+            {
+                largest = fmax(largest, calibrator->sums[row][row]);
+            }
+            for (column = 0; (column < 9) && (result == 0); column++)
+            {
+                double pivot = calibrator->sums[column][column];
+                for (index = 0; index < column; index++)
+                {
+                    pivot -= lower[column][index] * lower[column][index];
+                }
+                if (pivot > (kPivotTolerance * largest))
+                {
+                    lower[column][column] = sqrt(pivot);
+                    for (row = column + 1; row < 9; row++)
+                    {
+                        double value = calibrator->sums[row][column];
+                        for (index = 0; index < column; index++)
+                        {
+                            value -= lower[row][index] * lower[column][index];
+                        }
+                        lower[row][column] = value / lower[column][column];
+                    }
+                }
+                else    // The readings don't span an ellipsoid
+                {
+                    result = EDOM;
+                }
+            }
+
+            if (result == 0)
+            {
+                double a[3][3];
+                double inverse[3][3];
+                double b[3];
+                double centre[3];
+                double determinant = 0.0;
+                double k = 0.0;
+                double residual = 0.0;
+
+                // Forward and back substitute
+                for (row = 0; row < 9; row++)
+                {
+                    double value = calibrator->rhs[row];
+                    for (index = 0; index < row; index++)
+                    {
+                        value -= lower[row][index] * solution[index];
+                    }
+                    solution[row] = value / lower[row][row];
+                }
+                for (row = 8; row >= 0; row--)
+                {
+                    double value = solution[row];
+                    for (index = row + 1; index < 9; index++)
+                    {
+                        value -= lower[index][row] * solution[index];
+                    }
+                    solution[row] = value / lower[row][row];
+                }
+
+                // Sum of squared residuals, v'Sv - 2v'r + n, from the accumulated sums
+                for (row = 0; row < 9; row++)
+                {
+                    double value = 0.0;
+                    for (column = 0; column < 9; column++)
+                    {
+                        value += ((column <= row) ? calibrator->sums[row][column] : calibrator->sums[column][row]) * solution[column];
+                    }
+                    residual += solution[row] * (value - (2.0 * calibrator->rhs[row]));
+                }
+                residual = fmax(residual + (double)(calibrator->count), 0.0);
+
+                // Quadratic form and linear term
+                a[0][0] = solution[0];
+                a[1][1] = solution[1];
+                a[2][2] = solution[2];
+                a[0][1] = a[1][0] = solution[3];
+                a[0][2] = a[2][0] = solution[4];
+                a[1][2] = a[2][1] = solution[5];
+                b[0] = solution[6];
+                b[1] = solution[7];
+                b[2] = solution[8];
+
+                // The centre is -A⁻¹b
+                inverse[0][0] = (a[1][1] * a[2][2]) - (a[1][2] * a[2][1]);
+                inverse[0][1] = (a[0][2] * a[2][1]) - (a[0][1] * a[2][2]);
+                inverse[0][2] = (a[0][1] * a[1][2]) - (a[0][2] * a[1][1]);
+                inverse[1][0] = (a[1][2] * a[2][0]) - (a[1][0] * a[2][2]);
+                inverse[1][1] = (a[0][0] * a[2][2]) - (a[0][2] * a[2][0]);
+                inverse[1][2] = (a[0][2] * a[1][0]) - (a[0][0] * a[1][2]);
+                inverse[2][0] = (a[1][0] * a[2][1]) - (a[1][1] * a[2][0]);
+                inverse[2][1] = (a[0][1] * a[2][0]) - (a[0][0] * a[2][1]);
+                inverse[2][2] = (a[0][0] * a[1][1]) - (a[0][1] * a[1][0]);
+                determinant = (a[0][0] * inverse[0][0]) + (a[0][1] * inverse[1][0]) + (a[0][2] * inverse[2][0]);
+                if (determinant != 0.0)
+                {
+                    for (row = 0; row < 3; row++)
+                    {
+                        centre[row] = 0.0;
+                        for (column = 0; column < 3; column++)
+                        {
+                            inverse[row][column] /= determinant;
+                            centre[row] -= inverse[row][column] * b[column];
+                        }
+                    }
+
+                    // (x - centre)' A (x - centre) = k, with k = 1 + b'A⁻¹b = 1 - b'centre; k
+                    // is negative (along with A) when the hard iron offset puts the origin
+                    // outside the ellipsoid, which dividing by k takes care of
+                    k = 1.0 - ((b[0] * centre[0]) + (b[1] * centre[1]) + (b[2] * centre[2]));
+                }
+                if (fabs(k) > kQuadricTolerance)
+                {
+                    double eigenvalues[3];
+                    double eigenvectors[3][3];
+
+                    // Normalize to (x - centre)' M (x - centre) = 1
+                    for (row = 0; row < 3; row++)
+                    {
+                        for (column = 0; column < 3; column++)
+                        {
+                            a[row][column] /= k;
+                        }
+                    }
+                    SenseHAT_CompassSymmetricEigen(a, eigenvalues, eigenvectors);
+
+                    // An ellipsoid needs M positive definite
+                    if ((eigenvalues[0] > 0.0) && (eigenvalues[1] > 0.0) && (eigenvalues[2] > 0.0))
+                    {
+                        // Radius preserving the volume of the ellipsoid, det(M)^(-1/6)
+                        double radius = pow(eigenvalues[0] * eigenvalues[1] * eigenvalues[2], -1.0 / 6.0);
+
+                        // The correction is radius * sqrt(M), which is dimensionless, so the
+                        // fit scale only affects the offset and the radius
+                        memset(calibration, 0, sizeof(tSenseHAT_MagCalibration));
+                        for (row = 0; row < 3; row++)
+                        {
+                            for (column = 0; column < 3; column++)
+                            {
+                                double value = 0.0;
+                                for (index = 0; index < 3; index++)
+                                {
+                                    value += eigenvectors[row][index] * sqrt(eigenvalues[index]) * eigenvectors[column][index];
+                                }
+                                calibration->matrix[row][column] = radius * value;
+                            }
+                        }
+                        calibration->offset.x = centre[0] / kFitScale;
+                        calibration->offset.y = centre[1] / kFitScale;
+                        calibration->offset.z = centre[2] / kFitScale;
+                        calibration->fieldStrength = radius / kFitScale;
+
+                        // Each residual is about k times twice the relative radial error
+                        calibration->fitError = sqrt(residual / (double)(calibrator->count)) / (2.0 * fabs(k));
+                    }
+                    else    // Not an ellipsoid
+                    {
+                        result = EDOM;
+                    }
+                }
+                else    // Not an ellipsoid
+                {
+                    result = EDOM;
+                }
+            }
+        }
+        else    // Not enough readings
+        {
+            result = ENODATA;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SetMagCalibration
+// =================================================================================================
+int32_t SenseHAT_SetMagCalibration (const tSenseHAT_Instance instance,
+                                    const tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+        SenseHAT_CompassSetCalibration(&(instancePrivate->cache), calibration);
+        (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetMagCalibration
+// =================================================================================================
+int32_t SenseHAT_GetMagCalibration (const tSenseHAT_Instance instance,
+                                    tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (calibration != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+        if (instancePrivate->cache.magCalibrated)
+        {
+            *calibration = instancePrivate->cache.magCalibration;
+        }
+        else    // No calibration
+        {
+            result = ENODATA;
+        }
+        (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CalibrateCompass
+// =================================================================================================
+int32_t SenseHAT_CalibrateCompass (const tSenseHAT_Instance instance,
+                                   double durationSeconds,
+                                   double intervalSeconds,
+                                   tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (durationSeconds > 0.0) &&
+        (intervalSeconds > 0.0) &&
+        (calibration != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Cache* cache = &(instancePrivate->cache);
+        tSenseHAT_MagCalibrator calibrator;
+        tSenseHAT_MagCalibration previous;
+        bool hadCalibration = false;
+        double start = SenseHAT_GetMonotonicTime();
+        double wakeTime = start;
+
+        // Remove the current calibration, so the readings come back uncorrected
+        (void)pthread_mutex_lock(&(cache->mutex));
+        hadCalibration = cache->magCalibrated;
+        previous = cache->magCalibration;
+        SenseHAT_CompassSetCalibration(cache, NULL);
+        (void)pthread_mutex_unlock(&(cache->mutex));
+
+        // Collect readings on a fixed schedule
+        (void)SenseHAT_MagCalibratorInitialize(&calibrator);
+        while ((result == 0) && (wakeTime < (start + durationSeconds)))
+        {
+            tSenseHAT_Sample sample;
+            struct timespec deadline;
+
+            result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelCompassRaw, 0.0, &sample);
+            if (result == 0)
+            {
+                (void)SenseHAT_MagCalibratorAdd(&calibrator, &(sample.compassRaw));
+
+                wakeTime += intervalSeconds;
+                deadline.tv_sec = (time_t)wakeTime;
+                deadline.tv_nsec = (long)((wakeTime - (double)deadline.tv_sec) * 1000000000.0);
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+                {
+                    // Keep sleeping
+                }
+            }
+        }
+
+        // Fit, and install the result or put the old calibration back
+        if (result == 0)
+        {
+            result = SenseHAT_MagCalibratorSolve(&calibrator, calibration);
+        }
+        (void)pthread_mutex_lock(&(cache->mutex));
+        if (result == 0)
+        {
+            SenseHAT_CompassSetCalibration(cache, calibration);
+        }
+        else if (hadCalibration && !(cache->magCalibrated))
+        {
+            SenseHAT_CompassSetCalibration(cache, &previous);
+        }
+        (void)pthread_mutex_unlock(&(cache->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SaveMagCalibration
+// =================================================================================================
+int32_t SenseHAT_SaveMagCalibration (const char* path,
+                                     const tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((path != NULL) &&
+        (strlen(path) > 0) &&
+        (calibration != NULL))
+    {
+        size_t temporaryPathSize = strlen(path) + 5;
+        char* temporaryPath = (char*)malloc(temporaryPathSize);
+        if (temporaryPath != NULL)
+        {
+            tSenseHAT_CalibrationHeader header;
+
+            memset(&header, 0, sizeof(tSenseHAT_CalibrationHeader));
+            memcpy(header.magic, kCalibrationMagic, sizeof(kCalibrationMagic));
+            header.version = kCalibrationVersion;
+            header.size = sizeof(tSenseHAT_MagCalibration);
+
+            // Write a new file and rename it over the old one, so a crash never leaves a
+            // partial file behind
+            (void)snprintf(temporaryPath, temporaryPathSize, "%s.tmp", path);
+            int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd >= 0)
+            {
+                if ((write(fd, &header, sizeof(tSenseHAT_CalibrationHeader)) != (ssize_t)sizeof(tSenseHAT_CalibrationHeader)) ||
+                    (write(fd, calibration, sizeof(tSenseHAT_MagCalibration)) != (ssize_t)sizeof(tSenseHAT_MagCalibration)) ||
+                    (fdatasync(fd) != 0))
+                {
+                    result = EIO;
+                }
+                (void)close(fd);
+                if (result == 0)
+                {
+                    if (rename(temporaryPath, path) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+                if (result != 0)
+                {
+                    (void)unlink(temporaryPath);
+                }
+            }
+            else    // open failed
+            {
+                result = errno;
+            }
+            free((void*)temporaryPath);
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LoadMagCalibration
+// =================================================================================================
+int32_t SenseHAT_LoadMagCalibration (const char* path,
+                                     tSenseHAT_MagCalibration* calibration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((path != NULL) &&
+        (strlen(path) > 0) &&
+        (calibration != NULL))
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            tSenseHAT_CalibrationHeader header;
+            tSenseHAT_MagCalibration loaded;
+
+            // Check the header and read the calibration
+            if ((read(fd, &header, sizeof(tSenseHAT_CalibrationHeader)) == (ssize_t)sizeof(tSenseHAT_CalibrationHeader)) &&
+                (memcmp(header.magic, kCalibrationMagic, sizeof(kCalibrationMagic)) == 0) &&
+                (header.version == kCalibrationVersion) &&
+                (header.size == sizeof(tSenseHAT_MagCalibration)) &&
+                (read(fd, &loaded, sizeof(tSenseHAT_MagCalibration)) == (ssize_t)sizeof(tSenseHAT_MagCalibration)))
+            {
+                *calibration = loaded;
+            }
+            else    // Not a calibration file
+            {
+                result = EPROTO;
+            }
+            (void)close(fd);
+        }
+        else    // open failed
+        {
+            result = errno;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ComputeHeading
+// =================================================================================================
+int32_t SenseHAT_ComputeHeading (const tSenseHAT_RawData* acceleration,
+                                 const tSenseHAT_RawData* magneticField,
+                                 double* heading)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((acceleration != NULL) &&
+        (magneticField != NULL) &&
+        (heading != NULL))
+    {
+        // Roll and pitch from gravity, as RTIMULib's calculatePose does
+        double roll = atan2(acceleration->y, acceleration->z);
+        double pitch = -atan2(acceleration->x, sqrt((acceleration->y * acceleration->y) + (acceleration->z * acceleration->z)));
+        double cosRoll = cos(roll);
+        double sinRoll = sin(roll);
+        double cosPitch = cos(pitch);
+        double sinPitch = sin(pitch);
+
+        // Project the field onto the horizontal plane
+        double fx = (magneticField->x * cosPitch) +
+                    (magneticField->y * sinPitch * sinRoll) +
+                    (magneticField->z * sinPitch * cosRoll);
+        double fy = (magneticField->y * cosRoll) - (magneticField->z * sinRoll);
+
+        if (((acceleration->x != 0.0) || (acceleration->y != 0.0) || (acceleration->z != 0.0)) &&
+            ((fx != 0.0) || (fy != 0.0)))
+        {
+            double degrees = -atan2(fy, fx) * 180.0 / M_PI;
+            if (degrees < 0.0)
+            {
+                degrees += 360.0;
+            }
+            *heading = (degrees < 360.0) ? degrees : 0.0;
+        }
+        else    // No direction
+        {
+            result = EDOM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetHeading
+// =================================================================================================
+int32_t SenseHAT_GetHeading (const tSenseHAT_Instance instance,
+                             double* heading)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (heading != NULL))
+    {
+        tSenseHAT_Sample sample;
+
+        result = SenseHAT_GetChannels(instance,
+                                      eSenseHAT_ChannelAccelerometerRaw | eSenseHAT_ChannelCompassRaw,
+                                      kSenseHAT_CacheMaxAgeDefault,
+                                      &sample);
+        if (result == 0)
+        {
+            result = SenseHAT_ComputeHeading(&(sample.accelerometerRaw), &(sample.compassRaw), heading);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompassCorrect
+// =================================================================================================
+void SenseHAT_CompassCorrect (const tSenseHAT_Cache* cache,
+                              tSenseHAT_Sample* sample)
+{
+    if (cache->magCalibrated)
+    {
+        const tSenseHAT_MagCalibration* calibration = &(cache->magCalibration);
+        double x = sample->compassRaw.x;
+        double y = sample->compassRaw.y;
+        double z = sample->compassRaw.z;
+
+        sample->compassRaw.x = fma(calibration->matrix[0][0], x, fma(calibration->matrix[0][1], y, fma(calibration->matrix[0][2], z, cache->magBias[0])));
+        sample->compassRaw.y = fma(calibration->matrix[1][0], x, fma(calibration->matrix[1][1], y, fma(calibration->matrix[1][2], z, cache->magBias[1])));
+        sample->compassRaw.z = fma(calibration->matrix[2][0], x, fma(calibration->matrix[2][1], y, fma(calibration->matrix[2][2], z, cache->magBias[2])));
+    }
+}
+
+// =================================================================================================
+//  SenseHAT_CompassSymmetricEigen
+// =================================================================================================
+void SenseHAT_CompassSymmetricEigen (double matrix[3][3],
+                                     double eigenvalues[3],
+                                     double eigenvectors[3][3])
+{
+    int32_t sweep = 0;
+    int32_t row = 0;
+    int32_t column = 0;
+    int32_t index = 0;
+
+    // Cyclic Jacobi rotations; the matrix is diagonalized in place
+    for (row = 0; row < 3; row++)
+    {
+        for (column = 0; column < 3; column++)
+        {
+            eigenvectors[row][column] = (row == column) ? 1.0 : 0.0;
+        }
+    }
+    for (sweep = 0; sweep < kJacobiSweepsMax; sweep++)
+    {
+        double offDiagonal = fabs(matrix[0][1]) + fabs(matrix[0][2]) + fabs(matrix[1][2]);
+        if (offDiagonal == 0.0)
+        {
+            break;
+        }
+        for (row = 0; row < 2; row++)
+        {
+            for (column = row + 1; column < 3; column++)
+            {
+                if (matrix[row][column] != 0.0)
+                {
+                    double theta = (matrix[column][column] - matrix[row][row]) / (2.0 * matrix[row][column]);
+                    double t = ((theta >= 0.0) ? 1.0 : -1.0) / (fabs(theta) + sqrt((theta * theta) + 1.0));
+                    double c = 1.0 / sqrt((t * t) + 1.0);
+                    double s = t * c;
+
+                    // A' = J'AJ, V' = VJ
+                    for (index = 0; index < 3; index++)
+                    {
+                        double upper = matrix[index][row];
+                        double lower = matrix[index][column];
+                        matrix[index][row] = (c * upper) - (s * lower);
+                        matrix[index][column] = (s * upper) + (c * lower);
+                    }
+                    for (index = 0; index < 3; index++)
+                    {
+                        double upper = matrix[row][index];
+                        double lower = matrix[column][index];
+                        matrix[row][index] = (c * upper) - (s * lower);
+                        matrix[column][index] = (s * upper) + (c * lower);
+                    }
+                    for (index = 0; index < 3; index++)
+                    {
+                        double upper = eigenvectors[index][row];
+                        double lower = eigenvectors[index][column];
+                        eigenvectors[index][row] = (c * upper) - (s * lower);
+                        eigenvectors[index][column] = (s * upper) + (c * lower);
+                    }
+                }
+            }
+        }
+    }
+    for (index = 0; index < 3; index++)
+    {
+        eigenvalues[index] = matrix[index][index];
+    }
+}
+
+// =================================================================================================
+//  SenseHAT_CompassSetCalibration
+// =================================================================================================
+void SenseHAT_CompassSetCalibration (tSenseHAT_Cache* cache,
+                                     const tSenseHAT_MagCalibration* calibration)
+{
+    int32_t row = 0;
+
+    if (calibration != NULL)
+    {
+        // Fold the offset into a bias, so the correction is matrix * reading + bias
+        cache->magCalibration = *calibration;
+        for (row = 0; row < 3; row++)
+        {
+            cache->magBias[row] = -((calibration->matrix[row][0] * calibration->offset.x) +
+                                    (calibration->matrix[row][1] * calibration->offset.y) +
+                                    (calibration->matrix[row][2] * calibration->offset.z));
+        }
+        cache->magCalibrated = true;
+    }
+    else    // Stop correcting
+    {
+        cache->magCalibrated = false;
+    }
+}
+
+// =================================================================================================
@@ -0,0 +1,440 @@
+// ==================================================================================================
+//
+//  sensehat-compositor.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the layer compositor of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-compositor.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the layer compositor of the Raspberry
+//! Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <pthread.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define kCompositorNEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define kCompositorSSE2 1
+#endif
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Number of pixels in a layer
+#define kCompositorPixels   64
+
+// Color planes of a layer, then its alpha plane
+#define kCompositorColors   3
+#define kCompositorAlpha    3
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Layer contents, one plane per component, so the blend works on runs of the same component
+typedef uint8_t tSenseHAT_CompositorLayer[kCompositorColors + 1][kCompositorPixels];
+
+// Composited frame, widened so the blend can accumulate without converting back and forth
+typedef uint16_t tSenseHAT_CompositorFrame[kCompositorColors][kCompositorPixels];
+
+// Compositor
+typedef struct
+{
+    pthread_mutex_t             mutex;                                  // Guards everything below
+    tSenseHAT_Instance          instance;                               // Where frames go (NULL if off screen)
+    uint32_t                    layerCount;                             // Number of layers
+    tSenseHAT_CompositorLayer   layers[kSenseHAT_CompositorLayersMax];  // Layer contents
+    uint16_t                    opacity[kSenseHAT_CompositorLayersMax]; // Layer opacity, 0 to 255
+    int32_t                     order[kSenseHAT_CompositorLayersMax];   // Layer z-order
+    uint32_t                    stack[kSenseHAT_CompositorLayersMax];   // Layer indices, bottom first
+    uint8_t                     frame[kCompositorColors][kCompositorPixels];    // Last composited frame
+    bool                        shown;                                  // Whether the frame is on the LED matrix
+}
+tSenseHAT_CompositorPrivate;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_CompositorUpdate
+static int32_t SenseHAT_CompositorUpdate (tSenseHAT_CompositorPrivate* compositorPrivate);
+
+// SenseHAT_CompositorBlend
+static void SenseHAT_CompositorBlend (tSenseHAT_CompositorFrame frame,
+                                      const tSenseHAT_CompositorLayer layer,
+                                      uint16_t opacity);
+
+// SenseHAT_CompositorDivide255
+static uint16_t SenseHAT_CompositorDivide255 (uint32_t value);
+
+// =================================================================================================
+//  SenseHAT_CompositorOpen
+// =================================================================================================
+int32_t SenseHAT_CompositorOpen (const tSenseHAT_Instance instance,
+                                 uint32_t layerCount,
+                                 tSenseHAT_Compositor* compositor)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((layerCount > 0) &&
+        (layerCount <= kSenseHAT_CompositorLayersMax) &&
+        (compositor != NULL))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate =
+            (tSenseHAT_CompositorPrivate*)malloc(sizeof(tSenseHAT_CompositorPrivate));
+
+        // Setup
+        *compositor = NULL;
+
+        if (compositorPrivate != NULL)
+        {
+            uint32_t layer = 0;
+
+            // Every layer starts out transparent, fully opaque, and in index order
+            memset(compositorPrivate, 0, sizeof(tSenseHAT_CompositorPrivate));
+            (void)pthread_mutex_init(&(compositorPrivate->mutex), NULL);
+            compositorPrivate->instance = instance;
+            compositorPrivate->layerCount = layerCount;
+            for (layer = 0; layer < layerCount; layer++)
+            {
+                compositorPrivate->opacity[layer] = 255;
+                compositorPrivate->order[layer] = (int32_t)layer;
+                compositorPrivate->stack[layer] = layer;
+            }
+            *compositor = (tSenseHAT_Compositor)compositorPrivate;
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorSetLayer
+// =================================================================================================
+int32_t SenseHAT_CompositorSetLayer (const tSenseHAT_Compositor compositor,
+                                     uint32_t layer,
+                                     const tSenseHAT_RGBAPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((compositor != NULL) &&
+        (layer < ((tSenseHAT_CompositorPrivate*)compositor)->layerCount) &&
+        (pixels != NULL))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate = (tSenseHAT_CompositorPrivate*)compositor;
+        tSenseHAT_CompositorLayer contents;
+        uint32_t index = 0;
+
+        // Split the layer into planes
+        for (index = 0; index < kCompositorPixels; index++)
+        {
+            contents[0][index] = pixels[index].red;
+            contents[1][index] = pixels[index].green;
+            contents[2][index] = pixels[index].blue;
+            contents[kCompositorAlpha][index] = pixels[index].alpha;
+        }
+
+        // Only recomposite if the layer changed
+        (void)pthread_mutex_lock(&(compositorPrivate->mutex));
+        if (memcmp(compositorPrivate->layers[layer], contents, sizeof(tSenseHAT_CompositorLayer)) != 0)
+        {
+            memcpy(compositorPrivate->layers[layer], contents, sizeof(tSenseHAT_CompositorLayer));
+            result = SenseHAT_CompositorUpdate(compositorPrivate);
+        }
+        (void)pthread_mutex_unlock(&(compositorPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorSetLayerOpacity
+// =================================================================================================
+int32_t SenseHAT_CompositorSetLayerOpacity (const tSenseHAT_Compositor compositor,
+                                            uint32_t layer,
+                                            double opacity)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((compositor != NULL) &&
+        (layer < ((tSenseHAT_CompositorPrivate*)compositor)->layerCount) &&
+        (opacity >= 0.0) &&
+        (opacity <= 1.0))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate = (tSenseHAT_CompositorPrivate*)compositor;
+        uint16_t scaled = (uint16_t)((opacity * 255.0) + 0.5);
+
+        (void)pthread_mutex_lock(&(compositorPrivate->mutex));
+        if (compositorPrivate->opacity[layer] != scaled)
+        {
+            compositorPrivate->opacity[layer] = scaled;
+            result = SenseHAT_CompositorUpdate(compositorPrivate);
+        }
+        (void)pthread_mutex_unlock(&(compositorPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorSetLayerOrder
+// =================================================================================================
+int32_t SenseHAT_CompositorSetLayerOrder (const tSenseHAT_Compositor compositor,
+                                          uint32_t layer,
+                                          int32_t order)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((compositor != NULL) &&
+        (layer < ((tSenseHAT_CompositorPrivate*)compositor)->layerCount))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate = (tSenseHAT_CompositorPrivate*)compositor;
+
+        (void)pthread_mutex_lock(&(compositorPrivate->mutex));
+        if (compositorPrivate->order[layer] != order)
+        {
+            uint32_t index = 0;
+            uint32_t position = 0;
+
+            compositorPrivate->order[layer] = order;
+
+            // Rebuild the stack; an insertion sort keeps equal orders in index order
+            for (index = 0; index < compositorPrivate->layerCount; index++)
+            {
+                position = index;
+                while ((position > 0) &&
+                       (compositorPrivate->order[compositorPrivate->stack[position - 1]] > compositorPrivate->order[index]))
+                {
+                    compositorPrivate->stack[position] = compositorPrivate->stack[position - 1];
+                    position--;
+                }
+                compositorPrivate->stack[position] = index;
+            }
+            result = SenseHAT_CompositorUpdate(compositorPrivate);
+        }
+        (void)pthread_mutex_unlock(&(compositorPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorGetFrame
+// =================================================================================================
+int32_t SenseHAT_CompositorGetFrame (const tSenseHAT_Compositor compositor,
+                                     tSenseHAT_LEDPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((compositor != NULL) && (pixels != NULL))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate = (tSenseHAT_CompositorPrivate*)compositor;
+        uint32_t index = 0;
+
+        (void)pthread_mutex_lock(&(compositorPrivate->mutex));
+        for (index = 0; index < kCompositorPixels; index++)
+        {
+            pixels[index].red = compositorPrivate->frame[0][index];
+            pixels[index].green = compositorPrivate->frame[1][index];
+            pixels[index].blue = compositorPrivate->frame[2][index];
+        }
+        (void)pthread_mutex_unlock(&(compositorPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorClose
+// =================================================================================================
+int32_t SenseHAT_CompositorClose (tSenseHAT_Compositor* compositor)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((compositor != NULL) && (*compositor != NULL))
+    {
+        tSenseHAT_CompositorPrivate* compositorPrivate = (tSenseHAT_CompositorPrivate*)(*compositor);
+
+        (void)pthread_mutex_destroy(&(compositorPrivate->mutex));
+        free((void*)compositorPrivate);
+        *compositor = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorUpdate
+// =================================================================================================
+int32_t SenseHAT_CompositorUpdate (tSenseHAT_CompositorPrivate* compositorPrivate)
+{
+    int32_t result = 0;
+    tSenseHAT_CompositorFrame frame;
+    uint8_t composited[kCompositorColors][kCompositorPixels];
+    uint32_t index = 0;
+    uint32_t color = 0;
+
+    // Blend the visible layers over black, bottom first
+    memset(frame, 0, sizeof(tSenseHAT_CompositorFrame));
+    for (index = 0; index < compositorPrivate->layerCount; index++)
+    {
+        uint32_t layer = compositorPrivate->stack[index];
+        if (compositorPrivate->opacity[layer] > 0)
+        {
+            SenseHAT_CompositorBlend(frame, compositorPrivate->layers[layer], compositorPrivate->opacity[layer]);
+        }
+    }
+    for (color = 0; color < kCompositorColors; color++)
+    {
+        for (index = 0; index < kCompositorPixels; index++)
+        {
+            composited[color][index] = (uint8_t)(frame[color][index]);
+        }
+    }
+
+    // Only write the LED matrix if the frame changed, or the last write didn't get there. The
+    // lock stays held through the write, so frames from different producers land in order.
+    if (!(compositorPrivate->shown) ||
+        (memcmp(compositorPrivate->frame, composited, sizeof(composited)) != 0))
+    {
+        memcpy(compositorPrivate->frame, composited, sizeof(composited));
+        compositorPrivate->shown = true;
+        if (compositorPrivate->instance != NULL)
+        {
+            tSenseHAT_LEDPixelArray pixels;
+            for (index = 0; index < kCompositorPixels; index++)
+            {
+                pixels[index].red = composited[0][index];
+                pixels[index].green = composited[1][index];
+                pixels[index].blue = composited[2][index];
+            }
+            result = SenseHAT_LEDSetPixels(compositorPrivate->instance, pixels);
+            compositorPrivate->shown = (result == 0);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorBlend
+// =================================================================================================
+void SenseHAT_CompositorBlend (tSenseHAT_CompositorFrame frame,
+                               const tSenseHAT_CompositorLayer layer,
+                               uint16_t opacity)
+{
+    uint32_t index = 0;
+    uint32_t color = 0;
+
+    // Each pixel's alpha is scaled by the layer opacity, then every color plane is blended as
+    // (layer * alpha + frame * (255 - alpha)) / 255, rounded. Every intermediate fits in 16 bits.
+#if defined(kCompositorNEON)
+    for (; (index + 8) <= kCompositorPixels; index += 8)
+    {
+        uint16x8_t bias = vdupq_n_u16(128);
+        uint16x8_t alpha = vaddq_u16(vmulq_n_u16(vmovl_u8(vld1_u8(layer[kCompositorAlpha] + index)), opacity), bias);
+        alpha = vshrq_n_u16(vaddq_u16(alpha, vshrq_n_u16(alpha, 8)), 8);
+        uint16x8_t inverse = vsubq_u16(vdupq_n_u16(255), alpha);
+
+        for (color = 0; color < kCompositorColors; color++)
+        {
+            uint16x8_t value = vmulq_u16(vmovl_u8(vld1_u8(layer[color] + index)), alpha);
+            value = vaddq_u16(vmlaq_u16(value, vld1q_u16(frame[color] + index), inverse), bias);
+            vst1q_u16(frame[color] + index, vshrq_n_u16(vaddq_u16(value, vshrq_n_u16(value, 8)), 8));
+        }
+    }
+#elif defined(kCompositorSSE2)
+    for (; (index + 8) <= kCompositorPixels; index += 8)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i bias = _mm_set1_epi16(128);
+        __m128i alpha = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(layer[kCompositorAlpha] + index)), zero);
+        alpha = _mm_add_epi16(_mm_mullo_epi16(alpha, _mm_set1_epi16((int16_t)opacity)), bias);
+        alpha = _mm_srli_epi16(_mm_add_epi16(alpha, _mm_srli_epi16(alpha, 8)), 8);
+        __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+        for (color = 0; color < kCompositorColors; color++)
+        {
+            __m128i value = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(layer[color] + index)), zero);
+            __m128i below = _mm_loadu_si128((const __m128i*)(frame[color] + index));
+            value = _mm_add_epi16(_mm_mullo_epi16(value, alpha), _mm_mullo_epi16(below, inverse));
+            value = _mm_add_epi16(value, bias);
+            _mm_storeu_si128((__m128i*)(frame[color] + index), _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8));
+        }
+    }
+#endif
+
+    // Whatever the vector loop left
+    for (; index < kCompositorPixels; index++)
+    {
+        uint16_t alpha = SenseHAT_CompositorDivide255((uint32_t)(layer[kCompositorAlpha][index]) * opacity);
+        for (color = 0; color < kCompositorColors; color++)
+        {
+            frame[color][index] = SenseHAT_CompositorDivide255(((uint32_t)(layer[color][index]) * alpha) +
+                                                               ((uint32_t)(frame[color][index]) * (255u - alpha)));
+        }
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_CompositorDivide255
+// =================================================================================================
+uint16_t SenseHAT_CompositorDivide255 (uint32_t value)
+{
+    // Rounded division by 255 for values up to 255 * 255, without a divide
+    value += 128;
+    return (uint16_t)((value + (value >> 8)) >> 8);
+}
+
+// =================================================================================================
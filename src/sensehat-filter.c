@@ -0,0 +1,596 @@
+// ==================================================================================================
+//
+//  sensehat-filter.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the streaming filters of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-filter.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the streaming filters of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <math.h>
+#include <memory.h>
+#include <string.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Channels whose values are angles in degrees, from 0 up to 360; they're filtered as unit vectors
+// so that they wrap around
+static const uint32_t kAngularChannels = eSenseHAT_ChannelCompass | eSenseHAT_ChannelOrientation;
+
+// Degrees to radians conversion factor
+static const double kRadiansPerDegree = 0.017453292519943295;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_FilterCheckStage
+static bool SenseHAT_FilterCheckStage (const tSenseHAT_FilterStage* stage);
+
+// SenseHAT_FilterPush
+static void SenseHAT_FilterPush (tSenseHAT_FilterStageState* state,
+                                 uint32_t length,
+                                 double value);
+
+// SenseHAT_FilterRunEMA
+static void SenseHAT_FilterRunEMA (const tSenseHAT_FilterStage* stage,
+                                   tSenseHAT_FilterStageState* state,
+                                   double* values,
+                                   uint32_t count);
+
+// SenseHAT_FilterRunMedian
+static void SenseHAT_FilterRunMedian (const tSenseHAT_FilterStage* stage,
+                                      tSenseHAT_FilterStageState* state,
+                                      double* values,
+                                      uint32_t count);
+
+// SenseHAT_FilterRunFIR
+static void SenseHAT_FilterRunFIR (const tSenseHAT_FilterStage* stage,
+                                   tSenseHAT_FilterStageState* state,
+                                   double* values,
+                                   uint32_t count);
+
+// SenseHAT_FilterRunBiquad
+static void SenseHAT_FilterRunBiquad (const tSenseHAT_FilterStage* stage,
+                                      tSenseHAT_FilterStageState* state,
+                                      double* values,
+                                      uint32_t count);
+
+// SenseHAT_FilterGetValues
+static uint32_t SenseHAT_FilterGetValues (tSenseHAT_Sample* sample,
+                                          uint32_t channel,
+                                          double* values[3]);
+
+// =================================================================================================
+//  SenseHAT_FilterInitialize
+// =================================================================================================
+int32_t SenseHAT_FilterInitialize (tSenseHAT_Filter* filter,
+                                   const tSenseHAT_FilterStage* stages,
+                                   uint32_t stageCount)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+
+    // Check arguments
+    if ((filter != NULL) &&
+        ((stages != NULL) || (stageCount == 0)) &&
+        (stageCount <= kSenseHAT_FilterStagesMax))
+    {
+        for (index = 0; (index < stageCount) && (result == 0); index++)
+        {
+            if (!SenseHAT_FilterCheckStage(&(stages[index])))
+            {
+                result = EINVAL;
+            }
+        }
+        if (result == 0)
+        {
+            memset(filter, 0, sizeof(tSenseHAT_Filter));
+            filter->stageCount = stageCount;
+            for (index = 0; index < stageCount; index++)
+            {
+                filter->stages[index] = stages[index];
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterReset
+// =================================================================================================
+int32_t SenseHAT_FilterReset (tSenseHAT_Filter* filter)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (filter != NULL)
+    {
+        memset(filter->states, 0, sizeof(filter->states));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterProcess
+// =================================================================================================
+int32_t SenseHAT_FilterProcess (tSenseHAT_Filter* filter,
+                                const double* input,
+                                double* output,
+                                uint32_t count)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((filter != NULL) &&
+        (input != NULL) &&
+        (output != NULL))
+    {
+        uint32_t index = 0;
+
+        // Filter in place
+        if (output != input)
+        {
+            memmove(output, input, count * sizeof(double));
+        }
+
+        // Run each stage over the whole block
+        for (index = 0; (index < filter->stageCount) && (count > 0); index++)
+        {
+            const tSenseHAT_FilterStage* stage = &(filter->stages[index]);
+            tSenseHAT_FilterStageState* state = &(filter->states[index]);
+
+            switch (stage->type)
+            {
+                case eSenseHAT_FilterEMA:
+                    SenseHAT_FilterRunEMA(stage, state, output, count);
+                    break;
+                case eSenseHAT_FilterMedian:
+                    SenseHAT_FilterRunMedian(stage, state, output, count);
+                    break;
+                case eSenseHAT_FilterFIR:
+                    SenseHAT_FilterRunFIR(stage, state, output, count);
+                    break;
+                case eSenseHAT_FilterBiquad:
+                    SenseHAT_FilterRunBiquad(stage, state, output, count);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerSetFilter
+// =================================================================================================
+int32_t SenseHAT_SamplerSetFilter (const tSenseHAT_Instance instance,
+                                   uint32_t channel,
+                                   const tSenseHAT_FilterStage* stages,
+                                   uint32_t stageCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (channel != eSenseHAT_ChannelNone) &&
+        ((channel & ~eSenseHAT_ChannelAll) == 0) &&
+        ((channel & (channel - 1)) == 0))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        int32_t channelIndex = __builtin_ctz(channel);
+        tSenseHAT_Filter filter;
+
+        // Check the chain before touching the sampler
+        result = SenseHAT_FilterInitialize(&filter, stages, stageCount);
+        if (result == 0)
+        {
+            uint32_t index = 0;
+
+            (void)pthread_mutex_lock(&(sampler->mutex));
+            for (index = 0; index < 6; index++)
+            {
+                sampler->filters[channelIndex][index] = filter;
+            }
+            if (stageCount > 0)
+            {
+                sampler->filteredChannels |= channel;
+            }
+            else
+            {
+                sampler->filteredChannels &= ~channel;
+            }
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerGetFiltered
+// =================================================================================================
+int32_t SenseHAT_SamplerGetFiltered (const tSenseHAT_Instance instance,
+                                     tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (sample != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        // Has a sample been acquired?
+        if (sampler->filtered.sequence != 0)
+        {
+            *sample = sampler->filtered;
+        }
+        else    // No sample yet
+        {
+            memset(sample, 0, sizeof(tSenseHAT_Sample));
+            result = ENODATA;
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterSample
+// =================================================================================================
+void SenseHAT_FilterSample (tSenseHAT_Sampler* sampler,
+                            const tSenseHAT_Sample* sample)
+{
+    uint32_t channels = sampler->filteredChannels & sample->channels;
+
+    // Start from the raw readings
+    sampler->filtered = *sample;
+
+    while (channels != 0)
+    {
+        int32_t channelIndex = __builtin_ctz(channels);
+        double* values[3] = { NULL, NULL, NULL };
+        uint32_t count = SenseHAT_FilterGetValues(&(sampler->filtered), 1u << channelIndex, values);
+        uint32_t index = 0;
+
+        for (index = 0; index < count; index++)
+        {
+            if (((1u << channelIndex) & kAngularChannels) != 0)
+            {
+                double angle = *(values[index]) * kRadiansPerDegree;
+                double sine = sin(angle);
+                double cosine = cos(angle);
+
+                // Filter the unit vector, so 359 and 1 average to 0 rather than 180
+                (void)SenseHAT_FilterProcess(&(sampler->filters[channelIndex][2 * index]), &sine, &sine, 1);
+                (void)SenseHAT_FilterProcess(&(sampler->filters[channelIndex][(2 * index) + 1]), &cosine, &cosine, 1);
+                angle = atan2(sine, cosine) / kRadiansPerDegree;
+                *(values[index]) = (angle < 0.0) ? (angle + 360.0) : angle;
+            }
+            else
+            {
+                (void)SenseHAT_FilterProcess(&(sampler->filters[channelIndex][index]), values[index], values[index], 1);
+            }
+        }
+        channels &= channels - 1;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterCheckStage
+// =================================================================================================
+bool SenseHAT_FilterCheckStage (const tSenseHAT_FilterStage* stage)
+{
+    bool valid = false;
+    uint32_t index = 0;
+
+    switch (stage->type)
+    {
+        case eSenseHAT_FilterEMA:
+            valid = (stage->alpha > 0.0) && (stage->alpha <= 1.0);
+            break;
+        case eSenseHAT_FilterMedian:
+            valid = (stage->length >= 1) && (stage->length <= kSenseHAT_FilterTapsMax);
+            break;
+        case eSenseHAT_FilterFIR:
+            valid = (stage->length >= 1) && (stage->length <= kSenseHAT_FilterTapsMax);
+            for (index = 0; valid && (index < stage->length); index++)
+            {
+                valid = isfinite(stage->coefficients[index]);
+            }
+            break;
+        case eSenseHAT_FilterBiquad:
+            valid = true;
+            for (index = 0; valid && (index < 5); index++)
+            {
+                valid = isfinite(stage->coefficients[index]);
+            }
+            break;
+        default:
+            break;
+    }
+    return valid;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterPush
+// =================================================================================================
+void SenseHAT_FilterPush (tSenseHAT_FilterStageState* state,
+                          uint32_t length,
+                          double value)
+{
+    uint32_t index = 0;
+
+    if (state->primed)
+    {
+        // Newest first, and stored twice, so history[position...position + length - 1] is
+        // always the window
+        state->position = (state->position + length - 1) % length;
+        state->history[state->position] = value;
+        state->history[state->position + length] = value;
+    }
+    else
+    {
+        // Fill the history with the first input
+        for (index = 0; index < (2 * length); index++)
+        {
+            state->history[index] = value;
+        }
+        state->position = 0;
+        state->primed = true;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterRunEMA
+// =================================================================================================
+void SenseHAT_FilterRunEMA (const tSenseHAT_FilterStage* stage,
+                            tSenseHAT_FilterStageState* state,
+                            double* values,
+                            uint32_t count)
+{
+    double alpha = stage->alpha;
+    double output = state->output;
+    uint32_t index = 0;
+
+    // Start from the first input
+    if (!state->primed)
+    {
+        output = values[0];
+        state->primed = true;
+    }
+    for (index = 0; index < count; index++)
+    {
+        output += alpha * (values[index] - output);
+        values[index] = output;
+    }
+    state->output = output;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterRunMedian
+// =================================================================================================
+void SenseHAT_FilterRunMedian (const tSenseHAT_FilterStage* stage,
+                               tSenseHAT_FilterStageState* state,
+                               double* values,
+                               uint32_t count)
+{
+    uint32_t length = stage->length;
+    uint32_t index = 0;
+
+    for (index = 0; index < count; index++)
+    {
+        double sorted[kSenseHAT_FilterTapsMax];
+        uint32_t i = 0;
+
+        SenseHAT_FilterPush(state, length, values[index]);
+
+        // Insertion sort is the quickest way to sort a window this small
+        for (i = 0; i < length; i++)
+        {
+            double value = state->history[state->position + i];
+            uint32_t j = i;
+
+            while ((j > 0) && (sorted[j - 1] > value))
+            {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = value;
+        }
+        values[index] = ((length & 1) != 0) ? sorted[length / 2] :
+                                               ((sorted[(length / 2) - 1] + sorted[length / 2]) * 0.5);
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterRunFIR
+// =================================================================================================
+void SenseHAT_FilterRunFIR (const tSenseHAT_FilterStage* stage,
+                            tSenseHAT_FilterStageState* state,
+                            double* values,
+                            uint32_t count)
+{
+    const double* coefficients = stage->coefficients;
+    uint32_t length = stage->length;
+    uint32_t index = 0;
+
+    for (index = 0; index < count; index++)
+    {
+        const double* window = NULL;
+        double output = 0.0;
+        uint32_t tap = 0;
+
+        SenseHAT_FilterPush(state, length, values[index]);
+
+        // A dot product of two contiguous arrays, which the compiler can vectorize
+        window = &(state->history[state->position]);
+        for (tap = 0; tap < length; tap++)
+        {
+            output += coefficients[tap] * window[tap];
+        }
+        values[index] = output;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterRunBiquad
+// =================================================================================================
+void SenseHAT_FilterRunBiquad (const tSenseHAT_FilterStage* stage,
+                               tSenseHAT_FilterStageState* state,
+                               double* values,
+                               uint32_t count)
+{
+    double b0 = stage->coefficients[0];
+    double b1 = stage->coefficients[1];
+    double b2 = stage->coefficients[2];
+    double a1 = stage->coefficients[3];
+    double a2 = stage->coefficients[4];
+    double z1 = state->z1;
+    double z2 = state->z2;
+    uint32_t index = 0;
+
+    // Start in the steady state for the first input, if there is one
+    if (!state->primed)
+    {
+        double denominator = 1.0 + a1 + a2;
+
+        if (denominator != 0.0)
+        {
+            double input = values[0];
+            double output = ((b0 + b1 + b2) / denominator) * input;
+
+            z2 = (b2 * input) - (a2 * output);
+            z1 = (b1 * input) - (a1 * output) + z2;
+        }
+        state->primed = true;
+    }
+
+    // Transposed direct form II
+    for (index = 0; index < count; index++)
+    {
+        double input = values[index];
+        double output = (b0 * input) + z1;
+
+        z1 = (b1 * input) - (a1 * output) + z2;
+        z2 = (b2 * input) - (a2 * output);
+        values[index] = output;
+    }
+    state->z1 = z1;
+    state->z2 = z2;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FilterGetValues
+// =================================================================================================
+uint32_t SenseHAT_FilterGetValues (tSenseHAT_Sample* sample,
+                                   uint32_t channel,
+                                   double* values[3])
+{
+    uint32_t count = 1;
+
+    switch (channel)
+    {
+        case eSenseHAT_ChannelHumidity:
+            values[0] = &(sample->humidity);
+            break;
+        case eSenseHAT_ChannelTemperature:
+            values[0] = &(sample->temperature);
+            break;
+        case eSenseHAT_ChannelPressure:
+            values[0] = &(sample->pressure);
+            break;
+        case eSenseHAT_ChannelCompass:
+            values[0] = &(sample->compass);
+            break;
+        case eSenseHAT_ChannelAccelerometerRaw:
+            values[0] = &(sample->accelerometerRaw.x);
+            values[1] = &(sample->accelerometerRaw.y);
+            values[2] = &(sample->accelerometerRaw.z);
+            count = 3;
+            break;
+        case eSenseHAT_ChannelGyroscopeRaw:
+            values[0] = &(sample->gyroscopeRaw.x);
+            values[1] = &(sample->gyroscopeRaw.y);
+            values[2] = &(sample->gyroscopeRaw.z);
+            count = 3;
+            break;
+        case eSenseHAT_ChannelCompassRaw:
+            values[0] = &(sample->compassRaw.x);
+            values[1] = &(sample->compassRaw.y);
+            values[2] = &(sample->compassRaw.z);
+            count = 3;
+            break;
+        case eSenseHAT_ChannelOrientation:
+            values[0] = &(sample->orientation.pitch);
+            values[1] = &(sample->orientation.roll);
+            values[2] = &(sample->orientation.yaw);
+            count = 3;
+            break;
+        default:
+            count = 0;
+            break;
+    }
+    return count;
+}
+
+// =================================================================================================
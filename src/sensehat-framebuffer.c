@@ -0,0 +1,502 @@
+// ==================================================================================================
+//
+//  sensehat-framebuffer.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the native LED matrix backend of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-framebuffer.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the native LED matrix backend of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Framebuffer device
+static const char* kFramebufferDeviceName       = "RPi-Sense FB";
+static const char* kFramebufferDevicePathFormat = "/dev/fb%d";
+static const int32_t kMaxFramebufferDevices     = 32;
+
+// Size of the mapped framebuffer, one RGB565 pixel per LED
+#define kFramebufferPixels  64
+#define kFramebufferSize    (kFramebufferPixels * sizeof(uint16_t))
+
+// Sense HAT framebuffer driver gamma ioctls, and the tables the reset ioctl selects
+#define kFramebufferGetGamma        61696
+#define kFramebufferSetGamma        61697
+#define kFramebufferResetGamma      61698
+#define kFramebufferGammaDefault    0
+#define kFramebufferGammaLowLight   1
+
+// The driver's default gamma table
+static const uint8_t kFramebufferDefaultGamma[kSenseHAT_GammaTableSize] =
+{
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01,
+    0x02, 0x02, 0x03, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0E, 0x0F, 0x11,
+    0x12, 0x14, 0x15, 0x17, 0x19, 0x1B, 0x1D, 0x1F
+};
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_FramebufferPut
+static void SenseHAT_FramebufferPut (tSenseHAT_Framebuffer* framebuffer,
+                                     const uint16_t* pixels,
+                                     uint64_t changed);
+
+// SenseHAT_FramebufferOffset
+static uint32_t SenseHAT_FramebufferOffset (tSenseHAT_LEDRotation rotation,
+                                            uint32_t index);
+
+// =================================================================================================
+//  SenseHAT_LEDGammaGet
+// =================================================================================================
+int32_t SenseHAT_LEDGammaGet (const tSenseHAT_Instance instance,
+                              uint8_t* gamma)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (gamma != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        if (instancePrivate->framebuffer.fd >= 0)
+        {
+            if (ioctl(instancePrivate->framebuffer.fd, kFramebufferGetGamma, gamma) != 0)
+            {
+                // ioctl failed
+                result = errno;
+            }
+        }
+        else    // No framebuffer
+        {
+            result = ENODEV;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDGammaSet
+// =================================================================================================
+int32_t SenseHAT_LEDGammaSet (const tSenseHAT_Instance instance,
+                              const uint8_t* gamma)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (gamma != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        uint8_t table[kSenseHAT_GammaTableSize];
+        uint32_t index = 0;
+
+        // The driver takes the table as given, so check it here
+        for (index = 0; index < kSenseHAT_GammaTableSize; index++)
+        {
+            if (gamma[index] > 31)
+            {
+                result = EINVAL;
+            }
+            table[index] = gamma[index];
+        }
+
+        if (result == 0)
+        {
+            if (instancePrivate->framebuffer.fd >= 0)
+            {
+                if (ioctl(instancePrivate->framebuffer.fd, kFramebufferSetGamma, table) != 0)
+                {
+                    // ioctl failed
+                    result = errno;
+                }
+            }
+            else    // No framebuffer
+            {
+                result = ENODEV;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDSetLowLight
+// =================================================================================================
+int32_t SenseHAT_LEDSetLowLight (const tSenseHAT_Instance instance,
+                                 bool lowLight)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        if (instancePrivate->framebuffer.fd >= 0)
+        {
+            if (ioctl(instancePrivate->framebuffer.fd,
+                      kFramebufferResetGamma,
+                      (unsigned long)(lowLight ? kFramebufferGammaLowLight : kFramebufferGammaDefault)) != 0)
+            {
+                // ioctl failed
+                result = errno;
+            }
+        }
+        else    // No framebuffer
+        {
+            result = ENODEV;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDSetBrightness
+// =================================================================================================
+int32_t SenseHAT_LEDSetBrightness (const tSenseHAT_Instance instance,
+                                   double brightness)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (brightness >= 0.0) &&
+        (brightness <= 1.0))
+    {
+        uint8_t gamma[kSenseHAT_GammaTableSize];
+        uint32_t index = 0;
+
+        // Scale the default table, keeping lit levels lit
+        for (index = 0; index < kSenseHAT_GammaTableSize; index++)
+        {
+            gamma[index] = (uint8_t)((kFramebufferDefaultGamma[index] * brightness) + 0.5);
+            if ((gamma[index] == 0) && (kFramebufferDefaultGamma[index] > 0) && (brightness > 0.0))
+            {
+                gamma[index] = 1;
+            }
+        }
+        result = SenseHAT_LEDGammaSet(instance, gamma);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferInitialize
+// =================================================================================================
+int32_t SenseHAT_FramebufferInitialize (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Framebuffer* framebuffer = &(instancePrivate->framebuffer);
+
+        // Setup
+        memset(framebuffer, 0, sizeof(tSenseHAT_Framebuffer));
+        framebuffer->fd = -1;
+        framebuffer->rotation = eSenseHAT_LEDRotation0;
+        (void)pthread_mutex_init(&(framebuffer->mutex), NULL);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferOpen
+// =================================================================================================
+int32_t SenseHAT_FramebufferOpen (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = ENODEV;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Framebuffer* framebuffer = &(instancePrivate->framebuffer);
+        int32_t index = 0;
+        char path[32];
+
+        // Look for the Sense HAT among the framebuffer devices, as the Python library does
+        for (index = 0; index < kMaxFramebufferDevices; index++)
+        {
+            (void)snprintf(path, sizeof(path), kFramebufferDevicePathFormat, index);
+            int fd = open(path, O_RDWR | O_CLOEXEC);
+            if (fd >= 0)
+            {
+                struct fb_fix_screeninfo fixedInfo;
+
+                // Is this the LED matrix?
+                memset(&fixedInfo, 0, sizeof(fixedInfo));
+                if ((ioctl(fd, FBIOGET_FSCREENINFO, &fixedInfo) == 0) &&
+                    (strncmp(fixedInfo.id, kFramebufferDeviceName, sizeof(fixedInfo.id)) == 0) &&
+                    (fixedInfo.smem_len >= kFramebufferSize))
+                {
+                    void* mapping = mmap(NULL, kFramebufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    if (mapping != MAP_FAILED)
+                    {
+                        framebuffer->fd = fd;
+                        framebuffer->pixels = (uint16_t*)mapping;
+                        result = 0;
+                        break;
+                    }
+                }
+                (void)close(fd);
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferWrite
+// =================================================================================================
+int32_t SenseHAT_FramebufferWrite (tSenseHAT_InstancePrivate* instancePrivate,
+                                   const tSenseHAT_LEDPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instancePrivate != NULL)
+    {
+        uint16_t converted[kFramebufferPixels];
+
+        // Convert the frame before taking the lock
+        if (pixels != NULL)
+        {
+            result = SenseHAT_ColorConvertFrames(NULL, (const tSenseHAT_LEDPixelArray*)pixels, 1, converted);
+        }
+        else
+        {
+            memset(converted, 0, sizeof(converted));
+        }
+
+        if (result == 0)
+        {
+            result = SenseHAT_FramebufferWriteRGB565(instancePrivate, converted);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferWriteRGB565
+// =================================================================================================
+int32_t SenseHAT_FramebufferWriteRGB565 (tSenseHAT_InstancePrivate* instancePrivate,
+                                         const uint16_t* pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instancePrivate != NULL) &&
+        (instancePrivate->framebuffer.pixels != NULL) &&
+        (pixels != NULL))
+    {
+        tSenseHAT_Framebuffer* framebuffer = &(instancePrivate->framebuffer);
+
+        // Write the whole frame
+        (void)pthread_mutex_lock(&(framebuffer->mutex));
+        SenseHAT_FramebufferPut(framebuffer, pixels, UINT64_MAX);
+        (void)pthread_mutex_unlock(&(framebuffer->mutex));
+    }
+    else if ((instancePrivate != NULL) && (pixels != NULL))
+    {
+        // The framebuffer isn't open
+        result = ENODEV;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferPatchRGB565
+// =================================================================================================
+int32_t SenseHAT_FramebufferPatchRGB565 (tSenseHAT_InstancePrivate* instancePrivate,
+                                         const uint16_t* pixels,
+                                         uint64_t changed)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instancePrivate != NULL) &&
+        (instancePrivate->framebuffer.pixels != NULL) &&
+        (pixels != NULL))
+    {
+        tSenseHAT_Framebuffer* framebuffer = &(instancePrivate->framebuffer);
+
+        // Write the masked pixels; the rest of the frame stays as the device holds it
+        (void)pthread_mutex_lock(&(framebuffer->mutex));
+        SenseHAT_FramebufferPut(framebuffer, pixels, changed);
+        (void)pthread_mutex_unlock(&(framebuffer->mutex));
+    }
+    else if ((instancePrivate != NULL) && (pixels != NULL))
+    {
+        // The framebuffer isn't open
+        result = ENODEV;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferSetRotation
+// =================================================================================================
+void SenseHAT_FramebufferSetRotation (tSenseHAT_InstancePrivate* instancePrivate,
+                                      tSenseHAT_LEDRotation rotation)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        (void)pthread_mutex_lock(&(instancePrivate->framebuffer.mutex));
+        instancePrivate->framebuffer.rotation = rotation;
+        (void)pthread_mutex_unlock(&(instancePrivate->framebuffer.mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferRelease
+// =================================================================================================
+void SenseHAT_FramebufferRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Framebuffer* framebuffer = &(instancePrivate->framebuffer);
+
+        // Unmap and close the device
+        if (framebuffer->pixels != NULL)
+        {
+            (void)munmap((void*)(framebuffer->pixels), kFramebufferSize);
+            framebuffer->pixels = NULL;
+        }
+        if (framebuffer->fd >= 0)
+        {
+            (void)close(framebuffer->fd);
+            framebuffer->fd = -1;
+        }
+        (void)pthread_mutex_destroy(&(framebuffer->mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferPut
+// =================================================================================================
+void SenseHAT_FramebufferPut (tSenseHAT_Framebuffer* framebuffer,
+                              const uint16_t* pixels,
+                              uint64_t changed)
+{
+    uint32_t index = 0;
+
+    // The mapped device memory is what the LED matrix shows, whoever wrote it last, so pixels are
+    // compared against it; a frame that matches leaves the device untouched
+    for (index = 0; (index < kFramebufferPixels) && (changed != 0); index++, changed >>= 1)
+    {
+        if ((changed & 1) != 0)
+        {
+            uint32_t offset = SenseHAT_FramebufferOffset(framebuffer->rotation, index);
+            if (framebuffer->pixels[offset] != pixels[index])
+            {
+                framebuffer->pixels[offset] = pixels[index];
+            }
+        }
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_FramebufferOffset
+// =================================================================================================
+uint32_t SenseHAT_FramebufferOffset (tSenseHAT_LEDRotation rotation,
+                                     uint32_t index)
+{
+    uint32_t x = index % 8;
+    uint32_t y = index / 8;
+    uint32_t offset = index;
+
+    // Rotate into place with the same mapping as the Python library
+    switch (rotation)
+    {
+        case eSenseHAT_LEDRotation90:
+            offset = (x * 8) + (7 - y);
+            break;
+        case eSenseHAT_LEDRotation180:
+            offset = ((7 - y) * 8) + (7 - x);
+            break;
+        case eSenseHAT_LEDRotation270:
+            offset = ((7 - x) * 8) + y;
+            break;
+        default:
+            break;
+    }
+    return offset;
+}
+
+// =================================================================================================
@@ -0,0 +1,589 @@
+// ==================================================================================================
+//
+//  sensehat-gesture.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the joystick gesture recognizer of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-gesture.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the joystick gesture recognizer of 
+//! the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Default timing, in fractional seconds
+static const double kDefaultDoubleClickInterval     = 0.3;
+static const double kDefaultLongPressDuration       = 0.8;
+static const double kDefaultRepeatDelay             = 0.5;
+static const double kDefaultRepeatInterval          = 0.2;
+static const double kDefaultRepeatMinimumInterval   = 0.04;
+static const double kDefaultRepeatAcceleration      = 0.85;
+
+// Number of joystick directions tracked by a recognizer
+#define kGestureDirectionCount  5
+
+// Number of joystick events retrieved at a time by SenseHAT_GetGestures
+#define kGestureEventBatchSize  16
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_GestureAdd
+static void SenseHAT_GestureAdd (tSenseHAT_Gesture* gestures,
+                                 int32_t capacity,
+                                 int32_t* count,
+                                 bool* overflow,
+                                 double timestamp,
+                                 int32_t directionIndex,
+                                 tSenseHAT_GestureType type,
+                                 uint32_t repeatCount);
+
+// SenseHAT_GestureFlushDoubleClick
+static void SenseHAT_GestureFlushDoubleClick (tSenseHAT_GestureDirectionState* state,
+                                              int32_t directionIndex,
+                                              tSenseHAT_Gesture* gestures,
+                                              int32_t capacity,
+                                              int32_t* count,
+                                              bool* overflow);
+
+// SenseHAT_GestureLongPressPossible
+static bool SenseHAT_GestureLongPressPossible (const tSenseHAT_GestureConfiguration* configuration,
+                                               const tSenseHAT_GestureDirectionState* state);
+
+// SenseHAT_GestureAdvanceTo
+static void SenseHAT_GestureAdvanceTo (tSenseHAT_GestureRecognizer* recognizer,
+                                       double timestamp,
+                                       tSenseHAT_Gesture* gestures,
+                                       int32_t capacity,
+                                       int32_t* count,
+                                       bool* overflow);
+
+// =================================================================================================
+//  SenseHAT_GestureInitialize
+// =================================================================================================
+int32_t SenseHAT_GestureInitialize (tSenseHAT_GestureRecognizer* recognizer,
+                                    const tSenseHAT_GestureConfiguration* configuration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (recognizer != NULL)
+    {
+        tSenseHAT_GestureConfiguration defaultConfiguration;
+
+        // Use the defaults?
+        if (configuration == NULL)
+        {
+            defaultConfiguration.doubleClickInterval = kDefaultDoubleClickInterval;
+            defaultConfiguration.longPressDuration = kDefaultLongPressDuration;
+            defaultConfiguration.repeatDelay = kDefaultRepeatDelay;
+            defaultConfiguration.repeatInterval = kDefaultRepeatInterval;
+            defaultConfiguration.repeatMinimumInterval = kDefaultRepeatMinimumInterval;
+            defaultConfiguration.repeatAcceleration = kDefaultRepeatAcceleration;
+            configuration = &defaultConfiguration;
+        }
+
+        // Validate the configuration
+        if ((configuration->doubleClickInterval >= 0.0) &&
+            (configuration->longPressDuration >= 0.0) &&
+            (configuration->repeatDelay >= 0.0) &&
+            ((configuration->repeatDelay == 0.0) ||
+             ((configuration->repeatInterval > 0.0) &&
+              (configuration->repeatMinimumInterval > 0.0) &&
+              (configuration->repeatMinimumInterval <= configuration->repeatInterval) &&
+              (configuration->repeatAcceleration > 0.0) &&
+              (configuration->repeatAcceleration <= 1.0))))
+        {
+            memset(recognizer, 0, sizeof(tSenseHAT_GestureRecognizer));
+            recognizer->configuration = *configuration;
+        }
+        else    // Invalid configuration
+        {
+            result = EINVAL;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureProcessEvent
+// =================================================================================================
+int32_t SenseHAT_GestureProcessEvent (tSenseHAT_GestureRecognizer* recognizer,
+                                      const tSenseHAT_JoystickEvent* event,
+                                      tSenseHAT_Gesture* gestures,
+                                      int32_t capacity,
+                                      int32_t* gestureCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recognizer != NULL) &&
+        (event != NULL) &&
+        (event->direction >= eSenseHAT_JoystickDirectionUp) &&
+        (event->direction <= eSenseHAT_JoystickDirectionPush) &&
+        (event->action >= eSenseHAT_JoystickActionPressed) &&
+        (event->action <= eSenseHAT_JoystickActionHeld) &&
+        (gestures != NULL) &&
+        (capacity > 0) &&
+        (gestureCount != NULL))
+    {
+        const tSenseHAT_GestureConfiguration* configuration = &(recognizer->configuration);
+        int32_t directionIndex = (int32_t)(event->direction) - 1;
+        tSenseHAT_GestureDirectionState* state = &(recognizer->directions[directionIndex]);
+        int32_t count = 0;
+        bool overflow = false;
+
+        // Produce whatever became due before this event
+        SenseHAT_GestureAdvanceTo(recognizer, event->timestamp, gestures, capacity, &count, &overflow);
+
+        // Pressed?
+        if (event->action == eSenseHAT_JoystickActionPressed)
+        {
+            // Ignore a repeated press (e.g. from a missed release)
+            if (!state->pressed)
+            {
+                // Could this press complete a double click?
+                state->secondPress = state->clickPending;
+                state->clickPending = false;
+
+                state->pressed = true;
+                state->consumed = false;
+                state->longPressReported = false;
+                state->pressTime = event->timestamp;
+                state->repeatCount = 0;
+                state->repeatInterval = configuration->repeatInterval;
+                state->nextRepeatTime = event->timestamp + configuration->repeatDelay;
+            }
+        }
+
+        // Released?
+        else if (event->action == eSenseHAT_JoystickActionReleased)
+        {
+            // Ignore a release without a press (e.g. held before the recognizer started)
+            if (state->pressed)
+            {
+                state->pressed = false;
+
+                // A press that produced a long press or repeats doesn't also produce a click
+                if (!state->consumed)
+                {
+                    if (state->secondPress)
+                    {
+                        SenseHAT_GestureAdd(gestures, capacity, &count, &overflow, event->timestamp,
+                                            directionIndex, eSenseHAT_GestureDoubleClick, 0);
+                    }
+                    else if (configuration->doubleClickInterval == 0.0)
+                    {
+                        SenseHAT_GestureAdd(gestures, capacity, &count, &overflow, event->timestamp,
+                                            directionIndex, eSenseHAT_GestureClick, 0);
+                    }
+                    else    // Wait to see whether a second click follows
+                    {
+                        state->clickPending = true;
+                        state->releaseTime = event->timestamp;
+                    }
+                }
+                state->secondPress = false;
+            }
+        }
+
+        // Held events only move time forward, which we've already done
+
+        // Return results
+        *gestureCount = count;
+        if (overflow)
+        {
+            result = ENOBUFS;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureAdvance
+// =================================================================================================
+int32_t SenseHAT_GestureAdvance (tSenseHAT_GestureRecognizer* recognizer,
+                                 double timestamp,
+                                 tSenseHAT_Gesture* gestures,
+                                 int32_t capacity,
+                                 int32_t* gestureCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recognizer != NULL) &&
+        (gestures != NULL) &&
+        (capacity > 0) &&
+        (gestureCount != NULL))
+    {
+        int32_t count = 0;
+        bool overflow = false;
+
+        SenseHAT_GestureAdvanceTo(recognizer, timestamp, gestures, capacity, &count, &overflow);
+
+        // Return results
+        *gestureCount = count;
+        if (overflow)
+        {
+            result = ENOBUFS;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureGetDeadline
+// =================================================================================================
+int32_t SenseHAT_GestureGetDeadline (const tSenseHAT_GestureRecognizer* recognizer,
+                                     double* deadline)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recognizer != NULL) &&
+        (deadline != NULL))
+    {
+        const tSenseHAT_GestureConfiguration* configuration = &(recognizer->configuration);
+        bool found = false;
+        double earliest = 0.0;
+        int32_t index = 0;
+
+        for (index = 0; index < kGestureDirectionCount; index++)
+        {
+            const tSenseHAT_GestureDirectionState* state = &(recognizer->directions[index]);
+            double due[3];
+            int32_t dueCount = 0;
+            int32_t dueIndex = 0;
+
+            // Collect the times at which this direction will produce something
+            if (state->clickPending)
+            {
+                due[dueCount++] = state->releaseTime + configuration->doubleClickInterval;
+            }
+            if (state->pressed)
+            {
+                if (SenseHAT_GestureLongPressPossible(configuration, state))
+                {
+                    due[dueCount++] = state->pressTime + configuration->longPressDuration;
+                }
+                if (configuration->repeatDelay > 0.0)
+                {
+                    due[dueCount++] = state->nextRepeatTime;
+                }
+            }
+            for (dueIndex = 0; dueIndex < dueCount; dueIndex++)
+            {
+                if (!found || (due[dueIndex] < earliest))
+                {
+                    earliest = due[dueIndex];
+                    found = true;
+                }
+            }
+        }
+
+        // Check for success
+        if (found)
+        {
+            *deadline = earliest;
+        }
+        else    // Nothing is due
+        {
+            result = ENODATA;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetGestures
+// =================================================================================================
+int32_t SenseHAT_GetGestures (const tSenseHAT_Instance instance,
+                              tSenseHAT_GestureRecognizer* recognizer,
+                              tSenseHAT_Gesture* gestures,
+                              int32_t capacity,
+                              int32_t* gestureCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (recognizer != NULL) &&
+        (gestures != NULL) &&
+        (capacity > 0) &&
+        (gestureCount != NULL))
+    {
+        tSenseHAT_JoystickEvent events[kGestureEventBatchSize];
+        int32_t eventCount = 0;
+        int32_t count = 0;
+        bool overflow = false;
+
+        // Setup
+        *gestureCount = 0;
+
+        // Feed every available joystick event to the recognizer
+        do
+        {
+            int32_t index = 0;
+
+            result = SenseHAT_GetEventsInto(instance, events, kGestureEventBatchSize, &eventCount);
+            if ((result == 0) || (result == ENOBUFS))
+            {
+                for (index = 0; index < eventCount; index++)
+                {
+                    int32_t newCount = 0;
+
+                    // Once the caller's array is full, keep the recognizer state current anyway
+                    if (count < capacity)
+                    {
+                        if (SenseHAT_GestureProcessEvent(recognizer, &(events[index]), &(gestures[count]), 
+                                                         capacity - count, &newCount) == ENOBUFS)
+                        {
+                            overflow = true;
+                        }
+                    }
+                    else
+                    {
+                        tSenseHAT_Gesture discarded[kSenseHAT_MaxGestures];
+                        if (SenseHAT_GestureProcessEvent(recognizer, &(events[index]), discarded,
+                                                         kSenseHAT_MaxGestures, &newCount) == 0)
+                        {
+                            overflow = overflow || (newCount > 0);
+                        }
+                        newCount = 0;
+                    }
+                    count += newCount;
+                }
+            }
+        }
+        while (result == ENOBUFS);
+
+        // Check for success
+        if (result == 0)
+        {
+            // Get private data
+            tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+            double now = 0.0;
+
+            // Time moves with the instance's own clock, which for a replay is the log's
+            if (instancePrivate->replay != NULL)
+            {
+                now = SenseHAT_ReplayGetTime(instancePrivate);
+            }
+            else
+            {
+                now = SenseHAT_GetTimestamp();
+            }
+
+            // Produce whatever is due now
+            if (count < capacity)
+            {
+                int32_t newCount = 0;
+
+                if (SenseHAT_GestureAdvance(recognizer, now, &(gestures[count]),
+                                            capacity - count, &newCount) == ENOBUFS)
+                {
+                    overflow = true;
+                }
+                count += newCount;
+            }
+            else
+            {
+                tSenseHAT_Gesture discarded[kSenseHAT_MaxGestures];
+                int32_t newCount = 0;
+
+                (void)SenseHAT_GestureAdvance(recognizer, now, discarded,
+                                              kSenseHAT_MaxGestures, &newCount);
+                overflow = overflow || (newCount > 0);
+            }
+
+            // Return results
+            *gestureCount = count;
+            if (overflow)
+            {
+                result = ENOBUFS;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureAdd
+// =================================================================================================
+void SenseHAT_GestureAdd (tSenseHAT_Gesture* gestures,
+                          int32_t capacity,
+                          int32_t* count,
+                          bool* overflow,
+                          double timestamp,
+                          int32_t directionIndex,
+                          tSenseHAT_GestureType type,
+                          uint32_t repeatCount)
+{
+    // Is there room?
+    if (*count < capacity)
+    {
+        tSenseHAT_Gesture* gesture = &(gestures[*count]);
+
+        gesture->timestamp = timestamp;
+        gesture->direction = (tSenseHAT_JoystickDirection)(directionIndex + 1);
+        gesture->type = type;
+        gesture->repeatCount = repeatCount;
+        (*count)++;
+    }
+    else    // Out of room
+    {
+        *overflow = true;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureFlushDoubleClick
+// =================================================================================================
+void SenseHAT_GestureFlushDoubleClick (tSenseHAT_GestureDirectionState* state,
+                                       int32_t directionIndex,
+                                       tSenseHAT_Gesture* gestures,
+                                       int32_t capacity,
+                                       int32_t* count,
+                                       bool* overflow)
+{
+    // A second press that turns into a long press or a repeat isn't a double click, so the 
+    // first click stands on its own
+    if (state->secondPress)
+    {
+        SenseHAT_GestureAdd(gestures, capacity, count, overflow, state->releaseTime,
+                            directionIndex, eSenseHAT_GestureClick, 0);
+        state->secondPress = false;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_GestureLongPressPossible
+// =================================================================================================
+bool SenseHAT_GestureLongPressPossible (const tSenseHAT_GestureConfiguration* configuration,
+                                        const tSenseHAT_GestureDirectionState* state)
+{
+    // A press reports a long press only once, and not at all if it starts repeating first
+    return ((configuration->longPressDuration > 0.0) &&
+            !state->longPressReported &&
+            (state->repeatCount == 0) &&
+            ((configuration->repeatDelay == 0.0) ||
+             ((state->pressTime + configuration->longPressDuration) <= state->nextRepeatTime)));
+}
+
+// =================================================================================================
+//  SenseHAT_GestureAdvanceTo
+// =================================================================================================
+void SenseHAT_GestureAdvanceTo (tSenseHAT_GestureRecognizer* recognizer,
+                                double timestamp,
+                                tSenseHAT_Gesture* gestures,
+                                int32_t capacity,
+                                int32_t* count,
+                                bool* overflow)
+{
+    const tSenseHAT_GestureConfiguration* configuration = &(recognizer->configuration);
+    int32_t index = 0;
+
+    for (index = 0; index < kGestureDirectionCount; index++)
+    {
+        tSenseHAT_GestureDirectionState* state = &(recognizer->directions[index]);
+
+        // Has the double click interval expired?
+        if (state->clickPending &&
+            (timestamp >= (state->releaseTime + configuration->doubleClickInterval)))
+        {
+            SenseHAT_GestureAdd(gestures, capacity, count, overflow, state->releaseTime,
+                                index, eSenseHAT_GestureClick, 0);
+            state->clickPending = false;
+        }
+
+        // Is the direction being held?
+        if (state->pressed)
+        {
+            // Long press
+            if (SenseHAT_GestureLongPressPossible(configuration, state) &&
+                (timestamp >= (state->pressTime + configuration->longPressDuration)))
+            {
+                SenseHAT_GestureFlushDoubleClick(state, index, gestures, capacity, count, overflow);
+                SenseHAT_GestureAdd(gestures, capacity, count, overflow, 
+                                    state->pressTime + configuration->longPressDuration,
+                                    index, eSenseHAT_GestureLongPress, 0);
+                state->longPressReported = true;
+                state->consumed = true;
+            }
+
+            // Repeat
+            if ((configuration->repeatDelay > 0.0) &&
+                (timestamp >= state->nextRepeatTime))
+            {
+                SenseHAT_GestureFlushDoubleClick(state, index, gestures, capacity, count, overflow);
+                state->repeatCount++;
+                SenseHAT_GestureAdd(gestures, capacity, count, overflow, state->nextRepeatTime,
+                                    index, eSenseHAT_GestureRepeat, state->repeatCount);
+                state->consumed = true;
+
+                // Accelerate
+                state->repeatInterval *= configuration->repeatAcceleration;
+                if (state->repeatInterval < configuration->repeatMinimumInterval)
+                {
+                    state->repeatInterval = configuration->repeatMinimumInterval;
+                }
+
+                // Collapse any repeats we were too late for
+                state->nextRepeatTime += state->repeatInterval;
+                if (state->nextRepeatTime <= timestamp)
+                {
+                    state->nextRepeatTime = timestamp + state->repeatInterval;
+                }
+            }
+        }
+    }
+    return;
+}
+
+// =================================================================================================
@@ -0,0 +1,1601 @@
+// ==================================================================================================
+//
+//  sensehat-image.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the image decoder and sprite atlases of
+//      the Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-image.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the image decoder and sprite atlases
+//! of the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Image dimensions
+#define kImageSize              8
+#define kImagePixels            (kImageSize * kImageSize)
+
+// Largest sprite sheet, in pixels
+#define kImageSheetPixelsMax    (kSenseHAT_SpriteAtlasFramesMax * kImagePixels)
+
+// Largest file worth reading (metadata can make PNGs much bigger than the pixels)
+#define kImageFileSizeMax       (4 * 1024 * 1024)
+
+// Decoded images kept in the cache
+#define kImageCacheEntries      16
+
+// Inflate limits
+#define kInflateMaxBits         15
+#define kInflateMaxCodes        (286 + 30)
+
+// PNG color types
+#define kPNGColorGray           0
+#define kPNGColorRGB            2
+#define kPNGColorPalette        3
+#define kPNGColorGrayAlpha      4
+#define kPNGColorRGBA           6
+
+static const uint8_t kPNGSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+// Deflate length and distance bases and extra bits (RFC 1951, section 3.2.5)
+static const uint16_t kInflateLengthBase[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t kInflateLengthExtra[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t kInflateDistanceBase[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t kInflateDistanceExtra[30] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t kInflateCodeLengthOrder[19] =
+{
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+// Packed 8x8 RGB image
+typedef uint8_t tSenseHAT_ImageFrame[kImagePixels][3];
+
+// Decoded image of any supported size, as packed RGB rows
+typedef struct
+{
+    uint32_t    width;
+    uint32_t    height;
+    uint8_t*    pixels;
+}
+tSenseHAT_ImageBuffer;
+
+// Image cache entry
+typedef struct
+{
+    char*                   path;       // Image file path (NULL if the entry is free)
+    struct timespec         mtime;      // Modification time of the file when decoded
+    off_t                   size;       // Size of the file when decoded
+    uint64_t                lastUse;    // Value of the use counter when last hit
+    tSenseHAT_ImageFrame    frame;      // Decoded image
+}
+tSenseHAT_ImageCacheEntry;
+
+// Sprite atlas
+typedef struct
+{
+    uint32_t                frameCount; // Number of frames
+    tSenseHAT_ImageFrame*   frames;     // Frames, contiguous and in sheet order
+}
+tSenseHAT_SpriteAtlasPrivate;
+
+// Inflate bit reader and output window
+typedef struct
+{
+    const uint8_t*  input;
+    size_t          inputSize;
+    size_t          inputPosition;
+    uint32_t        bitBuffer;
+    uint32_t        bitCount;
+    uint8_t*        output;
+    size_t          outputSize;
+    size_t          outputPosition;
+}
+tSenseHAT_InflateState;
+
+// Canonical Huffman decoding table
+typedef struct
+{
+    uint16_t    counts[kInflateMaxBits + 1];    // Number of codes of each length
+    uint16_t    symbols[kInflateMaxCodes];      // Symbols ordered by code
+}
+tSenseHAT_InflateHuffman;
+
+// =================================================================================================
+//  Private globals
+// =================================================================================================
+
+static pthread_mutex_t gImageCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static tSenseHAT_ImageCacheEntry gImageCache[kImageCacheEntries];
+static uint64_t gImageCacheUses = 0;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_ImageReadFile
+static int32_t SenseHAT_ImageReadFile (const char* path,
+                                       bool sheet,
+                                       tSenseHAT_ImageBuffer* image,
+                                       struct stat* status);
+
+// SenseHAT_ImageDecode
+static int32_t SenseHAT_ImageDecode (const uint8_t* data,
+                                     size_t size,
+                                     bool sheet,
+                                     tSenseHAT_ImageBuffer* image);
+
+// SenseHAT_ImageAllocate
+static int32_t SenseHAT_ImageAllocate (tSenseHAT_ImageBuffer* image,
+                                       uint32_t width,
+                                       uint32_t height,
+                                       bool sheet);
+
+// SenseHAT_ImageDecodePNG
+static int32_t SenseHAT_ImageDecodePNG (const uint8_t* data,
+                                        size_t size,
+                                        bool sheet,
+                                        tSenseHAT_ImageBuffer* image);
+
+// SenseHAT_ImageDecodePPM
+static int32_t SenseHAT_ImageDecodePPM (const uint8_t* data,
+                                        size_t size,
+                                        bool sheet,
+                                        tSenseHAT_ImageBuffer* image);
+
+// SenseHAT_ImagePPMNumber
+static int32_t SenseHAT_ImagePPMNumber (const uint8_t* data,
+                                        size_t size,
+                                        size_t* position,
+                                        uint32_t* value);
+
+// SenseHAT_ImageDecodeBMP
+static int32_t SenseHAT_ImageDecodeBMP (const uint8_t* data,
+                                        size_t size,
+                                        bool sheet,
+                                        tSenseHAT_ImageBuffer* image);
+
+// SenseHAT_ImageInflate
+static int32_t SenseHAT_ImageInflate (const uint8_t* input,
+                                      size_t inputSize,
+                                      uint8_t* output,
+                                      size_t outputSize,
+                                      size_t* outputLength);
+
+// SenseHAT_InflateBits
+static int32_t SenseHAT_InflateBits (tSenseHAT_InflateState* state,
+                                     uint32_t count,
+                                     uint32_t* value);
+
+// SenseHAT_InflateBuild
+static int32_t SenseHAT_InflateBuild (tSenseHAT_InflateHuffman* huffman,
+                                      const uint8_t* lengths,
+                                      uint32_t count);
+
+// SenseHAT_InflateDecode
+static int32_t SenseHAT_InflateDecode (tSenseHAT_InflateState* state,
+                                       const tSenseHAT_InflateHuffman* huffman,
+                                       uint32_t* symbol);
+
+// SenseHAT_InflateCodes
+static int32_t SenseHAT_InflateCodes (tSenseHAT_InflateState* state,
+                                      const tSenseHAT_InflateHuffman* lengthCodes,
+                                      const tSenseHAT_InflateHuffman* distanceCodes);
+
+// SenseHAT_InflateDynamic
+static int32_t SenseHAT_InflateDynamic (tSenseHAT_InflateState* state);
+
+// SenseHAT_ImageReadBE32
+static uint32_t SenseHAT_ImageReadBE32 (const uint8_t* data);
+
+// SenseHAT_ImageReadLE32
+static uint32_t SenseHAT_ImageReadLE32 (const uint8_t* data);
+
+// =================================================================================================
+//  SenseHAT_LEDDecodeImage
+// =================================================================================================
+int32_t SenseHAT_LEDDecodeImage (const char* imageFilePath,
+                                 tSenseHAT_LEDPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((imageFilePath != NULL) &&
+        (strlen(imageFilePath) > 0) &&
+        (pixels != NULL))
+    {
+        tSenseHAT_ImageFrame frame;
+        struct stat status;
+        bool found = false;
+        int32_t index = 0;
+
+        // Look for an up to date decode of the file
+        if (stat(imageFilePath, &status) == 0)
+        {
+            (void)pthread_mutex_lock(&gImageCacheMutex);
+            for (index = 0; (index < kImageCacheEntries) && !found; index++)
+            {
+                tSenseHAT_ImageCacheEntry* entry = &(gImageCache[index]);
+                if ((entry->path != NULL) &&
+                    (entry->mtime.tv_sec == status.st_mtim.tv_sec) &&
+                    (entry->mtime.tv_nsec == status.st_mtim.tv_nsec) &&
+                    (entry->size == status.st_size) &&
+                    (strcmp(entry->path, imageFilePath) == 0))
+                {
+                    memcpy(frame, entry->frame, sizeof(tSenseHAT_ImageFrame));
+                    entry->lastUse = ++gImageCacheUses;
+                    found = true;
+                }
+            }
+            (void)pthread_mutex_unlock(&gImageCacheMutex);
+        }
+        else    // stat failed
+        {
+            result = errno;
+        }
+
+        // Decode the file
+        if ((result == 0) && !found)
+        {
+            tSenseHAT_ImageBuffer image;
+
+            result = SenseHAT_ImageReadFile(imageFilePath, false, &image, &status);
+            if (result == 0)
+            {
+                memcpy(frame, image.pixels, sizeof(tSenseHAT_ImageFrame));
+                free((void*)(image.pixels));
+            }
+
+            // Replace the least recently used entry
+            if (result == 0)
+            {
+                char* path = strdup(imageFilePath);
+                if (path != NULL)
+                {
+                    tSenseHAT_ImageCacheEntry* entry = &(gImageCache[0]);
+
+                    (void)pthread_mutex_lock(&gImageCacheMutex);
+                    for (index = 1; index < kImageCacheEntries; index++)
+                    {
+                        if (gImageCache[index].lastUse < entry->lastUse)
+                        {
+                            entry = &(gImageCache[index]);
+                        }
+                    }
+                    free((void*)(entry->path));
+                    entry->path = path;
+                    entry->mtime = status.st_mtim;
+                    entry->size = status.st_size;
+                    entry->lastUse = ++gImageCacheUses;
+                    memcpy(entry->frame, frame, sizeof(tSenseHAT_ImageFrame));
+                    (void)pthread_mutex_unlock(&gImageCacheMutex);
+                }
+            }
+        }
+
+        // Expand the packed frame
+        if (result == 0)
+        {
+            for (index = 0; index < kImagePixels; index++)
+            {
+                pixels[index].red = frame[index][0];
+                pixels[index].green = frame[index][1];
+                pixels[index].blue = frame[index][2];
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpriteAtlasOpen
+// =================================================================================================
+int32_t SenseHAT_SpriteAtlasOpen (const char* imageFilePath,
+                                  tSenseHAT_SpriteAtlas* atlas)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((imageFilePath != NULL) &&
+        (strlen(imageFilePath) > 0) &&
+        (atlas != NULL))
+    {
+        tSenseHAT_ImageBuffer image;
+        struct stat status;
+
+        // Setup
+        *atlas = NULL;
+
+        // Decode the sheet once
+        result = SenseHAT_ImageReadFile(imageFilePath, true, &image, &status);
+        if (result == 0)
+        {
+            tSenseHAT_SpriteAtlasPrivate* atlasPrivate =
+                (tSenseHAT_SpriteAtlasPrivate*)malloc(sizeof(tSenseHAT_SpriteAtlasPrivate));
+            if (atlasPrivate != NULL)
+            {
+                uint32_t columns = image.width / kImageSize;
+                uint32_t frameCount = columns * (image.height / kImageSize);
+
+                atlasPrivate->frameCount = frameCount;
+                atlasPrivate->frames = (tSenseHAT_ImageFrame*)malloc(frameCount * sizeof(tSenseHAT_ImageFrame));
+                if (atlasPrivate->frames != NULL)
+                {
+                    uint32_t frame = 0;
+                    uint32_t row = 0;
+
+                    // Cut the sheet into tiles, left to right and then top to bottom
+                    for (frame = 0; frame < frameCount; frame++)
+                    {
+                        uint32_t left = (frame % columns) * kImageSize;
+                        uint32_t top = (frame / columns) * kImageSize;
+                        for (row = 0; row < kImageSize; row++)
+                        {
+                            memcpy(atlasPrivate->frames[frame][row * kImageSize],
+                                   image.pixels + ((((size_t)(top + row) * image.width) + left) * 3),
+                                   kImageSize * 3);
+                        }
+                    }
+                    *atlas = (tSenseHAT_SpriteAtlas)atlasPrivate;
+                }
+                else    // malloc failed
+                {
+                    free((void*)atlasPrivate);
+                    result = ENOMEM;
+                }
+            }
+            else    // malloc failed
+            {
+                result = ENOMEM;
+            }
+            free((void*)(image.pixels));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpriteAtlasGetFrameCount
+// =================================================================================================
+int32_t SenseHAT_SpriteAtlasGetFrameCount (const tSenseHAT_SpriteAtlas atlas,
+                                           uint32_t* frameCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((atlas != NULL) && (frameCount != NULL))
+    {
+        *frameCount = ((const tSenseHAT_SpriteAtlasPrivate*)atlas)->frameCount;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpriteAtlasGetFrame
+// =================================================================================================
+int32_t SenseHAT_SpriteAtlasGetFrame (const tSenseHAT_SpriteAtlas atlas,
+                                      uint32_t frameIndex,
+                                      tSenseHAT_LEDPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((atlas != NULL) &&
+        (frameIndex < ((const tSenseHAT_SpriteAtlasPrivate*)atlas)->frameCount) &&
+        (pixels != NULL))
+    {
+        const tSenseHAT_SpriteAtlasPrivate* atlasPrivate = (const tSenseHAT_SpriteAtlasPrivate*)atlas;
+        uint8_t (*frame)[3] = atlasPrivate->frames[frameIndex];
+        int32_t index = 0;
+
+        // Expand the packed frame
+        for (index = 0; index < kImagePixels; index++)
+        {
+            pixels[index].red = frame[index][0];
+            pixels[index].green = frame[index][1];
+            pixels[index].blue = frame[index][2];
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpriteAtlasClose
+// =================================================================================================
+int32_t SenseHAT_SpriteAtlasClose (tSenseHAT_SpriteAtlas* atlas)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((atlas != NULL) && (*atlas != NULL))
+    {
+        tSenseHAT_SpriteAtlasPrivate* atlasPrivate = (tSenseHAT_SpriteAtlasPrivate*)(*atlas);
+
+        free((void*)(atlasPrivate->frames));
+        free((void*)atlasPrivate);
+        *atlas = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDShowSprite
+// =================================================================================================
+int32_t SenseHAT_LEDShowSprite (const tSenseHAT_Instance instance,
+                                const tSenseHAT_SpriteAtlas atlas,
+                                uint32_t frameIndex)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        tSenseHAT_LEDPixelArray pixels;
+
+        // The frame stays packed in the atlas until it is presented
+        result = SenseHAT_SpriteAtlasGetFrame(atlas, frameIndex, pixels);
+        if (result == 0)
+        {
+            result = SenseHAT_LEDSetPixels(instance, pixels);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageReadFile
+// =================================================================================================
+int32_t SenseHAT_ImageReadFile (const char* path,
+                                bool sheet,
+                                tSenseHAT_ImageBuffer* image,
+                                struct stat* status)
+{
+    int32_t result = 0;
+
+    memset(image, 0, sizeof(tSenseHAT_ImageBuffer));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        // Return the status of the file actually read, so callers can key caches with it
+        if (fstat(fd, status) == 0)
+        {
+            if ((status->st_size > 0) && (status->st_size <= kImageFileSizeMax))
+            {
+                uint8_t* data = (uint8_t*)malloc((size_t)(status->st_size));
+                if (data != NULL)
+                {
+                    if (read(fd, data, (size_t)(status->st_size)) == (ssize_t)(status->st_size))
+                    {
+                        result = SenseHAT_ImageDecode(data, (size_t)(status->st_size), sheet, image);
+                    }
+                    else    // read failed
+                    {
+                        result = EIO;
+                    }
+                    free((void*)data);
+                }
+                else    // malloc failed
+                {
+                    result = ENOMEM;
+                }
+            }
+            else    // Empty, or far too big for an LED image
+            {
+                result = (status->st_size > 0) ? EFBIG : EPROTO;
+            }
+        }
+        else    // fstat failed
+        {
+            result = errno;
+        }
+        (void)close(fd);
+    }
+    else    // open failed
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageDecode
+// =================================================================================================
+int32_t SenseHAT_ImageDecode (const uint8_t* data,
+                              size_t size,
+                              bool sheet,
+                              tSenseHAT_ImageBuffer* image)
+{
+    int32_t result = 0;
+
+    // Sniff the format
+    if ((size >= sizeof(kPNGSignature)) && (memcmp(data, kPNGSignature, sizeof(kPNGSignature)) == 0))
+    {
+        result = SenseHAT_ImageDecodePNG(data, size, sheet, image);
+    }
+    else if ((size >= 2) && (data[0] == 'P') && (data[1] >= '2') && (data[1] <= '6') && (data[1] != '4'))
+    {
+        result = SenseHAT_ImageDecodePPM(data, size, sheet, image);
+    }
+    else if ((size >= 2) && (data[0] == 'B') && (data[1] == 'M'))
+    {
+        result = SenseHAT_ImageDecodeBMP(data, size, sheet, image);
+    }
+    else    // Unknown format
+    {
+        result = ENOTSUP;
+    }
+
+    // Don't hand back half decoded images
+    if (result != 0)
+    {
+        free((void*)(image->pixels));
+        image->pixels = NULL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageAllocate
+// =================================================================================================
+int32_t SenseHAT_ImageAllocate (tSenseHAT_ImageBuffer* image,
+                                uint32_t width,
+                                uint32_t height,
+                                bool sheet)
+{
+    int32_t result = 0;
+
+    // Single images are 8x8; sheets are whole numbers of 8x8 frames
+    if (sheet ? ((width > 0) && (height > 0) &&
+                 ((width % kImageSize) == 0) && ((height % kImageSize) == 0) &&
+                 (((uint64_t)width * height) <= kImageSheetPixelsMax))
+              : ((width == kImageSize) && (height == kImageSize)))
+    {
+        image->width = width;
+        image->height = height;
+        image->pixels = (uint8_t*)calloc((size_t)width * height, 3);
+        if (image->pixels == NULL)
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Wrong size
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageDecodePNG
+// =================================================================================================
+int32_t SenseHAT_ImageDecodePNG (const uint8_t* data,
+                                 size_t size,
+                                 bool sheet,
+                                 tSenseHAT_ImageBuffer* image)
+{
+    int32_t result = 0;
+    uint8_t* compressed = (uint8_t*)malloc(size);
+    uint8_t* scanlines = NULL;
+
+    if (compressed != NULL)
+    {
+        uint8_t palette[256][3];
+        size_t compressedSize = 0;
+        size_t scanlineSize = 0;
+        size_t position = sizeof(kPNGSignature);
+        uint32_t paletteCount = 0;
+        uint32_t bitDepth = 0;
+        uint32_t colorType = 0;
+        uint32_t channels = 0;
+        bool header = false;
+        bool end = false;
+
+        // Walk the chunks, collecting the header, the palette and the image data
+        while ((result == 0) && !end)
+        {
+            if ((size - position) >= 12)
+            {
+                uint32_t length = SenseHAT_ImageReadBE32(data + position);
+                const uint8_t* type = data + position + 4;
+                const uint8_t* chunk = data + position + 8;
+
+                if (length <= (size - position - 12))
+                {
+                    if (memcmp(type, "IHDR", 4) == 0)
+                    {
+                        if ((length == 13) && !header)
+                        {
+                            uint32_t width = SenseHAT_ImageReadBE32(chunk);
+                            uint32_t height = SenseHAT_ImageReadBE32(chunk + 4);
+
+                            bitDepth = chunk[8];
+                            colorType = chunk[9];
+                            header = true;
+                            switch (colorType)
+                            {
+                                case kPNGColorGray:
+                                    channels = 1;
+                                    break;
+                                case kPNGColorRGB:
+                                    channels = 3;
+                                    break;
+                                case kPNGColorPalette:
+                                    channels = 1;
+                                    break;
+                                case kPNGColorGrayAlpha:
+                                    channels = 2;
+                                    break;
+                                case kPNGColorRGBA:
+                                    channels = 4;
+                                    break;
+                                default:
+                                    result = EPROTO;
+                                    break;
+                            }
+                            if (result == 0)
+                            {
+                                // Sub-byte depths are only valid for gray and palette images
+                                if (((bitDepth == 8) || (bitDepth == 16)) ||
+                                    (((bitDepth == 1) || (bitDepth == 2) || (bitDepth == 4)) && (channels == 1)))
+                                {
+                                    if ((colorType == kPNGColorPalette) && (bitDepth == 16))
+                                    {
+                                        result = EPROTO;
+                                    }
+                                    else if ((chunk[10] != 0) || (chunk[11] != 0))
+                                    {
+                                        result = EPROTO;
+                                    }
+                                    else if (chunk[12] != 0)
+                                    {
+                                        // Interlaced images are left to PIL
+                                        result = ENOTSUP;
+                                    }
+                                    else
+                                    {
+                                        result = SenseHAT_ImageAllocate(image, width, height, sheet);
+                                    }
+                                }
+                                else    // Bad bit depth
+                                {
+                                    result = EPROTO;
+                                }
+                            }
+                        }
+                        else    // Bad or repeated header
+                        {
+                            result = EPROTO;
+                        }
+                    }
+                    else if (!header)
+                    {
+                        // IHDR must come first
+                        result = EPROTO;
+                    }
+                    else if (memcmp(type, "PLTE", 4) == 0)
+                    {
+                        if (((length % 3) == 0) && (length <= (256 * 3)))
+                        {
+                            paletteCount = length / 3;
+                            memcpy(palette, chunk, length);
+                        }
+                        else    // Bad palette
+                        {
+                            result = EPROTO;
+                        }
+                    }
+                    else if (memcmp(type, "IDAT", 4) == 0)
+                    {
+                        memcpy(compressed + compressedSize, chunk, length);
+                        compressedSize += length;
+                    }
+                    else if (memcmp(type, "IEND", 4) == 0)
+                    {
+                        end = true;
+                    }
+                    else if ((type[0] & 0x20) == 0)
+                    {
+                        // Unknown critical chunk
+                        result = ENOTSUP;
+                    }
+                    position += (size_t)length + 12;
+                }
+                else    // Truncated chunk
+                {
+                    result = EPROTO;
+                }
+            }
+            else    // Missing IEND
+            {
+                result = EPROTO;
+            }
+        }
+
+        // Inflate the scanlines
+        if (result == 0)
+        {
+            scanlineSize = 1 + ((((size_t)(image->width) * channels * bitDepth) + 7) / 8);
+            scanlines = (uint8_t*)malloc(image->height * scanlineSize);
+            if (scanlines == NULL)
+            {
+                result = ENOMEM;
+            }
+            else if ((compressedSize > 2) &&
+                     ((compressed[0] & 0x0F) == 8) &&
+                     ((compressed[1] & 0x20) == 0) &&
+                     ((((uint32_t)(compressed[0]) << 8) | compressed[1]) % 31 == 0))
+            {
+                size_t length = 0;
+                result = SenseHAT_ImageInflate(compressed + 2, compressedSize - 2, scanlines, image->height * scanlineSize, &length);
+                if ((result == 0) && (length != (image->height * scanlineSize)))
+                {
+                    result = EPROTO;
+                }
+            }
+            else    // Not a zlib stream
+            {
+                result = EPROTO;
+            }
+        }
+
+        // Undo the filters and convert to RGB
+        if (result == 0)
+        {
+            size_t rowSize = scanlineSize - 1;
+            size_t pixelSize = ((channels * bitDepth) >= 8) ? ((channels * bitDepth) / 8) : 1;
+            uint32_t row = 0;
+            uint32_t column = 0;
+            size_t byteIndex = 0;
+
+            for (row = 0; (row < image->height) && (result == 0); row++)
+            {
+                uint8_t* line = scanlines + (row * scanlineSize) + 1;
+                const uint8_t* previous = (row > 0) ? (line - scanlineSize) : NULL;
+                uint8_t filter = line[-1];
+
+                for (byteIndex = 0; (byteIndex < rowSize) && (result == 0); byteIndex++)
+                {
+                    uint32_t left = (byteIndex >= pixelSize) ? line[byteIndex - pixelSize] : 0;
+                    uint32_t up = (previous != NULL) ? previous[byteIndex] : 0;
+                    uint32_t upLeft = ((previous != NULL) && (byteIndex >= pixelSize)) ? previous[byteIndex - pixelSize] : 0;
+
+                    switch (filter)
+                    {
+                        case 0:
+                            break;
+                        case 1:
+                            line[byteIndex] = (uint8_t)(line[byteIndex] + left);
+                            break;
+                        case 2:
+                            line[byteIndex] = (uint8_t)(line[byteIndex] + up);
+                            break;
+                        case 3:
+                            line[byteIndex] = (uint8_t)(line[byteIndex] + ((left + up) / 2));
+                            break;
+                        case 4:
+                        {
+                            int32_t estimate = (int32_t)left + (int32_t)up - (int32_t)upLeft;
+                            int32_t distanceLeft = abs(estimate - (int32_t)left);
+                            int32_t distanceUp = abs(estimate - (int32_t)up);
+                            int32_t distanceUpLeft = abs(estimate - (int32_t)upLeft);
+                            uint32_t predictor = upLeft;
+                            if ((distanceLeft <= distanceUp) && (distanceLeft <= distanceUpLeft))
+                            {
+                                predictor = left;
+                            }
+                            else if (distanceUp <= distanceUpLeft)
+                            {
+                                predictor = up;
+                            }
+                            line[byteIndex] = (uint8_t)(line[byteIndex] + predictor);
+                            break;
+                        }
+                        default:
+                            result = EPROTO;
+                            break;
+                    }
+                }
+
+                // Take the high byte of 16 bit samples, scale up sub-byte gray, look up palettes
+                for (column = 0; (column < image->width) && (result == 0); column++)
+                {
+                    uint8_t* pixel = image->pixels + ((((size_t)row * image->width) + column) * 3);
+                    if (bitDepth < 8)
+                    {
+                        uint32_t bitOffset = column * bitDepth;
+                        uint32_t value = (line[bitOffset / 8] >> (8 - bitDepth - (bitOffset % 8))) & ((1u << bitDepth) - 1);
+                        if (colorType == kPNGColorPalette)
+                        {
+                            if (value < paletteCount)
+                            {
+                                memcpy(pixel, palette[value], 3);
+                            }
+                            else    // Index out of range
+                            {
+                                result = EPROTO;
+                            }
+                        }
+                        else
+                        {
+                            pixel[0] = pixel[1] = pixel[2] = (uint8_t)((value * 255) / ((1u << bitDepth) - 1));
+                        }
+                    }
+                    else
+                    {
+                        const uint8_t* sample = line + ((size_t)column * channels * (bitDepth / 8));
+                        uint32_t step = bitDepth / 8;
+                        switch (colorType)
+                        {
+                            case kPNGColorPalette:
+                                if (sample[0] < paletteCount)
+                                {
+                                    memcpy(pixel, palette[sample[0]], 3);
+                                }
+                                else    // Index out of range
+                                {
+                                    result = EPROTO;
+                                }
+                                break;
+                            case kPNGColorGray:
+                            case kPNGColorGrayAlpha:
+                                pixel[0] = pixel[1] = pixel[2] = sample[0];
+                                break;
+                            default:
+                                pixel[0] = sample[0];
+                                pixel[1] = sample[step];
+                                pixel[2] = sample[2 * step];
+                                break;
+                        }
+                    }
+                }
+            }
+        }
+        free((void*)scanlines);
+        free((void*)compressed);
+    }
+    else    // malloc failed
+    {
+        result = ENOMEM;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageDecodePPM
+// =================================================================================================
+int32_t SenseHAT_ImageDecodePPM (const uint8_t* data,
+                                 size_t size,
+                                 bool sheet,
+                                 tSenseHAT_ImageBuffer* image)
+{
+    int32_t result = 0;
+    char format = (char)(data[1]);
+    bool ascii = (format == '2') || (format == '3');
+    uint32_t channels = ((format == '3') || (format == '6')) ? 3 : 1;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t maxValue = 0;
+    size_t position = 2;
+
+    // Read the width, height and maximum value
+    result = SenseHAT_ImagePPMNumber(data, size, &position, &width);
+    if (result == 0)
+    {
+        result = SenseHAT_ImagePPMNumber(data, size, &position, &height);
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_ImagePPMNumber(data, size, &position, &maxValue);
+    }
+    if ((result == 0) && (maxValue == 0))
+    {
+        result = EPROTO;
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_ImageAllocate(image, width, height, sheet);
+    }
+
+    // Read the samples; binary samples follow a single whitespace character
+    if (result == 0)
+    {
+        size_t count = (size_t)width * height * channels;
+        size_t sampleSize = (maxValue > 255) ? 2 : 1;
+        size_t index = 0;
+
+        if (!ascii)
+        {
+            if ((size - position) >= (1 + (count * sampleSize)))
+            {
+                position++;
+            }
+            else    // Truncated
+            {
+                result = EPROTO;
+            }
+        }
+        for (index = 0; (index < count) && (result == 0); index++)
+        {
+            uint32_t value = 0;
+            if (ascii)
+            {
+                result = SenseHAT_ImagePPMNumber(data, size, &position, &value);
+            }
+            else
+            {
+                value = (sampleSize == 2) ? (((uint32_t)(data[position]) << 8) | data[position + 1]) : data[position];
+                position += sampleSize;
+            }
+            if ((result == 0) && (value > maxValue))
+            {
+                result = EPROTO;
+            }
+            if (result == 0)
+            {
+                uint8_t scaled = (uint8_t)(((value * 255) + (maxValue / 2)) / maxValue);
+                if (channels == 3)
+                {
+                    image->pixels[index] = scaled;
+                }
+                else
+                {
+                    image->pixels[(index * 3)] = image->pixels[(index * 3) + 1] = image->pixels[(index * 3) + 2] = scaled;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImagePPMNumber
+// =================================================================================================
+int32_t SenseHAT_ImagePPMNumber (const uint8_t* data,
+                                 size_t size,
+                                 size_t* position,
+                                 uint32_t* value)
+{
+    int32_t result = 0;
+    size_t index = *position;
+    uint32_t number = 0;
+    bool digits = false;
+
+    // Skip whitespace and comments
+    while ((index < size) &&
+           ((data[index] == ' ') || (data[index] == '\t') || (data[index] == '\r') ||
+            (data[index] == '\n') || (data[index] == '#')))
+    {
+        if (data[index] == '#')
+        {
+            while ((index < size) && (data[index] != '\n'))
+            {
+                index++;
+            }
+        }
+        else
+        {
+            index++;
+        }
+    }
+    while ((index < size) && (data[index] >= '0') && (data[index] <= '9') && (number <= 65535))
+    {
+        number = (number * 10) + (uint32_t)(data[index] - '0');
+        digits = true;
+        index++;
+    }
+    if (digits && (number <= 65535))
+    {
+        *value = number;
+        *position = index;
+    }
+    else    // Not a number, or out of range
+    {
+        result = EPROTO;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageDecodeBMP
+// =================================================================================================
+int32_t SenseHAT_ImageDecodeBMP (const uint8_t* data,
+                                 size_t size,
+                                 bool sheet,
+                                 tSenseHAT_ImageBuffer* image)
+{
+    int32_t result = 0;
+
+    if (size >= 54)
+    {
+        uint32_t pixelOffset = SenseHAT_ImageReadLE32(data + 10);
+        uint32_t headerSize = SenseHAT_ImageReadLE32(data + 14);
+        int32_t width = (int32_t)SenseHAT_ImageReadLE32(data + 18);
+        int32_t height = (int32_t)SenseHAT_ImageReadLE32(data + 22);
+        uint32_t rows = (height < 0) ? (uint32_t)(-(int64_t)height) : (uint32_t)height;
+        uint32_t bitCount = (uint32_t)(data[28]) | ((uint32_t)(data[29]) << 8);
+        uint32_t compression = SenseHAT_ImageReadLE32(data + 30);
+        uint32_t colorsUsed = SenseHAT_ImageReadLE32(data + 46);
+        uint32_t paletteCount = 0;
+        size_t stride = 0;
+
+        if ((headerSize < 40) || (headerSize > (size - 14)))
+        {
+            // OS/2 headers and truncated headers
+            result = ENOTSUP;
+        }
+        else if ((compression != 0) ||
+                 ((bitCount != 1) && (bitCount != 4) && (bitCount != 8) && (bitCount != 24) && (bitCount != 32)))
+        {
+            // Compressed, bitfield and 16 bit images are left to PIL
+            result = ENOTSUP;
+        }
+        else if (width <= 0)
+        {
+            result = EPROTO;
+        }
+        else
+        {
+            result = SenseHAT_ImageAllocate(image, (uint32_t)width, rows, sheet);
+        }
+        if (result == 0)
+        {
+            stride = ((((size_t)bitCount * image->width) + 31) / 32) * 4;
+            if (bitCount <= 8)
+            {
+                paletteCount = (colorsUsed != 0) ? colorsUsed : (1u << bitCount);
+                if ((paletteCount > (1u << bitCount)) ||
+                    (((size_t)14 + headerSize + ((size_t)paletteCount * 4)) > size))
+                {
+                    result = EPROTO;
+                }
+            }
+            if ((pixelOffset > size) || ((size - pixelOffset) < (stride * image->height)))
+            {
+                result = EPROTO;
+            }
+        }
+
+        // Rows are stored bottom up unless the height is negative; colors are BGR
+        if (result == 0)
+        {
+            const uint8_t* palette = data + 14 + headerSize;
+            uint32_t row = 0;
+            uint32_t column = 0;
+
+            for (row = 0; (row < image->height) && (result == 0); row++)
+            {
+                const uint8_t* line = data + pixelOffset + (stride * ((height > 0) ? (image->height - 1 - row) : row));
+                for (column = 0; (column < image->width) && (result == 0); column++)
+                {
+                    uint8_t* pixel = image->pixels + ((((size_t)row * image->width) + column) * 3);
+                    const uint8_t* color = NULL;
+
+                    if (bitCount <= 8)
+                    {
+                        uint32_t bitOffset = column * bitCount;
+                        uint32_t value = (line[bitOffset / 8] >> (8 - bitCount - (bitOffset % 8))) & ((1u << bitCount) - 1);
+                        if (value < paletteCount)
+                        {
+                            color = palette + (value * 4);
+                        }
+                        else    // Index out of range
+                        {
+                            result = EPROTO;
+                        }
+                    }
+                    else
+                    {
+                        color = line + ((size_t)column * (bitCount / 8));
+                    }
+                    if (color != NULL)
+                    {
+                        pixel[0] = color[2];
+                        pixel[1] = color[1];
+                        pixel[2] = color[0];
+                    }
+                }
+            }
+        }
+    }
+    else    // Truncated
+    {
+        result = EPROTO;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageInflate
+// =================================================================================================
+int32_t SenseHAT_ImageInflate (const uint8_t* input,
+                               size_t inputSize,
+                               uint8_t* output,
+                               size_t outputSize,
+                               size_t* outputLength)
+{
+    int32_t result = 0;
+    tSenseHAT_InflateState state;
+    uint32_t last = 0;
+    uint32_t type = 0;
+
+    memset(&state, 0, sizeof(tSenseHAT_InflateState));
+    state.input = input;
+    state.inputSize = inputSize;
+    state.output = output;
+    state.outputSize = outputSize;
+
+    // Decode blocks until the last one (RFC 1951)
+    while ((result == 0) && (last == 0))
+    {
+        result = SenseHAT_InflateBits(&state, 1, &last);
+        if (result == 0)
+        {
+            result = SenseHAT_InflateBits(&state, 2, &type);
+        }
+        if (result == 0)
+        {
+            if (type == 0)
+            {
+                // Stored block, starting on a byte boundary
+                state.bitBuffer = 0;
+                state.bitCount = 0;
+                if ((state.inputSize - state.inputPosition) >= 4)
+                {
+                    uint32_t length = (uint32_t)(state.input[state.inputPosition]) |
+                                      ((uint32_t)(state.input[state.inputPosition + 1]) << 8);
+                    uint32_t complement = (uint32_t)(state.input[state.inputPosition + 2]) |
+                                          ((uint32_t)(state.input[state.inputPosition + 3]) << 8);
+                    state.inputPosition += 4;
+                    if ((length == (~complement & 0xFFFF)) &&
+                        (length <= (state.inputSize - state.inputPosition)) &&
+                        (length <= (state.outputSize - state.outputPosition)))
+                    {
+                        memcpy(state.output + state.outputPosition, state.input + state.inputPosition, length);
+                        state.inputPosition += length;
+                        state.outputPosition += length;
+                    }
+                    else    // Corrupt or oversized block
+                    {
+                        result = EPROTO;
+                    }
+                }
+                else    // Truncated
+                {
+                    result = EPROTO;
+                }
+            }
+            else if (type == 1)
+            {
+                // Fixed codes
+                tSenseHAT_InflateHuffman lengthCodes;
+                tSenseHAT_InflateHuffman distanceCodes;
+                uint8_t lengths[288];
+                uint32_t symbol = 0;
+
+                for (symbol = 0; symbol < 288; symbol++)
+                {
+                    lengths[symbol] = (symbol < 144) ? 8 : ((symbol < 256) ? 9 : ((symbol < 280) ? 7 : 8));
+                }
+                (void)SenseHAT_InflateBuild(&lengthCodes, lengths, 288);
+                memset(lengths, 5, 30);
+                (void)SenseHAT_InflateBuild(&distanceCodes, lengths, 30);
+                result = SenseHAT_InflateCodes(&state, &lengthCodes, &distanceCodes);
+            }
+            else if (type == 2)
+            {
+                result = SenseHAT_InflateDynamic(&state);
+            }
+            else    // Reserved block type
+            {
+                result = EPROTO;
+            }
+        }
+    }
+    *outputLength = state.outputPosition;
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_InflateBits
+// =================================================================================================
+int32_t SenseHAT_InflateBits (tSenseHAT_InflateState* state,
+                              uint32_t count,
+                              uint32_t* value)
+{
+    int32_t result = 0;
+
+    while ((state->bitCount < count) && (result == 0))
+    {
+        if (state->inputPosition < state->inputSize)
+        {
+            state->bitBuffer |= (uint32_t)(state->input[state->inputPosition++]) << state->bitCount;
+            state->bitCount += 8;
+        }
+        else    // Ran out of input
+        {
+            result = EPROTO;
+        }
+    }
+    if (result == 0)
+    {
+        *value = state->bitBuffer & ((1u << count) - 1);
+        state->bitBuffer >>= count;
+        state->bitCount -= count;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_InflateBuild
+// =================================================================================================
+int32_t SenseHAT_InflateBuild (tSenseHAT_InflateHuffman* huffman,
+                               const uint8_t* lengths,
+                               uint32_t count)
+{
+    int32_t result = 0;
+    uint16_t offsets[kInflateMaxBits + 1];
+    int32_t left = 1;
+    uint32_t index = 0;
+
+    memset(huffman->counts, 0, sizeof(huffman->counts));
+    for (index = 0; index < count; index++)
+    {
+        huffman->counts[lengths[index]]++;
+    }
+
+    // Over-subscribed code sets can't be decoded; incomplete ones are caught while decoding
+    for (index = 1; (index <= kInflateMaxBits) && (result == 0); index++)
+    {
+        left = (left << 1) - (int32_t)(huffman->counts[index]);
+        if (left < 0)
+        {
+            result = EPROTO;
+        }
+    }
+
+    // Order the symbols by code length, then by value
+    if (result == 0)
+    {
+        offsets[1] = 0;
+        for (index = 1; index < kInflateMaxBits; index++)
+        {
+            offsets[index + 1] = offsets[index] + huffman->counts[index];
+        }
+        for (index = 0; index < count; index++)
+        {
+            if (lengths[index] != 0)
+            {
+                huffman->symbols[offsets[lengths[index]]++] = (uint16_t)index;
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_InflateDecode
+// =================================================================================================
+int32_t SenseHAT_InflateDecode (tSenseHAT_InflateState* state,
+                                const tSenseHAT_InflateHuffman* huffman,
+                                uint32_t* symbol)
+{
+    int32_t result = EPROTO;
+    int32_t code = 0;
+    int32_t first = 0;
+    int32_t index = 0;
+    uint32_t length = 0;
+    uint32_t bit = 0;
+
+    // Canonical codes of each length follow on from the previous length
+    for (length = 1; length <= kInflateMaxBits; length++)
+    {
+        int32_t count = huffman->counts[length];
+        if (SenseHAT_InflateBits(state, 1, &bit) != 0)
+        {
+            break;
+        }
+        code |= (int32_t)bit;
+        if ((code - count) < first)
+        {
+            *symbol = huffman->symbols[index + (code - first)];
+            result = 0;
+            break;
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_InflateCodes
+// =================================================================================================
+int32_t SenseHAT_InflateCodes (tSenseHAT_InflateState* state,
+                               const tSenseHAT_InflateHuffman* lengthCodes,
+                               const tSenseHAT_InflateHuffman* distanceCodes)
+{
+    int32_t result = 0;
+    uint32_t symbol = 0;
+
+    do
+    {
+        result = SenseHAT_InflateDecode(state, lengthCodes, &symbol);
+        if (result == 0)
+        {
+            if (symbol < 256)
+            {
+                // Literal
+                if (state->outputPosition < state->outputSize)
+                {
+                    state->output[state->outputPosition++] = (uint8_t)symbol;
+                }
+                else    // More data than the image holds
+                {
+                    result = EPROTO;
+                }
+            }
+            else if ((symbol > 256) && (symbol <= 285))
+            {
+                // Length and distance pair
+                uint32_t length = 0;
+                uint32_t distance = 0;
+                uint32_t extra = 0;
+
+                symbol -= 257;
+                result = SenseHAT_InflateBits(state, kInflateLengthExtra[symbol], &extra);
+                length = kInflateLengthBase[symbol] + extra;
+                if (result == 0)
+                {
+                    result = SenseHAT_InflateDecode(state, distanceCodes, &symbol);
+                }
+                if ((result == 0) && (symbol >= 30))
+                {
+                    result = EPROTO;
+                }
+                if (result == 0)
+                {
+                    result = SenseHAT_InflateBits(state, kInflateDistanceExtra[symbol], &extra);
+                    distance = kInflateDistanceBase[symbol] + extra;
+                }
+                if (result == 0)
+                {
+                    if ((distance <= state->outputPosition) &&
+                        (length <= (state->outputSize - state->outputPosition)))
+                    {
+                        // Copy byte by byte, since the source may overlap the destination
+                        while (length > 0)
+                        {
+                            state->output[state->outputPosition] = state->output[state->outputPosition - distance];
+                            state->outputPosition++;
+                            length--;
+                        }
+                    }
+                    else    // Reaches back too far, or more data than the image holds
+                    {
+                        result = EPROTO;
+                    }
+                }
+            }
+            else if (symbol != 256)
+            {
+                result = EPROTO;
+            }
+        }
+    }
+    while ((result == 0) && (symbol != 256));
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_InflateDynamic
+// =================================================================================================
+int32_t SenseHAT_InflateDynamic (tSenseHAT_InflateState* state)
+{
+    int32_t result = 0;
+    tSenseHAT_InflateHuffman lengthCodes;
+    tSenseHAT_InflateHuffman distanceCodes;
+    uint8_t lengths[kInflateMaxCodes];
+    uint32_t lengthCount = 0;
+    uint32_t distanceCount = 0;
+    uint32_t codeCount = 0;
+    uint32_t index = 0;
+
+    // Read the code length code
+    result = SenseHAT_InflateBits(state, 5, &lengthCount);
+    if (result == 0)
+    {
+        result = SenseHAT_InflateBits(state, 5, &distanceCount);
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_InflateBits(state, 4, &codeCount);
+    }
+    if (result == 0)
+    {
+        lengthCount += 257;
+        distanceCount += 1;
+        codeCount += 4;
+        if ((lengthCount > 286) || (distanceCount > 30))
+        {
+            result = EPROTO;
+        }
+    }
+    if (result == 0)
+    {
+        memset(lengths, 0, sizeof(lengths));
+        for (index = 0; (index < codeCount) && (result == 0); index++)
+        {
+            uint32_t length = 0;
+            result = SenseHAT_InflateBits(state, 3, &length);
+            lengths[kInflateCodeLengthOrder[index]] = (uint8_t)length;
+        }
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_InflateBuild(&lengthCodes, lengths, 19);
+    }
+
+    // Read the literal/length and distance code lengths, which share one run length coding
+    index = 0;
+    while ((result == 0) && (index < (lengthCount + distanceCount)))
+    {
+        uint32_t symbol = 0;
+        result = SenseHAT_InflateDecode(state, &lengthCodes, &symbol);
+        if (result == 0)
+        {
+            if (symbol < 16)
+            {
+                lengths[index++] = (uint8_t)symbol;
+            }
+            else
+            {
+                uint32_t repeat = 0;
+                uint8_t value = 0;
+
+                if (symbol == 16)
+                {
+                    if (index > 0)
+                    {
+                        value = lengths[index - 1];
+                        result = SenseHAT_InflateBits(state, 2, &repeat);
+                        repeat += 3;
+                    }
+                    else    // Nothing to repeat
+                    {
+                        result = EPROTO;
+                    }
+                }
+                else if (symbol == 17)
+                {
+                    result = SenseHAT_InflateBits(state, 3, &repeat);
+                    repeat += 3;
+                }
+                else
+                {
+                    result = SenseHAT_InflateBits(state, 7, &repeat);
+                    repeat += 11;
+                }
+                if ((result == 0) && ((index + repeat) > (lengthCount + distanceCount)))
+                {
+                    result = EPROTO;
+                }
+                while ((result == 0) && (repeat > 0))
+                {
+                    lengths[index++] = value;
+                    repeat--;
+                }
+            }
+        }
+    }
+
+    // The end of block code must be present
+    if ((result == 0) && (lengths[256] == 0))
+    {
+        result = EPROTO;
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_InflateBuild(&lengthCodes, lengths, lengthCount);
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_InflateBuild(&distanceCodes, lengths + lengthCount, distanceCount);
+    }
+    if (result == 0)
+    {
+        result = SenseHAT_InflateCodes(state, &lengthCodes, &distanceCodes);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ImageReadBE32
+// =================================================================================================
+uint32_t SenseHAT_ImageReadBE32 (const uint8_t* data)
+{
+    return ((uint32_t)(data[0]) << 24) | ((uint32_t)(data[1]) << 16) | ((uint32_t)(data[2]) << 8) | (uint32_t)(data[3]);
+}
+
+// =================================================================================================
+//  SenseHAT_ImageReadLE32
+// =================================================================================================
+uint32_t SenseHAT_ImageReadLE32 (const uint8_t* data)
+{
+    return (uint32_t)(data[0]) | ((uint32_t)(data[1]) << 8) | ((uint32_t)(data[2]) << 16) | ((uint32_t)(data[3]) << 24);
+}
+
+// =================================================================================================
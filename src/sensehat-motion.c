@@ -0,0 +1,490 @@
+// ==================================================================================================
+//
+//  sensehat-motion.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the motion detector of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-motion.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the motion detector of the Raspberry
+//! Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <math.h>
+#include <memory.h>
+#include <sys/eventfd.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Default configuration
+static const double kDefaultTapThreshold            = 1.0;
+static const double kDefaultTapQuietTime            = 0.2;
+static const double kDefaultShakeThreshold          = 1.2;
+static const uint32_t kDefaultShakeStrokes          = 4;
+static const double kDefaultShakeWindow             = 1.0;
+static const double kDefaultFreeFallThreshold       = 0.3;
+static const double kDefaultFreeFallTime            = 0.1;
+static const double kDefaultTiltThreshold           = 30.0;
+static const double kDefaultHysteresis              = 0.2;
+static const double kDefaultGravityTimeConstant     = 0.5;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_MotionAdd
+static void SenseHAT_MotionAdd (tSenseHAT_MotionEvent* events,
+                                int32_t capacity,
+                                int32_t* count,
+                                bool* overflow,
+                                double timestamp,
+                                tSenseHAT_MotionType type,
+                                bool active,
+                                double magnitude,
+                                const tSenseHAT_RawData* acceleration);
+
+// SenseHAT_MotionLength
+static double SenseHAT_MotionLength (double x,
+                                     double y,
+                                     double z);
+
+// =================================================================================================
+//  SenseHAT_MotionInitialize
+// =================================================================================================
+int32_t SenseHAT_MotionInitialize (tSenseHAT_MotionDetector* detector,
+                                   const tSenseHAT_MotionConfiguration* configuration)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (detector != NULL)
+    {
+        tSenseHAT_MotionConfiguration defaultConfiguration;
+
+        // Use the defaults?
+        if (configuration == NULL)
+        {
+            defaultConfiguration.detectors = eSenseHAT_MotionAll;
+            defaultConfiguration.tapThreshold = kDefaultTapThreshold;
+            defaultConfiguration.tapQuietTime = kDefaultTapQuietTime;
+            defaultConfiguration.shakeThreshold = kDefaultShakeThreshold;
+            defaultConfiguration.shakeStrokes = kDefaultShakeStrokes;
+            defaultConfiguration.shakeWindow = kDefaultShakeWindow;
+            defaultConfiguration.freeFallThreshold = kDefaultFreeFallThreshold;
+            defaultConfiguration.freeFallTime = kDefaultFreeFallTime;
+            defaultConfiguration.tiltThreshold = kDefaultTiltThreshold;
+            defaultConfiguration.hysteresis = kDefaultHysteresis;
+            defaultConfiguration.gravityTimeConstant = kDefaultGravityTimeConstant;
+            configuration = &defaultConfiguration;
+        }
+
+        // Validate the configuration
+        if (((configuration->detectors & ~eSenseHAT_MotionAll) == 0) &&
+            (configuration->tapThreshold > 0.0) &&
+            (configuration->tapQuietTime >= 0.0) &&
+            (configuration->shakeThreshold > 0.0) &&
+            (configuration->shakeStrokes >= 1) &&
+            (configuration->shakeStrokes <= kSenseHAT_MotionShakeStrokesMax) &&
+            (configuration->shakeWindow > 0.0) &&
+            (configuration->freeFallThreshold > 0.0) &&
+            (configuration->freeFallTime >= 0.0) &&
+            (configuration->tiltThreshold > 0.0) &&
+            (configuration->tiltThreshold < 180.0) &&
+            (configuration->hysteresis >= 0.0) &&
+            (configuration->hysteresis < 1.0) &&
+            (configuration->gravityTimeConstant > 0.0))
+        {
+            memset(detector, 0, sizeof(tSenseHAT_MotionDetector));
+            detector->configuration = *configuration;
+        }
+        else    // Invalid configuration
+        {
+            result = EINVAL;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MotionProcess
+// =================================================================================================
+int32_t SenseHAT_MotionProcess (tSenseHAT_MotionDetector* detector,
+                                double timestamp,
+                                const tSenseHAT_RawData* acceleration,
+                                tSenseHAT_MotionEvent* events,
+                                int32_t capacity,
+                                int32_t* eventCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((detector != NULL) &&
+        (acceleration != NULL) &&
+        (events != NULL) &&
+        (capacity > 0) &&
+        (eventCount != NULL))
+    {
+        const tSenseHAT_MotionConfiguration* configuration = &(detector->configuration);
+        double release = 1.0 - configuration->hysteresis;
+        double magnitude = SenseHAT_MotionLength(acceleration->x, acceleration->y, acceleration->z);
+        int32_t count = 0;
+        bool overflow = false;
+
+        // The first reading starts the gravity estimate
+        if (!detector->primed)
+        {
+            detector->primed = true;
+            detector->gravity = *acceleration;
+            detector->previous = *acceleration;
+            detector->lastTime = timestamp;
+            detector->tapArmed = true;
+            detector->tapTime = timestamp - configuration->tapQuietTime;
+            detector->shakeArmed = true;
+        }
+        else
+        {
+            double interval = (timestamp > detector->lastTime) ? (timestamp - detector->lastTime) : 0.0;
+            double alpha = interval / (configuration->gravityTimeConstant + interval);
+            double jerk = SenseHAT_MotionLength(acceleration->x - detector->previous.x,
+                                                acceleration->y - detector->previous.y,
+                                                acceleration->z - detector->previous.z);
+            double stroke = 0.0;
+
+            // Track gravity with a low pass filter that adapts to the reading interval
+            detector->gravity.x += alpha * (acceleration->x - detector->gravity.x);
+            detector->gravity.y += alpha * (acceleration->y - detector->gravity.y);
+            detector->gravity.z += alpha * (acceleration->z - detector->gravity.z);
+            stroke = SenseHAT_MotionLength(acceleration->x - detector->gravity.x,
+                                           acceleration->y - detector->gravity.y,
+                                           acceleration->z - detector->gravity.z);
+            detector->previous = *acceleration;
+            detector->lastTime = timestamp;
+
+            // Taps
+            if ((configuration->detectors & eSenseHAT_MotionTap) != 0)
+            {
+                if (detector->tapArmed && (jerk >= configuration->tapThreshold))
+                {
+                    // Swallow the ringing after a tap
+                    detector->tapArmed = false;
+                    if ((timestamp - detector->tapTime) >= configuration->tapQuietTime)
+                    {
+                        detector->tapTime = timestamp;
+                        SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                           eSenseHAT_MotionTap, true, jerk, acceleration);
+                    }
+                }
+                else if (jerk < (configuration->tapThreshold * release))
+                {
+                    detector->tapArmed = true;
+                }
+            }
+
+            // Shakes
+            if ((configuration->detectors & eSenseHAT_MotionShake) != 0)
+            {
+                if (detector->shakeArmed && (stroke >= configuration->shakeThreshold))
+                {
+                    uint32_t strokes = configuration->shakeStrokes;
+
+                    // Remember the last few strokes; the oldest is overwritten
+                    detector->shakeArmed = false;
+                    detector->strokeTimes[detector->strokeIndex] = timestamp;
+                    detector->strokeIndex = (detector->strokeIndex + 1) % strokes;
+                    if (detector->strokeCount < strokes)
+                    {
+                        detector->strokeCount++;
+                    }
+                    if (stroke > detector->strokePeak)
+                    {
+                        detector->strokePeak = stroke;
+                    }
+
+                    // Enough strokes close enough together?
+                    if ((detector->strokeCount == strokes) &&
+                        ((timestamp - detector->strokeTimes[detector->strokeIndex]) <= configuration->shakeWindow))
+                    {
+                        SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                           eSenseHAT_MotionShake, true, detector->strokePeak, acceleration);
+                        detector->strokeCount = 0;
+                        detector->strokePeak = 0.0;
+                    }
+                }
+                else if (stroke < (configuration->shakeThreshold * release))
+                {
+                    detector->shakeArmed = true;
+                }
+            }
+        }
+
+        // Free-fall
+        if ((configuration->detectors & eSenseHAT_MotionFreeFall) != 0)
+        {
+            if (!detector->falling && (magnitude < configuration->freeFallThreshold))
+            {
+                detector->falling = true;
+                detector->fallReported = false;
+                detector->fallTime = timestamp;
+            }
+            else if (detector->falling &&
+                     (magnitude > (configuration->freeFallThreshold * (1.0 + configuration->hysteresis))))
+            {
+                detector->falling = false;
+                if (detector->fallReported)
+                {
+                    SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                       eSenseHAT_MotionFreeFall, false, timestamp - detector->fallTime, acceleration);
+                }
+            }
+            if (detector->falling && !detector->fallReported &&
+                ((timestamp - detector->fallTime) >= configuration->freeFallTime))
+            {
+                detector->fallReported = true;
+                SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                   eSenseHAT_MotionFreeFall, true, timestamp - detector->fallTime, acceleration);
+            }
+        }
+
+        // Tilt, which is meaningless while falling
+        if (((configuration->detectors & eSenseHAT_MotionTilt) != 0) && !detector->falling)
+        {
+            double gravity = SenseHAT_MotionLength(detector->gravity.x, detector->gravity.y, detector->gravity.z);
+            if (gravity > 0.0)
+            {
+                double cosine = detector->gravity.z / gravity;
+                double angle = 0.0;
+
+                cosine = (cosine > 1.0) ? 1.0 : ((cosine < -1.0) ? -1.0 : cosine);
+                angle = acos(cosine) * (180.0 / M_PI);
+                if (!detector->tilted && (angle >= configuration->tiltThreshold))
+                {
+                    detector->tilted = true;
+                    SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                       eSenseHAT_MotionTilt, true, angle, acceleration);
+                }
+                else if (detector->tilted && (angle < (configuration->tiltThreshold * release)))
+                {
+                    detector->tilted = false;
+                    SenseHAT_MotionAdd(events, capacity, &count, &overflow, timestamp,
+                                       eSenseHAT_MotionTilt, false, angle, acceleration);
+                }
+            }
+        }
+
+        // Return results
+        *eventCount = count;
+        if (overflow)
+        {
+            result = ENOBUFS;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerSetMotionDetection
+// =================================================================================================
+int32_t SenseHAT_SamplerSetMotionDetection (const tSenseHAT_Instance instance,
+                                            const tSenseHAT_MotionConfiguration* configuration,
+                                            tSenseHAT_MotionCallback callback,
+                                            void* context)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        tSenseHAT_MotionDetector detector;
+
+        // Check the configuration before touching the sampler
+        result = SenseHAT_MotionInitialize(&detector, configuration);
+        if (result == 0)
+        {
+            (void)pthread_mutex_lock(&(sampler->mutex));
+            sampler->motionDetector = detector;
+            sampler->motionEnabled = (detector.configuration.detectors != eSenseHAT_MotionNone);
+            sampler->motionCallback = callback;
+            sampler->motionContext = context;
+            sampler->motionEventIndex = 0;
+            sampler->motionEventCount = 0;
+            if (sampler->motionFd >= 0)
+            {
+                eventfd_t value = 0;
+                (void)eventfd_read(sampler->motionFd, &value);
+            }
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerGetMotionEvents
+// =================================================================================================
+int32_t SenseHAT_SamplerGetMotionEvents (const tSenseHAT_Instance instance,
+                                         tSenseHAT_MotionEvent* events,
+                                         int32_t capacity,
+                                         int32_t* eventCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (events != NULL) &&
+        (capacity > 0) &&
+        (eventCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        int32_t count = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        while ((count < capacity) && (sampler->motionEventCount > 0))
+        {
+            events[count] = sampler->motionEvents[sampler->motionEventIndex];
+            sampler->motionEventIndex = (sampler->motionEventIndex + 1) % kSenseHAT_MotionQueueLength;
+            sampler->motionEventCount--;
+            count++;
+        }
+        *eventCount = count;
+
+        // Acknowledge the events once they've all been retrieved
+        if (sampler->motionEventCount > 0)
+        {
+            result = ENOBUFS;
+        }
+        else if (sampler->motionFd >= 0)
+        {
+            eventfd_t value = 0;
+            (void)eventfd_read(sampler->motionFd, &value);
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MotionSample
+// =================================================================================================
+uint32_t SenseHAT_MotionSample (tSenseHAT_Sampler* sampler,
+                                const tSenseHAT_Sample* sample,
+                                tSenseHAT_MotionEvent* events)
+{
+    int32_t count = 0;
+
+    // Only accelerometer readings matter
+    if (sampler->motionEnabled &&
+        ((sample->channels & eSenseHAT_ChannelAccelerometerRaw) != 0))
+    {
+        int32_t index = 0;
+
+        (void)SenseHAT_MotionProcess(&(sampler->motionDetector), sample->timestamp, &(sample->accelerometerRaw),
+                                     events, kSenseHAT_MaxMotionEvents, &count);
+
+        // Queue the events, dropping the oldest if nobody's keeping up
+        for (index = 0; index < count; index++)
+        {
+            if (sampler->motionEventCount == kSenseHAT_MotionQueueLength)
+            {
+                sampler->motionEventIndex = (sampler->motionEventIndex + 1) % kSenseHAT_MotionQueueLength;
+                sampler->motionEventCount--;
+            }
+            sampler->motionEvents[(sampler->motionEventIndex + sampler->motionEventCount) % kSenseHAT_MotionQueueLength] =
+                events[index];
+            sampler->motionEventCount++;
+        }
+        if ((count > 0) && (sampler->motionFd >= 0))
+        {
+            (void)eventfd_write(sampler->motionFd, 1);
+        }
+    }
+    return (uint32_t)count;
+}
+
+// =================================================================================================
+//  SenseHAT_MotionAdd
+// =================================================================================================
+void SenseHAT_MotionAdd (tSenseHAT_MotionEvent* events,
+                         int32_t capacity,
+                         int32_t* count,
+                         bool* overflow,
+                         double timestamp,
+                         tSenseHAT_MotionType type,
+                         bool active,
+                         double magnitude,
+                         const tSenseHAT_RawData* acceleration)
+{
+    // Is there room?
+    if (*count < capacity)
+    {
+        tSenseHAT_MotionEvent* event = &(events[*count]);
+
+        event->timestamp = timestamp;
+        event->type = type;
+        event->active = active;
+        event->magnitude = magnitude;
+        event->acceleration = *acceleration;
+        (*count)++;
+    }
+    else    // Out of room
+    {
+        *overflow = true;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_MotionLength
+// =================================================================================================
+double SenseHAT_MotionLength (double x,
+                              double y,
+                              double z)
+{
+    return sqrt((x * x) + (y * y) + (z * z));
+}
+
+// =================================================================================================
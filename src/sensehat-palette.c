@@ -0,0 +1,291 @@
+// ==================================================================================================
+//
+//  sensehat-palette.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the palette-indexed frames of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-palette.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the palette-indexed frames of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Number of pixels in a frame
+#define kPalettePixels  64
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_PaletteIndex
+static uint32_t SenseHAT_PaletteIndex (const uint8_t* indices,
+                                       tSenseHAT_PaletteIndexSize indexSize,
+                                       uint32_t pixel);
+
+// =================================================================================================
+//  SenseHAT_PaletteInitialize
+// =================================================================================================
+int32_t SenseHAT_PaletteInitialize (tSenseHAT_Palette* palette,
+                                    const tSenseHAT_LEDPixel* colors,
+                                    uint32_t colorCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((palette != NULL) &&
+        (colors != NULL) &&
+        (colorCount > 0) &&
+        (colorCount <= kSenseHAT_PaletteColorsMax))
+    {
+        tSenseHAT_LEDPixelArray chunk;
+        uint32_t start = 0;
+
+        // Convert the colors to RGB565 a frame's worth at a time; colors past the last are off
+        memset(palette, 0, sizeof(tSenseHAT_Palette));
+        memcpy(palette->colors, colors, colorCount * sizeof(tSenseHAT_LEDPixel));
+        for (start = 0; (start < colorCount) && (result == 0); start += kPalettePixels)
+        {
+            memcpy(chunk, palette->colors + start, sizeof(tSenseHAT_LEDPixelArray));
+            result = SenseHAT_ColorConvertFrames(NULL, (const tSenseHAT_LEDPixelArray*)&chunk, 1, palette->device + start);
+        }
+
+        if (result == 0)
+        {
+            palette->colorCount = colorCount;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_PaletteEncodeFrame
+// =================================================================================================
+int32_t SenseHAT_PaletteEncodeFrame (const tSenseHAT_Palette* palette,
+                                     const tSenseHAT_LEDPixelArray pixels,
+                                     tSenseHAT_PaletteIndexSize indexSize,
+                                     uint8_t* indices)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((palette != NULL) &&
+        (pixels != NULL) &&
+        ((indexSize == eSenseHAT_PaletteIndex4Bit) || (indexSize == eSenseHAT_PaletteIndex8Bit)) &&
+        (indices != NULL))
+    {
+        uint32_t colorLimit = (indexSize == eSenseHAT_PaletteIndex4Bit) ? 16 : kSenseHAT_PaletteColorsMax;
+        uint32_t pixel = 0;
+        uint32_t color = 0;
+
+        if (colorLimit > palette->colorCount)
+        {
+            colorLimit = palette->colorCount;
+        }
+        memset(indices, 0, (indexSize == eSenseHAT_PaletteIndex4Bit) ? (kPalettePixels / 2) : kPalettePixels);
+
+        for (pixel = 0; (pixel < kPalettePixels) && (result == 0); pixel++)
+        {
+            // Find the first palette entry with this color
+            for (color = 0; color < colorLimit; color++)
+            {
+                if ((palette->colors[color].red == pixels[pixel].red) &&
+                    (palette->colors[color].green == pixels[pixel].green) &&
+                    (palette->colors[color].blue == pixels[pixel].blue))
+                {
+                    break;
+                }
+            }
+
+            if (color < colorLimit)
+            {
+                if (indexSize == eSenseHAT_PaletteIndex4Bit)
+                {
+                    indices[pixel / 2] |= (uint8_t)(color << ((pixel % 2) * 4));
+                }
+                else
+                {
+                    indices[pixel] = (uint8_t)color;
+                }
+            }
+            else    // Not in the palette
+            {
+                result = EINVAL;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_PaletteExpandFrame
+// =================================================================================================
+int32_t SenseHAT_PaletteExpandFrame (const tSenseHAT_Palette* palette,
+                                     const uint8_t* indices,
+                                     tSenseHAT_PaletteIndexSize indexSize,
+                                     tSenseHAT_LEDPixelArray pixels)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((palette != NULL) &&
+        (indices != NULL) &&
+        ((indexSize == eSenseHAT_PaletteIndex4Bit) || (indexSize == eSenseHAT_PaletteIndex8Bit)) &&
+        (pixels != NULL))
+    {
+        uint32_t pixel = 0;
+
+        // The colors past the last are zeroed, so they expand to off
+        for (pixel = 0; pixel < kPalettePixels; pixel++)
+        {
+            pixels[pixel] = palette->colors[SenseHAT_PaletteIndex(indices, indexSize, pixel)];
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_PaletteExpandRGB565
+// =================================================================================================
+int32_t SenseHAT_PaletteExpandRGB565 (const tSenseHAT_Palette* palette,
+                                      const uint8_t* indices,
+                                      tSenseHAT_PaletteIndexSize indexSize,
+                                      uint32_t frameCount,
+                                      uint16_t* output)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((palette != NULL) &&
+        (indices != NULL) &&
+        ((indexSize == eSenseHAT_PaletteIndex4Bit) || (indexSize == eSenseHAT_PaletteIndex8Bit)) &&
+        (output != NULL))
+    {
+        uint32_t pixelCount = frameCount * kPalettePixels;
+        uint32_t pixel = 0;
+
+        // 4-bit indices are unpacked a byte, and so two pixels, at a time
+        if (indexSize == eSenseHAT_PaletteIndex4Bit)
+        {
+            for (; (pixel + 2) <= pixelCount; pixel += 2)
+            {
+                uint8_t packed = indices[pixel / 2];
+
+                output[pixel] = palette->device[packed & 0x0F];
+                output[pixel + 1] = palette->device[packed >> 4];
+            }
+        }
+
+        // 8-bit indices, and whatever the 4-bit loop left
+        for (; pixel < pixelCount; pixel++)
+        {
+            output[pixel] = palette->device[SenseHAT_PaletteIndex(indices, indexSize, pixel)];
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_LEDShowPaletteFrame
+// =================================================================================================
+int32_t SenseHAT_LEDShowPaletteFrame (const tSenseHAT_Instance instance,
+                                      const tSenseHAT_Palette* palette,
+                                      const uint8_t* indices,
+                                      tSenseHAT_PaletteIndexSize indexSize)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        if (instancePrivate->framebuffer.pixels != NULL)
+        {
+            uint16_t device[kPalettePixels];
+
+            // Expand straight to the framebuffer format
+            result = SenseHAT_PaletteExpandRGB565(palette, indices, indexSize, 1, device);
+            if (result == 0)
+            {
+                result = SenseHAT_FramebufferWriteRGB565(instancePrivate, device);
+            }
+        }
+        else
+        {
+            tSenseHAT_LEDPixelArray pixels;
+
+            result = SenseHAT_PaletteExpandFrame(palette, indices, indexSize, pixels);
+            if (result == 0)
+            {
+                result = SenseHAT_LEDSetPixels(instance, pixels);
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_PaletteIndex
+// =================================================================================================
+uint32_t SenseHAT_PaletteIndex (const uint8_t* indices,
+                                tSenseHAT_PaletteIndexSize indexSize,
+                                uint32_t pixel)
+{
+    uint32_t index = 0;
+
+    if (indexSize == eSenseHAT_PaletteIndex4Bit)
+    {
+        index = (indices[pixel / 2] >> ((pixel % 2) * 4)) & 0x0F;
+    }
+    else
+    {
+        index = indices[pixel];
+    }
+    return index;
+}
+
+// =================================================================================================
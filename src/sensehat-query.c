@@ -0,0 +1,521 @@
+// ==================================================================================================
+//
+//  sensehat-query.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the telemetry range queries of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-query.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the telemetry range queries of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Maximum segment directory length
+#define kQueryPathSize  1024
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// A range of a segment to scan
+typedef struct
+{
+    uint64_t    offset;     // Offset of the first record or block in the segment
+    uint64_t    length;     // Length of the range
+}
+tSenseHAT_QuerySpan;
+
+// Query state
+typedef struct
+{
+    char                        directory[kQueryPathSize];  // Segment directory
+    tSenseHAT_QueryParameters   parameters;                 // What to match
+    uint32_t*                   segments;                   // Segment indices, in ascending order
+    uint32_t                    segmentCount;               // Number of segments
+    uint32_t                    nextSegment;                // Position of the next segment to open
+    void*                       mapping;                    // Current segment mapping (NULL if none)
+    size_t                      mappingLength;              // Length of the current mapping
+    bool                        compressed;                 // Whether the current segment is compressed
+    tSenseHAT_QuerySpan*        spans;                      // Ranges of the current segment to scan
+    uint32_t                    spanCount;                  // Number of spans
+    uint32_t                    nextSpan;                   // Position of the next span to scan
+    uint64_t                    position;                   // Offset of the next block in the current span
+    uint64_t                    spanEnd;                    // Offset of the end of the current span
+    const tSenseHAT_Record*     records;                    // Records being examined
+    uint32_t                    recordCount;                // Number of records being examined
+    uint32_t                    recordIndex;                // Position of the next record to examine
+    tSenseHAT_QueryStatistics   statistics;                 // Counters
+    tSenseHAT_Record            block[kSenseHAT_BlockRecordsMax];   // Decoded block
+}
+tSenseHAT_QueryPrivate;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_QueryOpenSegment
+static int32_t SenseHAT_QueryOpenSegment (tSenseHAT_QueryPrivate* queryPrivate,
+                                          uint32_t segmentIndex);
+
+// SenseHAT_QueryCloseSegment
+static void SenseHAT_QueryCloseSegment (tSenseHAT_QueryPrivate* queryPrivate);
+
+// SenseHAT_QueryNextBlock
+static int32_t SenseHAT_QueryNextBlock (tSenseHAT_QueryPrivate* queryPrivate);
+
+// SenseHAT_QueryExcludes
+static bool SenseHAT_QueryExcludes (const tSenseHAT_QueryParameters* parameters,
+                                    const tSenseHAT_IndexEntry* entry);
+
+// SenseHAT_QueryMatches
+static bool SenseHAT_QueryMatches (const tSenseHAT_QueryParameters* parameters,
+                                   const tSenseHAT_Record* record);
+
+// =================================================================================================
+//  SenseHAT_QueryOpen
+// =================================================================================================
+int32_t SenseHAT_QueryOpen (const char* directory,
+                            const tSenseHAT_QueryParameters* parameters,
+                            tSenseHAT_Query* query)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((directory != NULL) &&
+        (strlen(directory) < (kQueryPathSize - 32)) &&
+        (parameters != NULL) &&
+        (parameters->channels != 0) &&
+        (parameters->valueIndex < 3) &&
+        (query != NULL))
+    {
+        // Setup
+        *query = NULL;
+
+        // Allocate space
+        tSenseHAT_QueryPrivate* queryPrivate =
+            (tSenseHAT_QueryPrivate*)malloc(sizeof(tSenseHAT_QueryPrivate));
+        if (queryPrivate != NULL)
+        {
+            // Initialize memory
+            memset(queryPrivate, 0, sizeof(tSenseHAT_QueryPrivate));
+            (void)strcpy(queryPrivate->directory, directory);
+            queryPrivate->parameters = *parameters;
+
+            // Find the segments
+            result = SenseHAT_ListSegments(directory, &(queryPrivate->segments),
+                                           &(queryPrivate->segmentCount));
+            if (result == 0)
+            {
+                *query = (tSenseHAT_Query)queryPrivate;
+            }
+            else    // SenseHAT_ListSegments failed
+            {
+                free((void*)queryPrivate);
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryNext
+// =================================================================================================
+int32_t SenseHAT_QueryNext (tSenseHAT_Query query,
+                            tSenseHAT_Record* records,
+                            uint32_t capacity,
+                            uint32_t* recordCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((query != NULL) &&
+        (records != NULL) &&
+        (capacity > 0) &&
+        (recordCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_QueryPrivate* queryPrivate = (tSenseHAT_QueryPrivate*)query;
+        uint32_t count = 0;
+
+        while ((count < capacity) && (result == 0))
+        {
+            if (queryPrivate->recordIndex < queryPrivate->recordCount)
+            {
+                // Examine the next record
+                const tSenseHAT_Record* record = &(queryPrivate->records[queryPrivate->recordIndex]);
+
+                queryPrivate->recordIndex++;
+                queryPrivate->statistics.recordsRead++;
+                if (SenseHAT_QueryMatches(&(queryPrivate->parameters), record))
+                {
+                    records[count] = *record;
+                    count++;
+                }
+            }
+            else if (queryPrivate->mapping != NULL)
+            {
+                // Move on to the next block; ENODATA means the segment is done
+                result = SenseHAT_QueryNextBlock(queryPrivate);
+                if (result == ENODATA)
+                {
+                    SenseHAT_QueryCloseSegment(queryPrivate);
+                    result = 0;
+
+                    // Return what the segment matched before opening the next one
+                    if (count > 0)
+                    {
+                        break;
+                    }
+                }
+                else if (result != 0)
+                {
+                    // Give up on the rest of a corrupt segment
+                    SenseHAT_QueryCloseSegment(queryPrivate);
+                }
+            }
+            else if (queryPrivate->nextSegment < queryPrivate->segmentCount)
+            {
+                // Open the next segment
+                result = SenseHAT_QueryOpenSegment(queryPrivate,
+                                                   queryPrivate->segments[queryPrivate->nextSegment]);
+                queryPrivate->nextSegment++;
+            }
+            else    // No more segments
+            {
+                if (count == 0)
+                {
+                    result = ENODATA;
+                }
+                break;
+            }
+        }
+        *recordCount = count;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryGetStatistics
+// =================================================================================================
+int32_t SenseHAT_QueryGetStatistics (tSenseHAT_Query query,
+                                     tSenseHAT_QueryStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((query != NULL) &&
+        (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_QueryPrivate* queryPrivate = (tSenseHAT_QueryPrivate*)query;
+
+        *statistics = queryPrivate->statistics;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryClose
+// =================================================================================================
+int32_t SenseHAT_QueryClose (tSenseHAT_Query* query)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((query != NULL) &&
+        (*query != NULL))
+    {
+        // Get private data
+        tSenseHAT_QueryPrivate* queryPrivate = (tSenseHAT_QueryPrivate*)(*query);
+
+        // Clean up
+        SenseHAT_QueryCloseSegment(queryPrivate);
+        free((void*)(queryPrivate->segments));
+        free((void*)queryPrivate);
+        *query = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryOpenSegment
+// =================================================================================================
+int32_t SenseHAT_QueryOpenSegment (tSenseHAT_QueryPrivate* queryPrivate,
+                                   uint32_t segmentIndex)
+{
+    int32_t result = 0;
+    size_t dataOffset = 0;
+    tSenseHAT_IndexEntry* entries = NULL;
+    uint32_t entryCount = 0;
+
+    // Map the segment; pages are only read if a span touches them
+    result = SenseHAT_MapSegmentFile(queryPrivate->directory, segmentIndex, &(queryPrivate->mapping),
+                                     &(queryPrivate->mappingLength), &dataOffset, &(queryPrivate->compressed));
+    if (result == 0)
+    {
+        uint64_t indexed = dataOffset;
+        uint32_t index = 0;
+
+        (void)madvise(queryPrivate->mapping, queryPrivate->mappingLength, MADV_RANDOM);
+
+        // Use the index if it describes this segment; otherwise scan all of it
+        if (SenseHAT_ReadSegmentIndex(queryPrivate->directory, segmentIndex, &entries, &entryCount) == 0)
+        {
+            for (index = 0; index < entryCount; index++)
+            {
+                if ((entries[index].offset != indexed) ||
+                    (entries[index].length > (queryPrivate->mappingLength - indexed)))
+                {
+                    break;
+                }
+                indexed += entries[index].length;
+            }
+            if (index < entryCount)
+            {
+                indexed = dataOffset;
+                entryCount = 0;
+            }
+        }
+        if (entryCount == 0)
+        {
+            queryPrivate->statistics.segmentsUnindexed++;
+        }
+
+        // Collect the entries that may match, and whatever was written after the last one
+        queryPrivate->spans = (tSenseHAT_QuerySpan*)malloc((entryCount + 1) * sizeof(tSenseHAT_QuerySpan));
+        if (queryPrivate->spans != NULL)
+        {
+            for (index = 0; index < entryCount; index++)
+            {
+                if (SenseHAT_QueryExcludes(&(queryPrivate->parameters), &(entries[index])))
+                {
+                    queryPrivate->statistics.blocksSkipped++;
+                }
+                else
+                {
+                    queryPrivate->spans[queryPrivate->spanCount].offset = entries[index].offset;
+                    queryPrivate->spans[queryPrivate->spanCount].length = entries[index].length;
+                    queryPrivate->spanCount++;
+                }
+            }
+            if (indexed < queryPrivate->mappingLength)
+            {
+                queryPrivate->spans[queryPrivate->spanCount].offset = indexed;
+                queryPrivate->spans[queryPrivate->spanCount].length = queryPrivate->mappingLength - indexed;
+                queryPrivate->spanCount++;
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+        free((void*)entries);
+    }
+    if (result != 0)
+    {
+        SenseHAT_QueryCloseSegment(queryPrivate);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryCloseSegment
+// =================================================================================================
+void SenseHAT_QueryCloseSegment (tSenseHAT_QueryPrivate* queryPrivate)
+{
+    if (queryPrivate->mapping != NULL)
+    {
+        (void)munmap(queryPrivate->mapping, queryPrivate->mappingLength);
+        queryPrivate->mapping = NULL;
+        queryPrivate->mappingLength = 0;
+    }
+    free((void*)(queryPrivate->spans));
+    queryPrivate->spans = NULL;
+    queryPrivate->spanCount = 0;
+    queryPrivate->nextSpan = 0;
+    queryPrivate->position = 0;
+    queryPrivate->spanEnd = 0;
+    queryPrivate->records = NULL;
+    queryPrivate->recordCount = 0;
+    queryPrivate->recordIndex = 0;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryNextBlock
+// =================================================================================================
+int32_t SenseHAT_QueryNextBlock (tSenseHAT_QueryPrivate* queryPrivate)
+{
+    int32_t result = 0;
+    const uint8_t* mapping = (const uint8_t*)(queryPrivate->mapping);
+
+    // Move on to the next span if this one is done
+    if (queryPrivate->position >= queryPrivate->spanEnd)
+    {
+        if (queryPrivate->nextSpan < queryPrivate->spanCount)
+        {
+            queryPrivate->position = queryPrivate->spans[queryPrivate->nextSpan].offset;
+            queryPrivate->spanEnd = queryPrivate->position + queryPrivate->spans[queryPrivate->nextSpan].length;
+            queryPrivate->nextSpan++;
+            queryPrivate->statistics.blocksRead++;
+        }
+        else    // No more spans
+        {
+            result = ENODATA;
+        }
+    }
+
+    if (result == 0)
+    {
+        uint64_t length = queryPrivate->spanEnd - queryPrivate->position;
+
+        queryPrivate->recordIndex = 0;
+        if (queryPrivate->compressed)
+        {
+            tSenseHAT_BlockHeader header;
+
+            // A segment that's still being written may end with a partial block
+            memset(&header, 0, sizeof(tSenseHAT_BlockHeader));
+            if (length >= sizeof(tSenseHAT_BlockHeader))
+            {
+                memcpy(&header, mapping + queryPrivate->position, sizeof(tSenseHAT_BlockHeader));
+            }
+            if ((length < sizeof(tSenseHAT_BlockHeader)) ||
+                (header.length > (length - sizeof(tSenseHAT_BlockHeader))))
+            {
+                queryPrivate->recordCount = 0;
+                queryPrivate->position = queryPrivate->spanEnd;
+            }
+            else if (header.recordCount <= kSenseHAT_BlockRecordsMax)
+            {
+                tSenseHAT_Decoder decoder;
+                uint32_t count = 0;
+                int32_t status = 0;
+
+                // Decode the whole block
+                (void)SenseHAT_DecoderInitialize(&decoder, mapping + queryPrivate->position + sizeof(tSenseHAT_BlockHeader),
+                                                 header.length, header.recordCount);
+                while ((status = SenseHAT_DecoderNext(&decoder, &(queryPrivate->block[count]))) == 0)
+                {
+                    count++;
+                }
+                if (status == ENODATA)
+                {
+                    queryPrivate->records = queryPrivate->block;
+                    queryPrivate->recordCount = count;
+                    queryPrivate->position += sizeof(tSenseHAT_BlockHeader) + header.length;
+                }
+                else    // Corrupt block
+                {
+                    result = status;
+                }
+            }
+            else    // Corrupt block
+            {
+                result = EPROTO;
+            }
+        }
+        else
+        {
+            // Records are read in place; drop a partial record at the end
+            queryPrivate->records = (const tSenseHAT_Record*)(mapping + queryPrivate->position);
+            queryPrivate->recordCount = (uint32_t)(length / sizeof(tSenseHAT_Record));
+            queryPrivate->position = queryPrivate->spanEnd;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryExcludes
+// =================================================================================================
+bool SenseHAT_QueryExcludes (const tSenseHAT_QueryParameters* parameters,
+                             const tSenseHAT_IndexEntry* entry)
+{
+    bool excludes = true;
+    uint32_t channels = entry->channels & parameters->channels;
+
+    // The entry may match if its times overlap the query and one of its channels has values
+    // that overlap the query; NaN ranges never exclude
+    if ((channels != 0) &&
+        !(entry->maximumTime < parameters->startTime) &&
+        !(entry->minimumTime > parameters->endTime))
+    {
+        while ((channels != 0) && excludes)
+        {
+            int32_t channel = __builtin_ctz(channels);
+
+            if (channel < kSenseHAT_RecordChannelCount)
+            {
+                excludes = (entry->maximum[channel][parameters->valueIndex] < parameters->minimumValue) ||
+                           (entry->minimum[channel][parameters->valueIndex] > parameters->maximumValue);
+            }
+            channels &= channels - 1;
+        }
+    }
+    return excludes;
+}
+
+// =================================================================================================
+//  SenseHAT_QueryMatches
+// =================================================================================================
+bool SenseHAT_QueryMatches (const tSenseHAT_QueryParameters* parameters,
+                            const tSenseHAT_Record* record)
+{
+    double value = record->values[parameters->valueIndex];
+
+    return (((record->channel & parameters->channels) != 0) &&
+            (record->timestamp >= parameters->startTime) &&
+            (record->timestamp <= parameters->endTime) &&
+            (value >= parameters->minimumValue) &&
+            (value <= parameters->maximumValue));
+}
+
+// =================================================================================================
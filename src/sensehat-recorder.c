@@ -0,0 +1,1546 @@
+// ==================================================================================================
+//
+//  sensehat-recorder.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the telemetry recorder and reader of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-recorder.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the telemetry recorder and reader of
+//! the Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Segment file name format and its parts
+static const char* kSegmentNameFormat   = "%s/telemetry-%08u.shl";
+static const char* kIndexNameFormat     = "%s/telemetry-%08u.shi";
+static const char* kSegmentNamePrefix   = "telemetry-";
+static const char* kSegmentNameSuffix   = ".shl";
+
+// Segment file magic numbers
+static const char kSegmentMagic[4]              = { 'S', 'H', 'T', 'L' };
+static const char kCompressedSegmentMagic[4]    = { 'S', 'H', 'T', 'Z' };
+
+// Segment index file magic number
+static const char kIndexMagic[4]                = { 'S', 'H', 'T', 'I' };
+
+// Maximum segment path length
+#define kSegmentPathSize        1024
+
+// Number of records buffered in memory by a recorder
+#define kRecorderBufferSize     8192
+
+// The writer thread is woken once this many records are buffered...
+#define kRecorderWakeThreshold  512
+
+// ...or after this many seconds, whichever comes first
+static const time_t kRecorderWakeInterval = 1;
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Segment (and segment index) file header
+typedef struct
+{
+    char        magic[4];       // kSegmentMagic, kCompressedSegmentMagic or kIndexMagic
+    uint16_t    version;        // kSenseHAT_RecordVersion
+    uint16_t    recordSize;     // sizeof(tSenseHAT_Record), or sizeof(tSenseHAT_IndexEntry)
+    uint32_t    headerSize;     // sizeof(tSenseHAT_SegmentHeader)
+    uint32_t    reserved;       // Always 0
+    double      created;        // Time the segment was created
+}
+tSenseHAT_SegmentHeader;
+
+// Recorder state
+typedef struct
+{
+    pthread_t           thread;                         // Writer thread
+    pthread_mutex_t     mutex;                          // Lock protecting everything below
+    pthread_cond_t      wake;                           // Signalled to wake the writer thread
+    pthread_cond_t      drained;                        // Signalled when the writer empties the buffer
+    bool                stopRequested;                  // Whether the writer thread should exit
+    bool                flushRequested;                 // Whether a caller is waiting for the buffer to drain
+    bool                writing;                        // Whether the writer thread is writing a batch
+    bool                compressed;                     // Whether new segments are compressed
+    bool                segmentCompressed;              // Whether the current segment is compressed
+    char                directory[kSegmentPathSize];    // Segment directory
+    uint32_t            attached;                       // Number of instances recording to this recorder
+    uint32_t            recordsPerSegment;              // Records per segment
+    uint32_t            segmentIndex;                   // Index of the current segment
+    uint32_t            segmentRecords;                 // Records written to the current segment
+    int32_t             fd;                             // Current segment file descriptor (-1 if none)
+    int32_t             indexFd;                        // Current segment index file descriptor (-1 if none)
+    uint64_t            segmentBytes;                   // Length of the current segment
+    tSenseHAT_IndexEntry indexEntry;                    // Index entry being built for the current segment
+    tSenseHAT_Record    buffer[kRecorderBufferSize];    // Buffered records
+    uint32_t            bufferIndex;                    // Index of the oldest buffered record
+    uint32_t            bufferCount;                    // Number of buffered records
+    tSenseHAT_RecorderStatistics statistics;            // Counters
+    uint8_t             block[sizeof(tSenseHAT_BlockHeader) + 
+                              (kSenseHAT_BlockRecordsMax * kSenseHAT_EncodedRecordSizeMax)];
+                                                        // Compressed block being written
+}
+tSenseHAT_RecorderPrivate;
+
+// Reader state
+typedef struct
+{
+    char        directory[kSegmentPathSize];    // Segment directory
+    uint32_t*   segments;                       // Segment indices, in ascending order
+    uint32_t    segmentCount;                   // Number of segments
+    uint32_t    nextSegment;                    // Position of the next segment to map
+    void*       mapping;                        // Current mapping (NULL if none)
+    size_t      mappingLength;                  // Length of the current mapping
+}
+tSenseHAT_ReaderPrivate;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_RecorderThread
+static void* SenseHAT_RecorderThread (void* argument);
+
+// SenseHAT_RecorderWriteBatch
+static int32_t SenseHAT_RecorderWriteBatch (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                            const tSenseHAT_Record* records,
+                                            uint32_t count,
+                                            bool compressed,
+                                            uint64_t* bytesWritten);
+
+// SenseHAT_RecorderWriteBlocks
+static int32_t SenseHAT_RecorderWriteBlocks (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                             const tSenseHAT_Record* records,
+                                             uint32_t count,
+                                             uint64_t* bytesWritten);
+
+// SenseHAT_RecorderWrite
+static int32_t SenseHAT_RecorderWrite (int32_t fd,
+                                       const void* bytes,
+                                       size_t length);
+
+// SenseHAT_RecorderOpenSegment
+static int32_t SenseHAT_RecorderOpenSegment (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                             bool compressed);
+
+// SenseHAT_RecorderCloseSegment
+static void SenseHAT_RecorderCloseSegment (tSenseHAT_RecorderPrivate* recorderPrivate);
+
+// SenseHAT_RecorderIndexRecords
+static void SenseHAT_RecorderIndexRecords (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                           const tSenseHAT_Record* records,
+                                           uint32_t count,
+                                           uint64_t length);
+
+// SenseHAT_RecorderWriteIndexEntry
+static void SenseHAT_RecorderWriteIndexEntry (tSenseHAT_RecorderPrivate* recorderPrivate);
+
+// SenseHAT_RecorderPush
+static bool SenseHAT_RecorderPush (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                   const tSenseHAT_Record* record);
+
+// SenseHAT_DecodeSegment
+static int32_t SenseHAT_DecodeSegment (const uint8_t* blocks,
+                                       size_t length,
+                                       void** mapping,
+                                       size_t* mappingLength,
+                                       const tSenseHAT_Record** records,
+                                       uint64_t* recordCount);
+
+// SenseHAT_CompareSegments
+static int SenseHAT_CompareSegments (const void* first,
+                                     const void* second);
+
+// =================================================================================================
+//  SenseHAT_RecorderOpen
+// =================================================================================================
+int32_t SenseHAT_RecorderOpen (const char* directory,
+                               uint32_t recordsPerSegment,
+                               tSenseHAT_Recorder* recorder)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((directory != NULL) &&
+        (strlen(directory) < (kSegmentPathSize - 32)) &&
+        (recordsPerSegment > 0) &&
+        (recorder != NULL))
+    {
+        // Setup
+        *recorder = NULL;
+
+        // Allocate space
+        tSenseHAT_RecorderPrivate* recorderPrivate =
+            (tSenseHAT_RecorderPrivate*)malloc(sizeof(tSenseHAT_RecorderPrivate));
+        if (recorderPrivate != NULL)
+        {
+            uint32_t* segments = NULL;
+            uint32_t segmentCount = 0;
+
+            // Initialize memory
+            memset(recorderPrivate, 0, sizeof(tSenseHAT_RecorderPrivate));
+            (void)strcpy(recorderPrivate->directory, directory);
+            recorderPrivate->recordsPerSegment = recordsPerSegment;
+            recorderPrivate->fd = -1;
+            recorderPrivate->indexFd = -1;
+
+            // Continue after any existing segments
+            result = SenseHAT_ListSegments(directory, &segments, &segmentCount);
+            if (result == 0)
+            {
+                if (segmentCount > 0)
+                {
+                    recorderPrivate->segmentIndex = segments[segmentCount - 1] + 1;
+                }
+                free((void*)segments);
+
+                // Start the writer thread
+                (void)pthread_mutex_init(&(recorderPrivate->mutex), NULL);
+                (void)pthread_cond_init(&(recorderPrivate->wake), NULL);
+                (void)pthread_cond_init(&(recorderPrivate->drained), NULL);
+                result = pthread_create(&(recorderPrivate->thread), NULL, 
+                                        SenseHAT_RecorderThread, recorderPrivate);
+                if (result == 0)
+                {
+                    *recorder = (tSenseHAT_Recorder)recorderPrivate;
+                }
+                else    // pthread_create failed
+                {
+                    (void)pthread_cond_destroy(&(recorderPrivate->drained));
+                    (void)pthread_cond_destroy(&(recorderPrivate->wake));
+                    (void)pthread_mutex_destroy(&(recorderPrivate->mutex));
+                }
+            }
+
+            // Clean up on failure
+            if (result != 0)
+            {
+                free((void*)recorderPrivate);
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderClose
+// =================================================================================================
+int32_t SenseHAT_RecorderClose (tSenseHAT_Recorder* recorder)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recorder != NULL) &&
+        (*recorder != NULL))
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)(*recorder);
+
+        // Ask the writer thread to write what's left and exit, unless an instance still records
+        // to the recorder
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        if (recorderPrivate->attached == 0)
+        {
+            recorderPrivate->stopRequested = true;
+            (void)pthread_cond_signal(&(recorderPrivate->wake));
+        }
+        else    // Still attached
+        {
+            result = EBUSY;
+        }
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+
+        if (result == 0)
+        {
+            result = pthread_join(recorderPrivate->thread, NULL);
+
+            // Clean up
+            SenseHAT_RecorderCloseSegment(recorderPrivate);
+            (void)pthread_cond_destroy(&(recorderPrivate->drained));
+            (void)pthread_cond_destroy(&(recorderPrivate->wake));
+            (void)pthread_mutex_destroy(&(recorderPrivate->mutex));
+            free((void*)recorderPrivate);
+            *recorder = NULL;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderSetCompression
+// =================================================================================================
+int32_t SenseHAT_RecorderSetCompression (tSenseHAT_Recorder recorder,
+                                         bool compressed)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (recorder != NULL)
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        recorderPrivate->compressed = compressed;
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderAppend
+// =================================================================================================
+int32_t SenseHAT_RecorderAppend (tSenseHAT_Recorder recorder,
+                                 const tSenseHAT_Record* record)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recorder != NULL) &&
+        (record != NULL) &&
+        (record->channel != 0) &&
+        ((record->channel & (record->channel - 1)) == 0) &&
+        (record->channel <= eSenseHAT_ChannelJoystick))
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        if (!SenseHAT_RecorderPush(recorderPrivate, record))
+        {
+            result = ENOBUFS;
+        }
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderAppendSample
+// =================================================================================================
+int32_t SenseHAT_RecorderAppendSample (tSenseHAT_Recorder recorder,
+                                       const tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recorder != NULL) &&
+        (sample != NULL))
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+        tSenseHAT_Record record;
+        uint32_t channel = 0;
+
+        // Setup
+        memset(&record, 0, sizeof(tSenseHAT_Record));
+        record.timestamp = sample->timestamp;
+
+        // One record per valid channel
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        for (channel = eSenseHAT_ChannelHumidity; channel <= eSenseHAT_ChannelOrientation; channel <<= 1)
+        {
+            if ((sample->channels & channel) != 0)
+            {
+                const tSenseHAT_RawData* rawData = NULL;
+
+                record.channel = channel;
+                record.values[0] = 0.0;
+                record.values[1] = 0.0;
+                record.values[2] = 0.0;
+                switch (channel)
+                {
+                    case eSenseHAT_ChannelHumidity:
+                        record.values[0] = sample->humidity;
+                        break;
+                    case eSenseHAT_ChannelTemperature:
+                        record.values[0] = sample->temperature;
+                        break;
+                    case eSenseHAT_ChannelPressure:
+                        record.values[0] = sample->pressure;
+                        break;
+                    case eSenseHAT_ChannelCompass:
+                        record.values[0] = sample->compass;
+                        break;
+                    case eSenseHAT_ChannelAccelerometerRaw:
+                        rawData = &(sample->accelerometerRaw);
+                        break;
+                    case eSenseHAT_ChannelGyroscopeRaw:
+                        rawData = &(sample->gyroscopeRaw);
+                        break;
+                    case eSenseHAT_ChannelCompassRaw:
+                        rawData = &(sample->compassRaw);
+                        break;
+                    case eSenseHAT_ChannelOrientation:
+                        record.values[0] = sample->orientation.pitch;
+                        record.values[1] = sample->orientation.roll;
+                        record.values[2] = sample->orientation.yaw;
+                        break;
+                    default:
+                        break;
+                }
+                if (rawData != NULL)
+                {
+                    record.values[0] = rawData->x;
+                    record.values[1] = rawData->y;
+                    record.values[2] = rawData->z;
+                }
+                if (!SenseHAT_RecorderPush(recorderPrivate, &record))
+                {
+                    result = ENOBUFS;
+                }
+            }
+        }
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderAppendEvent
+// =================================================================================================
+int32_t SenseHAT_RecorderAppendEvent (tSenseHAT_Recorder recorder,
+                                      const tSenseHAT_JoystickEvent* event)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recorder != NULL) &&
+        (event != NULL))
+    {
+        tSenseHAT_Record record;
+
+        memset(&record, 0, sizeof(tSenseHAT_Record));
+        record.timestamp = event->timestamp;
+        record.channel = eSenseHAT_ChannelJoystick;
+        record.values[0] = (double)(event->direction);
+        record.values[1] = (double)(event->action);
+        result = SenseHAT_RecorderAppend(recorder, &record);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderFlush
+// =================================================================================================
+int32_t SenseHAT_RecorderFlush (tSenseHAT_Recorder recorder)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (recorder != NULL)
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+
+        // Wake the writer thread and wait for it to empty the buffer
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        recorderPrivate->flushRequested = true;
+        (void)pthread_cond_signal(&(recorderPrivate->wake));
+        while (recorderPrivate->flushRequested)
+        {
+            (void)pthread_cond_wait(&(recorderPrivate->drained), &(recorderPrivate->mutex));
+        }
+        result = recorderPrivate->statistics.lastError;
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderGetStatistics
+// =================================================================================================
+int32_t SenseHAT_RecorderGetStatistics (tSenseHAT_Recorder recorder,
+                                        tSenseHAT_RecorderStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((recorder != NULL) &&
+        (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+
+        (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+        *statistics = recorderPrivate->statistics;
+        (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SetRecorder
+// =================================================================================================
+int32_t SenseHAT_SetRecorder (const tSenseHAT_Instance instance,
+                              tSenseHAT_Recorder recorder)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Sensor readings are recorded as they pass through the cache; count the instances each
+        // recorder is attached to, so it can't be closed under them
+        (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+        if (instancePrivate->cache.recorder != recorder)
+        {
+            tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)(instancePrivate->cache.recorder);
+            if (recorderPrivate != NULL)
+            {
+                (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+                recorderPrivate->attached--;
+                (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+            }
+            recorderPrivate = (tSenseHAT_RecorderPrivate*)recorder;
+            if (recorderPrivate != NULL)
+            {
+                (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+                recorderPrivate->attached++;
+                (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+            }
+            instancePrivate->cache.recorder = recorder;
+        }
+        (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReaderOpen
+// =================================================================================================
+int32_t SenseHAT_ReaderOpen (const char* directory,
+                             tSenseHAT_Reader* reader)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((directory != NULL) &&
+        (strlen(directory) < (kSegmentPathSize - 32)) &&
+        (reader != NULL))
+    {
+        // Setup
+        *reader = NULL;
+
+        // Allocate space
+        tSenseHAT_ReaderPrivate* readerPrivate =
+            (tSenseHAT_ReaderPrivate*)malloc(sizeof(tSenseHAT_ReaderPrivate));
+        if (readerPrivate != NULL)
+        {
+            // Initialize memory
+            memset(readerPrivate, 0, sizeof(tSenseHAT_ReaderPrivate));
+            (void)strcpy(readerPrivate->directory, directory);
+
+            // Find the segments
+            result = SenseHAT_ListSegments(directory, &(readerPrivate->segments), 
+                                           &(readerPrivate->segmentCount));
+            if (result == 0)
+            {
+                *reader = (tSenseHAT_Reader)readerPrivate;
+            }
+            else    // SenseHAT_ListSegments failed
+            {
+                free((void*)readerPrivate);
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReaderNextSegment
+// =================================================================================================
+int32_t SenseHAT_ReaderNextSegment (tSenseHAT_Reader reader,
+                                    const tSenseHAT_Record** records,
+                                    uint64_t* recordCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((reader != NULL) &&
+        (records != NULL) &&
+        (recordCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_ReaderPrivate* readerPrivate = (tSenseHAT_ReaderPrivate*)reader;
+
+        // Setup
+        *records = NULL;
+        *recordCount = 0;
+
+        // Unmap the previous segment
+        if (readerPrivate->mapping != NULL)
+        {
+            (void)munmap(readerPrivate->mapping, readerPrivate->mappingLength);
+            readerPrivate->mapping = NULL;
+            readerPrivate->mappingLength = 0;
+        }
+
+        // Any segments left?
+        if (readerPrivate->nextSegment < readerPrivate->segmentCount)
+        {
+            result = SenseHAT_MapSegment(readerPrivate->directory,
+                                         readerPrivate->segments[readerPrivate->nextSegment],
+                                         &(readerPrivate->mapping),
+                                         &(readerPrivate->mappingLength),
+                                         records,
+                                         recordCount);
+            readerPrivate->nextSegment++;
+        }
+        else    // No more segments
+        {
+            result = ENODATA;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReaderClose
+// =================================================================================================
+int32_t SenseHAT_ReaderClose (tSenseHAT_Reader* reader)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((reader != NULL) &&
+        (*reader != NULL))
+    {
+        // Get private data
+        tSenseHAT_ReaderPrivate* readerPrivate = (tSenseHAT_ReaderPrivate*)(*reader);
+
+        // Clean up
+        if (readerPrivate->mapping != NULL)
+        {
+            (void)munmap(readerPrivate->mapping, readerPrivate->mappingLength);
+        }
+        free((void*)(readerPrivate->segments));
+        free((void*)readerPrivate);
+        *reader = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MapSegment
+// =================================================================================================
+int32_t SenseHAT_MapSegment (const char* directory,
+                             uint32_t segmentIndex,
+                             void** mapping,
+                             size_t* mappingLength,
+                             const tSenseHAT_Record** records,
+                             uint64_t* recordCount)
+{
+    int32_t result = 0;
+    size_t dataOffset = 0;
+    bool compressed = false;
+
+    // Setup
+    *records = NULL;
+    *recordCount = 0;
+
+    // Map the segment
+    result = SenseHAT_MapSegmentFile(directory, segmentIndex, mapping, mappingLength, &dataOffset, &compressed);
+    if (result == 0)
+    {
+        void* address = *mapping;
+        size_t length = *mappingLength;
+
+        // Tell the kernel we'll read it front to back
+        (void)madvise(address, length, MADV_SEQUENTIAL);
+
+        if (compressed)
+        {
+            // Decode it into memory of its own, and drop the file mapping
+            result = SenseHAT_DecodeSegment((const uint8_t*)address + dataOffset, length - dataOffset,
+                                            mapping, mappingLength, records, recordCount);
+            (void)munmap(address, length);
+        }
+        else
+        {
+            // A segment that's still being written may end with a partial record
+            *records = (const tSenseHAT_Record*)((const uint8_t*)address + dataOffset);
+            *recordCount = (length - dataOffset) / sizeof(tSenseHAT_Record);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_MapSegmentFile
+// =================================================================================================
+int32_t SenseHAT_MapSegmentFile (const char* directory,
+                                 uint32_t segmentIndex,
+                                 void** mapping,
+                                 size_t* mappingLength,
+                                 size_t* dataOffset,
+                                 bool* compressed)
+{
+    int32_t result = 0;
+    char path[kSegmentPathSize];
+
+    // Setup
+    *mapping = NULL;
+    *mappingLength = 0;
+    *dataOffset = 0;
+    *compressed = false;
+
+    // Open the segment
+    if (snprintf(path, sizeof(path), kSegmentNameFormat, directory, segmentIndex) < (int)sizeof(path))
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            struct stat status;
+
+            if ((fstat(fd, &status) == 0) &&
+                ((size_t)status.st_size >= sizeof(tSenseHAT_SegmentHeader)))
+            {
+                // Map it
+                void* address = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (address != MAP_FAILED)
+                {
+                    const tSenseHAT_SegmentHeader* header = (const tSenseHAT_SegmentHeader*)address;
+
+                    *mapping = address;
+                    *mappingLength = (size_t)status.st_size;
+
+                    // Check the header
+                    *compressed = (memcmp(header->magic, kCompressedSegmentMagic, sizeof(kCompressedSegmentMagic)) == 0);
+                    if ((*compressed || (memcmp(header->magic, kSegmentMagic, sizeof(kSegmentMagic)) == 0)) &&
+                        (header->version == kSenseHAT_RecordVersion) &&
+                        (header->recordSize == sizeof(tSenseHAT_Record)) &&
+                        (header->headerSize == sizeof(tSenseHAT_SegmentHeader)))
+                    {
+                        *dataOffset = header->headerSize;
+                    }
+                    else    // Unsupported segment
+                    {
+                        result = EPROTO;
+                    }
+                }
+                else    // mmap failed
+                {
+                    result = errno;
+                }
+            }
+            else    // Truncated segment
+            {
+                result = EPROTO;
+            }
+            (void)close(fd);
+        }
+        else    // open failed
+        {
+            result = errno;
+        }
+    }
+    else    // Path too long
+    {
+        result = ENAMETOOLONG;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadSegmentIndex
+// =================================================================================================
+int32_t SenseHAT_ReadSegmentIndex (const char* directory,
+                                   uint32_t segmentIndex,
+                                   tSenseHAT_IndexEntry** entries,
+                                   uint32_t* entryCount)
+{
+    int32_t result = 0;
+    char path[kSegmentPathSize];
+
+    // Setup
+    *entries = NULL;
+    *entryCount = 0;
+
+    // Open the index
+    if (snprintf(path, sizeof(path), kIndexNameFormat, directory, segmentIndex) < (int)sizeof(path))
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            tSenseHAT_SegmentHeader header;
+            struct stat status;
+
+            // Check the header
+            if ((fstat(fd, &status) == 0) &&
+                (read(fd, &header, sizeof(tSenseHAT_SegmentHeader)) == (ssize_t)sizeof(tSenseHAT_SegmentHeader)) &&
+                (memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) == 0) &&
+                (header.version == kSenseHAT_RecordVersion) &&
+                (header.recordSize == sizeof(tSenseHAT_IndexEntry)) &&
+                (header.headerSize == sizeof(tSenseHAT_SegmentHeader)))
+            {
+                // An index that's still being written may end with a partial entry
+                uint32_t count = (uint32_t)(((size_t)status.st_size - sizeof(tSenseHAT_SegmentHeader)) / sizeof(tSenseHAT_IndexEntry));
+                if (count > 0)
+                {
+                    *entries = (tSenseHAT_IndexEntry*)malloc(count * sizeof(tSenseHAT_IndexEntry));
+                    if (*entries != NULL)
+                    {
+                        size_t length = count * sizeof(tSenseHAT_IndexEntry);
+                        if (pread(fd, *entries, length, sizeof(tSenseHAT_SegmentHeader)) == (ssize_t)length)
+                        {
+                            *entryCount = count;
+                        }
+                        else    // pread failed
+                        {
+                            result = EIO;
+                            free((void*)(*entries));
+                            *entries = NULL;
+                        }
+                    }
+                    else    // malloc failed
+                    {
+                        result = ENOMEM;
+                    }
+                }
+            }
+            else    // Unsupported index
+            {
+                result = EPROTO;
+            }
+            (void)close(fd);
+        }
+        else    // open failed
+        {
+            result = errno;
+        }
+    }
+    else    // Path too long
+    {
+        result = ENAMETOOLONG;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderThread
+// =================================================================================================
+void* SenseHAT_RecorderThread (void* argument)
+{
+    tSenseHAT_RecorderPrivate* recorderPrivate = (tSenseHAT_RecorderPrivate*)argument;
+    bool done = false;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+
+    while (!done)
+    {
+        // Sleep until there's enough to write, or a while has passed
+        if (!recorderPrivate->stopRequested &&
+            !recorderPrivate->flushRequested &&
+            (recorderPrivate->bufferCount < kRecorderWakeThreshold))
+        {
+            struct timespec deadline;
+
+            (void)clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += kRecorderWakeInterval;
+            (void)pthread_cond_timedwait(&(recorderPrivate->wake), &(recorderPrivate->mutex), &deadline);
+        }
+
+        // Write everything that's buffered; the buffer may wrap, so this can take two batches
+        while (recorderPrivate->bufferCount > 0)
+        {
+            uint32_t index = recorderPrivate->bufferIndex;
+            uint32_t count = recorderPrivate->bufferCount;
+            bool compressed = recorderPrivate->compressed;
+            uint64_t bytesWritten = 0;
+            int32_t status = 0;
+
+            if ((index + count) > kRecorderBufferSize)
+            {
+                count = kRecorderBufferSize - index;
+            }
+
+            // Don't hold the lock while writing, so appending never waits on the SD card; the
+            // records being written can't be overwritten since they still count as buffered
+            recorderPrivate->writing = true;
+            (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+            status = SenseHAT_RecorderWriteBatch(recorderPrivate, &(recorderPrivate->buffer[index]), count,
+                                                 compressed, &bytesWritten);
+            (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+            recorderPrivate->writing = false;
+            recorderPrivate->statistics.bytes += bytesWritten;
+
+            if (status == 0)
+            {
+                recorderPrivate->statistics.written += count;
+            }
+            else    // Write failed
+            {
+                recorderPrivate->statistics.dropped += count;
+                recorderPrivate->statistics.lastError = status;
+            }
+            recorderPrivate->bufferIndex = (index + count) % kRecorderBufferSize;
+            recorderPrivate->bufferCount -= count;
+        }
+        recorderPrivate->flushRequested = false;
+        (void)pthread_cond_broadcast(&(recorderPrivate->drained));
+
+        done = recorderPrivate->stopRequested;
+    }
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderWriteBatch
+// =================================================================================================
+int32_t SenseHAT_RecorderWriteBatch (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                     const tSenseHAT_Record* records,
+                                     uint32_t count,
+                                     bool compressed,
+                                     uint64_t* bytesWritten)
+{
+    int32_t result = 0;
+
+    while ((result == 0) && (count > 0))
+    {
+        // Start a new segment if needed
+        if ((recorderPrivate->fd < 0) ||
+            (recorderPrivate->segmentRecords >= recorderPrivate->recordsPerSegment) ||
+            (recorderPrivate->segmentCompressed != compressed))
+        {
+            SenseHAT_RecorderCloseSegment(recorderPrivate);
+            result = SenseHAT_RecorderOpenSegment(recorderPrivate, compressed);
+            if (result == 0)
+            {
+                *bytesWritten += sizeof(tSenseHAT_SegmentHeader);
+            }
+        }
+
+        // Check for success
+        if (result == 0)
+        {
+            uint32_t room = recorderPrivate->recordsPerSegment - recorderPrivate->segmentRecords;
+            uint32_t batch = (count < room) ? count : room;
+
+            // Write the batch
+            if (compressed)
+            {
+                result = SenseHAT_RecorderWriteBlocks(recorderPrivate, records, batch, bytesWritten);
+            }
+            else
+            {
+                result = SenseHAT_RecorderWrite(recorderPrivate->fd, records, (size_t)batch * sizeof(tSenseHAT_Record));
+                if (result == 0)
+                {
+                    uint32_t indexed = 0;
+
+                    *bytesWritten += (uint64_t)batch * sizeof(tSenseHAT_Record);
+
+                    // Index the records in runs, so queries can skip most of a large batch
+                    while (indexed < batch)
+                    {
+                        uint32_t run = ((batch - indexed) < kSenseHAT_IndexRecords) ? (batch - indexed) : kSenseHAT_IndexRecords;
+
+                        SenseHAT_RecorderIndexRecords(recorderPrivate, records + indexed, run,
+                                                      (uint64_t)run * sizeof(tSenseHAT_Record));
+                        indexed += run;
+                    }
+                }
+            }
+
+            // Check for success
+            if (result == 0)
+            {
+                recorderPrivate->segmentRecords += batch;
+                records += batch;
+                count -= batch;
+            }
+            else    // Don't append to a segment that may now end with a partial record
+            {
+                SenseHAT_RecorderCloseSegment(recorderPrivate);
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderWriteBlocks
+// =================================================================================================
+int32_t SenseHAT_RecorderWriteBlocks (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                      const tSenseHAT_Record* records,
+                                      uint32_t count,
+                                      uint64_t* bytesWritten)
+{
+    int32_t result = 0;
+
+    while ((result == 0) && (count > 0))
+    {
+        tSenseHAT_BlockHeader header;
+        tSenseHAT_Encoder encoder;
+        size_t length = 0;
+
+        // Encode up to a block's worth of records; each block starts a fresh history, so blocks 
+        // can be decoded on their own
+        (void)SenseHAT_EncoderInitialize(&encoder, 
+                                         recorderPrivate->block + sizeof(tSenseHAT_BlockHeader),
+                                         sizeof(recorderPrivate->block) - sizeof(tSenseHAT_BlockHeader));
+        while ((encoder.recordCount < count) &&
+               (encoder.recordCount < kSenseHAT_BlockRecordsMax) &&
+               (SenseHAT_EncoderAppend(&encoder, &(records[encoder.recordCount])) == 0))
+        {
+            // Keep going
+        }
+        (void)SenseHAT_EncoderGetLength(&encoder, &length, &(header.recordCount));
+        header.length = (uint32_t)length;
+
+        // Write the block
+        if (header.recordCount > 0)
+        {
+            memcpy(recorderPrivate->block, &header, sizeof(tSenseHAT_BlockHeader));
+            result = SenseHAT_RecorderWrite(recorderPrivate->fd, recorderPrivate->block,
+                                            sizeof(tSenseHAT_BlockHeader) + length);
+            if (result == 0)
+            {
+                *bytesWritten += sizeof(tSenseHAT_BlockHeader) + length;
+                SenseHAT_RecorderIndexRecords(recorderPrivate, records, header.recordCount,
+                                              sizeof(tSenseHAT_BlockHeader) + length);
+                records += header.recordCount;
+                count -= header.recordCount;
+            }
+        }
+        else    // Can't happen, since appended records are always valid
+        {
+            result = EINVAL;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderWrite
+// =================================================================================================
+int32_t SenseHAT_RecorderWrite (int32_t fd,
+                                const void* bytes,
+                                size_t length)
+{
+    int32_t result = 0;
+    const uint8_t* next = (const uint8_t*)bytes;
+
+    while ((result == 0) && (length > 0))
+    {
+        ssize_t bytesWritten = write(fd, next, length);
+        if (bytesWritten > 0)
+        {
+            next += bytesWritten;
+            length -= (size_t)bytesWritten;
+        }
+        else if ((bytesWritten < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        else    // write failed
+        {
+            result = (bytesWritten < 0) ? errno : EIO;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderOpenSegment
+// =================================================================================================
+int32_t SenseHAT_RecorderOpenSegment (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                     bool compressed)
+{
+    int32_t result = 0;
+    char path[kSegmentPathSize];
+    int fd = -1;
+
+    // Create the segment; never overwrite one, so skip over any name that's in the way
+    do
+    {
+        if (snprintf(path, sizeof(path), kSegmentNameFormat, recorderPrivate->directory, 
+                     recorderPrivate->segmentIndex) < (int)sizeof(path))
+        {
+            fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+            if ((fd < 0) && (errno == EEXIST))
+            {
+                recorderPrivate->segmentIndex++;
+            }
+        }
+        else    // Path too long; fail the same way open would
+        {
+            errno = ENAMETOOLONG;
+        }
+    }
+    while ((fd < 0) && (errno == EEXIST));
+
+    if (fd >= 0)
+    {
+        tSenseHAT_SegmentHeader header;
+
+        // Write the header
+        memset(&header, 0, sizeof(tSenseHAT_SegmentHeader));
+        memcpy(header.magic, (compressed ? kCompressedSegmentMagic : kSegmentMagic), sizeof(kSegmentMagic));
+        header.version = kSenseHAT_RecordVersion;
+        header.recordSize = sizeof(tSenseHAT_Record);
+        header.headerSize = sizeof(tSenseHAT_SegmentHeader);
+        header.created = SenseHAT_GetTimestamp();
+        if (write(fd, &header, sizeof(tSenseHAT_SegmentHeader)) == (ssize_t)sizeof(tSenseHAT_SegmentHeader))
+        {
+            recorderPrivate->fd = fd;
+            recorderPrivate->segmentCompressed = compressed;
+            recorderPrivate->segmentRecords = 0;
+            recorderPrivate->segmentBytes = sizeof(tSenseHAT_SegmentHeader);
+            recorderPrivate->indexEntry.recordCount = 0;
+
+            // Create the index; the segment is still usable without one, so failing here only
+            // makes queries scan it
+            if (snprintf(path, sizeof(path), kIndexNameFormat, recorderPrivate->directory, 
+                         recorderPrivate->segmentIndex) < (int)sizeof(path))
+            {
+                recorderPrivate->indexFd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+            }
+            if (recorderPrivate->indexFd >= 0)
+            {
+                memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+                header.recordSize = sizeof(tSenseHAT_IndexEntry);
+                if (write(recorderPrivate->indexFd, &header, sizeof(tSenseHAT_SegmentHeader)) != (ssize_t)sizeof(tSenseHAT_SegmentHeader))
+                {
+                    (void)close(recorderPrivate->indexFd);
+                    recorderPrivate->indexFd = -1;
+                    (void)unlink(path);
+                }
+            }
+            recorderPrivate->segmentIndex++;
+
+            (void)pthread_mutex_lock(&(recorderPrivate->mutex));
+            recorderPrivate->statistics.segments++;
+            (void)pthread_mutex_unlock(&(recorderPrivate->mutex));
+        }
+        else    // write failed
+        {
+            result = (errno != 0) ? errno : EIO;
+            (void)close(fd);
+            (void)unlink(path);
+        }
+    }
+    else    // open failed
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderCloseSegment
+// =================================================================================================
+void SenseHAT_RecorderCloseSegment (tSenseHAT_RecorderPrivate* recorderPrivate)
+{
+    if (recorderPrivate->fd >= 0)
+    {
+        // Only sync when a segment is complete, rather than after every batch
+        (void)fdatasync(recorderPrivate->fd);
+        (void)close(recorderPrivate->fd);
+        recorderPrivate->fd = -1;
+    }
+    if (recorderPrivate->indexFd >= 0)
+    {
+        // Index the rest of the segment
+        SenseHAT_RecorderWriteIndexEntry(recorderPrivate);
+        (void)close(recorderPrivate->indexFd);
+        recorderPrivate->indexFd = -1;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderIndexRecords
+// =================================================================================================
+void SenseHAT_RecorderIndexRecords (tSenseHAT_RecorderPrivate* recorderPrivate,
+                                    const tSenseHAT_Record* records,
+                                    uint32_t count,
+                                    uint64_t length)
+{
+    tSenseHAT_IndexEntry* entry = &(recorderPrivate->indexEntry);
+    uint32_t index = 0;
+
+    // Start a new entry if needed
+    if (entry->recordCount == 0)
+    {
+        memset(entry, 0, sizeof(tSenseHAT_IndexEntry));
+        entry->offset = recorderPrivate->segmentBytes;
+        entry->minimumTime = records[0].timestamp;
+        entry->maximumTime = records[0].timestamp;
+    }
+
+    // Widen the ranges; fmin and fmax ignore NaNs
+    for (index = 0; index < count; index++)
+    {
+        const tSenseHAT_Record* record = &(records[index]);
+        int32_t channel = __builtin_ctz(record->channel);
+        int32_t value = 0;
+
+        entry->minimumTime = fmin(entry->minimumTime, record->timestamp);
+        entry->maximumTime = fmax(entry->maximumTime, record->timestamp);
+        for (value = 0; value < 3; value++)
+        {
+            if ((entry->channels & record->channel) == 0)
+            {
+                entry->minimum[channel][value] = record->values[value];
+                entry->maximum[channel][value] = record->values[value];
+            }
+            else
+            {
+                entry->minimum[channel][value] = fmin(entry->minimum[channel][value], record->values[value]);
+                entry->maximum[channel][value] = fmax(entry->maximum[channel][value], record->values[value]);
+            }
+        }
+        entry->channels |= record->channel;
+    }
+    entry->recordCount += count;
+    entry->length += length;
+    recorderPrivate->segmentBytes += length;
+
+    // Write the entry once it covers enough records
+    if (entry->recordCount >= kSenseHAT_IndexRecords)
+    {
+        SenseHAT_RecorderWriteIndexEntry(recorderPrivate);
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderWriteIndexEntry
+// =================================================================================================
+void SenseHAT_RecorderWriteIndexEntry (tSenseHAT_RecorderPrivate* recorderPrivate)
+{
+    if ((recorderPrivate->indexFd >= 0) &&
+        (recorderPrivate->indexEntry.recordCount > 0))
+    {
+        // A failed write leaves at most a partial entry, which readers ignore; stop indexing
+        // this segment so later entries can't be misaligned
+        if (SenseHAT_RecorderWrite(recorderPrivate->indexFd, &(recorderPrivate->indexEntry),
+                                   sizeof(tSenseHAT_IndexEntry)) != 0)
+        {
+            (void)close(recorderPrivate->indexFd);
+            recorderPrivate->indexFd = -1;
+        }
+    }
+    recorderPrivate->indexEntry.recordCount = 0;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_RecorderPush
+// =================================================================================================
+bool SenseHAT_RecorderPush (tSenseHAT_RecorderPrivate* recorderPrivate,
+                            const tSenseHAT_Record* record)
+{
+    bool pushed = false;
+
+    // Drop the record rather than wait when the writer can't keep up
+    if (recorderPrivate->bufferCount < kRecorderBufferSize)
+    {
+        uint32_t index = (recorderPrivate->bufferIndex + recorderPrivate->bufferCount) % kRecorderBufferSize;
+
+        recorderPrivate->buffer[index] = *record;
+        recorderPrivate->buffer[index].reserved = 0;
+        recorderPrivate->bufferCount++;
+        pushed = true;
+
+        // Only wake the writer once there's a worthwhile batch
+        if (recorderPrivate->bufferCount == kRecorderWakeThreshold)
+        {
+            (void)pthread_cond_signal(&(recorderPrivate->wake));
+        }
+    }
+    else    // Buffer full
+    {
+        recorderPrivate->statistics.dropped++;
+    }
+    return pushed;
+}
+
+// =================================================================================================
+//  SenseHAT_ListSegments
+// =================================================================================================
+int32_t SenseHAT_ListSegments (const char* directory,
+                               uint32_t** segments,
+                               uint32_t* segmentCount)
+{
+    int32_t result = 0;
+    DIR* dir = NULL;
+
+    // Setup
+    *segments = NULL;
+    *segmentCount = 0;
+
+    dir = opendir(directory);
+    if (dir != NULL)
+    {
+        uint32_t capacity = 0;
+        struct dirent* entry = NULL;
+        size_t prefixLength = strlen(kSegmentNamePrefix);
+        size_t suffixLength = strlen(kSegmentNameSuffix);
+
+        while ((result == 0) && ((entry = readdir(dir)) != NULL))
+        {
+            size_t nameLength = strlen(entry->d_name);
+            char* end = NULL;
+            unsigned long index = 0;
+
+            // Is this a segment?
+            if ((nameLength > (prefixLength + suffixLength)) &&
+                (strncmp(entry->d_name, kSegmentNamePrefix, prefixLength) == 0) &&
+                (strcmp(entry->d_name + nameLength - suffixLength, kSegmentNameSuffix) == 0))
+            {
+                index = strtoul(entry->d_name + prefixLength, &end, 10);
+                if (end == (entry->d_name + nameLength - suffixLength))
+                {
+                    // Grow the list if needed
+                    if (*segmentCount == capacity)
+                    {
+                        uint32_t newCapacity = (capacity == 0) ? 64 : (capacity * 2);
+                        uint32_t* newSegments = (uint32_t*)realloc(*segments, newCapacity * sizeof(uint32_t));
+                        if (newSegments != NULL)
+                        {
+                            *segments = newSegments;
+                            capacity = newCapacity;
+                        }
+                        else    // realloc failed
+                        {
+                            result = ENOMEM;
+                        }
+                    }
+                    if (result == 0)
+                    {
+                        (*segments)[*segmentCount] = (uint32_t)index;
+                        (*segmentCount)++;
+                    }
+                }
+            }
+        }
+        (void)closedir(dir);
+
+        // Check for success
+        if (result == 0)
+        {
+            if (*segmentCount > 1)
+            {
+                qsort(*segments, *segmentCount, sizeof(uint32_t), SenseHAT_CompareSegments);
+            }
+        }
+        else    // Clean up
+        {
+            free((void*)(*segments));
+            *segments = NULL;
+            *segmentCount = 0;
+        }
+    }
+    else    // opendir failed
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_DecodeSegment
+// =================================================================================================
+int32_t SenseHAT_DecodeSegment (const uint8_t* blocks,
+                                size_t length,
+                                void** mapping,
+                                size_t* mappingLength,
+                                const tSenseHAT_Record** records,
+                                uint64_t* recordCount)
+{
+    int32_t result = 0;
+    tSenseHAT_BlockHeader header;
+    size_t offset = 0;
+    size_t end = 0;
+    uint64_t count = 0;
+
+    // Setup
+    *mapping = NULL;
+    *mappingLength = 0;
+
+    // Count the records; a segment that's still being written may end with a partial block
+    while ((result == 0) && ((offset + sizeof(tSenseHAT_BlockHeader)) <= length))
+    {
+        memcpy(&header, blocks + offset, sizeof(tSenseHAT_BlockHeader));
+        if (header.length > (length - offset - sizeof(tSenseHAT_BlockHeader)))
+        {
+            break;
+        }
+
+        // Every record takes at least 5 bits
+        if (((uint64_t)(header.recordCount) * 5) <= ((uint64_t)(header.length) * 8))
+        {
+            count += header.recordCount;
+            offset += sizeof(tSenseHAT_BlockHeader) + header.length;
+        }
+        else    // Corrupt block
+        {
+            result = EPROTO;
+        }
+    }
+    end = offset;
+
+    // Decode the blocks
+    if ((result == 0) && (count > 0))
+    {
+        size_t size = (size_t)count * sizeof(tSenseHAT_Record);
+        void* address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address != MAP_FAILED)
+        {
+            tSenseHAT_Record* decoded = (tSenseHAT_Record*)address;
+            uint64_t index = 0;
+
+            offset = 0;
+            while ((result == 0) && (offset < end))
+            {
+                tSenseHAT_Decoder decoder;
+                int32_t status = 0;
+
+                memcpy(&header, blocks + offset, sizeof(tSenseHAT_BlockHeader));
+                (void)SenseHAT_DecoderInitialize(&decoder, blocks + offset + sizeof(tSenseHAT_BlockHeader),
+                                                 header.length, header.recordCount);
+                while ((status = SenseHAT_DecoderNext(&decoder, &(decoded[index]))) == 0)
+                {
+                    index++;
+                }
+                if (status != ENODATA)
+                {
+                    result = status;
+                }
+                offset += sizeof(tSenseHAT_BlockHeader) + header.length;
+            }
+
+            // Check for success
+            if (result == 0)
+            {
+                *mapping = address;
+                *mappingLength = size;
+                *records = decoded;
+                *recordCount = count;
+            }
+            else    // Clean up
+            {
+                (void)munmap(address, size);
+            }
+        }
+        else    // mmap failed
+        {
+            result = errno;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_CompareSegments
+// =================================================================================================
+int SenseHAT_CompareSegments (const void* first,
+                              const void* second)
+{
+    uint32_t a = *(const uint32_t*)first;
+    uint32_t b = *(const uint32_t*)second;
+
+    return (a > b) - (a < b);
+}
+
+// =================================================================================================
@@ -0,0 +1,598 @@
+// ==================================================================================================
+//
+//  sensehat-replay.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for driving the Raspberry Pi Sense HAT C 
+//      library from a recorded telemetry log.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-replay.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for driving the Raspberry Pi Sense HAT C
+//! library from a recorded telemetry log.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Number of events added to the list at a time by SenseHAT_ReplayGetEvents
+#define kReplayEventBatchSize   16
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_ReplayPeek
+static const tSenseHAT_Record* SenseHAT_ReplayPeek (const tSenseHAT_Replay* replay,
+                                                    tSenseHAT_ReplayCursor* cursor);
+
+// SenseHAT_ReplayNextEvent
+static const tSenseHAT_Record* SenseHAT_ReplayNextEvent (tSenseHAT_Replay* replay);
+
+// SenseHAT_ReplayNow
+static double SenseHAT_ReplayNow (const tSenseHAT_Replay* replay);
+
+// SenseHAT_ReplayCopyRecord
+static void SenseHAT_ReplayCopyRecord (const tSenseHAT_Record* record,
+                                       tSenseHAT_Sample* sample);
+
+// SenseHAT_ReplayCopyEvent
+static void SenseHAT_ReplayCopyEvent (const tSenseHAT_Record* record,
+                                      tSenseHAT_JoystickEvent* event);
+
+// =================================================================================================
+//  SenseHAT_ReplayInitialize
+// =================================================================================================
+int32_t SenseHAT_ReplayInitialize (tSenseHAT_InstancePrivate* instancePrivate,
+                                   const char* directory,
+                                   double speed)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instancePrivate != NULL) &&
+        (directory != NULL) &&
+        (speed >= 0.0))
+    {
+        uint32_t* segmentIndices = NULL;
+        uint32_t segmentCount = 0;
+
+        // Allocate space
+        tSenseHAT_Replay* replay = (tSenseHAT_Replay*)malloc(sizeof(tSenseHAT_Replay));
+        if (replay != NULL)
+        {
+            // Initialize memory
+            memset(replay, 0, sizeof(tSenseHAT_Replay));
+            (void)pthread_mutex_init(&(replay->mutex), NULL);
+            replay->speed = speed;
+            instancePrivate->replay = replay;
+
+            // Map every segment of the log; pages are only read as playback reaches them
+            result = SenseHAT_ListSegments(directory, &segmentIndices, &segmentCount);
+            if ((result == 0) && (segmentCount > 0))
+            {
+                replay->segments = (tSenseHAT_ReplaySegment*)calloc(segmentCount, sizeof(tSenseHAT_ReplaySegment));
+                if (replay->segments != NULL)
+                {
+                    uint32_t index = 0;
+
+                    for (index = 0; (result == 0) && (index < segmentCount); index++)
+                    {
+                        tSenseHAT_ReplaySegment* segment = &(replay->segments[index]);
+
+                        result = SenseHAT_MapSegment(directory, segmentIndices[index],
+                                                     &(segment->mapping), &(segment->mappingLength),
+                                                     &(segment->records), &(segment->recordCount));
+                        replay->segmentCount++;
+                    }
+                }
+                else    // calloc failed
+                {
+                    result = ENOMEM;
+                }
+            }
+            free((void*)segmentIndices);
+
+            // Find the extent of the log
+            if (result == 0)
+            {
+                tSenseHAT_ReplayCursor cursor = { 0, 0 };
+                const tSenseHAT_Record* record = SenseHAT_ReplayPeek(replay, &cursor);
+                if (record != NULL)
+                {
+                    uint32_t index = replay->segmentCount;
+
+                    replay->logStart = record->timestamp;
+                    while (index > 0)
+                    {
+                        index--;
+                        if (replay->segments[index].recordCount > 0)
+                        {
+                            replay->logEnd = 
+                                replay->segments[index].records[replay->segments[index].recordCount - 1].timestamp;
+                            break;
+                        }
+                    }
+
+                    // Start playing
+                    replay->virtualTime = replay->logStart;
+                    replay->wallStart = SenseHAT_GetMonotonicTime();
+                }
+                else    // Empty log
+                {
+                    result = ENODATA;
+                }
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayRelease
+// =================================================================================================
+void SenseHAT_ReplayRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if ((instancePrivate != NULL) &&
+        (instancePrivate->replay != NULL))
+    {
+        tSenseHAT_Replay* replay = instancePrivate->replay;
+        uint32_t index = 0;
+
+        // Clean up
+        for (index = 0; index < replay->segmentCount; index++)
+        {
+            if (replay->segments[index].mapping != NULL)
+            {
+                (void)munmap(replay->segments[index].mapping, replay->segments[index].mappingLength);
+            }
+        }
+        free((void*)(replay->segments));
+        (void)pthread_mutex_destroy(&(replay->mutex));
+        free((void*)replay);
+        instancePrivate->replay = NULL;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayReadChannels
+// =================================================================================================
+int32_t SenseHAT_ReplayReadChannels (tSenseHAT_InstancePrivate* instancePrivate,
+                                     uint32_t channels,
+                                     tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+    tSenseHAT_Replay* replay = instancePrivate->replay;
+    int32_t index = 0;
+
+    // Setup
+    memset(sample, 0, sizeof(tSenseHAT_Sample));
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(replay->mutex));
+
+    double now = SenseHAT_ReplayNow(replay);
+    for (index = 0; index < kSenseHAT_ChannelCount; index++)
+    {
+        uint32_t channel = (uint32_t)1 << index;
+        tSenseHAT_ReplayCursor* cursor = &(replay->cursors[index]);
+        const tSenseHAT_Record* record = NULL;
+        bool finished = false;
+
+        if ((channels & channel) != 0)
+        {
+            if (replay->speed > 0.0)
+            {
+                // Catch up with the clock
+                while (((record = SenseHAT_ReplayPeek(replay, cursor)) != NULL) &&
+                       (record->timestamp <= now))
+                {
+                    if (record->channel == channel)
+                    {
+                        replay->latest[index] = record;
+                    }
+                    cursor->index++;
+                }
+                finished = (now > replay->logEnd);
+            }
+            else    // As fast as possible
+            {
+                // Step to the next reading of this channel
+                while (((record = SenseHAT_ReplayPeek(replay, cursor)) != NULL) &&
+                       (record->channel != channel))
+                {
+                    cursor->index++;
+                }
+                if (record != NULL)
+                {
+                    replay->latest[index] = record;
+                    cursor->index++;
+                    if (record->timestamp > replay->virtualTime)
+                    {
+                        replay->virtualTime = record->timestamp;
+                    }
+                }
+                else
+                {
+                    finished = true;
+                }
+            }
+
+            // Return the reading
+            record = replay->latest[index];
+            if ((record != NULL) && !finished)
+            {
+                SenseHAT_ReplayCopyRecord(record, sample);
+                if ((sample->timestamp == 0.0) || (record->timestamp < sample->timestamp))
+                {
+                    sample->timestamp = record->timestamp;
+                }
+            }
+            else if (result == 0)
+            {
+                result = ENODATA;
+            }
+        }
+    }
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(replay->mutex));
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayReadEvents
+// =================================================================================================
+int32_t SenseHAT_ReplayReadEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                   tSenseHAT_JoystickEvent* events,
+                                   int32_t capacity,
+                                   int32_t* eventCount)
+{
+    int32_t result = 0;
+    tSenseHAT_Replay* replay = instancePrivate->replay;
+    const tSenseHAT_Record* record = NULL;
+    int32_t count = 0;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(replay->mutex));
+
+    double now = SenseHAT_ReplayNow(replay);
+    while ((record = SenseHAT_ReplayNextEvent(replay)) != NULL)
+    {
+        // Is the event due?
+        if (record->timestamp > now)
+        {
+            // Playing as fast as possible, a read with nothing due moves on to the next event
+            if ((replay->speed == 0.0) && (count == 0))
+            {
+                replay->virtualTime = record->timestamp;
+                now = record->timestamp;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // Is there room?
+        if (count == capacity)
+        {
+            result = ENOBUFS;
+            break;
+        }
+
+        SenseHAT_ReplayCopyEvent(record, &(events[count]));
+        replay->eventCursor.index++;
+        count++;
+    }
+
+    // Has the log run out of events?
+    if ((count == 0) && (record == NULL))
+    {
+        result = ENODATA;
+    }
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(replay->mutex));
+
+    *eventCount = count;
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayGetEvents
+// =================================================================================================
+int32_t SenseHAT_ReplayGetEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                  int32_t* eventCount,
+                                  tSenseHAT_JoystickEvent** events)
+{
+    int32_t result = 0;
+    tSenseHAT_JoystickEvent* list = NULL;
+    int32_t count = 0;
+
+    // Setup
+    *eventCount = 0;
+    if (events != NULL)
+    {
+        *events = NULL;
+    }
+
+    // Grow the list until every event that's due has been read
+    do
+    {
+        tSenseHAT_JoystickEvent* newList = 
+            (tSenseHAT_JoystickEvent*)realloc(list, (count + kReplayEventBatchSize) * sizeof(tSenseHAT_JoystickEvent));
+        if (newList != NULL)
+        {
+            int32_t newCount = 0;
+
+            list = newList;
+            result = SenseHAT_ReplayReadEvents(instancePrivate, &(list[count]), kReplayEventBatchSize, &newCount);
+            count += newCount;
+        }
+        else    // realloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    while (result == ENOBUFS);
+
+    // Like the Python library, running out of events isn't an error
+    if (result == ENODATA)
+    {
+        result = 0;
+    }
+
+    // Check for success
+    if ((result == 0) && (count > 0) && (events != NULL))
+    {
+        *eventCount = count;
+        *events = list;
+    }
+    else    // Clean up
+    {
+        free((void*)list);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayWaitForEvent
+// =================================================================================================
+int32_t SenseHAT_ReplayWaitForEvent (tSenseHAT_InstancePrivate* instancePrivate,
+                                     bool flushPendingEvents,
+                                     tSenseHAT_JoystickEvent* event)
+{
+    int32_t result = 0;
+    tSenseHAT_Replay* replay = instancePrivate->replay;
+    const tSenseHAT_Record* record = NULL;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(replay->mutex));
+
+    // Skip the events that are already due
+    if (flushPendingEvents)
+    {
+        double now = SenseHAT_ReplayNow(replay);
+        while (((record = SenseHAT_ReplayNextEvent(replay)) != NULL) &&
+               (record->timestamp <= now))
+        {
+            replay->eventCursor.index++;
+        }
+    }
+
+    record = SenseHAT_ReplayNextEvent(replay);
+    if (record != NULL)
+    {
+        if (replay->speed > 0.0)
+        {
+            // Sleep until the event is due
+            double wakeTime = replay->wallStart + ((record->timestamp - replay->logStart) / replay->speed);
+            double now = SenseHAT_GetMonotonicTime();
+            if (wakeTime > now)
+            {
+                struct timespec deadline;
+
+                deadline.tv_sec = (time_t)wakeTime;
+                deadline.tv_nsec = (long)((wakeTime - (double)deadline.tv_sec) * 1000000000.0);
+                (void)pthread_mutex_unlock(&(replay->mutex));
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+                {
+                    // Keep sleeping
+                }
+                (void)pthread_mutex_lock(&(replay->mutex));
+
+                // Another thread may have consumed it meanwhile
+                record = SenseHAT_ReplayNextEvent(replay);
+            }
+        }
+        else if (record->timestamp > replay->virtualTime)
+        {
+            replay->virtualTime = record->timestamp;
+        }
+
+        if (record != NULL)
+        {
+            SenseHAT_ReplayCopyEvent(record, event);
+            replay->eventCursor.index++;
+        }
+        else    // Out of events
+        {
+            result = ENODATA;
+        }
+    }
+    else    // Out of events
+    {
+        result = ENODATA;
+    }
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(replay->mutex));
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayGetTime
+// =================================================================================================
+double SenseHAT_ReplayGetTime (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    tSenseHAT_Replay* replay = instancePrivate->replay;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(replay->mutex));
+
+    double now = SenseHAT_ReplayNow(replay);
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(replay->mutex));
+
+    return now;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayPeek
+// =================================================================================================
+const tSenseHAT_Record* SenseHAT_ReplayPeek (const tSenseHAT_Replay* replay,
+                                             tSenseHAT_ReplayCursor* cursor)
+{
+    const tSenseHAT_Record* record = NULL;
+
+    // Move on to the next segment at the end of each one
+    while ((cursor->segment < replay->segmentCount) &&
+           (cursor->index >= replay->segments[cursor->segment].recordCount))
+    {
+        cursor->segment++;
+        cursor->index = 0;
+    }
+    if (cursor->segment < replay->segmentCount)
+    {
+        record = &(replay->segments[cursor->segment].records[cursor->index]);
+    }
+    return record;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayNextEvent
+// =================================================================================================
+const tSenseHAT_Record* SenseHAT_ReplayNextEvent (tSenseHAT_Replay* replay)
+{
+    const tSenseHAT_Record* record = NULL;
+
+    // Skip over sensor readings
+    while (((record = SenseHAT_ReplayPeek(replay, &(replay->eventCursor))) != NULL) &&
+           (record->channel != eSenseHAT_ChannelJoystick))
+    {
+        replay->eventCursor.index++;
+    }
+    return record;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayNow
+// =================================================================================================
+double SenseHAT_ReplayNow (const tSenseHAT_Replay* replay)
+{
+    double now = replay->virtualTime;
+
+    // Map the clock onto the log
+    if (replay->speed > 0.0)
+    {
+        now = replay->logStart + ((SenseHAT_GetMonotonicTime() - replay->wallStart) * replay->speed);
+    }
+    return now;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayCopyRecord
+// =================================================================================================
+void SenseHAT_ReplayCopyRecord (const tSenseHAT_Record* record,
+                                tSenseHAT_Sample* sample)
+{
+    tSenseHAT_RawData* rawData = NULL;
+
+    switch (record->channel)
+    {
+        case eSenseHAT_ChannelHumidity:
+            sample->humidity = record->values[0];
+            break;
+        case eSenseHAT_ChannelTemperature:
+            sample->temperature = record->values[0];
+            break;
+        case eSenseHAT_ChannelPressure:
+            sample->pressure = record->values[0];
+            break;
+        case eSenseHAT_ChannelCompass:
+            sample->compass = record->values[0];
+            break;
+        case eSenseHAT_ChannelAccelerometerRaw:
+            rawData = &(sample->accelerometerRaw);
+            break;
+        case eSenseHAT_ChannelGyroscopeRaw:
+            rawData = &(sample->gyroscopeRaw);
+            break;
+        case eSenseHAT_ChannelCompassRaw:
+            rawData = &(sample->compassRaw);
+            break;
+        case eSenseHAT_ChannelOrientation:
+            sample->orientation.pitch = record->values[0];
+            sample->orientation.roll = record->values[1];
+            sample->orientation.yaw = record->values[2];
+            break;
+        default:
+            break;
+    }
+    if (rawData != NULL)
+    {
+        rawData->x = record->values[0];
+        rawData->y = record->values[1];
+        rawData->z = record->values[2];
+    }
+    sample->channels |= record->channel;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_ReplayCopyEvent
+// =================================================================================================
+void SenseHAT_ReplayCopyEvent (const tSenseHAT_Record* record,
+                               tSenseHAT_JoystickEvent* event)
+{
+    event->timestamp = record->timestamp;
+    event->direction = (tSenseHAT_JoystickDirection)(record->values[0]);
+    event->action = (tSenseHAT_JoystickAction)(record->values[1]);
+    return;
+}
+
+// =================================================================================================
@@ -0,0 +1,396 @@
+// ==================================================================================================
+//
+//  sensehat-rollup.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the sampler rollups of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-rollup.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the sampler rollups of the Raspberry
+//! Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Rollup file magic number and version
+static const char kRollupMagic[4] = { 'S', 'H', 'T', 'R' };
+#define kRollupVersion  1
+
+// Bucket duration of each tSenseHAT_RollupResolution, in seconds
+static const double kRollupDurations[kSenseHAT_RollupResolutionCount] = { 1.0, 60.0, 3600.0 };
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Rollup file header
+typedef struct
+{
+    char        magic[4];       // kRollupMagic
+    uint16_t    version;        // kRollupVersion
+    uint16_t    reserved;       // Always 0
+    uint32_t    size;           // sizeof(tSenseHAT_Rollups)
+}
+tSenseHAT_RollupHeader;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_RollupGetChannelIndex
+static int32_t SenseHAT_RollupGetChannelIndex (uint32_t channel);
+
+// SenseHAT_RollupLoad
+static int32_t SenseHAT_RollupLoad (const char* path,
+                                    tSenseHAT_Rollups* rollups);
+
+// =================================================================================================
+//  SenseHAT_SamplerGetRollups
+// =================================================================================================
+int32_t SenseHAT_SamplerGetRollups (const tSenseHAT_Instance instance,
+                                    uint32_t channel,
+                                    tSenseHAT_RollupResolution resolution,
+                                    tSenseHAT_RollupBucket* buckets,
+                                    uint32_t capacity,
+                                    uint32_t* bucketCount)
+{
+    int32_t result = 0;
+    int32_t channelIndex = SenseHAT_RollupGetChannelIndex(channel);
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (channelIndex >= 0) &&
+        ((uint32_t)resolution < kSenseHAT_RollupResolutionCount) &&
+        (buckets != NULL) &&
+        (bucketCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        uint32_t count = 0;
+        uint32_t used = 0;
+        uint32_t index = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        const tSenseHAT_RollupAccumulator* ring = sampler->rollups.buckets[channelIndex][resolution];
+        uint32_t newest = sampler->rollups.newest[channelIndex][resolution];
+
+        // Count the buckets in use, newest first; the ring fills in order
+        while ((used < kSenseHAT_RollupBuckets) &&
+               (ring[(newest + kSenseHAT_RollupBuckets - used) % kSenseHAT_RollupBuckets].count > 0))
+        {
+            used++;
+        }
+        count = (used < capacity) ? used : capacity;
+
+        // Copy them out, oldest first
+        for (index = 0; index < count; index++)
+        {
+            const tSenseHAT_RollupAccumulator* accumulator =
+                &(ring[(newest + kSenseHAT_RollupBuckets - (count - 1 - index)) % kSenseHAT_RollupBuckets]);
+
+            buckets[index].startTime = accumulator->startTime;
+            buckets[index].count = accumulator->count;
+            buckets[index].minimum = accumulator->minimum;
+            buckets[index].maximum = accumulator->maximum;
+            buckets[index].mean = accumulator->mean;
+            buckets[index].standardDeviation = sqrt(accumulator->m2 / (double)(accumulator->count));
+        }
+        *bucketCount = count;
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerSetRollupFile
+// =================================================================================================
+int32_t SenseHAT_SamplerSetRollupFile (const tSenseHAT_Instance instance,
+                                       const char* path)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        ((path == NULL) ||
+         ((path[0] != '\0') && (strlen(path) < kSenseHAT_RollupPathSize))))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+
+        if (path != NULL)
+        {
+            // Load the saved rollups, if any, outside the lock
+            tSenseHAT_Rollups* rollups = (tSenseHAT_Rollups*)malloc(sizeof(tSenseHAT_Rollups));
+            if (rollups != NULL)
+            {
+                result = SenseHAT_RollupLoad(path, rollups);
+                if ((result == 0) || (result == ENOENT))
+                {
+                    (void)pthread_mutex_lock(&(sampler->mutex));
+                    if (result == 0)
+                    {
+                        sampler->rollups = *rollups;
+                    }
+                    (void)strcpy(sampler->rollupPath, path);
+                    (void)pthread_mutex_unlock(&(sampler->mutex));
+                    result = 0;
+                }
+                free((void*)rollups);
+            }
+            else    // malloc failed
+            {
+                result = ENOMEM;
+            }
+        }
+        else
+        {
+            (void)pthread_mutex_lock(&(sampler->mutex));
+            sampler->rollupPath[0] = '\0';
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RollupAdd
+// =================================================================================================
+bool SenseHAT_RollupAdd (tSenseHAT_Rollups* rollups,
+                         const tSenseHAT_Sample* sample)
+{
+    bool minuteCompleted = false;
+    int32_t channelIndex = 0;
+    const double readings[kSenseHAT_RollupChannelCount] =
+        { sample->humidity, sample->temperature, sample->pressure };
+
+    for (channelIndex = 0; channelIndex < kSenseHAT_RollupChannelCount; channelIndex++)
+    {
+        int32_t resolution = 0;
+        double reading = readings[channelIndex];
+
+        // Skip channels that weren't read, and readings that would poison the aggregates
+        if (((sample->channels & (1u << channelIndex)) == 0) || !isfinite(reading))
+        {
+            continue;
+        }
+
+        for (resolution = 0; resolution < kSenseHAT_RollupResolutionCount; resolution++)
+        {
+            uint32_t* newest = &(rollups->newest[channelIndex][resolution]);
+            tSenseHAT_RollupAccumulator* accumulator = &(rollups->buckets[channelIndex][resolution][*newest]);
+            double startTime = floor(sample->timestamp / kRollupDurations[resolution]) * kRollupDurations[resolution];
+            double delta = 0.0;
+
+            // Start a new bucket when the reading falls outside the newest one
+            if ((accumulator->count == 0) ||
+                (accumulator->startTime != startTime))
+            {
+                if (accumulator->count != 0)
+                {
+                    *newest = (*newest + 1) % kSenseHAT_RollupBuckets;
+                    accumulator = &(rollups->buckets[channelIndex][resolution][*newest]);
+                    if (resolution == eSenseHAT_RollupMinute)
+                    {
+                        minuteCompleted = true;
+                    }
+                }
+                accumulator->startTime = startTime;
+                accumulator->count = 0;
+                accumulator->minimum = reading;
+                accumulator->maximum = reading;
+                accumulator->mean = 0.0;
+                accumulator->m2 = 0.0;
+            }
+
+            // Welford's update
+            accumulator->count++;
+            delta = reading - accumulator->mean;
+            accumulator->mean += delta / (double)(accumulator->count);
+            accumulator->m2 += delta * (reading - accumulator->mean);
+            accumulator->minimum = fmin(accumulator->minimum, reading);
+            accumulator->maximum = fmax(accumulator->maximum, reading);
+        }
+    }
+    return minuteCompleted;
+}
+
+// =================================================================================================
+//  SenseHAT_RollupSave
+// =================================================================================================
+int32_t SenseHAT_RollupSave (tSenseHAT_Sampler* sampler)
+{
+    int32_t result = 0;
+    char path[kSenseHAT_RollupPathSize];
+    char temporaryPath[kSenseHAT_RollupPathSize + 8];
+    tSenseHAT_Rollups* rollups = (tSenseHAT_Rollups*)malloc(sizeof(tSenseHAT_Rollups));
+
+    if (rollups != NULL)
+    {
+        // Take a copy, so the sampler isn't held up by the write
+        (void)pthread_mutex_lock(&(sampler->mutex));
+        *rollups = sampler->rollups;
+        (void)strcpy(path, sampler->rollupPath);
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+
+        if (path[0] != '\0')
+        {
+            tSenseHAT_RollupHeader header;
+
+            memset(&header, 0, sizeof(tSenseHAT_RollupHeader));
+            memcpy(header.magic, kRollupMagic, sizeof(kRollupMagic));
+            header.version = kRollupVersion;
+            header.size = sizeof(tSenseHAT_Rollups);
+
+            // Write a new file and rename it over the old one, so a crash never leaves a
+            // partial file behind
+            (void)snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+            int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd >= 0)
+            {
+                if ((write(fd, &header, sizeof(tSenseHAT_RollupHeader)) != (ssize_t)sizeof(tSenseHAT_RollupHeader)) ||
+                    (write(fd, rollups, sizeof(tSenseHAT_Rollups)) != (ssize_t)sizeof(tSenseHAT_Rollups)) ||
+                    (fdatasync(fd) != 0))
+                {
+                    result = EIO;
+                }
+                (void)close(fd);
+                if (result == 0)
+                {
+                    if (rename(temporaryPath, path) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+                if (result != 0)
+                {
+                    (void)unlink(temporaryPath);
+                }
+            }
+            else    // open failed
+            {
+                result = errno;
+            }
+        }
+        free((void*)rollups);
+    }
+    else    // malloc failed
+    {
+        result = ENOMEM;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_RollupGetChannelIndex
+// =================================================================================================
+int32_t SenseHAT_RollupGetChannelIndex (uint32_t channel)
+{
+    int32_t channelIndex = -1;
+
+    switch (channel)
+    {
+        case eSenseHAT_ChannelHumidity:
+            channelIndex = 0;
+            break;
+        case eSenseHAT_ChannelTemperature:
+            channelIndex = 1;
+            break;
+        case eSenseHAT_ChannelPressure:
+            channelIndex = 2;
+            break;
+        default:
+            break;
+    }
+    return channelIndex;
+}
+
+// =================================================================================================
+//  SenseHAT_RollupLoad
+// =================================================================================================
+int32_t SenseHAT_RollupLoad (const char* path,
+                             tSenseHAT_Rollups* rollups)
+{
+    int32_t result = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        tSenseHAT_RollupHeader header;
+        int32_t channelIndex = 0;
+        int32_t resolution = 0;
+
+        // Check the header and read the rollups
+        if ((read(fd, &header, sizeof(tSenseHAT_RollupHeader)) == (ssize_t)sizeof(tSenseHAT_RollupHeader)) &&
+            (memcmp(header.magic, kRollupMagic, sizeof(kRollupMagic)) == 0) &&
+            (header.version == kRollupVersion) &&
+            (header.size == sizeof(tSenseHAT_Rollups)) &&
+            (read(fd, rollups, sizeof(tSenseHAT_Rollups)) == (ssize_t)sizeof(tSenseHAT_Rollups)))
+        {
+            // Don't trust the ring indices
+            for (channelIndex = 0; channelIndex < kSenseHAT_RollupChannelCount; channelIndex++)
+            {
+                for (resolution = 0; resolution < kSenseHAT_RollupResolutionCount; resolution++)
+                {
+                    if (rollups->newest[channelIndex][resolution] >= kSenseHAT_RollupBuckets)
+                    {
+                        result = EPROTO;
+                    }
+                }
+            }
+        }
+        else    // Not a rollup file
+        {
+            result = EPROTO;
+        }
+        (void)close(fd);
+    }
+    else    // open failed
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
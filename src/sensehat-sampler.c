@@ -0,0 +1,435 @@
+// ==================================================================================================
+//
+//  sensehat-sampler.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the background sampler of the Raspberry
+//      Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-sampler.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the background sampler of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_SamplerThread
+static void* SenseHAT_SamplerThread (void* argument);
+
+// SenseHAT_SamplerAcquire
+static void SenseHAT_SamplerAcquire (tSenseHAT_InstancePrivate* instancePrivate,
+                                     uint32_t channels,
+                                     tSenseHAT_Sample* sample);
+
+// SenseHAT_SamplerAdvanceDeadline
+static void SenseHAT_SamplerAdvanceDeadline (struct timespec* deadline,
+                                             double interval);
+
+// =================================================================================================
+//  SenseHAT_SamplerStart
+// =================================================================================================
+int32_t SenseHAT_SamplerStart (const tSenseHAT_Instance instance,
+                               uint32_t channels,
+                               double intervalSeconds)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (channels != eSenseHAT_ChannelNone) &&
+        ((channels & ~eSenseHAT_ChannelAll) == 0) &&
+        (intervalSeconds > 0.0))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        // Is the sampler already running?
+        if (!sampler->running)
+        {
+            sampler->channels = channels;
+            sampler->interval = intervalSeconds;
+            sampler->stopRequested = false;
+            sampler->running = true;
+
+            // Start the sampler thread
+            result = pthread_create(&(sampler->thread), NULL, SenseHAT_SamplerThread, instancePrivate);
+            if (result != 0)
+            {
+                // pthread_create failed
+                sampler->running = false;
+            }
+        }
+        else    // Already running
+        {
+            result = EBUSY;
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerStop
+// =================================================================================================
+int32_t SenseHAT_SamplerStop (const tSenseHAT_Instance instance)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        bool running = false;
+
+        // Ask the sampler thread to stop
+        (void)pthread_mutex_lock(&(sampler->mutex));
+        running = sampler->running;
+        if (running)
+        {
+            sampler->stopRequested = true;
+            (void)pthread_cond_signal(&(sampler->condition));
+        }
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+
+        // Wait for it to finish
+        if (running)
+        {
+            result = pthread_join(sampler->thread, NULL);
+
+            (void)pthread_mutex_lock(&(sampler->mutex));
+            sampler->running = false;
+            sampler->stopRequested = false;
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+
+            // Keep the partial buckets
+            (void)SenseHAT_RollupSave(sampler);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerGetLatest
+// =================================================================================================
+int32_t SenseHAT_SamplerGetLatest (const tSenseHAT_Instance instance,
+                                   tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (sample != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        // Has a sample been acquired?
+        if (sampler->latest.sequence != 0)
+        {
+            *sample = sampler->latest;
+
+            // Acknowledge the sample
+            if (sampler->eventFd >= 0)
+            {
+                eventfd_t value = 0;
+                (void)eventfd_read(sampler->eventFd, &value);
+            }
+        }
+        else    // No sample yet
+        {
+            memset(sample, 0, sizeof(tSenseHAT_Sample));
+            result = ENODATA;
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerInitialize
+// =================================================================================================
+int32_t SenseHAT_SamplerInitialize (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        pthread_condattr_t conditionAttributes;
+
+        // Setup
+        memset(sampler, 0, sizeof(tSenseHAT_Sampler));
+
+        // The sampler paces itself against the monotonic clock
+        (void)pthread_mutex_init(&(sampler->mutex), NULL);
+        (void)pthread_condattr_init(&conditionAttributes);
+        (void)pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+        (void)pthread_cond_init(&(sampler->condition), &conditionAttributes);
+        (void)pthread_condattr_destroy(&conditionAttributes);
+
+        // Create the new sample notification; the sampler still works without it, but
+        // SenseHAT_WaitForSources can't wait on it
+        sampler->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (sampler->eventFd < 0)
+        {
+            result = errno;
+            sampler->eventFd = -1;
+        }
+
+        // Likewise for motion events
+        sampler->motionFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (sampler->motionFd < 0)
+        {
+            if (result == 0)
+            {
+                result = errno;
+            }
+            sampler->motionFd = -1;
+        }
+
+        // And for subscription notifications
+        sampler->subscriptionFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (sampler->subscriptionFd < 0)
+        {
+            if (result == 0)
+            {
+                result = errno;
+            }
+            sampler->subscriptionFd = -1;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerRelease
+// =================================================================================================
+void SenseHAT_SamplerRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+
+        // Make sure the sampler thread is gone
+        (void)SenseHAT_SamplerStop((tSenseHAT_Instance)instancePrivate);
+
+        // Clean up
+        if (sampler->eventFd >= 0)
+        {
+            (void)close(sampler->eventFd);
+            sampler->eventFd = -1;
+        }
+        if (sampler->motionFd >= 0)
+        {
+            (void)close(sampler->motionFd);
+            sampler->motionFd = -1;
+        }
+        if (sampler->subscriptionFd >= 0)
+        {
+            (void)close(sampler->subscriptionFd);
+            sampler->subscriptionFd = -1;
+        }
+        (void)pthread_cond_destroy(&(sampler->condition));
+        (void)pthread_mutex_destroy(&(sampler->mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerThread
+// =================================================================================================
+void* SenseHAT_SamplerThread (void* argument)
+{
+    tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)argument;
+    tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+    tSenseHAT_Sample sample;
+    tSenseHAT_MotionEvent motionEvents[kSenseHAT_MaxMotionEvents];
+    tSenseHAT_SubscriptionDelivery deliveries[kSenseHAT_SubscriptionsMax];
+    struct timespec deadline;
+
+    // Samples are due at fixed multiples of the interval from now
+    (void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(sampler->mutex));
+
+    while (!sampler->stopRequested)
+    {
+        uint32_t channels = sampler->channels;
+        double interval = sampler->interval;
+        uint32_t motionCount = 0;
+        uint32_t deliveryCount = 0;
+
+        // Don't hold the lock while talking to the sensors
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+        SenseHAT_SamplerAcquire(instancePrivate, channels, &sample);
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        // Publish the sample
+        sample.sequence = sampler->latest.sequence + 1;
+        sampler->latest = sample;
+        SenseHAT_FilterSample(sampler, &sample);
+        if (sampler->eventFd >= 0)
+        {
+            (void)eventfd_write(sampler->eventFd, 1);
+        }
+
+        // Look for motion, and tell the callback about it without holding the lock
+        motionCount = SenseHAT_MotionSample(sampler, &sample, motionEvents);
+        if ((motionCount > 0) && (sampler->motionCallback != NULL))
+        {
+            tSenseHAT_MotionCallback callback = sampler->motionCallback;
+            void* context = sampler->motionContext;
+            uint32_t index = 0;
+
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+            for (index = 0; index < motionCount; index++)
+            {
+                callback(&(motionEvents[index]), context);
+            }
+            (void)pthread_mutex_lock(&(sampler->mutex));
+        }
+
+        // Notify subscribers the same way
+        deliveryCount = SenseHAT_SubscriptionSample(sampler, &sample, deliveries);
+        if (deliveryCount > 0)
+        {
+            uint32_t index = 0;
+
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+            for (index = 0; index < deliveryCount; index++)
+            {
+                if (deliveries[index].callback != NULL)
+                {
+                    deliveries[index].callback(&(deliveries[index].notification), deliveries[index].context);
+                }
+            }
+            (void)pthread_mutex_lock(&(sampler->mutex));
+        }
+
+        // Update the rollups, and save them once a minute
+        if (SenseHAT_RollupAdd(&(sampler->rollups), &sample) &&
+            (sampler->rollupPath[0] != '\0'))
+        {
+            (void)pthread_mutex_unlock(&(sampler->mutex));
+            (void)SenseHAT_RollupSave(sampler);
+            (void)pthread_mutex_lock(&(sampler->mutex));
+        }
+
+        // Sleep until the next sample is due, or until we're asked to stop
+        SenseHAT_SamplerAdvanceDeadline(&deadline, interval);
+        while (!sampler->stopRequested)
+        {
+            if (pthread_cond_timedwait(&(sampler->condition),
+                                       &(sampler->mutex),
+                                       &deadline) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+    }
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(sampler->mutex));
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerAcquire
+// =================================================================================================
+void SenseHAT_SamplerAcquire (tSenseHAT_InstancePrivate* instancePrivate,
+                              uint32_t channels,
+                              tSenseHAT_Sample* sample)
+{
+    // Always read the sensors; the readings also refresh the cache. Channels that fail are left 
+    // out of the sample.
+    (void)SenseHAT_GetChannels((tSenseHAT_Instance)instancePrivate, channels, 0.0, sample);
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerAdvanceDeadline
+// =================================================================================================
+void SenseHAT_SamplerAdvanceDeadline (struct timespec* deadline,
+                                      double interval)
+{
+    struct timespec now;
+    int64_t nanoseconds = (int64_t)(interval * 1000000000.0);
+
+    // Move the deadline on by one interval
+    deadline->tv_sec += (time_t)(nanoseconds / 1000000000);
+    deadline->tv_nsec += (long)(nanoseconds % 1000000000);
+    if (deadline->tv_nsec >= 1000000000)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+
+    // If we've fallen behind (e.g. a slow Python call), start again from now rather than
+    // firing a burst of late samples
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((deadline->tv_sec < now.tv_sec) ||
+        ((deadline->tv_sec == now.tv_sec) && (deadline->tv_nsec < now.tv_nsec)))
+    {
+        *deadline = now;
+    }
+    return;
+}
+
+// =================================================================================================
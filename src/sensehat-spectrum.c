@@ -0,0 +1,500 @@
+// ==================================================================================================
+//
+//  sensehat-spectrum.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the spectrum analysis of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//      3)  The FFT butterflies use NEON when compiled with NEON enabled (e.g. -mfpu=neon), SSE
+//          on x86, and plain C otherwise.
+//
+// =================================================================================================
+//! @file sensehat-spectrum.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the spectrum analysis of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <math.h>
+#include <memory.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define kSpectrumNEON   1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define kSpectrumSSE    1
+#endif
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Alignment of the plan buffers, in bytes
+#define kSpectrumAlignment  64
+
+// Number of floats the plan buffers are rounded up to, so each stays aligned
+#define kSpectrumRounding   (kSpectrumAlignment / sizeof(float))
+
+// Pi
+static const double kSpectrumPi = 3.14159265358979323846;
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Plan state; every array lives in one aligned allocation
+typedef struct
+{
+    uint32_t    length;             // Number of samples (N)
+    uint32_t    half;               // Size of the complex FFT (N / 2)
+    float       windowSum;          // Sum of the window coefficients
+    float*      window;             // Window coefficients, N
+    float*      twiddleReal;        // Butterfly twiddles for each stage, N / 2 - 1
+    float*      twiddleImaginary;
+    float*      splitReal;          // Real FFT split twiddles, N / 2 + 1
+    float*      splitImaginary;
+    uint32_t*   reversed;           // Bit reversal permutation, N / 2
+    float*      real;               // Complex FFT work buffer, N / 2
+    float*      imaginary;
+    float*      power;              // Power spectrum, N / 2 + 1
+    void*       memory;             // The allocation
+}
+tSenseHAT_SpectrumPlanPrivate;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_SpectrumRound
+static size_t SenseHAT_SpectrumRound (size_t count);
+
+// SenseHAT_SpectrumButterflies
+static void SenseHAT_SpectrumButterflies (float* real,
+                                          float* imaginary,
+                                          const float* twiddleReal,
+                                          const float* twiddleImaginary,
+                                          uint32_t half);
+
+// SenseHAT_SpectrumAddPeak
+static void SenseHAT_SpectrumAddPeak (tSenseHAT_AxisSpectrum* spectrum,
+                                      uint32_t peakCount,
+                                      float frequency,
+                                      float power);
+
+// =================================================================================================
+//  SenseHAT_SpectrumOpen
+// =================================================================================================
+int32_t SenseHAT_SpectrumOpen (uint32_t length,
+                               tSenseHAT_SpectrumWindow window,
+                               tSenseHAT_SpectrumPlan* plan)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((length >= kSenseHAT_SpectrumLengthMin) &&
+        (length <= kSenseHAT_SpectrumLengthMax) &&
+        ((length & (length - 1)) == 0) &&
+        ((uint32_t)window <= eSenseHAT_SpectrumWindowBlackman) &&
+        (plan != NULL))
+    {
+        // Setup
+        *plan = NULL;
+
+        // Allocate space
+        tSenseHAT_SpectrumPlanPrivate* planPrivate =
+            (tSenseHAT_SpectrumPlanPrivate*)malloc(sizeof(tSenseHAT_SpectrumPlanPrivate));
+        if (planPrivate != NULL)
+        {
+            uint32_t half = length / 2;
+            size_t floats = length + (2 * half) + (2 * (half + 1)) + (2 * half) + (half + 1) + (8 * kSpectrumRounding);
+
+            // Initialize memory
+            memset(planPrivate, 0, sizeof(tSenseHAT_SpectrumPlanPrivate));
+            planPrivate->length = length;
+            planPrivate->half = half;
+            if (posix_memalign(&(planPrivate->memory), kSpectrumAlignment,
+                               (floats * sizeof(float)) + (half * sizeof(uint32_t))) == 0)
+            {
+                float* next = (float*)(planPrivate->memory);
+                uint32_t index = 0;
+                uint32_t bits = 0;
+                uint32_t stage = 0;
+                double windowSum = 0.0;
+
+                // Carve up the allocation
+                planPrivate->window = next;
+                next += SenseHAT_SpectrumRound(length);
+                planPrivate->twiddleReal = next;
+                next += SenseHAT_SpectrumRound(half);
+                planPrivate->twiddleImaginary = next;
+                next += SenseHAT_SpectrumRound(half);
+                planPrivate->splitReal = next;
+                next += SenseHAT_SpectrumRound(half + 1);
+                planPrivate->splitImaginary = next;
+                next += SenseHAT_SpectrumRound(half + 1);
+                planPrivate->real = next;
+                next += SenseHAT_SpectrumRound(half);
+                planPrivate->imaginary = next;
+                next += SenseHAT_SpectrumRound(half);
+                planPrivate->power = next;
+                next += SenseHAT_SpectrumRound(half + 1);
+                planPrivate->reversed = (uint32_t*)next;
+
+                // Periodic window, so bins line up with the transform
+                for (index = 0; index < length; index++)
+                {
+                    double phase = (2.0 * kSpectrumPi * index) / length;
+                    double coefficient = 1.0;
+
+                    switch (window)
+                    {
+                        case eSenseHAT_SpectrumWindowHann:
+                            coefficient = 0.5 - (0.5 * cos(phase));
+                            break;
+                        case eSenseHAT_SpectrumWindowHamming:
+                            coefficient = 0.54 - (0.46 * cos(phase));
+                            break;
+                        case eSenseHAT_SpectrumWindowBlackman:
+                            coefficient = 0.42 - (0.5 * cos(phase)) + (0.08 * cos(2.0 * phase));
+                            break;
+                        default:
+                            break;
+                    }
+                    planPrivate->window[index] = (float)coefficient;
+                    windowSum += coefficient;
+                }
+                planPrivate->windowSum = (float)windowSum;
+
+                // Each stage gets a contiguous run of twiddles, so its butterflies read them
+                // in order: stage h uses entries h - 1 to 2h - 2
+                for (stage = 1; stage < half; stage *= 2)
+                {
+                    for (index = 0; index < stage; index++)
+                    {
+                        double phase = (kSpectrumPi * index) / stage;
+
+                        planPrivate->twiddleReal[stage - 1 + index] = (float)cos(phase);
+                        planPrivate->twiddleImaginary[stage - 1 + index] = (float)(-sin(phase));
+                    }
+                }
+                for (index = 0; index <= half; index++)
+                {
+                    double phase = (2.0 * kSpectrumPi * index) / length;
+
+                    planPrivate->splitReal[index] = (float)cos(phase);
+                    planPrivate->splitImaginary[index] = (float)(-sin(phase));
+                }
+                bits = (uint32_t)__builtin_ctz(half);
+                for (index = 0; index < half; index++)
+                {
+                    uint32_t reversed = 0;
+                    uint32_t bit = 0;
+
+                    for (bit = 0; bit < bits; bit++)
+                    {
+                        reversed |= ((index >> bit) & 1u) << (bits - 1 - bit);
+                    }
+                    planPrivate->reversed[index] = reversed;
+                }
+
+                *plan = (tSenseHAT_SpectrumPlan)planPrivate;
+            }
+            else    // posix_memalign failed
+            {
+                result = ENOMEM;
+                free((void*)planPrivate);
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpectrumCompute
+// =================================================================================================
+int32_t SenseHAT_SpectrumCompute (tSenseHAT_SpectrumPlan plan,
+                                  const float* samples,
+                                  double sampleRate,
+                                  uint32_t peakCount,
+                                  tSenseHAT_AxisSpectrum* spectrum,
+                                  float* power)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((plan != NULL) &&
+        (samples != NULL) &&
+        (sampleRate > 0.0) &&
+        (peakCount <= kSenseHAT_SpectrumPeaksMax) &&
+        (spectrum != NULL))
+    {
+        // Get private data
+        tSenseHAT_SpectrumPlanPrivate* planPrivate = (tSenseHAT_SpectrumPlanPrivate*)plan;
+        uint32_t length = planPrivate->length;
+        uint32_t half = planPrivate->half;
+        float* real = planPrivate->real;
+        float* imaginary = planPrivate->imaginary;
+        float* bins = planPrivate->power;
+        double sum = 0.0;
+        double squares = 0.0;
+        float mean = 0.0f;
+        float scale = 0.0f;
+        uint32_t index = 0;
+        uint32_t stage = 0;
+        uint32_t band = 0;
+
+        memset(spectrum, 0, sizeof(tSenseHAT_AxisSpectrum));
+
+        // Remove the mean
+        for (index = 0; index < length; index++)
+        {
+            sum += samples[index];
+        }
+        mean = (float)(sum / length);
+        for (index = 0; index < length; index++)
+        {
+            double deviation = samples[index] - mean;
+            squares += deviation * deviation;
+        }
+        spectrum->mean = mean;
+        spectrum->rms = (float)sqrt(squares / length);
+
+        // Pack the windowed samples into a half length complex sequence, even samples in the
+        // real part and odd ones in the imaginary part, in bit reversed order
+        for (index = 0; index < half; index++)
+        {
+            uint32_t reversed = planPrivate->reversed[index];
+
+            real[reversed] = (samples[2 * index] - mean) * planPrivate->window[2 * index];
+            imaginary[reversed] = (samples[(2 * index) + 1] - mean) * planPrivate->window[(2 * index) + 1];
+        }
+
+        // Complex FFT
+        for (stage = 1; stage < half; stage *= 2)
+        {
+            uint32_t group = 0;
+
+            for (group = 0; group < half; group += 2 * stage)
+            {
+                SenseHAT_SpectrumButterflies(real + group, imaginary + group,
+                                             planPrivate->twiddleReal + stage - 1,
+                                             planPrivate->twiddleImaginary + stage - 1,
+                                             stage);
+            }
+        }
+
+        // Split into the spectrum of the real sequence, scaled so a centred sine of amplitude A
+        // has power A * A / 2 whatever the window
+        scale = 1.0f / (planPrivate->windowSum * planPrivate->windowSum);
+        for (index = 0; index <= half; index++)
+        {
+            uint32_t k = (index == half) ? 0 : index;
+            uint32_t m = (index == 0) ? 0 : (half - index);
+            float evenReal = 0.5f * (real[k] + real[m]);
+            float evenImaginary = 0.5f * (imaginary[k] - imaginary[m]);
+            float oddReal = 0.5f * (imaginary[k] + imaginary[m]);
+            float oddImaginary = -0.5f * (real[k] - real[m]);
+            float wr = planPrivate->splitReal[index];
+            float wi = planPrivate->splitImaginary[index];
+            float xr = evenReal + (wr * oddReal) - (wi * oddImaginary);
+            float xi = evenImaginary + (wr * oddImaginary) + (wi * oddReal);
+
+            bins[index] = ((xr * xr) + (xi * xi)) * scale * (((index == 0) || (index == half)) ? 1.0f : 2.0f);
+        }
+
+        // Find the strongest local maxima, and interpolate their frequencies
+        for (index = 1; (peakCount > 0) && (index < half); index++)
+        {
+            if ((bins[index] > bins[index - 1]) && (bins[index] >= bins[index + 1]))
+            {
+                float before = bins[index - 1];
+                float after = bins[index + 1];
+                float denominator = before - (2.0f * bins[index]) + after;
+                float offset = (denominator != 0.0f) ? (0.5f * (before - after) / denominator) : 0.0f;
+
+                SenseHAT_SpectrumAddPeak(spectrum, peakCount,
+                                         (float)(((index + offset) * sampleRate) / length), bins[index]);
+            }
+        }
+
+        // Sum the bands
+        for (band = 0; band < kSenseHAT_SpectrumBands; band++)
+        {
+            uint32_t first = 1 + ((band * half) / kSenseHAT_SpectrumBands);
+            uint32_t last = 1 + (((band + 1) * half) / kSenseHAT_SpectrumBands);
+
+            for (index = first; index < last; index++)
+            {
+                spectrum->bands[band] += bins[index];
+            }
+        }
+
+        if (power != NULL)
+        {
+            memcpy(power, bins, (half + 1) * sizeof(float));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpectrumClose
+// =================================================================================================
+int32_t SenseHAT_SpectrumClose (tSenseHAT_SpectrumPlan* plan)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((plan != NULL) &&
+        (*plan != NULL))
+    {
+        // Get private data
+        tSenseHAT_SpectrumPlanPrivate* planPrivate = (tSenseHAT_SpectrumPlanPrivate*)(*plan);
+
+        // Clean up
+        free(planPrivate->memory);
+        free((void*)planPrivate);
+        *plan = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SpectrumRound
+// =================================================================================================
+size_t SenseHAT_SpectrumRound (size_t count)
+{
+    // Round up to a whole number of alignment units
+    return ((count + kSpectrumRounding - 1) / kSpectrumRounding) * kSpectrumRounding;
+}
+
+// =================================================================================================
+//  SenseHAT_SpectrumButterflies
+// =================================================================================================
+void SenseHAT_SpectrumButterflies (float* real,
+                                   float* imaginary,
+                                   const float* twiddleReal,
+                                   const float* twiddleImaginary,
+                                   uint32_t half)
+{
+    uint32_t index = 0;
+
+    // The top half of the group is multiplied by the twiddles, then added to and subtracted
+    // from the bottom half
+#if defined(kSpectrumNEON)
+    for (; (index + 4) <= half; index += 4)
+    {
+        float32x4_t wr = vld1q_f32(twiddleReal + index);
+        float32x4_t wi = vld1q_f32(twiddleImaginary + index);
+        float32x4_t br = vld1q_f32(real + half + index);
+        float32x4_t bi = vld1q_f32(imaginary + half + index);
+        float32x4_t ar = vld1q_f32(real + index);
+        float32x4_t ai = vld1q_f32(imaginary + index);
+        float32x4_t tr = vmlsq_f32(vmulq_f32(wr, br), wi, bi);
+        float32x4_t ti = vmlaq_f32(vmulq_f32(wr, bi), wi, br);
+
+        vst1q_f32(real + half + index, vsubq_f32(ar, tr));
+        vst1q_f32(imaginary + half + index, vsubq_f32(ai, ti));
+        vst1q_f32(real + index, vaddq_f32(ar, tr));
+        vst1q_f32(imaginary + index, vaddq_f32(ai, ti));
+    }
+#elif defined(kSpectrumSSE)
+    for (; (index + 4) <= half; index += 4)
+    {
+        __m128 wr = _mm_loadu_ps(twiddleReal + index);
+        __m128 wi = _mm_loadu_ps(twiddleImaginary + index);
+        __m128 br = _mm_loadu_ps(real + half + index);
+        __m128 bi = _mm_loadu_ps(imaginary + half + index);
+        __m128 ar = _mm_loadu_ps(real + index);
+        __m128 ai = _mm_loadu_ps(imaginary + index);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+
+        _mm_storeu_ps(real + half + index, _mm_sub_ps(ar, tr));
+        _mm_storeu_ps(imaginary + half + index, _mm_sub_ps(ai, ti));
+        _mm_storeu_ps(real + index, _mm_add_ps(ar, tr));
+        _mm_storeu_ps(imaginary + index, _mm_add_ps(ai, ti));
+    }
+#endif
+
+    // The first stages, and whatever the vector loop left
+    for (; index < half; index++)
+    {
+        float br = real[half + index];
+        float bi = imaginary[half + index];
+        float tr = (twiddleReal[index] * br) - (twiddleImaginary[index] * bi);
+        float ti = (twiddleReal[index] * bi) + (twiddleImaginary[index] * br);
+
+        real[half + index] = real[index] - tr;
+        imaginary[half + index] = imaginary[index] - ti;
+        real[index] += tr;
+        imaginary[index] += ti;
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_SpectrumAddPeak
+// =================================================================================================
+void SenseHAT_SpectrumAddPeak (tSenseHAT_AxisSpectrum* spectrum,
+                               uint32_t peakCount,
+                               float frequency,
+                               float power)
+{
+    uint32_t position = spectrum->peakCount;
+
+    // Keep the peaks sorted, strongest first
+    if ((position < peakCount) || (power > spectrum->peaks[peakCount - 1].power))
+    {
+        if (position == peakCount)
+        {
+            position--;
+        }
+        else
+        {
+            spectrum->peakCount++;
+        }
+        while ((position > 0) && (spectrum->peaks[position - 1].power < power))
+        {
+            spectrum->peaks[position] = spectrum->peaks[position - 1];
+            position--;
+        }
+        spectrum->peaks[position].frequency = frequency;
+        spectrum->peaks[position].power = power;
+    }
+    return;
+}
+
+// =================================================================================================
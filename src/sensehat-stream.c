@@ -0,0 +1,596 @@
+// ==================================================================================================
+//
+//  sensehat-stream.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the raw frame stream player of the
+//      Raspberry Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-stream.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the raw frame stream player of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// Number of pixels in a frame
+#define kStreamPixels           64
+
+// Largest frame size in bytes
+#define kStreamFrameSizeMax     (kStreamPixels * 3)
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_StreamReader
+static void* SenseHAT_StreamReader (void* argument);
+
+// SenseHAT_StreamPresenter
+static void* SenseHAT_StreamPresenter (void* argument);
+
+// SenseHAT_StreamShow
+static int32_t SenseHAT_StreamShow (tSenseHAT_InstancePrivate* instancePrivate,
+                                    tSenseHAT_StreamFormat format,
+                                    const uint8_t* frame);
+
+// SenseHAT_StreamWaitUntil
+static void SenseHAT_StreamWaitUntil (tSenseHAT_Stream* stream,
+                                      double wakeTime);
+
+// SenseHAT_StreamJoin
+static void SenseHAT_StreamJoin (tSenseHAT_Stream* stream);
+
+// =================================================================================================
+//  SenseHAT_StreamStart
+// =================================================================================================
+int32_t SenseHAT_StreamStart (const tSenseHAT_Instance instance,
+                              int32_t fd,
+                              tSenseHAT_StreamFormat format,
+                              double fps,
+                              uint32_t bufferFrames)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (fd >= 0) &&
+        ((format == eSenseHAT_StreamFormatRGB888) || (format == eSenseHAT_StreamFormatRGB565)) &&
+        (fps > 0.0) &&
+        (fps <= kSenseHAT_StreamFrameRateMax) &&
+        (bufferFrames > 0) &&
+        (bufferFrames <= kSenseHAT_StreamBufferFramesMax))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Stream* stream = &(instancePrivate->stream);
+        uint32_t frameSize = (format == eSenseHAT_StreamFormatRGB888) ? (kStreamPixels * 3) : (kStreamPixels * 2);
+        uint8_t* frames = NULL;
+        int wakeFd = -1;
+        struct stat status;
+
+        if (fstat(fd, &status) == 0)
+        {
+            frames = (uint8_t*)malloc(bufferFrames * frameSize);
+            if (frames != NULL)
+            {
+                wakeFd = eventfd(0, EFD_CLOEXEC);
+                if (wakeFd < 0)
+                {
+                    // eventfd failed
+                    result = errno;
+                }
+            }
+            else    // malloc failed
+            {
+                result = ENOMEM;
+            }
+        }
+        else    // fstat failed
+        {
+            result = errno;
+        }
+
+        if (result == 0)
+        {
+            // Get a lock
+            (void)pthread_mutex_lock(&(stream->mutex));
+
+            // Clear away a stream that has finished by itself
+            if (stream->running && stream->finished)
+            {
+                (void)pthread_mutex_unlock(&(stream->mutex));
+                SenseHAT_StreamJoin(stream);
+                (void)pthread_mutex_lock(&(stream->mutex));
+            }
+
+            // Is a stream already playing?
+            if (!stream->running)
+            {
+                free((void*)(stream->frames));
+                stream->frames = frames;
+                stream->bufferFrames = bufferFrames;
+                stream->head = 0;
+                stream->count = 0;
+                stream->wakeFd = wakeFd;
+                stream->fd = fd;
+                stream->format = format;
+                stream->frameSize = frameSize;
+                stream->waitForSpace = S_ISREG(status.st_mode);
+                stream->period = 1.0 / fps;
+                stream->stopRequested = false;
+                stream->finished = false;
+                stream->startTime = SenseHAT_GetMonotonicTime();
+                stream->endTime = stream->startTime;
+                memset(&(stream->statistics), 0, sizeof(tSenseHAT_StreamStatistics));
+                stream->running = true;
+                frames = NULL;
+                wakeFd = -1;
+
+                // Start the stream threads
+                result = pthread_create(&(stream->reader), NULL, SenseHAT_StreamReader, instancePrivate);
+                if (result == 0)
+                {
+                    result = pthread_create(&(stream->presenter), NULL, SenseHAT_StreamPresenter, instancePrivate);
+                    if (result != 0)
+                    {
+                        // pthread_create failed; take the reader back down
+                        stream->stopRequested = true;
+                        (void)pthread_cond_broadcast(&(stream->space));
+                        (void)pthread_mutex_unlock(&(stream->mutex));
+                        (void)eventfd_write(stream->wakeFd, 1);
+                        (void)pthread_join(stream->reader, NULL);
+                        (void)pthread_mutex_lock(&(stream->mutex));
+                    }
+                }
+                if (result != 0)
+                {
+                    // pthread_create failed
+                    (void)close(stream->wakeFd);
+                    stream->wakeFd = -1;
+                    stream->stopRequested = false;
+                    stream->running = false;
+                }
+            }
+            else    // Already playing
+            {
+                result = EBUSY;
+            }
+
+            // Release our lock
+            (void)pthread_mutex_unlock(&(stream->mutex));
+        }
+
+        // Clean up whatever wasn't handed over
+        if (wakeFd >= 0)
+        {
+            (void)close(wakeFd);
+        }
+        free((void*)frames);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamStop
+// =================================================================================================
+int32_t SenseHAT_StreamStop (const tSenseHAT_Instance instance)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if (instance != NULL)
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Stream* stream = &(instancePrivate->stream);
+        bool running = false;
+
+        // Ask the stream threads to stop; the reader may be waiting on the stream, so it's woken
+        // through its eventfd as well
+        (void)pthread_mutex_lock(&(stream->mutex));
+        running = stream->running;
+        if (running)
+        {
+            stream->stopRequested = true;
+            (void)pthread_cond_signal(&(stream->condition));
+            (void)pthread_cond_broadcast(&(stream->space));
+            (void)eventfd_write(stream->wakeFd, 1);
+        }
+        (void)pthread_mutex_unlock(&(stream->mutex));
+
+        // Wait for them to finish
+        if (running)
+        {
+            SenseHAT_StreamJoin(stream);
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamGetStatistics
+// =================================================================================================
+int32_t SenseHAT_StreamGetStatistics (const tSenseHAT_Instance instance,
+                                      tSenseHAT_StreamStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Stream* stream = &(instancePrivate->stream);
+        double elapsed = 0.0;
+
+        (void)pthread_mutex_lock(&(stream->mutex));
+        *statistics = stream->statistics;
+        statistics->playing = stream->running && !(stream->finished);
+        elapsed = (statistics->playing ? SenseHAT_GetMonotonicTime() : stream->endTime) - stream->startTime;
+        statistics->fps = (elapsed > 0.0) ? ((double)(statistics->framesShown) / elapsed) : 0.0;
+        (void)pthread_mutex_unlock(&(stream->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamInitialize
+// =================================================================================================
+int32_t SenseHAT_StreamInitialize (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Stream* stream = &(instancePrivate->stream);
+        pthread_condattr_t conditionAttributes;
+
+        // Setup
+        memset(stream, 0, sizeof(tSenseHAT_Stream));
+        stream->wakeFd = -1;
+        stream->fd = -1;
+
+        // The presenter paces itself against the monotonic clock
+        (void)pthread_mutex_init(&(stream->mutex), NULL);
+        (void)pthread_condattr_init(&conditionAttributes);
+        (void)pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+        (void)pthread_cond_init(&(stream->condition), &conditionAttributes);
+        (void)pthread_condattr_destroy(&conditionAttributes);
+        (void)pthread_cond_init(&(stream->space), NULL);
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamRelease
+// =================================================================================================
+void SenseHAT_StreamRelease (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        tSenseHAT_Stream* stream = &(instancePrivate->stream);
+
+        // Make sure the stream threads are gone
+        (void)SenseHAT_StreamStop((tSenseHAT_Instance)instancePrivate);
+
+        // Clean up
+        free((void*)(stream->frames));
+        stream->frames = NULL;
+        (void)pthread_cond_destroy(&(stream->space));
+        (void)pthread_cond_destroy(&(stream->condition));
+        (void)pthread_mutex_destroy(&(stream->mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamReader
+// =================================================================================================
+void* SenseHAT_StreamReader (void* argument)
+{
+    tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)argument;
+    tSenseHAT_Stream* stream = &(instancePrivate->stream);
+    uint8_t frame[kStreamFrameSizeMax];
+    uint32_t filled = 0;
+    int32_t status = 0;
+    bool done = false;
+
+    while (!done)
+    {
+        struct pollfd fds[2];
+
+        // Wait for data, or to be woken up to stop
+        fds[0].fd = stream->fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = stream->wakeFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                // poll failed
+                status = errno;
+                done = true;
+            }
+        }
+        else if (fds[1].revents != 0)
+        {
+            done = true;
+        }
+        else if (fds[0].revents != 0)
+        {
+            ssize_t count = read(stream->fd, frame + filled, stream->frameSize - filled);
+            if (count > 0)
+            {
+                filled += (uint32_t)count;
+            }
+            else if (count == 0)
+            {
+                // End of the stream
+                done = true;
+            }
+            else if ((errno != EINTR) && (errno != EAGAIN))
+            {
+                // read failed
+                status = errno;
+                done = true;
+            }
+        }
+
+        // Queue each whole frame
+        if (!done && (filled == stream->frameSize))
+        {
+            (void)pthread_mutex_lock(&(stream->mutex));
+
+            // A file can't be outrun, so it waits for room; anything else replaces the oldest
+            // frame
+            while (stream->waitForSpace && (stream->count == stream->bufferFrames) && !(stream->stopRequested))
+            {
+                (void)pthread_cond_wait(&(stream->space), &(stream->mutex));
+            }
+            if (stream->count == stream->bufferFrames)
+            {
+                stream->head = (stream->head + 1) % stream->bufferFrames;
+                stream->count--;
+                stream->statistics.framesDropped++;
+            }
+            memcpy(stream->frames + (((stream->head + stream->count) % stream->bufferFrames) * stream->frameSize),
+                   frame, stream->frameSize);
+            stream->count++;
+            stream->statistics.framesRead++;
+            done = stream->stopRequested;
+            (void)pthread_mutex_unlock(&(stream->mutex));
+            filled = 0;
+        }
+    }
+
+    // Let the presenter drain the ring
+    (void)pthread_mutex_lock(&(stream->mutex));
+    stream->statistics.endOfStream = true;
+    if (status != 0)
+    {
+        stream->statistics.lastError = status;
+    }
+    (void)pthread_cond_signal(&(stream->condition));
+    (void)pthread_mutex_unlock(&(stream->mutex));
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamPresenter
+// =================================================================================================
+void* SenseHAT_StreamPresenter (void* argument)
+{
+    tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)argument;
+    tSenseHAT_Stream* stream = &(instancePrivate->stream);
+    uint8_t frame[kStreamFrameSizeMax];
+    double due = 0.0;
+
+    // Get a lock
+    (void)pthread_mutex_lock(&(stream->mutex));
+    due = stream->startTime;
+
+    // Frame deadlines are accumulated from the start time, so lateness never compounds
+    while (!stream->stopRequested)
+    {
+        double now = 0.0;
+
+        SenseHAT_StreamWaitUntil(stream, due);
+        if (stream->stopRequested)
+        {
+            break;
+        }
+
+        if (stream->count > 0)
+        {
+            int32_t status = 0;
+
+            // Take the oldest frame, and show it without holding up the reader
+            memcpy(frame, stream->frames + (stream->head * stream->frameSize), stream->frameSize);
+            stream->head = (stream->head + 1) % stream->bufferFrames;
+            stream->count--;
+            (void)pthread_cond_signal(&(stream->space));
+            (void)pthread_mutex_unlock(&(stream->mutex));
+            status = SenseHAT_StreamShow(instancePrivate, stream->format, frame);
+            (void)pthread_mutex_lock(&(stream->mutex));
+
+            stream->statistics.framesShown++;
+            if (status != 0)
+            {
+                stream->statistics.lastError = status;
+            }
+        }
+        else if (stream->statistics.endOfStream)
+        {
+            break;
+        }
+        else
+        {
+            stream->statistics.underruns++;
+        }
+
+        // Move on to the next slot; slots missed entirely are skipped rather than rushed through
+        due += stream->period;
+        now = SenseHAT_GetMonotonicTime();
+        while ((due + stream->period) <= now)
+        {
+            due += stream->period;
+        }
+    }
+    stream->endTime = SenseHAT_GetMonotonicTime();
+    stream->finished = true;
+
+    // Release our lock
+    (void)pthread_mutex_unlock(&(stream->mutex));
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamShow
+// =================================================================================================
+int32_t SenseHAT_StreamShow (tSenseHAT_InstancePrivate* instancePrivate,
+                             tSenseHAT_StreamFormat format,
+                             const uint8_t* frame)
+{
+    int32_t result = 0;
+    uint16_t device[kStreamPixels];
+
+    // Frames go straight to the framebuffer if it's there
+    if (format == eSenseHAT_StreamFormatRGB888)
+    {
+        if (instancePrivate->framebuffer.pixels != NULL)
+        {
+            result = SenseHAT_ColorConvertRGB888(NULL, frame, kStreamPixels, device);
+            if (result == 0)
+            {
+                result = SenseHAT_FramebufferWriteRGB565(instancePrivate, device);
+            }
+        }
+        else
+        {
+            tSenseHAT_LEDPixelArray pixels;
+            uint32_t index = 0;
+
+            for (index = 0; index < kStreamPixels; index++)
+            {
+                pixels[index].red = frame[(index * 3) + 0];
+                pixels[index].green = frame[(index * 3) + 1];
+                pixels[index].blue = frame[(index * 3) + 2];
+            }
+            result = SenseHAT_LEDSetPixels((tSenseHAT_Instance)instancePrivate, pixels);
+        }
+    }
+    else
+    {
+        memcpy(device, frame, sizeof(device));
+        if (instancePrivate->framebuffer.pixels != NULL)
+        {
+            result = SenseHAT_FramebufferWriteRGB565(instancePrivate, device);
+        }
+        else
+        {
+            tSenseHAT_LEDPixelArray pixels;
+
+            SenseHAT_ColorExpandRGB565(device, kStreamPixels, pixels);
+            result = SenseHAT_LEDSetPixels((tSenseHAT_Instance)instancePrivate, pixels);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamWaitUntil
+// =================================================================================================
+void SenseHAT_StreamWaitUntil (tSenseHAT_Stream* stream,
+                               double wakeTime)
+{
+    struct timespec deadline;
+
+    // Sleep until the deadline, or until we're asked to stop
+    deadline.tv_sec = (time_t)wakeTime;
+    deadline.tv_nsec = (long)((wakeTime - (double)(deadline.tv_sec)) * 1000000000.0);
+    while (!stream->stopRequested)
+    {
+        if (pthread_cond_timedwait(&(stream->condition),
+                                   &(stream->mutex),
+                                   &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_StreamJoin
+// =================================================================================================
+void SenseHAT_StreamJoin (tSenseHAT_Stream* stream)
+{
+    (void)pthread_join(stream->presenter, NULL);
+
+    // The reader may still be waiting on the stream after an early end
+    (void)pthread_mutex_lock(&(stream->mutex));
+    stream->stopRequested = true;
+    (void)pthread_cond_broadcast(&(stream->space));
+    (void)eventfd_write(stream->wakeFd, 1);
+    (void)pthread_mutex_unlock(&(stream->mutex));
+    (void)pthread_join(stream->reader, NULL);
+
+    (void)pthread_mutex_lock(&(stream->mutex));
+    (void)close(stream->wakeFd);
+    stream->wakeFd = -1;
+    stream->running = false;
+    stream->stopRequested = false;
+    (void)pthread_mutex_unlock(&(stream->mutex));
+    return;
+}
+
+// =================================================================================================
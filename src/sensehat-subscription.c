@@ -0,0 +1,428 @@
+// ==================================================================================================
+//
+//  sensehat-subscription.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the sensor subscriptions of the Raspberry
+//      Pi Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-subscription.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the sensor subscriptions of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <memory.h>
+#include <sys/eventfd.h>
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_SubscriptionEvaluate
+static bool SenseHAT_SubscriptionEvaluate (tSenseHAT_SubscriptionState* state,
+                                           double timestamp,
+                                           double value,
+                                           double* change);
+
+// SenseHAT_SubscriptionRate
+static bool SenseHAT_SubscriptionRate (tSenseHAT_SubscriptionState* state,
+                                       double timestamp,
+                                       double value,
+                                       double* rate);
+
+// =================================================================================================
+//  SenseHAT_SamplerSubscribe
+// =================================================================================================
+int32_t SenseHAT_SamplerSubscribe (const tSenseHAT_Instance instance,
+                                   const tSenseHAT_Subscription* subscription,
+                                   tSenseHAT_SubscriptionCallback callback,
+                                   void* context,
+                                   uint32_t* subscriptionId)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (subscription != NULL) &&
+        ((subscription->channel == eSenseHAT_ChannelHumidity) ||
+         (subscription->channel == eSenseHAT_ChannelTemperature) ||
+         (subscription->channel == eSenseHAT_ChannelPressure)) &&
+        ((uint32_t)(subscription->type) <= eSenseHAT_SubscriptionFallRate) &&
+        ((subscription->type <= eSenseHAT_SubscriptionBelow) || (subscription->threshold > 0.0)) &&
+        ((subscription->type < eSenseHAT_SubscriptionRiseRate) || (subscription->window > 0.0)) &&
+        (subscription->hysteresis >= 0.0) &&
+        (subscriptionId != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        uint32_t index = 0;
+
+        // Setup
+        *subscriptionId = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        // Find a free slot
+        while ((index < kSenseHAT_SubscriptionsMax) && (sampler->subscriptions[index].id != 0))
+        {
+            index++;
+        }
+        if (index < kSenseHAT_SubscriptionsMax)
+        {
+            tSenseHAT_SubscriptionState* state = &(sampler->subscriptions[index]);
+
+            // Identifiers are never 0, and aren't reused until they wrap
+            sampler->lastSubscriptionId++;
+            if (sampler->lastSubscriptionId == 0)
+            {
+                sampler->lastSubscriptionId = 1;
+            }
+            memset(state, 0, sizeof(tSenseHAT_SubscriptionState));
+            state->id = sampler->lastSubscriptionId;
+            state->subscription = *subscription;
+            state->callback = callback;
+            state->context = context;
+            *subscriptionId = state->id;
+        }
+        else    // No room
+        {
+            result = ENOSPC;
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerUnsubscribe
+// =================================================================================================
+int32_t SenseHAT_SamplerUnsubscribe (const tSenseHAT_Instance instance,
+                                     uint32_t subscriptionId)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (subscriptionId != 0))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        uint32_t index = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        while ((index < kSenseHAT_SubscriptionsMax) && (sampler->subscriptions[index].id != subscriptionId))
+        {
+            index++;
+        }
+        if (index < kSenseHAT_SubscriptionsMax)
+        {
+            memset(&(sampler->subscriptions[index]), 0, sizeof(tSenseHAT_SubscriptionState));
+        }
+        else    // Not found
+        {
+            result = ENOENT;
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SamplerGetNotifications
+// =================================================================================================
+int32_t SenseHAT_SamplerGetNotifications (const tSenseHAT_Instance instance,
+                                          tSenseHAT_Notification* notifications,
+                                          int32_t capacity,
+                                          int32_t* notificationCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (notifications != NULL) &&
+        (capacity > 0) &&
+        (notificationCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sampler* sampler = &(instancePrivate->sampler);
+        int32_t count = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(sampler->mutex));
+
+        while ((count < capacity) && (sampler->notificationCount > 0))
+        {
+            notifications[count] = sampler->notifications[sampler->notificationIndex];
+            sampler->notificationIndex = (sampler->notificationIndex + 1) % kSenseHAT_NotificationQueueLength;
+            sampler->notificationCount--;
+            count++;
+        }
+        *notificationCount = count;
+
+        // Acknowledge the notifications once they've all been retrieved
+        if (sampler->notificationCount > 0)
+        {
+            result = ENOBUFS;
+        }
+        else if (sampler->subscriptionFd >= 0)
+        {
+            eventfd_t value = 0;
+            (void)eventfd_read(sampler->subscriptionFd, &value);
+        }
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(sampler->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_SubscriptionSample
+// =================================================================================================
+uint32_t SenseHAT_SubscriptionSample (tSenseHAT_Sampler* sampler,
+                                      const tSenseHAT_Sample* sample,
+                                      tSenseHAT_SubscriptionDelivery* deliveries)
+{
+    uint32_t count = 0;
+    uint32_t index = 0;
+
+    for (index = 0; index < kSenseHAT_SubscriptionsMax; index++)
+    {
+        tSenseHAT_SubscriptionState* state = &(sampler->subscriptions[index]);
+        uint32_t channel = state->subscription.channel;
+
+        // Is this subscription's channel in the sample?
+        if ((state->id != 0) && ((sample->channels & channel) != 0))
+        {
+            double value = (channel == eSenseHAT_ChannelHumidity) ? sample->humidity :
+                           ((channel == eSenseHAT_ChannelTemperature) ? sample->temperature : sample->pressure);
+            double change = 0.0;
+
+            if (SenseHAT_SubscriptionEvaluate(state, sample->timestamp, value, &change))
+            {
+                tSenseHAT_Notification* notification = &(deliveries[count].notification);
+
+                notification->timestamp = sample->timestamp;
+                notification->subscriptionId = state->id;
+                notification->channel = channel;
+                notification->type = state->subscription.type;
+                notification->value = value;
+                notification->change = change;
+                deliveries[count].callback = state->callback;
+                deliveries[count].context = state->context;
+
+                // Queue it, dropping the oldest if nobody's keeping up
+                if (sampler->notificationCount == kSenseHAT_NotificationQueueLength)
+                {
+                    sampler->notificationIndex = (sampler->notificationIndex + 1) % kSenseHAT_NotificationQueueLength;
+                    sampler->notificationCount--;
+                }
+                sampler->notifications[(sampler->notificationIndex + sampler->notificationCount) %
+                                       kSenseHAT_NotificationQueueLength] = *notification;
+                sampler->notificationCount++;
+                count++;
+            }
+        }
+    }
+    if ((count > 0) && (sampler->subscriptionFd >= 0))
+    {
+        (void)eventfd_write(sampler->subscriptionFd, 1);
+    }
+    return count;
+}
+
+// =================================================================================================
+//  SenseHAT_SubscriptionEvaluate
+// =================================================================================================
+bool SenseHAT_SubscriptionEvaluate (tSenseHAT_SubscriptionState* state,
+                                    double timestamp,
+                                    double value,
+                                    double* change)
+{
+    const tSenseHAT_Subscription* subscription = &(state->subscription);
+    bool notify = false;
+    double rate = 0.0;
+
+    switch (subscription->type)
+    {
+        case eSenseHAT_SubscriptionAbove:
+            // The first reading only decides whether we're above already
+            if (!state->primed)
+            {
+                state->armed = (value <= subscription->threshold);
+            }
+            else if (state->armed && (value > subscription->threshold))
+            {
+                state->armed = false;
+                notify = true;
+            }
+            else if (value < (subscription->threshold - subscription->hysteresis))
+            {
+                state->armed = true;
+            }
+            break;
+
+        case eSenseHAT_SubscriptionBelow:
+            if (!state->primed)
+            {
+                state->armed = (value >= subscription->threshold);
+            }
+            else if (state->armed && (value < subscription->threshold))
+            {
+                state->armed = false;
+                notify = true;
+            }
+            else if (value > (subscription->threshold + subscription->hysteresis))
+            {
+                state->armed = true;
+            }
+            break;
+
+        case eSenseHAT_SubscriptionChange:
+            if (!state->primed)
+            {
+                state->reference = value;
+            }
+            else if ((value - state->reference) > subscription->threshold)
+            {
+                notify = true;
+            }
+            else if ((state->reference - value) > subscription->threshold)
+            {
+                notify = true;
+            }
+            if (notify)
+            {
+                *change = value - state->reference;
+                state->reference = value;
+            }
+            break;
+
+        default:
+            if (!state->primed)
+            {
+                state->armed = true;
+            }
+            if (SenseHAT_SubscriptionRate(state, timestamp, value, &rate))
+            {
+                // Rises are positive, falls negative
+                double signedRate = (subscription->type == eSenseHAT_SubscriptionRiseRate) ? rate : -rate;
+
+                if (state->armed && (signedRate > subscription->threshold))
+                {
+                    state->armed = false;
+                    notify = true;
+                    *change = rate;
+                }
+                else if (signedRate < (subscription->threshold - subscription->hysteresis))
+                {
+                    state->armed = true;
+                }
+            }
+            break;
+    }
+    state->primed = true;
+    return notify;
+}
+
+// =================================================================================================
+//  SenseHAT_SubscriptionRate
+// =================================================================================================
+bool SenseHAT_SubscriptionRate (tSenseHAT_SubscriptionState* state,
+                                double timestamp,
+                                double value,
+                                double* rate)
+{
+    const double spacing = state->subscription.window / (double)(kSenseHAT_SubscriptionHistory - 1);
+    bool valid = false;
+    uint32_t newest = (state->historyIndex + state->historyCount + kSenseHAT_SubscriptionHistory - 1) %
+                      kSenseHAT_SubscriptionHistory;
+
+    // Keep readings spread evenly over the window, so the history covers it whatever the
+    // sampling interval
+    if ((state->historyCount == 0) || ((timestamp - state->times[newest]) >= spacing))
+    {
+        if (state->historyCount == kSenseHAT_SubscriptionHistory)
+        {
+            state->historyIndex = (state->historyIndex + 1) % kSenseHAT_SubscriptionHistory;
+            state->historyCount--;
+        }
+        newest = (state->historyIndex + state->historyCount) % kSenseHAT_SubscriptionHistory;
+        state->times[newest] = timestamp;
+        state->values[newest] = value;
+        state->historyCount++;
+
+        // Fit a line once the window is full; times are relative to the oldest reading to keep
+        // the sums well conditioned
+        if (state->historyCount == kSenseHAT_SubscriptionHistory)
+        {
+            double origin = state->times[state->historyIndex];
+            double sumT = 0.0;
+            double sumV = 0.0;
+            double sumTT = 0.0;
+            double sumTV = 0.0;
+            double denominator = 0.0;
+            uint32_t index = 0;
+
+            for (index = 0; index < kSenseHAT_SubscriptionHistory; index++)
+            {
+                double t = state->times[index] - origin;
+                double v = state->values[index];
+
+                sumT += t;
+                sumV += v;
+                sumTT += t * t;
+                sumTV += t * v;
+            }
+            denominator = (kSenseHAT_SubscriptionHistory * sumTT) - (sumT * sumT);
+            if (denominator > 0.0)
+            {
+                // Per hour
+                *rate = 3600.0 * ((kSenseHAT_SubscriptionHistory * sumTV) - (sumT * sumV)) / denominator;
+                valid = true;
+            }
+        }
+    }
+    return valid;
+}
+
+// =================================================================================================
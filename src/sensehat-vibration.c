@@ -0,0 +1,701 @@
+// ==================================================================================================
+//
+//  sensehat-vibration.c
+//
+//  Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//
+//  Supported host operating systems:
+//      Raspbian Stretch or later
+//
+//  Description:
+//      This file contains function implementations for the vibration capture of the Raspberry Pi
+//      Sense HAT C library.
+//
+//  Notes:
+//      1)  Requires ANSI C99 (or better) compliant compilers.
+//      2)  This library requires Python 2.x/3.x or later.
+//
+// =================================================================================================
+//! @file sensehat-vibration.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains function implementations for the vibration capture of the
+//! Raspberry Pi Sense HAT C library.
+//! @date 2019-09-25
+//! @copyright Copyright (c) 2019 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sensehat.h"
+#include "sensehat-private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <memory.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+// I2C bus the Sense HAT is on, and the address of the LSM9DS1 accelerometer and gyroscope
+static const char* kVibrationBusPath        = "/dev/i2c-1";
+static const uint16_t kVibrationAddress     = 0x6A;
+
+// LSM9DS1 accelerometer and gyroscope registers
+#define kLSM9DS1_WhoAmI             0x0F
+#define kLSM9DS1_CtrlReg1G          0x10
+#define kLSM9DS1_CtrlReg6XL         0x20
+#define kLSM9DS1_CtrlReg8           0x22
+#define kLSM9DS1_CtrlReg9           0x23
+#define kLSM9DS1_OutXXL             0x28
+#define kLSM9DS1_FIFOCtrl           0x2E
+#define kLSM9DS1_FIFOSrc            0x2F
+
+// LSM9DS1 register values
+#define kLSM9DS1_WhoAmIValue        0x68    // WHO_AM_I of the accelerometer and gyroscope
+#define kLSM9DS1_ODRXL952           0xC0    // CTRL_REG6_XL: 952 Hz output data rate
+#define kLSM9DS1_AddressIncrement   0x04    // CTRL_REG8: IF_ADD_INC
+#define kLSM9DS1_FIFOEnable         0x02    // CTRL_REG9: FIFO_EN
+#define kLSM9DS1_FIFOBypass         0x00    // FIFO_CTRL: bypass mode, which also empties the FIFO
+#define kLSM9DS1_FIFOContinuous     0xC0    // FIFO_CTRL: continuous mode
+#define kLSM9DS1_FIFOOverrun        0x40    // FIFO_SRC: OVRN
+#define kLSM9DS1_FIFOLevelMask      0x3F    // FIFO_SRC: FSS
+
+// Nominal accelerometer output data rate in accelerometer-only mode
+static const double kVibrationSampleRate = 952.0;
+
+// Interval between FIFO drains; the 32 level FIFO fills in about 34 ms
+static const long kVibrationDrainInterval = 10000000;
+
+// Samples read per I2C transaction (a register write and a 6 byte read each; the kernel
+// accepts at most 42 messages per transaction)
+#define kVibrationBatchSamples  21
+
+// Number of spectra kept for SenseHAT_VibrationGetSpectra
+#define kVibrationQueueLength   16
+
+// Time measured before the sample rate estimate replaces the nominal rate
+static const double kVibrationRateSettleTime = 1.0;
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+// Capture state
+typedef struct
+{
+    pthread_t                           thread;             // Capture thread
+    pthread_mutex_t                     mutex;              // Lock protecting the members below
+    bool                                stopRequested;      // Whether the capture thread should exit
+    tSenseHAT_VibrationSpectrum         queue[kVibrationQueueLength];   // Spectra not yet retrieved
+    uint32_t                            queueIndex;         // Index of the oldest queued spectrum
+    uint32_t                            queueCount;         // Number of queued spectra
+    tSenseHAT_VibrationStatistics       statistics;         // Counters
+
+    // Only touched by the capture thread once it's running
+    int32_t                             fd;                 // I2C bus file descriptor
+    tSenseHAT_VibrationConfiguration    configuration;      // Capture configuration
+    double                              sensitivity;        // G's per LSB
+    uint8_t                             saved[5];           // Register values to restore on close
+    tSenseHAT_SpectrumPlan              plan;               // FFT plan
+    float*                              samples[3];         // Aligned blocks of samples for each axis
+    uint32_t                            sampleCount;        // Number of samples in the blocks
+    double                              blockTime;          // Time of the first sample in the blocks
+    uint32_t                            blockOverruns;      // FIFO overruns during the blocks
+    double                              firstDrainTime;     // Time of the first drain
+    uint64_t                            drainedSamples;     // Samples drained since the first drain
+}
+tSenseHAT_VibrationPrivate;
+
+// Registers saved while capturing, in the order they're restored
+static const uint8_t kVibrationSavedRegisters[5] =
+{
+    kLSM9DS1_FIFOCtrl, kLSM9DS1_CtrlReg9, kLSM9DS1_CtrlReg8, kLSM9DS1_CtrlReg6XL, kLSM9DS1_CtrlReg1G
+};
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+// SenseHAT_VibrationThread
+static void* SenseHAT_VibrationThread (void* argument);
+
+// SenseHAT_VibrationConfigure
+static int32_t SenseHAT_VibrationConfigure (tSenseHAT_VibrationPrivate* vibrationPrivate);
+
+// SenseHAT_VibrationRestore
+static void SenseHAT_VibrationRestore (tSenseHAT_VibrationPrivate* vibrationPrivate);
+
+// SenseHAT_VibrationDrain
+static int32_t SenseHAT_VibrationDrain (tSenseHAT_VibrationPrivate* vibrationPrivate);
+
+// SenseHAT_VibrationAddSamples
+static void SenseHAT_VibrationAddSamples (tSenseHAT_VibrationPrivate* vibrationPrivate,
+                                          const uint8_t* data,
+                                          uint32_t count,
+                                          double drainTime);
+
+// SenseHAT_VibrationReadRegisters
+static int32_t SenseHAT_VibrationReadRegisters (int32_t fd,
+                                                uint8_t reg,
+                                                uint8_t* data,
+                                                uint16_t length);
+
+// SenseHAT_VibrationWriteRegister
+static int32_t SenseHAT_VibrationWriteRegister (int32_t fd,
+                                                uint8_t reg,
+                                                uint8_t value);
+
+// SenseHAT_VibrationRelease
+static void SenseHAT_VibrationRelease (tSenseHAT_VibrationPrivate* vibrationPrivate);
+
+// =================================================================================================
+//  SenseHAT_VibrationOpen
+// =================================================================================================
+int32_t SenseHAT_VibrationOpen (const tSenseHAT_VibrationConfiguration* configuration,
+                                tSenseHAT_VibrationCapture* capture)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((configuration != NULL) &&
+        ((configuration->fullScale == 2) || (configuration->fullScale == 4) ||
+         (configuration->fullScale == 8) || (configuration->fullScale == 16)) &&
+        (configuration->peakCount <= kSenseHAT_SpectrumPeaksMax) &&
+        (capture != NULL))
+    {
+        // Setup
+        *capture = NULL;
+
+        // Allocate space
+        tSenseHAT_VibrationPrivate* vibrationPrivate =
+            (tSenseHAT_VibrationPrivate*)malloc(sizeof(tSenseHAT_VibrationPrivate));
+        if (vibrationPrivate != NULL)
+        {
+            uint32_t axis = 0;
+
+            // Initialize memory
+            memset(vibrationPrivate, 0, sizeof(tSenseHAT_VibrationPrivate));
+            vibrationPrivate->configuration = *configuration;
+            vibrationPrivate->fd = -1;
+            (void)pthread_mutex_init(&(vibrationPrivate->mutex), NULL);
+
+            // The plan checks the window length and type
+            result = SenseHAT_SpectrumOpen(configuration->windowLength, configuration->window,
+                                           &(vibrationPrivate->plan));
+            for (axis = 0; (axis < 3) && (result == 0); axis++)
+            {
+                if (posix_memalign((void**)&(vibrationPrivate->samples[axis]), 64,
+                                   configuration->windowLength * sizeof(float)) != 0)
+                {
+                    vibrationPrivate->samples[axis] = NULL;
+                    result = ENOMEM;
+                }
+            }
+
+            // Take over the IMU
+            if (result == 0)
+            {
+                vibrationPrivate->fd = open(kVibrationBusPath, O_RDWR | O_CLOEXEC);
+                if (vibrationPrivate->fd >= 0)
+                {
+                    result = SenseHAT_VibrationConfigure(vibrationPrivate);
+                }
+                else    // open failed
+                {
+                    result = (errno == ENOENT) ? ENODEV : errno;
+                }
+            }
+
+            // Start the capture thread
+            if (result == 0)
+            {
+                result = pthread_create(&(vibrationPrivate->thread), NULL, SenseHAT_VibrationThread, vibrationPrivate);
+                if (result != 0)
+                {
+                    // pthread_create failed
+                    SenseHAT_VibrationRestore(vibrationPrivate);
+                }
+            }
+
+            // Check for success
+            if (result == 0)
+            {
+                *capture = (tSenseHAT_VibrationCapture)vibrationPrivate;
+            }
+            else    // Clean up
+            {
+                SenseHAT_VibrationRelease(vibrationPrivate);
+            }
+        }
+        else    // malloc failed
+        {
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationGetSpectra
+// =================================================================================================
+int32_t SenseHAT_VibrationGetSpectra (tSenseHAT_VibrationCapture capture,
+                                      tSenseHAT_VibrationSpectrum* spectra,
+                                      uint32_t capacity,
+                                      uint32_t* spectrumCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((capture != NULL) &&
+        (spectra != NULL) &&
+        (spectrumCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_VibrationPrivate* vibrationPrivate = (tSenseHAT_VibrationPrivate*)capture;
+        uint32_t count = 0;
+
+        // Get a lock
+        (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+
+        while ((count < capacity) && (vibrationPrivate->queueCount > 0))
+        {
+            spectra[count] = vibrationPrivate->queue[vibrationPrivate->queueIndex];
+            vibrationPrivate->queueIndex = (vibrationPrivate->queueIndex + 1) % kVibrationQueueLength;
+            vibrationPrivate->queueCount--;
+            count++;
+        }
+        *spectrumCount = count;
+
+        // Release our lock
+        (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationGetStatistics
+// =================================================================================================
+int32_t SenseHAT_VibrationGetStatistics (tSenseHAT_VibrationCapture capture,
+                                         tSenseHAT_VibrationStatistics* statistics)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((capture != NULL) &&
+        (statistics != NULL))
+    {
+        // Get private data
+        tSenseHAT_VibrationPrivate* vibrationPrivate = (tSenseHAT_VibrationPrivate*)capture;
+
+        (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+        *statistics = vibrationPrivate->statistics;
+        (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationClose
+// =================================================================================================
+int32_t SenseHAT_VibrationClose (tSenseHAT_VibrationCapture* capture)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((capture != NULL) &&
+        (*capture != NULL))
+    {
+        // Get private data
+        tSenseHAT_VibrationPrivate* vibrationPrivate = (tSenseHAT_VibrationPrivate*)(*capture);
+
+        // Stop the capture thread
+        (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+        vibrationPrivate->stopRequested = true;
+        (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+        (void)pthread_join(vibrationPrivate->thread, NULL);
+
+        // Give the IMU back, and clean up
+        SenseHAT_VibrationRestore(vibrationPrivate);
+        SenseHAT_VibrationRelease(vibrationPrivate);
+        *capture = NULL;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationThread
+// =================================================================================================
+void* SenseHAT_VibrationThread (void* argument)
+{
+    tSenseHAT_VibrationPrivate* vibrationPrivate = (tSenseHAT_VibrationPrivate*)argument;
+    struct timespec deadline;
+    bool stopRequested = false;
+
+    // Drain at fixed multiples of the interval
+    (void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (!stopRequested)
+    {
+        int32_t result = SenseHAT_VibrationDrain(vibrationPrivate);
+
+        (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+        if (result != 0)
+        {
+            vibrationPrivate->statistics.lastError = result;
+        }
+        stopRequested = vibrationPrivate->stopRequested;
+        (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+
+        // Sleep until the next drain is due
+        deadline.tv_nsec += kVibrationDrainInterval;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        (void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    }
+    return NULL;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationConfigure
+// =================================================================================================
+int32_t SenseHAT_VibrationConfigure (tSenseHAT_VibrationPrivate* vibrationPrivate)
+{
+    int32_t result = 0;
+    int32_t fd = vibrationPrivate->fd;
+    uint8_t value = 0;
+    uint8_t scale = 0;
+    uint32_t index = 0;
+
+    // Is the IMU there?
+    result = SenseHAT_VibrationReadRegisters(fd, kLSM9DS1_WhoAmI, &value, 1);
+    if ((result == 0) && (value != kLSM9DS1_WhoAmIValue))
+    {
+        result = ENODEV;
+    }
+
+    // Save the registers we change
+    for (index = 0; (index < 5) && (result == 0); index++)
+    {
+        result = SenseHAT_VibrationReadRegisters(fd, kVibrationSavedRegisters[index],
+                                                 &(vibrationPrivate->saved[index]), 1);
+    }
+
+    if (result == 0)
+    {
+        // FS_XL and its sensitivity
+        switch (vibrationPrivate->configuration.fullScale)
+        {
+            case 2:
+                scale = 0x00;
+                vibrationPrivate->sensitivity = 0.000061;
+                break;
+            case 4:
+                scale = 0x10;
+                vibrationPrivate->sensitivity = 0.000122;
+                break;
+            case 8:
+                scale = 0x18;
+                vibrationPrivate->sensitivity = 0.000244;
+                break;
+            default:
+                scale = 0x08;
+                vibrationPrivate->sensitivity = 0.000732;
+                break;
+        }
+
+        // Power the gyroscope down, so the accelerometer runs alone at its own rate, and
+        // stream it through the FIFO
+        result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_FIFOCtrl, kLSM9DS1_FIFOBypass);
+        if (result == 0)
+        {
+            result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_CtrlReg1G, 0x00);
+        }
+        if (result == 0)
+        {
+            result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_CtrlReg6XL, kLSM9DS1_ODRXL952 | scale);
+        }
+        if (result == 0)
+        {
+            result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_CtrlReg8,
+                                                     vibrationPrivate->saved[2] | kLSM9DS1_AddressIncrement);
+        }
+        if (result == 0)
+        {
+            result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_CtrlReg9,
+                                                     vibrationPrivate->saved[1] | kLSM9DS1_FIFOEnable);
+        }
+        if (result == 0)
+        {
+            result = SenseHAT_VibrationWriteRegister(fd, kLSM9DS1_FIFOCtrl, kLSM9DS1_FIFOContinuous);
+        }
+        if (result != 0)
+        {
+            SenseHAT_VibrationRestore(vibrationPrivate);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationRestore
+// =================================================================================================
+void SenseHAT_VibrationRestore (tSenseHAT_VibrationPrivate* vibrationPrivate)
+{
+    uint32_t index = 0;
+
+    // Empty the FIFO first, then put everything back
+    (void)SenseHAT_VibrationWriteRegister(vibrationPrivate->fd, kLSM9DS1_FIFOCtrl, kLSM9DS1_FIFOBypass);
+    for (index = 0; index < 5; index++)
+    {
+        (void)SenseHAT_VibrationWriteRegister(vibrationPrivate->fd, kVibrationSavedRegisters[index],
+                                              vibrationPrivate->saved[index]);
+    }
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationDrain
+// =================================================================================================
+int32_t SenseHAT_VibrationDrain (tSenseHAT_VibrationPrivate* vibrationPrivate)
+{
+    int32_t result = 0;
+    uint8_t status = 0;
+
+    // How much is in the FIFO?
+    result = SenseHAT_VibrationReadRegisters(vibrationPrivate->fd, kLSM9DS1_FIFOSrc, &status, 1);
+    if (result == 0)
+    {
+        uint32_t count = status & kLSM9DS1_FIFOLevelMask;
+        uint8_t data[kVibrationBatchSamples * 6];
+        struct timespec now;
+
+        (void)clock_gettime(CLOCK_REALTIME, &now);
+        if ((status & kLSM9DS1_FIFOOverrun) != 0)
+        {
+            vibrationPrivate->blockOverruns++;
+            (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+            vibrationPrivate->statistics.overruns++;
+            (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+        }
+
+        // Read the samples in as few transactions as possible; each 6 byte read from OUT_X_XL
+        // pops one sample
+        while ((count > 0) && (result == 0))
+        {
+            struct i2c_msg messages[2 * kVibrationBatchSamples];
+            struct i2c_rdwr_ioctl_data transaction;
+            uint8_t reg = kLSM9DS1_OutXXL;
+            uint32_t batch = (count < kVibrationBatchSamples) ? count : kVibrationBatchSamples;
+            uint32_t index = 0;
+
+            for (index = 0; index < batch; index++)
+            {
+                messages[2 * index].addr = kVibrationAddress;
+                messages[2 * index].flags = 0;
+                messages[2 * index].len = 1;
+                messages[2 * index].buf = &reg;
+                messages[(2 * index) + 1].addr = kVibrationAddress;
+                messages[(2 * index) + 1].flags = I2C_M_RD;
+                messages[(2 * index) + 1].len = 6;
+                messages[(2 * index) + 1].buf = data + (6 * index);
+            }
+            transaction.msgs = messages;
+            transaction.nmsgs = 2 * batch;
+            if (ioctl(vibrationPrivate->fd, I2C_RDWR, &transaction) >= 0)
+            {
+                count -= batch;
+                SenseHAT_VibrationAddSamples(vibrationPrivate, data, batch,
+                                             (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0) -
+                                             ((double)count / kVibrationSampleRate));
+            }
+            else    // ioctl failed
+            {
+                result = errno;
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationAddSamples
+// =================================================================================================
+void SenseHAT_VibrationAddSamples (tSenseHAT_VibrationPrivate* vibrationPrivate,
+                                   const uint8_t* data,
+                                   uint32_t count,
+                                   double drainTime)
+{
+    uint32_t windowLength = vibrationPrivate->configuration.windowLength;
+    double sampleRate = kVibrationSampleRate;
+    uint32_t index = 0;
+
+    // Measure the real output data rate, which can be a few percent off
+    if (vibrationPrivate->drainedSamples == 0)
+    {
+        vibrationPrivate->firstDrainTime = drainTime;
+    }
+    else if ((drainTime - vibrationPrivate->firstDrainTime) >= kVibrationRateSettleTime)
+    {
+        sampleRate = (double)(vibrationPrivate->drainedSamples) / (drainTime - vibrationPrivate->firstDrainTime);
+    }
+    vibrationPrivate->drainedSamples += count;
+
+    for (index = 0; index < count; index++)
+    {
+        const uint8_t* sample = data + (6 * index);
+        uint32_t axis = 0;
+
+        // The newest sample was taken at drainTime
+        if (vibrationPrivate->sampleCount == 0)
+        {
+            vibrationPrivate->blockTime = drainTime - ((double)(count - 1 - index) / sampleRate);
+        }
+        for (axis = 0; axis < 3; axis++)
+        {
+            int16_t raw = (int16_t)((uint16_t)sample[2 * axis] | ((uint16_t)sample[(2 * axis) + 1] << 8));
+            vibrationPrivate->samples[axis][vibrationPrivate->sampleCount] = (float)(raw * vibrationPrivate->sensitivity);
+        }
+        vibrationPrivate->sampleCount++;
+
+        // Analyse each full block
+        if (vibrationPrivate->sampleCount == windowLength)
+        {
+            tSenseHAT_VibrationSpectrum spectrum;
+
+            memset(&spectrum, 0, sizeof(tSenseHAT_VibrationSpectrum));
+            spectrum.timestamp = vibrationPrivate->blockTime;
+            spectrum.sampleRate = sampleRate;
+            spectrum.windowLength = windowLength;
+            spectrum.overruns = vibrationPrivate->blockOverruns;
+            for (axis = 0; axis < 3; axis++)
+            {
+                (void)SenseHAT_SpectrumCompute(vibrationPrivate->plan, vibrationPrivate->samples[axis], sampleRate,
+                                               vibrationPrivate->configuration.peakCount, &(spectrum.axes[axis]), NULL);
+            }
+            vibrationPrivate->sampleCount = 0;
+            vibrationPrivate->blockOverruns = 0;
+
+            // Queue it, dropping the oldest if nobody's keeping up
+            (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+            if (vibrationPrivate->queueCount == kVibrationQueueLength)
+            {
+                vibrationPrivate->queueIndex = (vibrationPrivate->queueIndex + 1) % kVibrationQueueLength;
+                vibrationPrivate->queueCount--;
+                vibrationPrivate->statistics.dropped++;
+            }
+            vibrationPrivate->queue[(vibrationPrivate->queueIndex + vibrationPrivate->queueCount) % kVibrationQueueLength] = spectrum;
+            vibrationPrivate->queueCount++;
+            vibrationPrivate->statistics.spectra++;
+            (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+        }
+    }
+
+    (void)pthread_mutex_lock(&(vibrationPrivate->mutex));
+    vibrationPrivate->statistics.samples += count;
+    (void)pthread_mutex_unlock(&(vibrationPrivate->mutex));
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationReadRegisters
+// =================================================================================================
+int32_t SenseHAT_VibrationReadRegisters (int32_t fd,
+                                         uint8_t reg,
+                                         uint8_t* data,
+                                         uint16_t length)
+{
+    int32_t result = 0;
+    struct i2c_msg messages[2];
+    struct i2c_rdwr_ioctl_data transaction;
+
+    // Write the register address, then read
+    messages[0].addr = kVibrationAddress;
+    messages[0].flags = 0;
+    messages[0].len = 1;
+    messages[0].buf = &reg;
+    messages[1].addr = kVibrationAddress;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = length;
+    messages[1].buf = data;
+    transaction.msgs = messages;
+    transaction.nmsgs = 2;
+    if (ioctl(fd, I2C_RDWR, &transaction) < 0)
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationWriteRegister
+// =================================================================================================
+int32_t SenseHAT_VibrationWriteRegister (int32_t fd,
+                                         uint8_t reg,
+                                         uint8_t value)
+{
+    int32_t result = 0;
+    uint8_t buffer[2] = { reg, value };
+    struct i2c_msg message;
+    struct i2c_rdwr_ioctl_data transaction;
+
+    message.addr = kVibrationAddress;
+    message.flags = 0;
+    message.len = 2;
+    message.buf = buffer;
+    transaction.msgs = &message;
+    transaction.nmsgs = 1;
+    if (ioctl(fd, I2C_RDWR, &transaction) < 0)
+    {
+        result = errno;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_VibrationRelease
+// =================================================================================================
+void SenseHAT_VibrationRelease (tSenseHAT_VibrationPrivate* vibrationPrivate)
+{
+    uint32_t axis = 0;
+
+    if (vibrationPrivate->fd >= 0)
+    {
+        (void)close(vibrationPrivate->fd);
+    }
+    if (vibrationPrivate->plan != NULL)
+    {
+        (void)SenseHAT_SpectrumClose(&(vibrationPrivate->plan));
+    }
+    for (axis = 0; axis < 3; axis++)
+    {
+        free((void*)(vibrationPrivate->samples[axis]));
+    }
+    (void)pthread_mutex_destroy(&(vibrationPrivate->mutex));
+    free((void*)vibrationPrivate);
+    return;
+}
+
+// =================================================================================================
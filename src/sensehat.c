@@ -26,10 +26,20 @@
 //  Includes
 // =================================================================================================
 #include "sensehat.h"
+#include "sensehat-private.h"
 #include "python-support.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <memory.h>
 #include <math.h>
+#include <poll.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
 
 // =================================================================================================
 //  Constants
@@ -92,54 +102,30 @@ static const char* kStickSubmoduleName  = "stick";
 static const char* kGetEventsFunctionName       = "get_events";
 static const char* kWaitForEventFunctionName    = "wait_for_event";
 
+// Joystick input device
+static const char* kJoystickDeviceName      = "Raspberry Pi Sense HAT Joystick";
+static const char* kInputDevicePathFormat   = "/dev/input/event%d";
+static const int32_t kMaxInputDevices       = 32;
+
+// Degrees to radians conversion factor
+static const double kRadiansPerDegree = 0.017453292519943295;
+
+// Number of input events read from the joystick device per read call
+#define kSenseHAT_InputEventBatchSize   16
+
+// Older kernel headers don't define the input event time accessors
+#ifndef input_event_sec
+#define input_event_sec     time.tv_sec
+#define input_event_usec    time.tv_usec
+#endif
+
 // =================================================================================================
-//  Types
+//  Private globals
 // =================================================================================================
 
-//! @brief Private instance data.
-//! 
-//! This structure represents the private instance data required by the Raspberry Pi Sense HAT
-//! C library.
-//! 
-typedef struct
-{
-    PyObject*   senseHATModule;                     //!< Top level Python module reference. 
-    PyObject*   self;                               //!< Python object instance.
-
-    PyObject*   senseHATSubModule;                  //!< Sense HAT Python submodule reference. 
-    PyObject*   clearFunction;                      //!< clear Python function reference. 
-    PyObject*   flipHorizontalFunction;             //!< flip_h Python function reference.
-    PyObject*   flipVerticalFunction;               //!< flip_v Python function reference.
-    PyObject*   gammaResetFunction;                 //!< gamma_reset Python function reference.
-    PyObject*   getAccelerometerFunction;           //!< get_accelerometer Python function reference.
-    PyObject*   getAccelerometerRawFunction;        //!< get_accelerometer_raw Python function reference.
-    PyObject*   getCompassFunction;                 //!< get_compass Python function reference.
-    PyObject*   getCompassRawFunction;              //!< get_compass_raw Python function reference.
-    PyObject*   getGyroscopeFunction;               //!< get_gyroscope Python function reference.
-    PyObject*   getGyroscopeRawFunction;            //!< get_gyroscope_raw Python function reference.
-    PyObject*   getHumidityFunction;                //!< get_humidity Python function reference.
-    PyObject*   getOrientationFunction;             //!< get_orientation Python function reference.
-    PyObject*   getOrientationDegreesFunction;      //!< get_orientation_degrees Python function reference.
-    PyObject*   getOrientationRadiansFunction;      //!< get_orientation_radians Python function reference.
-    PyObject*   getPixelFunction;                   //!< get_pixel Python function reference.
-    PyObject*   getPixelsFunction;                  //!< get_pixels Python function reference.
-    PyObject*   getPressureFunction;                //!< get_pressure Python function reference.
-    PyObject*   getTemperatureFunction;             //!< get_temperature Python function reference.
-    PyObject*   getTemperatureFromHumidityFunction; //!< get_temperature_from_humidity Python function reference.
-    PyObject*   getTemperatureFromPressureFunction; //!< get_temperature_from_pressure Python function reference.
-    PyObject*   loadImageFunction;                  //!< load_image Python function reference.
-    PyObject*   setIMUConfigFunction;               //!< set_imu_config Python function reference.
-    PyObject*   setPixelFunction;                   //!< set_pixel Python function reference.
-    PyObject*   setPixelsFunction;                  //!< set_pixels Python function reference.
-    PyObject*   setRotationFunction;                //!< set_rotation Python function reference.
-    PyObject*   showLetterFunction;                 //!< show_letter Python function reference.
-    PyObject*   showMessageFunction;                //!< show_message Python function reference.
-
-    PyObject*   stickSubModule;                     //!< Joystick Python submodule reference.
-    PyObject*   getEventsFunction;                  //!< get_events Python function reference.
-    PyObject*   waitForEventFunction;               //!< wait_for_event Python function reference.
-}
-tSenseHAT_InstancePrivate;
+// Instances sharing the embedded interpreter; the GIL is released once for all of them
+static pthread_mutex_t gInterpreterMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t gInterpreterInstanceCount = 0;
 
 // =================================================================================================
 //  Private prototypes
@@ -165,9 +151,66 @@ static int32_t SenseHAT_ConvertDictToRawData (const PyObject* dict,
 static int32_t SenseHAT_ParseJoystickEvent (const PyObject* tuple,
                                             tSenseHAT_JoystickEvent* event);
 
+// SenseHAT_OpenJoystick
+static int32_t SenseHAT_OpenJoystick (tSenseHAT_InstancePrivate* instancePrivate);
+
+// SenseHAT_ReadJoystickEvents
+static int32_t SenseHAT_ReadJoystickEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                            tSenseHAT_JoystickEvent* events,
+                                            int32_t capacity,
+                                            int32_t* eventCount);
+
+// SenseHAT_FetchPythonEvents
+static int32_t SenseHAT_FetchPythonEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                           tSenseHAT_JoystickEvent* events,
+                                           int32_t capacity,
+                                           int32_t* eventCount);
+
+// SenseHAT_PushPendingEvent
+static void SenseHAT_PushPendingEvent (tSenseHAT_InstancePrivate* instancePrivate,
+                                       const tSenseHAT_JoystickEvent* event);
+
+// SenseHAT_ReadHumidity
+static int32_t SenseHAT_ReadHumidity (const tSenseHAT_Instance instance,
+                                      double* percentRelativeHumidity);
+
+// SenseHAT_ReadTemperature
+static int32_t SenseHAT_ReadTemperature (const tSenseHAT_Instance instance,
+                                         double* degreesCelsius);
+
+// SenseHAT_ReadPressure
+static int32_t SenseHAT_ReadPressure (const tSenseHAT_Instance instance,
+                                      double* millibars);
+
+// SenseHAT_ReadCompass
+static int32_t SenseHAT_ReadCompass (const tSenseHAT_Instance instance,
+                                     double* degrees);
+
+// SenseHAT_ReadAccelerometerRaw
+static int32_t SenseHAT_ReadAccelerometerRaw (const tSenseHAT_Instance instance,
+                                              tSenseHAT_RawData* rawData);
+
+// SenseHAT_ReadGyroscopeRaw
+static int32_t SenseHAT_ReadGyroscopeRaw (const tSenseHAT_Instance instance,
+                                          tSenseHAT_RawData* rawData);
+
+// SenseHAT_ReadCompassRaw
+static int32_t SenseHAT_ReadCompassRaw (const tSenseHAT_Instance instance,
+                                        tSenseHAT_RawData* rawData);
+
+// SenseHAT_ReadOrientation
+static int32_t SenseHAT_ReadOrientation (const tSenseHAT_Instance instance,
+                                         tSenseHAT_Orientation* orientation);
+
 // SenseHAT_Release
 static int32_t SenseHAT_Release (tSenseHAT_InstancePrivate* instancePrivate);
 
+// SenseHAT_AcquireInterpreter
+static int32_t SenseHAT_AcquireInterpreter (void);
+
+// SenseHAT_ReleaseInterpreter
+static void SenseHAT_ReleaseInterpreter (void);
+
 // =================================================================================================
 //  SenseHAT_Version
 // =================================================================================================
@@ -187,19 +230,32 @@ int32_t SenseHAT_Open (tSenseHAT_Instance* instance)
     // Check arguments
     if (instance != NULL)
     {
+        tSenseHAT_InstancePrivate* instancePrivate = NULL;
+
         // Setup
         *instance = NULL;
 
-        // Allocate space
-        tSenseHAT_InstancePrivate* instancePrivate =
-            (tSenseHAT_InstancePrivate*)malloc(sizeof(tSenseHAT_InstancePrivate));
+        // Allocate space, unless another instance already owns the interpreter
+        result = SenseHAT_AcquireInterpreter();
+        if (result == 0)
+        {
+            instancePrivate = (tSenseHAT_InstancePrivate*)malloc(sizeof(tSenseHAT_InstancePrivate));
+        }
         if (instancePrivate != NULL)
         {
             // Initialize memory
             memset(instancePrivate, 0, sizeof(tSenseHAT_InstancePrivate));
+            instancePrivate->joystickFd = -1;
+            instancePrivate->notificationFd = -1;
+            (void)SenseHAT_SamplerInitialize(instancePrivate);
+            (void)SenseHAT_CacheInitialize(instancePrivate);
+            (void)SenseHAT_AnimationInitialize(instancePrivate);
+            (void)SenseHAT_StreamInitialize(instancePrivate);
+            (void)SenseHAT_FramebufferInitialize(instancePrivate);
 
             // Initialize
             Py_Initialize();
+            PY_INIT_THREADS();
 
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -512,6 +568,17 @@ int32_t SenseHAT_Open (tSenseHAT_Instance* instance)
 
             if (result == 0)
             {
+                // Open the joystick input device; if it isn't available, joystick events are
+                // retrieved through Python instead
+                (void)SenseHAT_OpenJoystick(instancePrivate);
+
+                // Map the LED matrix framebuffer; if it isn't available, frames are written 
+                // through Python instead
+                (void)SenseHAT_FramebufferOpen(instancePrivate);
+
+                // Release the GIL so that library threads (e.g. the sampler) can call into Python
+                instancePrivate->mainThreadState = PyEval_SaveThread();
+
                 *instance = (tSenseHAT_Instance)instancePrivate;
             }
             else    // There was an error
@@ -523,6 +590,64 @@ int32_t SenseHAT_Open (tSenseHAT_Instance* instance)
 
                 // Close down the interpreter
                 Python_CloseInterpreter();
+                SenseHAT_ReleaseInterpreter();
+            }
+        }
+        else if (result == 0)   // malloc failed
+        {
+            SenseHAT_ReleaseInterpreter();
+            result = ENOMEM;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_OpenReplay
+// =================================================================================================
+int32_t SenseHAT_OpenReplay (const char* directory,
+                             double speed,
+                             tSenseHAT_Instance* instance)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((directory != NULL) &&
+        (speed >= 0.0) &&
+        (instance != NULL))
+    {
+        // Setup
+        *instance = NULL;
+
+        // Allocate space
+        tSenseHAT_InstancePrivate* instancePrivate =
+            (tSenseHAT_InstancePrivate*)malloc(sizeof(tSenseHAT_InstancePrivate));
+        if (instancePrivate != NULL)
+        {
+            // Initialize memory
+            memset(instancePrivate, 0, sizeof(tSenseHAT_InstancePrivate));
+            instancePrivate->joystickFd = -1;
+            instancePrivate->notificationFd = -1;
+            (void)SenseHAT_SamplerInitialize(instancePrivate);
+            (void)SenseHAT_CacheInitialize(instancePrivate);
+            (void)SenseHAT_AnimationInitialize(instancePrivate);
+            (void)SenseHAT_StreamInitialize(instancePrivate);
+            (void)SenseHAT_FramebufferInitialize(instancePrivate);
+
+            // Load the log; no interpreter is needed
+            result = SenseHAT_ReplayInitialize(instancePrivate, directory, speed);
+            if (result == 0)
+            {
+                *instance = (tSenseHAT_Instance)instancePrivate;
+            }
+            else    // SenseHAT_ReplayInitialize failed
+            {
+                SenseHAT_Release(instancePrivate);
+                free((void*)instancePrivate);
             }
         }
         else    // malloc failed
@@ -549,17 +674,40 @@ int32_t SenseHAT_Close (tSenseHAT_Instance* instance)
     {
         // Get private data
 	    tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)(*instance);
+        bool closeInterpreter = false;
 
         // Clean up 
         if (instancePrivate != NULL)
         {
+            // Stop the sampler and players before taking back the GIL they may be waiting for
+            (void)SenseHAT_SamplerStop(*instance);
+            (void)SenseHAT_AnimationStop(*instance);
+            (void)SenseHAT_StreamStop(*instance);
+
+            // Let go of the recorder so it can be closed
+            (void)SenseHAT_SetRecorder(*instance, NULL);
+
+            // Restore the Python thread state saved by SenseHAT_Open
+            if (instancePrivate->mainThreadState != NULL)
+            {
+                PyEval_RestoreThread(instancePrivate->mainThreadState);
+                instancePrivate->mainThreadState = NULL;
+            }
+
+            // Replay instances don't have an interpreter to close
+            closeInterpreter = (instancePrivate->replay == NULL);
+
             SenseHAT_Release(instancePrivate);
             free((void*)instancePrivate);
             *instance = NULL;
         }
 
         // Close down the interpreter
-        Python_CloseInterpreter();
+        if (closeInterpreter)
+        {
+            Python_CloseInterpreter();
+            SenseHAT_ReleaseInterpreter();
+        }
     }
     else    // Invalid argument
     {
@@ -601,9 +749,13 @@ int32_t SenseHAT_LEDSetRotation (const tSenseHAT_Instance instance,
                                                                      pRotation,
                                                                      pRedraw,
                                                                      NULL);
+
                     // Check for success
                     if (pResult != NULL)
                     {
+                        // Frames written natively need the same rotation
+                        SenseHAT_FramebufferSetRotation(instancePrivate, rotation);
+
                         // Release reference
                         Py_DECREF(pResult);
                     }
@@ -671,6 +823,7 @@ int32_t SenseHAT_LEDFlipHorizontal (const tSenseHAT_Instance instance,
                                                                  instancePrivate->self, 
                                                                  pRedraw,
                                                                  NULL);
+
                 // Check for success
                 if (pResult != NULL)
                 {
@@ -740,6 +893,7 @@ int32_t SenseHAT_LEDFlipVertical (const tSenseHAT_Instance instance,
                                                                  instancePrivate->self, 
                                                                  pRedraw,
                                                                  NULL);
+
                 // Check for success
                 if (pResult != NULL)
                 {
@@ -793,7 +947,12 @@ int32_t SenseHAT_LEDGammaReset (const tSenseHAT_Instance instance)
     {
         // Get private data
         tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
-        if (instancePrivate->gammaResetFunction != NULL)
+        if (instancePrivate->framebuffer.fd >= 0)
+        {
+            // Ask the driver directly
+            result = SenseHAT_LEDSetLowLight(instance, false);
+        }
+        else if (instancePrivate->gammaResetFunction != NULL)
         {
              // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -836,7 +995,12 @@ int32_t SenseHAT_LEDSetPixels (const tSenseHAT_Instance instance,
     {
         // Get private data
         tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
-        if (instancePrivate->setPixelsFunction != NULL)
+        if (instancePrivate->framebuffer.pixels != NULL)
+        {
+            // Write the frame straight to the LED matrix framebuffer
+            result = SenseHAT_FramebufferWrite(instancePrivate, pixels);
+        }
+        else if (instancePrivate->setPixelsFunction != NULL)
         {
              // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -1176,6 +1340,7 @@ int32_t SenseHAT_LEDSetPixel (const tSenseHAT_Instance instance,
                                                                          pYPos,
                                                                          pColor,
                                                                          NULL);
+
                         if (pResult != NULL)
                         {
                             // Release reference
@@ -1221,6 +1386,87 @@ int32_t SenseHAT_LEDSetPixel (const tSenseHAT_Instance instance,
     return result;
 }
 
+// =================================================================================================
+//  SenseHAT_LEDSetPixelBatch
+// =================================================================================================
+int32_t SenseHAT_LEDSetPixelBatch (const tSenseHAT_Instance instance,
+                                   const tSenseHAT_LEDPixelUpdate* updates,
+                                   uint32_t updateCount)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (updates != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_LEDPixelArray pixels;
+        uint64_t changed = 0;
+        uint32_t index = 0;
+
+        // Check every update before applying any
+        for (index = 0; (index < updateCount) && (result == 0); index++)
+        {
+            const tSenseHAT_LEDPixelUpdate* update = &(updates[index]);
+            if ((update->xPosition >= 0) &&
+                (update->xPosition <= 7) &&
+                (update->yPosition >= 0) &&
+                (update->yPosition <= 7) &&
+                (update->color.red >= 0) &&
+                (update->color.red <= 255) &&
+                (update->color.green >= 0) &&
+                (update->color.green <= 255) &&
+                (update->color.blue >= 0) &&
+                (update->color.blue <= 255))
+            {
+                changed |= ((uint64_t)1 << ((update->yPosition * 8) + update->xPosition));
+            }
+            else    // Invalid argument
+            {
+                result = EINVAL;
+            }
+        }
+
+        if ((result == 0) && (changed != 0))
+        {
+            if (instancePrivate->framebuffer.pixels != NULL)
+            {
+                uint16_t converted[64];
+
+                // Gather the updates into a frame, and write just those pixels with one commit
+                memset(pixels, 0, sizeof(tSenseHAT_LEDPixelArray));
+                for (index = 0; index < updateCount; index++)
+                {
+                    pixels[(updates[index].yPosition * 8) + updates[index].xPosition] = updates[index].color;
+                }
+                result = SenseHAT_ColorConvertFrames(NULL, (const tSenseHAT_LEDPixelArray*)&pixels, 1, converted);
+                if (result == 0)
+                {
+                    result = SenseHAT_FramebufferPatchRGB565(instancePrivate, converted, changed);
+                }
+            }
+            else
+            {
+                // One read and one write through Python, however many pixels change
+                result = SenseHAT_LEDGetPixels(instance, pixels);
+                if (result == 0)
+                {
+                    for (index = 0; index < updateCount; index++)
+                    {
+                        pixels[(updates[index].yPosition * 8) + updates[index].xPosition] = updates[index].color;
+                    }
+                    result = SenseHAT_LEDSetPixels(instance, pixels);
+                }
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
 // =================================================================================================
 //  SenseHAT_LEDGetPixel
 // =================================================================================================
@@ -1350,26 +1596,24 @@ int32_t SenseHAT_LEDLoadImage (const tSenseHAT_Instance instance,
         (imageFilePath != NULL) && 
         (strlen(imageFilePath) > 0))
     {
-        // Make sure file path points to a file
-        bool fileExists = false;
-        FILE* fp = fopen(imageFilePath, "rb");
-        if (fp != NULL)
+        // Decode the image ourselves if we can
+        tSenseHAT_LEDPixelArray decoded;
+        result = SenseHAT_LEDDecodeImage(imageFilePath, decoded);
+        if (result == 0)
         {
-            // The file exists
-
-            // TODO: Is the file an image (JPEG, PNG, etc.)?
-
-            // TODO: Is the image 8-bit?
-
-            // TODO: Is the image 8x8 pixels?
-
-            (void)fclose(fp);
-            fileExists = true;
+            if (redraw)
+            {
+                result = SenseHAT_LEDSetPixels(instance, decoded);
+            }
+            if ((result == 0) && (pixels != NULL))
+            {
+                memcpy((void*)pixels, (void*)decoded, sizeof(tSenseHAT_LEDPixelArray));
+            }
         }
-
-        // Does the file exist?
-        if (fileExists)
+        else if (result == ENOTSUP)
         {
+            // Let PIL have a go at other formats
+            result = 0;
             // Get private data
             tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
             if (instancePrivate->loadImageFunction != NULL)
@@ -1434,10 +1678,6 @@ int32_t SenseHAT_LEDLoadImage (const tSenseHAT_Instance instance,
                 result = EFAULT;
             }
         }
-        else    // File doesn't exist
-        {
-            result = ENOENT;
-        }
     }
     else    // Invalid argument
     {
@@ -1503,6 +1743,7 @@ int32_t SenseHAT_LEDClear (const tSenseHAT_Instance instance,
                                                                  instancePrivate->self, 
                                                                  pColor,
                                                                  NULL);
+
                 if (pResult != NULL)
                 {
                     // Release reference
@@ -1637,6 +1878,7 @@ int32_t SenseHAT_LEDShowLetter (const tSenseHAT_Instance instance,
                                                                      pTextColor,
                                                                      pBackColor,
                                                                      NULL);
+
                     if (pResult != NULL)
                     {
                         // Release reference
@@ -1791,6 +2033,7 @@ int32_t SenseHAT_LEDShowMessage (const tSenseHAT_Instance instance,
                                                                          pTextColor,
                                                                          pBackColor,
                                                                          NULL);
+
                         if (pResult != NULL)
                         {
                             // Release reference
@@ -1857,46 +2100,16 @@ int32_t SenseHAT_GetHumidity (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (percentRelativeHumidity != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         *percentRelativeHumidity = 0;
 
-        if (instancePrivate->getHumidityFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getHumidityFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Get the result
-                if (PyFloat_Check(pResult))
-                {
-                    *percentRelativeHumidity = PyFloat_AsDouble(pResult);
-                }
-                else    // PyFloat_Check failed
-                {
-                    result = -1;
-                }
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelHumidity, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *percentRelativeHumidity = sample.humidity;
         }
     }
     else    // Invalid argument
@@ -1918,46 +2131,16 @@ int32_t SenseHAT_GetTemperature (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (degreesCelsius != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         *degreesCelsius = 0;
 
-        if (instancePrivate->getTemperatureFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getTemperatureFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Get the result
-                if (PyFloat_Check(pResult))
-                {
-                    *degreesCelsius = PyFloat_AsDouble(pResult);
-                }
-                else    // PyFloat_Check failed
-                {
-                    result = -1;
-                }
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelTemperature, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *degreesCelsius = sample.temperature;
         }
     }
     else    // Invalid argument
@@ -1979,46 +2162,16 @@ int32_t SenseHAT_GetPressure (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (millibars != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         *millibars = 0;
 
-        if (instancePrivate->getPressureFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getPressureFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Get the result
-                if (PyFloat_Check(pResult))
-                {
-                    *millibars = PyFloat_AsDouble(pResult);
-                }
-                else    // PyFloat_Check failed
-                {
-                    result = -1;
-                }
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelPressure, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *millibars = sample.pressure;
         }
     }
     else    // Invalid argument
@@ -2040,46 +2193,16 @@ int32_t SenseHAT_GetCompass (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (degrees != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         *degrees = 0;
 
-        if (instancePrivate->getCompassFunction != NULL)
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelCompass, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getCompassFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Get the result
-                if (PyFloat_Check(pResult))
-                {
-                    *degrees = PyFloat_AsDouble(pResult);
-                }
-                else    // PyFloat_Check failed
-                {
-                    result = -1;
-                }
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
-        {
-            result = EFAULT;
+            *degrees = sample.compass;
         }
     }
     else    // Invalid argument
@@ -2155,39 +2278,16 @@ int32_t SenseHAT_GetAccelerometerRaw (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (rawData != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
 
-        if (instancePrivate->getAccelerometerRawFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getAccelerometerRawFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Convert the result
-                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelAccelerometerRaw, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *rawData = sample.accelerometerRaw;
         }
     }
     else    // Invalid argument
@@ -2209,39 +2309,16 @@ int32_t SenseHAT_GetCompassRaw (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (rawData != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
 
-        if (instancePrivate->getCompassRawFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getCompassRawFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Convert the result
-                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelCompassRaw, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *rawData = sample.compassRaw;
         }
     }
     else    // Invalid argument
@@ -2317,39 +2394,16 @@ int32_t SenseHAT_GetGyroscopeRaw (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (rawData != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
 
-        if (instancePrivate->getGyroscopeRawFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getGyroscopeRawFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Convert the result
-                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelGyroscopeRaw, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *rawData = sample.gyroscopeRaw;
         }
     }
     else    // Invalid argument
@@ -2371,39 +2425,16 @@ int32_t SenseHAT_GetOrientation (const tSenseHAT_Instance instance,
     if ((instance != NULL) &&
         (orientation != NULL))
     {
-        // Get private data
-        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        tSenseHAT_Sample sample;
 
         // Setup
         memset((void*)orientation, 0, sizeof(tSenseHAT_Orientation));
 
-        if (instancePrivate->getOrientationFunction != NULL)
-        {
-            // Get a lock
-            PyGILState_STATE state = PyGILState_Ensure();
-
-            // Call the function
-            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getOrientationFunction,
-                                                             instancePrivate->self, NULL);
-            if (pResult != NULL)
-            {
-                // Convert the result
-                result = SenseHAT_ConvertDictToOrientation(pResult, orientation);
-
-                // Release reference
-                Py_DECREF(pResult);
-            }
-            else    // PyObject_CallFunctionObjArgs failed
-            {
-                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
-            }
-
-            // Release our lock
-            PyGILState_Release(state);
-        }
-        else    // Bad function pointer
+        // Read the value, or use the cached one if it's fresh enough
+        result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelOrientation, kSenseHAT_CacheMaxAgeDefault, &sample);
+        if (result == 0)
         {
-            result = EFAULT;
+            *orientation = sample.orientation;
         }
     }
     else    // Invalid argument
@@ -2431,7 +2462,18 @@ int32_t SenseHAT_GetOrientationDegrees (const tSenseHAT_Instance instance,
         // Setup
         memset((void*)orientation, 0, sizeof(tSenseHAT_Orientation));
 
-        if (instancePrivate->getOrientationDegreesFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            tSenseHAT_Sample sample;
+
+            // Serve the value from the replay log
+            result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelOrientation, kSenseHAT_CacheMaxAgeDefault, &sample);
+            if (result == 0)
+            {
+                *orientation = sample.orientation;
+            }
+        }
+        else if (instancePrivate->getOrientationDegreesFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2485,7 +2527,20 @@ int32_t SenseHAT_GetOrientationRadians (const tSenseHAT_Instance instance,
         // Setup
         memset((void*)orientation, 0, sizeof(tSenseHAT_Orientation));
 
-        if (instancePrivate->getOrientationRadiansFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            tSenseHAT_Sample sample;
+
+            // Serve the value from the replay log
+            result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelOrientation, kSenseHAT_CacheMaxAgeDefault, &sample);
+            if (result == 0)
+            {
+                orientation->pitch = sample.orientation.pitch * kRadiansPerDegree;
+                orientation->roll = sample.orientation.roll * kRadiansPerDegree;
+                orientation->yaw = sample.orientation.yaw * kRadiansPerDegree;
+            }
+        }
+        else if (instancePrivate->getOrientationRadiansFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2539,7 +2594,18 @@ int32_t SenseHAT_GetTemperatureFromHumidity (const tSenseHAT_Instance instance,
         // Setup
         *degreesCelsius = 0;
 
-        if (instancePrivate->getTemperatureFromHumidityFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            tSenseHAT_Sample sample;
+
+            // Serve the value from the replay log
+            result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelTemperature, kSenseHAT_CacheMaxAgeDefault, &sample);
+            if (result == 0)
+            {
+                *degreesCelsius = sample.temperature;
+            }
+        }
+        else if (instancePrivate->getTemperatureFromHumidityFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2600,7 +2666,18 @@ int32_t SenseHAT_GetTemperatureFromPressure (const tSenseHAT_Instance instance,
         // Setup
         *degreesCelsius = 0;
 
-        if (instancePrivate->getTemperatureFromPressureFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            tSenseHAT_Sample sample;
+
+            // Serve the value from the replay log
+            result = SenseHAT_GetChannels(instance, eSenseHAT_ChannelTemperature, kSenseHAT_CacheMaxAgeDefault, &sample);
+            if (result == 0)
+            {
+                *degreesCelsius = sample.temperature;
+            }
+        }
+        else if (instancePrivate->getTemperatureFromPressureFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2751,7 +2828,12 @@ int32_t SenseHAT_GetEvents (const tSenseHAT_Instance instance,
         // Setup
 		*eventCount = 0;
 
-        if (instancePrivate->getEventsFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            // Serve the events from the replay log
+            result = SenseHAT_ReplayGetEvents(instancePrivate, eventCount, events);
+        }
+        else if (instancePrivate->getEventsFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2776,7 +2858,7 @@ int32_t SenseHAT_GetEvents (const tSenseHAT_Instance instance,
                             // Setup
                             *events = NULL;
 
-                            list = (tSenseHAT_JoystickEvent*)(sizeof(tSenseHAT_JoystickEvent) * numEvents);
+                            list = (tSenseHAT_JoystickEvent*)malloc(sizeof(tSenseHAT_JoystickEvent) * numEvents);
                             if (list != NULL)
                             {
                                 memset(list, 0, sizeof(tSenseHAT_JoystickEvent) * numEvents);
@@ -2786,7 +2868,7 @@ int32_t SenseHAT_GetEvents (const tSenseHAT_Instance instance,
 
                                 for (i = 0; i < numEvents; i++)
                                 {
-                                    // Get an event from the list
+                                    // Get an event from the list (note this is a borrowed reference)
                                     tuple = PyList_GetItem(pResult, i);
                                     if (tuple != NULL)
                                     {
@@ -2798,9 +2880,6 @@ int32_t SenseHAT_GetEvents (const tSenseHAT_Instance instance,
                                         {
                                             result = -1;
                                         }
-
-                                        // Release reference
-                                        Py_DECREF(tuple);
                                         tuple = NULL;
                                     }
                                     else    // PyList_GetItem failed
@@ -2861,6 +2940,125 @@ int32_t SenseHAT_GetEvents (const tSenseHAT_Instance instance,
     return result;
 }
 
+// =================================================================================================
+//  SenseHAT_GetEventsInto
+// =================================================================================================
+int32_t SenseHAT_GetEventsInto (const tSenseHAT_Instance instance,
+                                tSenseHAT_JoystickEvent* events,
+                                int32_t capacity,
+                                int32_t* eventCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (events != NULL) &&
+        (capacity > 0) &&
+        (eventCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        int32_t count = 0;
+
+        // Setup
+        *eventCount = 0;
+
+        // Deliver events left over from a previous call first
+        while ((instancePrivate->pendingEventCount > 0) && (count < capacity))
+        {
+            events[count] = instancePrivate->pendingEvents[instancePrivate->pendingEventIndex];
+            instancePrivate->pendingEventIndex = 
+                (instancePrivate->pendingEventIndex + 1) % kSenseHAT_MaxPendingEvents;
+            instancePrivate->pendingEventCount--;
+            count++;
+        }
+
+        // Is there room for more events?
+        if (count < capacity)
+        {
+            int32_t newCount = 0;
+
+            // Read from the replay log or the joystick device if we have one, otherwise go 
+            // through Python
+            if (instancePrivate->replay != NULL)
+            {
+                result = SenseHAT_ReplayReadEvents(instancePrivate, 
+                                                   &(events[count]), 
+                                                   capacity - count, 
+                                                   &newCount);
+            }
+            else if (instancePrivate->joystickFd >= 0)
+            {
+                result = SenseHAT_ReadJoystickEvents(instancePrivate, 
+                                                     &(events[count]), 
+                                                     capacity - count, 
+                                                     &newCount);
+            }
+            else
+            {
+                result = SenseHAT_FetchPythonEvents(instancePrivate, 
+                                                    &(events[count]), 
+                                                    capacity - count, 
+                                                    &newCount);
+            }
+            count += newCount;
+        }
+
+        // A full buffer may have left events behind, in the pending queue or the source, so ask 
+        // for another call
+        if ((result == 0) && (count == capacity))
+        {
+            result = ENOBUFS;
+        }
+
+        // Record the events delivered
+        if (count > 0)
+        {
+            tSenseHAT_Recorder recorder = NULL;
+            int32_t index = 0;
+
+            (void)pthread_mutex_lock(&(instancePrivate->cache.mutex));
+            recorder = instancePrivate->cache.recorder;
+            for (index = 0; (recorder != NULL) && (index < count); index++)
+            {
+                (void)SenseHAT_RecorderAppendEvent(recorder, &(events[index]));
+            }
+            (void)pthread_mutex_unlock(&(instancePrivate->cache.mutex));
+        }
+
+        // Return the number of events delivered, even if there was an overflow
+        *eventCount = count;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetDroppedEventCount
+// =================================================================================================
+int32_t SenseHAT_GetDroppedEventCount (const tSenseHAT_Instance instance,
+                                       uint64_t* droppedCount)
+{
+    int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) && (droppedCount != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        *droppedCount = instancePrivate->droppedEventCount;
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
 // =================================================================================================
 //  SenseHAT_WaitForEvent
 // =================================================================================================
@@ -2879,7 +3077,12 @@ int32_t SenseHAT_WaitForEvent (const tSenseHAT_Instance instance,
 
         memset(event, 0, sizeof(tSenseHAT_JoystickEvent));
 
-        if (instancePrivate->waitForEventFunction != NULL)
+        if (instancePrivate->replay != NULL)
+        {
+            // Serve the event from the replay log
+            result = SenseHAT_ReplayWaitForEvent(instancePrivate, flushPendingEvents, event);
+        }
+        else if (instancePrivate->waitForEventFunction != NULL)
         {
             // Get a lock
             PyGILState_STATE state = PyGILState_Ensure();
@@ -2936,33 +3139,328 @@ int32_t SenseHAT_WaitForEvent (const tSenseHAT_Instance instance,
 }
 
 // =================================================================================================
-//  SenseHAT_ConvertPixelToLEDPixel
+//  SenseHAT_GetNotificationFd
 // =================================================================================================
-int32_t SenseHAT_ConvertPixelToLEDPixel (const PyObject* pixel,
-                                         tSenseHAT_LEDPixel* color)
+int32_t SenseHAT_GetNotificationFd (const tSenseHAT_Instance instance,
+                                    int32_t* notificationFd)
 {
     int32_t result = 0;
-    PyObject* pChannel = NULL;
 
-    pChannel = PyList_GetItem((PyObject*)pixel, 0);
-    if (pChannel != NULL)
+    // Check arguments
+    if ((instance != NULL) &&
+        (notificationFd != NULL))
     {
-        if (PYLONG_CHECK(pChannel))
-        {
-            color->red = PyLong_AsLong(pChannel);
-        }
-        else    // PyLong_Check failed
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        *notificationFd = -1;
+
+        // Create the notification descriptor the first time it's asked for
+        if (instancePrivate->notificationFd < 0)
         {
-            result = -1;
-        }
-        pChannel = NULL;
-    }
-    else    // PyList_GetItem failed
-    {
-        result = -1;
-    }
+            // An epoll descriptor is itself pollable, and is readable whenever one of the
+            // descriptors in its interest list is readable
+            int32_t fd = epoll_create1(EPOLL_CLOEXEC);
+            if (fd >= 0)
+            {
+                struct epoll_event event;
 
-    if (result == 0)
+                // Joystick events
+                if (instancePrivate->joystickFd >= 0)
+                {
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.u32 = eSenseHAT_WaitSourceJoystick;
+                    if (epoll_ctl(fd, EPOLL_CTL_ADD, instancePrivate->joystickFd, &event) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+
+                // New samples
+                if ((result == 0) && (instancePrivate->sampler.eventFd >= 0))
+                {
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.u32 = eSenseHAT_WaitSourceSampler;
+                    if (epoll_ctl(fd, EPOLL_CTL_ADD, instancePrivate->sampler.eventFd, &event) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+
+                // Motion events
+                if ((result == 0) && (instancePrivate->sampler.motionFd >= 0))
+                {
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.u32 = eSenseHAT_WaitSourceMotion;
+                    if (epoll_ctl(fd, EPOLL_CTL_ADD, instancePrivate->sampler.motionFd, &event) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+
+                // Subscription notifications
+                if ((result == 0) && (instancePrivate->sampler.subscriptionFd >= 0))
+                {
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.u32 = eSenseHAT_WaitSourceSubscription;
+                    if (epoll_ctl(fd, EPOLL_CTL_ADD, instancePrivate->sampler.subscriptionFd, &event) != 0)
+                    {
+                        result = errno;
+                    }
+                }
+
+                // Check for success
+                if (result == 0)
+                {
+                    instancePrivate->notificationFd = fd;
+                }
+                else    // epoll_ctl failed
+                {
+                    (void)close(fd);
+                }
+            }
+            else    // epoll_create1 failed
+            {
+                result = errno;
+            }
+        }
+
+        // Check for success
+        if (result == 0)
+        {
+            *notificationFd = instancePrivate->notificationFd;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_WaitForSources
+// =================================================================================================
+int32_t SenseHAT_WaitForSources (const tSenseHAT_Instance instance,
+                                 uint32_t sources,
+                                 int32_t userFd,
+                                 int32_t timeoutMilliseconds,
+                                 uint32_t* readySources)
+{
+    int32_t result = 0;
+    const uint32_t allSources = eSenseHAT_WaitSourceJoystick | 
+                                eSenseHAT_WaitSourceSampler | 
+                                eSenseHAT_WaitSourceUser |
+                                eSenseHAT_WaitSourceMotion |
+                                eSenseHAT_WaitSourceSubscription;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (sources != eSenseHAT_WaitSourceNone) &&
+        ((sources & ~allSources) == 0) &&
+        (((sources & eSenseHAT_WaitSourceUser) == 0) || (userFd >= 0)) &&
+        (readySources != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+        struct pollfd pollFds[5];
+        uint32_t pollSources[5];
+        nfds_t pollCount = 0;
+        uint32_t ready = eSenseHAT_WaitSourceNone;
+
+        // Setup
+        *readySources = eSenseHAT_WaitSourceNone;
+
+        // Joystick events
+        if ((sources & eSenseHAT_WaitSourceJoystick) != 0)
+        {
+            // Events left over from a previous call are ready right away
+            if (instancePrivate->pendingEventCount > 0)
+            {
+                ready |= eSenseHAT_WaitSourceJoystick;
+            }
+            else if (instancePrivate->joystickFd >= 0)
+            {
+                pollFds[pollCount].fd = instancePrivate->joystickFd;
+                pollFds[pollCount].events = POLLIN;
+                pollFds[pollCount].revents = 0;
+                pollSources[pollCount] = eSenseHAT_WaitSourceJoystick;
+                pollCount++;
+            }
+            else    // Joystick events can only be retrieved by polling Python
+            {
+                result = ENOTSUP;
+            }
+        }
+
+        // New samples
+        if ((result == 0) && ((sources & eSenseHAT_WaitSourceSampler) != 0))
+        {
+            if (instancePrivate->sampler.eventFd >= 0)
+            {
+                pollFds[pollCount].fd = instancePrivate->sampler.eventFd;
+                pollFds[pollCount].events = POLLIN;
+                pollFds[pollCount].revents = 0;
+                pollSources[pollCount] = eSenseHAT_WaitSourceSampler;
+                pollCount++;
+            }
+            else    // No eventfd
+            {
+                result = ENOTSUP;
+            }
+        }
+
+        // Motion events
+        if ((result == 0) && ((sources & eSenseHAT_WaitSourceMotion) != 0))
+        {
+            if (instancePrivate->sampler.motionFd >= 0)
+            {
+                pollFds[pollCount].fd = instancePrivate->sampler.motionFd;
+                pollFds[pollCount].events = POLLIN;
+                pollFds[pollCount].revents = 0;
+                pollSources[pollCount] = eSenseHAT_WaitSourceMotion;
+                pollCount++;
+            }
+            else    // No eventfd
+            {
+                result = ENOTSUP;
+            }
+        }
+
+        // Subscription notifications
+        if ((result == 0) && ((sources & eSenseHAT_WaitSourceSubscription) != 0))
+        {
+            if (instancePrivate->sampler.subscriptionFd >= 0)
+            {
+                pollFds[pollCount].fd = instancePrivate->sampler.subscriptionFd;
+                pollFds[pollCount].events = POLLIN;
+                pollFds[pollCount].revents = 0;
+                pollSources[pollCount] = eSenseHAT_WaitSourceSubscription;
+                pollCount++;
+            }
+            else    // No eventfd
+            {
+                result = ENOTSUP;
+            }
+        }
+
+        // Caller supplied file descriptor
+        if ((result == 0) && ((sources & eSenseHAT_WaitSourceUser) != 0))
+        {
+            pollFds[pollCount].fd = userFd;
+            pollFds[pollCount].events = POLLIN;
+            pollFds[pollCount].revents = 0;
+            pollSources[pollCount] = eSenseHAT_WaitSourceUser;
+            pollCount++;
+        }
+
+        // Check for success
+        if (result == 0)
+        {
+            // Don't block if something is already ready
+            int32_t timeout = (ready != eSenseHAT_WaitSourceNone) ? 0 : timeoutMilliseconds;
+            double deadline = SenseHAT_GetMonotonicTime() + ((double)timeout / 1000.0);
+            int count = 0;
+
+            do
+            {
+                count = poll(pollFds, pollCount, timeout);
+                if ((count < 0) && (errno == EINTR) && (timeout > 0))
+                {
+                    // Interrupted by a signal; wait for whatever time is left
+                    double remaining = deadline - SenseHAT_GetMonotonicTime();
+                    timeout = (remaining > 0.0) ? (int32_t)ceil(remaining * 1000.0) : 0;
+                }
+            }
+            while ((count < 0) && (errno == EINTR));
+
+            if (count >= 0)
+            {
+                nfds_t index = 0;
+                for (index = 0; index < pollCount; index++)
+                {
+                    if ((pollFds[index].revents & (POLLIN | POLLERR | POLLHUP)) != 0)
+                    {
+                        ready |= pollSources[index];
+                    }
+                }
+
+                // Did anything become ready?
+                *readySources = ready;
+                if (ready == eSenseHAT_WaitSourceNone)
+                {
+                    result = ETIMEDOUT;
+                }
+            }
+            else    // poll failed
+            {
+                result = errno;
+            }
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_GetTimestamp
+// =================================================================================================
+double SenseHAT_GetTimestamp (void)
+{
+    struct timespec now;
+
+    // Use the same clock as the joystick input device
+    (void)clock_gettime(CLOCK_REALTIME, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+}
+
+// =================================================================================================
+//  SenseHAT_GetMonotonicTime
+// =================================================================================================
+double SenseHAT_GetMonotonicTime (void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+}
+
+// =================================================================================================
+//  SenseHAT_ConvertPixelToLEDPixel
+// =================================================================================================
+int32_t SenseHAT_ConvertPixelToLEDPixel (const PyObject* pixel,
+                                         tSenseHAT_LEDPixel* color)
+{
+    int32_t result = 0;
+    PyObject* pChannel = NULL;
+
+    pChannel = PyList_GetItem((PyObject*)pixel, 0);
+    if (pChannel != NULL)
+    {
+        if (PYLONG_CHECK(pChannel))
+        {
+            color->red = PyLong_AsLong(pChannel);
+        }
+        else    // PyLong_Check failed
+        {
+            result = -1;
+        }
+        pChannel = NULL;
+    }
+    else    // PyList_GetItem failed
+    {
+        result = -1;
+    }
+
+    if (result == 0)
     {
         pChannel = PyList_GetItem((PyObject*)pixel, 1);
         if (pChannel != NULL)
@@ -3398,74 +3896,981 @@ int32_t SenseHAT_ParseJoystickEvent (const PyObject* tuple,
 }
 
 // =================================================================================================
-//  SenseHAT_Release
+//  SenseHAT_OpenJoystick
 // =================================================================================================
-int32_t SenseHAT_Release (tSenseHAT_InstancePrivate* instancePrivate)
+int32_t SenseHAT_OpenJoystick (tSenseHAT_InstancePrivate* instancePrivate)
 {
-    int32_t result = 0;
+    int32_t result = ENODEV;
+    int32_t index = 0;
+    char path[32];
+    char name[256];
 
-    // Check argument
-    if (instancePrivate != NULL)
+    // Look for the Sense HAT joystick among the input event devices
+    for (index = 0; index < kMaxInputDevices; index++)
     {
-        // Clean up
-        if (instancePrivate->senseHATModule != NULL)
+        (void)snprintf(path, sizeof(path), kInputDevicePathFormat, index);
+        int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0)
         {
-            // Release stick submodule
-            if (instancePrivate->stickSubModule != NULL)
+            // Is this the joystick?
+            memset(name, 0, sizeof(name));
+            if ((ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) >= 0) &&
+                (strcmp(name, kJoystickDeviceName) == 0))
             {
-                Python_ReleaseFunctionReference(&(instancePrivate->getEventsFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->waitForEventFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->stickSubModule));                
+                instancePrivate->joystickFd = fd;
+                result = 0;
+                break;
             }
-            
-            // Release sensehat submodule
-            if (instancePrivate->senseHATSubModule != NULL)
+            (void)close(fd);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadJoystickEvents
+// =================================================================================================
+int32_t SenseHAT_ReadJoystickEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                     tSenseHAT_JoystickEvent* events,
+                                     int32_t capacity,
+                                     int32_t* eventCount)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+    bool drained = false;
+    struct input_event inputEvents[kSenseHAT_InputEventBatchSize];
+
+    // Never read more input events than there are free slots in the caller's buffer, so that
+    // anything we don't have room for stays queued in the kernel until the next call
+    while ((count < capacity) && !drained)
+    {
+        int32_t batchSize = capacity - count;
+        if (batchSize > kSenseHAT_InputEventBatchSize)
+        {
+            batchSize = kSenseHAT_InputEventBatchSize;
+        }
+
+        ssize_t bytesRead = read(instancePrivate->joystickFd, 
+                                 inputEvents, 
+                                 sizeof(struct input_event) * batchSize);
+        if (bytesRead >= 0)
+        {
+            int32_t numInputEvents = (int32_t)(bytesRead / sizeof(struct input_event));
+            int32_t i = 0;
+
+            for (i = 0; i < numInputEvents; i++)
             {
-                Python_ReleaseFunctionReference(&(instancePrivate->clearFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->flipHorizontalFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->flipVerticalFunction));
-                #if 0
-                Python_ReleaseFunctionReference(&(instancePrivate->gammaFunction));
-                #endif
-                Python_ReleaseFunctionReference(&(instancePrivate->gammaResetFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getAccelerometerFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getAccelerometerRawFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getCompassFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getCompassRawFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getGyroscopeFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getGyroscopeRawFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getHumidityFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationDegreesFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationRadiansFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getPixelFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getPixelsFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getPressureFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFromHumidityFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFromPressureFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->loadImageFunction));
-                #if 0
-                Python_ReleaseFunctionReference(&(instancePrivate->lowLightFunction));
-                #endif
-                Python_ReleaseFunctionReference(&(instancePrivate->setIMUConfigFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->setPixelFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->setPixelsFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->setRotationFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->showLetterFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->showMessageFunction));
-                Python_ReleaseFunctionReference(&(instancePrivate->self));
-                Python_ReleaseFunctionReference(&(instancePrivate->senseHATSubModule));
+                // Only key events are of interest
+                if (inputEvents[i].type == EV_KEY)
+                {
+                    tSenseHAT_JoystickEvent* event = &(events[count]);
+
+                    // Convert the key code to a direction
+                    switch (inputEvents[i].code)
+                    {
+                        case KEY_UP:    event->direction = eSenseHAT_JoystickDirectionUp;       break;
+                        case KEY_DOWN:  event->direction = eSenseHAT_JoystickDirectionDown;     break;
+                        case KEY_LEFT:  event->direction = eSenseHAT_JoystickDirectionLeft;     break;
+                        case KEY_RIGHT: event->direction = eSenseHAT_JoystickDirectionRight;    break;
+                        case KEY_ENTER: event->direction = eSenseHAT_JoystickDirectionPush;     break;
+                        default:        event->direction = eSenseHAT_JoystickDirectionNone;     break;
+                    }
+
+                    // Convert the key value to an action
+                    switch (inputEvents[i].value)
+                    {
+                        case 0:     event->action = eSenseHAT_JoystickActionReleased;   break;
+                        case 1:     event->action = eSenseHAT_JoystickActionPressed;    break;
+                        case 2:     event->action = eSenseHAT_JoystickActionHeld;       break;
+                        default:    event->action = eSenseHAT_JoystickActionNone;       break;
+                    }
+
+                    // Convert the time stamp
+                    event->timestamp = (double)inputEvents[i].input_event_sec +
+                                       ((double)inputEvents[i].input_event_usec / 1000000.0);
+
+                    // Skip anything that isn't a joystick key
+                    if (event->direction != eSenseHAT_JoystickDirectionNone)
+                    {
+                        count++;
+                    }
+                }
             }
 
-            Python_ReleaseFunctionReference(&(instancePrivate->senseHATModule));
+            // A short read means the device queue is empty
+            if (numInputEvents < batchSize)
+            {
+                drained = true;
+            }
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+            // Nothing left to read
+            drained = true;
+        }
+        else if (errno != EINTR)
+        {
+            // read failed
+            result = errno;
+            break;
         }
     }
-    else    // Invalid argument
+
+    // If the caller's buffer filled up, let them know whether there's more to come
+    if ((result == 0) && !drained)
     {
-        result = EINVAL;
+        struct pollfd pfd = { instancePrivate->joystickFd, POLLIN, 0 };
+        if ((poll(&pfd, 1, 0) > 0) && ((pfd.revents & POLLIN) != 0))
+        {
+            result = ENOBUFS;
+        }
     }
+
+    *eventCount = count;
     return result;
 }
 
 // =================================================================================================
+//  SenseHAT_FetchPythonEvents
+// =================================================================================================
+int32_t SenseHAT_FetchPythonEvents (tSenseHAT_InstancePrivate* instancePrivate,
+                                    tSenseHAT_JoystickEvent* events,
+                                    int32_t capacity,
+                                    int32_t* eventCount)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+
+    if (instancePrivate->getEventsFunction != NULL)
+    {
+        // Get a lock
+        PyGILState_STATE state = PyGILState_Ensure();
+
+        // Call the function
+        PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getEventsFunction,
+                                                         NULL);
+        if (pResult != NULL)
+        {
+            // The result should be a list of events
+            if (PyList_Check(pResult))
+            {
+                int32_t numEvents = (int32_t)PyList_Size(pResult);
+                int32_t i = 0;
+                tSenseHAT_JoystickEvent event;
+
+                for (i = 0; i < numEvents; i++)
+                {
+                    int32_t status = 0;
+
+                    // Get an event from the list (note this is a borrowed reference)
+                    PyObject* tuple = PyList_GetItem(pResult, i);
+                    if ((tuple != NULL) && PyTuple_Check(tuple))
+                    {
+                        memset(&event, 0, sizeof(tSenseHAT_JoystickEvent));
+                        status = SenseHAT_ParseJoystickEvent(tuple, &event);
+                        if (status == 0)
+                        {
+                            // Python has already dequeued the event, so anything that doesn't
+                            // fit in the caller's buffer is kept for the next call
+                            if (count < capacity)
+                            {
+                                events[count] = event;
+                                count++;
+                            }
+                            else
+                            {
+                                SenseHAT_PushPendingEvent(instancePrivate, &event);
+                            }
+                        }
+                    }
+                    else    // PyList_GetItem or PyTuple_Check failed
+                    {
+                        status = -1;
+                    }
+
+                    // Skip a bad event rather than stopping; the ones after it have been dequeued
+                    // too, so they'd be lost. Report the first failure once they're all moved.
+                    if ((status != 0) && (result == 0))
+                    {
+                        result = status;
+                    }
+                }
+            }
+            else    // PyList_Check failed
+            {
+                result = -1;
+            }
+
+            // Release reference
+            Py_DECREF(pResult);
+        }
+        else    // PyObject_CallFunctionObjArgs failed
+        {
+            result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+        }
+
+        // Release our lock
+        PyGILState_Release(state);
+    }
+    else    // Bad function pointer
+    {
+        result = EFAULT;
+    }
+
+    *eventCount = count;
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_PushPendingEvent
+// =================================================================================================
+void SenseHAT_PushPendingEvent (tSenseHAT_InstancePrivate* instancePrivate,
+                                const tSenseHAT_JoystickEvent* event)
+{
+    // If the queue is full, drop the oldest event and count it
+    if (instancePrivate->pendingEventCount == kSenseHAT_MaxPendingEvents)
+    {
+        instancePrivate->pendingEventIndex = 
+            (instancePrivate->pendingEventIndex + 1) % kSenseHAT_MaxPendingEvents;
+        instancePrivate->pendingEventCount--;
+        instancePrivate->droppedEventCount++;
+    }
+
+    // Append the event
+    int32_t index = (instancePrivate->pendingEventIndex + instancePrivate->pendingEventCount) %
+                    kSenseHAT_MaxPendingEvents;
+    instancePrivate->pendingEvents[index] = *event;
+    instancePrivate->pendingEventCount++;
+    return;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadHumidity
+// =================================================================================================
+int32_t SenseHAT_ReadHumidity (const tSenseHAT_Instance instance,
+                              double* percentRelativeHumidity)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (percentRelativeHumidity != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        *percentRelativeHumidity = 0;
+
+        if (instancePrivate->getHumidityFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getHumidityFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Get the result
+                if (PyFloat_Check(pResult))
+                {
+                    *percentRelativeHumidity = PyFloat_AsDouble(pResult);
+                }
+                else    // PyFloat_Check failed
+                {
+                    result = -1;
+                }
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadTemperature
+// =================================================================================================
+int32_t SenseHAT_ReadTemperature (const tSenseHAT_Instance instance,
+                                 double* degreesCelsius)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (degreesCelsius != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        *degreesCelsius = 0;
+
+        if (instancePrivate->getTemperatureFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getTemperatureFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Get the result
+                if (PyFloat_Check(pResult))
+                {
+                    *degreesCelsius = PyFloat_AsDouble(pResult);
+                }
+                else    // PyFloat_Check failed
+                {
+                    result = -1;
+                }
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadPressure
+// =================================================================================================
+int32_t SenseHAT_ReadPressure (const tSenseHAT_Instance instance,
+                              double* millibars)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (millibars != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        *millibars = 0;
+
+        if (instancePrivate->getPressureFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getPressureFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Get the result
+                if (PyFloat_Check(pResult))
+                {
+                    *millibars = PyFloat_AsDouble(pResult);
+                }
+                else    // PyFloat_Check failed
+                {
+                    result = -1;
+                }
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadCompass
+// =================================================================================================
+int32_t SenseHAT_ReadCompass (const tSenseHAT_Instance instance,
+                             double* degrees)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (degrees != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        *degrees = 0;
+
+        if (instancePrivate->getCompassFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getCompassFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Get the result
+                if (PyFloat_Check(pResult))
+                {
+                    *degrees = PyFloat_AsDouble(pResult);
+                }
+                else    // PyFloat_Check failed
+                {
+                    result = -1;
+                }
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadAccelerometerRaw
+// =================================================================================================
+int32_t SenseHAT_ReadAccelerometerRaw (const tSenseHAT_Instance instance,
+                                      tSenseHAT_RawData* rawData)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (rawData != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
+
+        if (instancePrivate->getAccelerometerRawFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getAccelerometerRawFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Convert the result
+                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadGyroscopeRaw
+// =================================================================================================
+int32_t SenseHAT_ReadGyroscopeRaw (const tSenseHAT_Instance instance,
+                                  tSenseHAT_RawData* rawData)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (rawData != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
+
+        if (instancePrivate->getGyroscopeRawFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getGyroscopeRawFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Convert the result
+                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadCompassRaw
+// =================================================================================================
+int32_t SenseHAT_ReadCompassRaw (const tSenseHAT_Instance instance,
+                                tSenseHAT_RawData* rawData)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (rawData != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        memset((void*)rawData, 0, sizeof(tSenseHAT_RawData));
+
+        if (instancePrivate->getCompassRawFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getCompassRawFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Convert the result
+                result = SenseHAT_ConvertDictToRawData(pResult, rawData);
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadOrientation
+// =================================================================================================
+int32_t SenseHAT_ReadOrientation (const tSenseHAT_Instance instance,
+                                 tSenseHAT_Orientation* orientation)
+{
+	int32_t result = 0;
+
+    // Check arguments
+    if ((instance != NULL) &&
+        (orientation != NULL))
+    {
+        // Get private data
+        tSenseHAT_InstancePrivate* instancePrivate = (tSenseHAT_InstancePrivate*)instance;
+
+        // Setup
+        memset((void*)orientation, 0, sizeof(tSenseHAT_Orientation));
+
+        if (instancePrivate->getOrientationFunction != NULL)
+        {
+            // Get a lock
+            PyGILState_STATE state = PyGILState_Ensure();
+
+            // Call the function
+            PyObject* pResult = PyObject_CallFunctionObjArgs(instancePrivate->getOrientationFunction,
+                                                             instancePrivate->self, NULL);
+            if (pResult != NULL)
+            {
+                // Convert the result
+                result = SenseHAT_ConvertDictToOrientation(pResult, orientation);
+
+                // Release reference
+                Py_DECREF(pResult);
+            }
+            else    // PyObject_CallFunctionObjArgs failed
+            {
+                result = Python_Error("PyObject_CallFunctionObjArgs failed!");
+            }
+
+            // Release our lock
+            PyGILState_Release(state);
+        }
+        else    // Bad function pointer
+        {
+            result = EFAULT;
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+	return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReadChannels
+// =================================================================================================
+int32_t SenseHAT_ReadChannels (tSenseHAT_InstancePrivate* instancePrivate,
+                               uint32_t channels,
+                               tSenseHAT_Sample* sample)
+{
+    int32_t result = 0;
+    tSenseHAT_Instance instance = (tSenseHAT_Instance)instancePrivate;
+    int32_t status = 0;
+
+    // Replay instances don't have an interpreter
+    if (instancePrivate->replay != NULL)
+    {
+        result = SenseHAT_ReplayReadChannels(instancePrivate, channels, sample);
+    }
+    else
+    {
+        // Setup
+        memset(sample, 0, sizeof(tSenseHAT_Sample));
+        sample->timestamp = SenseHAT_GetTimestamp();
+
+        // Hold the GIL across all the readings rather than taking it once per reading
+        PyGILState_STATE state = PyGILState_Ensure();
+
+        // Read each requested channel; channels that fail are left out of the sample, and the
+        // first failure is returned
+        if ((channels & eSenseHAT_ChannelHumidity) != 0)
+        {
+            status = SenseHAT_ReadHumidity(instance, &(sample->humidity));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelHumidity;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelTemperature) != 0)
+        {
+            status = SenseHAT_ReadTemperature(instance, &(sample->temperature));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelTemperature;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelPressure) != 0)
+        {
+            status = SenseHAT_ReadPressure(instance, &(sample->pressure));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelPressure;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelCompass) != 0)
+        {
+            status = SenseHAT_ReadCompass(instance, &(sample->compass));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelCompass;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelAccelerometerRaw) != 0)
+        {
+            status = SenseHAT_ReadAccelerometerRaw(instance, &(sample->accelerometerRaw));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelAccelerometerRaw;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelGyroscopeRaw) != 0)
+        {
+            status = SenseHAT_ReadGyroscopeRaw(instance, &(sample->gyroscopeRaw));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelGyroscopeRaw;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelCompassRaw) != 0)
+        {
+            status = SenseHAT_ReadCompassRaw(instance, &(sample->compassRaw));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelCompassRaw;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+        if ((channels & eSenseHAT_ChannelOrientation) != 0)
+        {
+            status = SenseHAT_ReadOrientation(instance, &(sample->orientation));
+            if (status == 0)
+            {
+                sample->channels |= eSenseHAT_ChannelOrientation;
+            }
+            else if (result == 0)
+            {
+                result = status;
+            }
+        }
+
+        // Release our lock
+        PyGILState_Release(state);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_Release
+// =================================================================================================
+int32_t SenseHAT_Release (tSenseHAT_InstancePrivate* instancePrivate)
+{
+    int32_t result = 0;
+
+    // Check argument
+    if (instancePrivate != NULL)
+    {
+        // Close the notification descriptor
+        if (instancePrivate->notificationFd >= 0)
+        {
+            (void)close(instancePrivate->notificationFd);
+            instancePrivate->notificationFd = -1;
+        }
+
+        // Release the animation player
+        SenseHAT_AnimationRelease(instancePrivate);
+
+        // Release the stream player
+        SenseHAT_StreamRelease(instancePrivate);
+
+        // Release the sampler
+        SenseHAT_SamplerRelease(instancePrivate);
+
+        // Release the cache
+        SenseHAT_CacheRelease(instancePrivate);
+
+        // Release the replay log
+        SenseHAT_ReplayRelease(instancePrivate);
+
+        // Close the joystick input device
+        if (instancePrivate->joystickFd >= 0)
+        {
+            (void)close(instancePrivate->joystickFd);
+            instancePrivate->joystickFd = -1;
+        }
+
+        // Close the LED matrix framebuffer
+        SenseHAT_FramebufferRelease(instancePrivate);
+
+        // Clean up
+        if (instancePrivate->senseHATModule != NULL)
+        {
+            // Release stick submodule
+            if (instancePrivate->stickSubModule != NULL)
+            {
+                Python_ReleaseFunctionReference(&(instancePrivate->getEventsFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->waitForEventFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->stickSubModule));                
+            }
+            
+            // Release sensehat submodule
+            if (instancePrivate->senseHATSubModule != NULL)
+            {
+                Python_ReleaseFunctionReference(&(instancePrivate->clearFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->flipHorizontalFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->flipVerticalFunction));
+                #if 0
+                Python_ReleaseFunctionReference(&(instancePrivate->gammaFunction));
+                #endif
+                Python_ReleaseFunctionReference(&(instancePrivate->gammaResetFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getAccelerometerFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getAccelerometerRawFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getCompassFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getCompassRawFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getGyroscopeFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getGyroscopeRawFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getHumidityFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationDegreesFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getOrientationRadiansFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getPixelFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getPixelsFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getPressureFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFromHumidityFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->getTemperatureFromPressureFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->loadImageFunction));
+                #if 0
+                Python_ReleaseFunctionReference(&(instancePrivate->lowLightFunction));
+                #endif
+                Python_ReleaseFunctionReference(&(instancePrivate->setIMUConfigFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->setPixelFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->setPixelsFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->setRotationFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->showLetterFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->showMessageFunction));
+                Python_ReleaseFunctionReference(&(instancePrivate->self));
+                Python_ReleaseFunctionReference(&(instancePrivate->senseHATSubModule));
+            }
+
+            Python_ReleaseFunctionReference(&(instancePrivate->senseHATModule));
+        }
+    }
+    else    // Invalid argument
+    {
+        result = EINVAL;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_AcquireInterpreter
+// =================================================================================================
+int32_t SenseHAT_AcquireInterpreter (void)
+{
+    int32_t result = 0;
+
+    // The interpreter is initialized and finalized with each instance, and the GIL released for
+    // it by a single saved thread state, so only one instance may use it at a time
+    (void)pthread_mutex_lock(&gInterpreterMutex);
+    if (gInterpreterInstanceCount == 0)
+    {
+        gInterpreterInstanceCount++;
+    }
+    else    // Already open
+    {
+        result = EBUSY;
+    }
+    (void)pthread_mutex_unlock(&gInterpreterMutex);
+    return result;
+}
+
+// =================================================================================================
+//  SenseHAT_ReleaseInterpreter
+// =================================================================================================
+void SenseHAT_ReleaseInterpreter (void)
+{
+    (void)pthread_mutex_lock(&gInterpreterMutex);
+    if (gInterpreterInstanceCount > 0)
+    {
+        gInterpreterInstanceCount--;
+    }
+    (void)pthread_mutex_unlock(&gInterpreterMutex);
+    return;
+}
+
+// =================================================================================================
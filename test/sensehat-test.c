@@ -18,7 +18,12 @@
 // =================================================================================================
 #include <CUnit.h>
 #include <Automated.h>
+#include <fcntl.h>
+#include <math.h>
+#include <memory.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include "sensehat.h"
 
@@ -27,6 +32,8 @@
 // =================================================================================================
 
 static tSenseHAT_Instance gInstance = NULL;
+static uint32_t gMotionEventCount = 0;
+static uint32_t gNotificationCount = 0;
 
 // =================================================================================================
 //  SenseHAT_SuiteInit
@@ -100,6 +107,7 @@ void TestLEDFunctions (void)
     tSenseHAT_LEDPixel badHighBluePixel = {0,0,256};
     tSenseHAT_LEDPixel pixel = {0,0,0};
     tSenseHAT_LEDPixelArray pixels;
+    tSenseHAT_LEDPixelUpdate updates[3];
     uint16_t i = 0;
     uint16_t j = 0;
     int32_t result = 0;
@@ -230,6 +238,41 @@ void TestLEDFunctions (void)
     result = SenseHAT_LEDSetPixels(gInstance, pixels);
     CU_ASSERT_EQUAL(result, EINVAL);
 
+    // Test SenseHAT_LEDSetPixelBatch
+    updates[0].xPosition = 1;
+    updates[0].yPosition = 2;
+    updates[0].color = greenColor;
+    updates[1].xPosition = 6;
+    updates[1].yPosition = 7;
+    updates[1].color = blueColor;
+    updates[2].xPosition = 1;
+    updates[2].yPosition = 2;
+    updates[2].color = redColor;
+    result = SenseHAT_LEDSetPixels(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_LEDSetPixelBatch(gInstance, updates, 3);
+    CU_ASSERT_EQUAL(result, 0);
+    usleep(500000);
+    result = SenseHAT_LEDGetPixels(gInstance, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[(2 * 8) + 1].red, (redColor.red & 0xF8));
+    CU_ASSERT_EQUAL(pixels[(2 * 8) + 1].green, 0);
+    CU_ASSERT_EQUAL(pixels[(7 * 8) + 6].blue, (blueColor.blue & 0xF8));
+    CU_ASSERT_EQUAL(pixels[0].red, 0);
+    result = SenseHAT_LEDSetPixelBatch(gInstance, updates, 0);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_LEDSetPixelBatch(NULL, updates, 3);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_LEDSetPixelBatch(gInstance, NULL, 3);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    updates[2].xPosition = 8;
+    result = SenseHAT_LEDSetPixelBatch(gInstance, updates, 3);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    updates[2].xPosition = 1;
+    updates[2].color = badHighGreenPixel;
+    result = SenseHAT_LEDSetPixelBatch(gInstance, updates, 3);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
     // Test SenseHAT_LEDShowLetter
     result = SenseHAT_LEDShowLetter(gInstance, "1", &redColor, &clearColor);
     CU_ASSERT_EQUAL(result, 0);
@@ -400,169 +443,2898 @@ void TestLEDFunctions (void)
 }
 
 // =================================================================================================
-//  TestEnvironmentalFunctions
+//  TestWriteFile
 // =================================================================================================
-void TestEnvironmentalFunctions (void)
+int32_t TestWriteFile (const char* path,
+                       const void* data,
+                       size_t size)
 {
-    double humidity = 0.0;
-    double temperature = 0.0;
-    double pressure = 0.0;
-    double heading = 0.0;
-    tSenseHAT_Orientation orientation;
-    tSenseHAT_RawData rawData;
     int32_t result = 0;
+    FILE* fp = fopen(path, "wb");
+    if (fp != NULL)
+    {
+        if (fwrite(data, 1, size, fp) != size)
+        {
+            result = EIO;
+        }
+        (void)fclose(fp);
+    }
+    else
+    {
+        result = errno;
+    }
+    return result;
+}
 
-    // High level functions
-    result = SenseHAT_GetHumidity(gInstance, &humidity);
+// =================================================================================================
+//  TestImageFunctions
+// =================================================================================================
+void TestImageFunctions (void)
+{
+    static const uint8_t kRGBImage[177] =
+    {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08, 0x08, 0x02, 0x00, 0x00, 0x00, 0x4B, 0x6D, 0x29,
+        0xDC, 0x00, 0x00, 0x00, 0x78, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x75, 0x8E, 0xB1, 0x0D, 0xC2,
+        0x40, 0x14, 0x43, 0x5F, 0xE0, 0x8A, 0x13, 0x3A, 0x21, 0x0B, 0x5D, 0x91, 0x82, 0xC2, 0x65, 0x86,
+        0xA0, 0xC8, 0x08, 0x8C, 0x90, 0x82, 0x21, 0x28, 0x33, 0x00, 0x43, 0xFC, 0x51, 0x32, 0x4A, 0x46,
+        0xE1, 0xAE, 0x43, 0x8A, 0xB0, 0x5E, 0xF5, 0x65, 0xFB, 0x1B, 0xC0, 0x30, 0xC3, 0x02, 0x2B, 0x04,
+        0x6C, 0xB0, 0xC3, 0xD0, 0xCE, 0x26, 0x1D, 0x39, 0x75, 0xBF, 0x13, 0xCE, 0xB8, 0x60, 0xE1, 0x8A,
+        0x47, 0x7C, 0x3F, 0xB7, 0x16, 0x29, 0x4B, 0x17, 0xA9, 0x48, 0x57, 0x75, 0xDD, 0xA4, 0x9A, 0x7A,
+        0x82, 0x04, 0x19, 0x0A, 0xE8, 0x87, 0xC0, 0x51, 0xE7, 0x98, 0x96, 0x78, 0xAC, 0xF1, 0x8C, 0x78,
+        0x6D, 0xF1, 0xDE, 0xE3, 0x33, 0xB4, 0x11, 0x66, 0x3C, 0xF2, 0xF7, 0xF9, 0x17, 0xC3, 0xC3, 0x16,
+        0x7C, 0x35, 0x89, 0xC3, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60,
+        0x82
+    };
+    static const uint8_t kPaletteImage[104] =
+    {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08, 0x02, 0x03, 0x00, 0x00, 0x00, 0xB9, 0x61, 0x56,
+        0x18, 0x00, 0x00, 0x00, 0x0C, 0x50, 0x4C, 0x54, 0x45, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00,
+        0xFF, 0x00, 0x00, 0x00, 0xFF, 0x9B, 0xC0, 0x13, 0xDC, 0x00, 0x00, 0x00, 0x17, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0x01, 0x63, 0x90, 0x96, 0x66, 0xC8, 0xC9, 0x61, 0xD8, 0xB8, 0x91, 0xE1, 0xD8, 0x31,
+        0x06, 0x24, 0x36, 0x00, 0x52, 0x14, 0x07, 0xF9, 0x2E, 0x54, 0xFE, 0xD2, 0x00, 0x00, 0x00, 0x00,
+        0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82
+    };
+    int32_t result = 0;
+    int32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    char text[1024];
+    uint8_t data[256];
+    size_t length = 0;
+    struct stat status;
+    struct timespec times[2];
+    tSenseHAT_LEDPixelArray pixels;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    // Test a binary PPM
+    (void)snprintf(path, sizeof(path), "%s/image.ppm", directory);
+    length = (size_t)snprintf((char*)data, sizeof(data), "P6\n# icon\n8 8\n255\n");
+    for (index = 0; index < 64; index++)
+    {
+        data[length++] = (uint8_t)index;
+        data[length++] = (uint8_t)(2 * index);
+        data[length++] = (uint8_t)(3 * index);
+    }
+    result = TestWriteFile(path, data, length);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetHumidity(NULL, &humidity);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetHumidity(gInstance, NULL);
-    CU_ASSERT_EQUAL(result, EINVAL);
+    CU_ASSERT_EQUAL(pixels[9].red, 9);
+    CU_ASSERT_EQUAL(pixels[9].green, 18);
+    CU_ASSERT_EQUAL(pixels[9].blue, 27);
+    CU_ASSERT_EQUAL(pixels[63].blue, 189);
 
-    result = SenseHAT_GetTemperature(gInstance, &temperature);
+    // Test the cache: the same size and modification time return the cached decode
+    (void)stat(path, &status);
+    data[length - 1] = 0;
+    result = TestWriteFile(path, data, length);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    times[0] = status.st_atim;
+    times[1] = status.st_mtim;
+    (void)utimensat(AT_FDCWD, path, times, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetTemperature(NULL, &temperature);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetTemperature(gInstance, NULL);
-    CU_ASSERT_EQUAL(result, EINVAL);
+    CU_ASSERT_EQUAL(pixels[63].blue, 189);
+    times[1].tv_sec -= 10;
+    (void)utimensat(AT_FDCWD, path, times, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[63].blue, 0);
 
-    result = SenseHAT_GetPressure(gInstance, &pressure);
+    // Test an ASCII PGM with a maximum value of 15
+    (void)snprintf(path, sizeof(path), "%s/image.pgm", directory);
+    length = (size_t)snprintf(text, sizeof(text), "P2 8 8 15\n");
+    for (index = 0; index < 64; index++)
+    {
+        length += (size_t)snprintf(text + length, sizeof(text) - length, "%d\n", index % 16);
+    }
+    result = TestWriteFile(path, text, length);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetPressure(NULL, &pressure);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetPressure(gInstance, NULL);
-    CU_ASSERT_EQUAL(result, EINVAL);
+    CU_ASSERT_EQUAL(pixels[1].red, 17);
+    CU_ASSERT_EQUAL(pixels[15].green, 255);
+    CU_ASSERT_EQUAL(pixels[16].blue, 0);
 
-    result = SenseHAT_GetCompass(gInstance, &heading);
+    // Test a bottom up 24 bit BMP, whose first stored row is the bottom of the image
+    (void)snprintf(path, sizeof(path), "%s/image.bmp", directory);
+    memset(data, 0, sizeof(data));
+    data[0] = 'B';
+    data[1] = 'M';
+    data[2] = 54 + 192;
+    data[10] = 54;
+    data[14] = 40;
+    data[18] = 8;
+    data[22] = 8;
+    data[26] = 1;
+    data[28] = 24;
+    for (index = 0; index < 64; index++)
+    {
+        data[54 + (index * 3)] = (uint8_t)index;            // Blue
+        data[54 + (index * 3) + 2] = (uint8_t)(index + 100);  // Red
+    }
+    result = TestWriteFile(path, data, 54 + 192);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetCompass(NULL, &heading);
+    CU_ASSERT_EQUAL(pixels[56].red, 100);
+    CU_ASSERT_EQUAL(pixels[56].blue, 0);
+    CU_ASSERT_EQUAL(pixels[1].red, 157);
+    CU_ASSERT_EQUAL(pixels[1].blue, 57);
+
+    // Test an RGB PNG using every filter type
+    (void)snprintf(path, sizeof(path), "%s/rgb.png", directory);
+    result = TestWriteFile(path, kRGBImage, sizeof(kRGBImage));
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 64; index++)
+    {
+        CU_ASSERT_EQUAL(pixels[index].red, (index % 8) * 32);
+        CU_ASSERT_EQUAL(pixels[index].green, (index / 8) * 32);
+        CU_ASSERT_EQUAL(pixels[index].blue, ((index % 8) * (index / 8) * 4) & 255);
+    }
+
+    // Test a 2 bit palette PNG
+    (void)snprintf(path, sizeof(path), "%s/palette.png", directory);
+    result = TestWriteFile(path, kPaletteImage, sizeof(kPaletteImage));
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[0].red, 0);
+    CU_ASSERT_EQUAL(pixels[1].red, 255);
+    CU_ASSERT_EQUAL(pixels[2].green, 255);
+    CU_ASSERT_EQUAL(pixels[10].blue, 255);
+
+    // Test a truncated PNG, an image of the wrong size and an unknown format
+    (void)snprintf(path, sizeof(path), "%s/truncated.png", directory);
+    result = TestWriteFile(path, kRGBImage, sizeof(kRGBImage) - 20);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, EPROTO);
+    (void)snprintf(path, sizeof(path), "%s/small.ppm", directory);
+    length = (size_t)snprintf((char*)data, sizeof(data), "P6 4 4 255\n");
+    memset(data + length, 0, 48);
+    result = TestWriteFile(path, data, length + 48);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    (void)snprintf(path, sizeof(path), "%s/image.gif", directory);
+    result = TestWriteFile(path, "GIF89a", 6);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, ENOTSUP);
+    (void)snprintf(path, sizeof(path), "%s/missing.png", directory);
+    result = SenseHAT_LEDDecodeImage(path, pixels);
+    CU_ASSERT_EQUAL(result, ENOENT);
+    result = SenseHAT_LEDDecodeImage(path, NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetCompass(gInstance, NULL);
+    result = SenseHAT_LEDDecodeImage(NULL, pixels);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    // Low level functions
-    result = SenseHAT_GetAccelerometer(gInstance, &orientation);
+    return;
+}
+
+// =================================================================================================
+//  TestSpriteFunctions
+// =================================================================================================
+void TestSpriteFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t frameCount = 0;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    uint8_t data[16 + (24 * 16 * 3)];
+    size_t length = 0;
+    tSenseHAT_SpriteAtlas atlas = NULL;
+    tSenseHAT_LEDPixelArray pixels;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    // A 24x16 sheet of six frames; red holds the frame number and green the pixel index
+    (void)snprintf(path, sizeof(path), "%s/sheet.ppm", directory);
+    length = (size_t)snprintf((char*)data, sizeof(data), "P6 24 16 255\n");
+    for (y = 0; y < 16; y++)
+    {
+        for (x = 0; x < 24; x++)
+        {
+            data[length++] = (uint8_t)(((y / 8) * 3) + (x / 8));
+            data[length++] = (uint8_t)(((y % 8) * 8) + (x % 8));
+            data[length++] = 0;
+        }
+    }
+    result = TestWriteFile(path, data, length);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    // Test SenseHAT_SpriteAtlasOpen and SenseHAT_SpriteAtlasGetFrameCount
+    result = SenseHAT_SpriteAtlasOpen(path, &atlas);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SpriteAtlasGetFrameCount(atlas, &frameCount);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetAccelerometer(NULL, &orientation);
+    CU_ASSERT_EQUAL(frameCount, 6);
+    result = SenseHAT_SpriteAtlasGetFrameCount(atlas, NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetAccelerometer(gInstance, NULL);
+
+    // Test SenseHAT_SpriteAtlasGetFrame
+    for (x = 0; x < frameCount; x++)
+    {
+        result = SenseHAT_SpriteAtlasGetFrame(atlas, x, pixels);
+        CU_ASSERT_EQUAL(result, 0);
+        for (y = 0; y < 64; y++)
+        {
+            CU_ASSERT_EQUAL(pixels[y].red, (int32_t)x);
+            CU_ASSERT_EQUAL(pixels[y].green, (int32_t)y);
+        }
+    }
+    result = SenseHAT_SpriteAtlasGetFrame(atlas, frameCount, pixels);
     CU_ASSERT_EQUAL(result, EINVAL);
-    
-    result = SenseHAT_GetAccelerometerRaw(gInstance, &rawData);
-    CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetAccelerometerRaw(NULL, &rawData);
+    result = SenseHAT_SpriteAtlasGetFrame(atlas, 0, NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetAccelerometerRaw(gInstance, NULL);
+    result = SenseHAT_LEDShowSprite(NULL, atlas, 0);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    result = SenseHAT_GetCompassRaw(gInstance, &rawData);
+    // Test SenseHAT_SpriteAtlasClose
+    result = SenseHAT_SpriteAtlasClose(&atlas);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetCompassRaw(NULL, &rawData);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetCompassRaw(gInstance, NULL);
+    CU_ASSERT_PTR_NULL(atlas);
+    result = SenseHAT_SpriteAtlasClose(&atlas);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    result = SenseHAT_GetGyroscope(gInstance, &orientation);
-    CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetGyroscope(NULL, &orientation);
+    // A sheet is not an LED image, and sheets must hold whole frames
+    result = SenseHAT_LEDDecodeImage(path, pixels);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetGyroscope(gInstance, NULL);
+    (void)snprintf(path, sizeof(path), "%s/ragged.ppm", directory);
+    length = (size_t)snprintf((char*)data, sizeof(data), "P6 12 8 255\n");
+    memset(data + length, 0, 12 * 8 * 3);
+    result = TestWriteFile(path, data, length + (12 * 8 * 3));
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SpriteAtlasOpen(path, &atlas);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    CU_ASSERT_PTR_NULL(atlas);
+    result = SenseHAT_SpriteAtlasOpen(NULL, &atlas);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    result = SenseHAT_GetGyroscopeRaw(gInstance, &rawData);
+    return;
+}
+
+// =================================================================================================
+//  TestAnimationFunctions
+// =================================================================================================
+void TestAnimationFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_AnimationFrame frames[5];
+    tSenseHAT_AnimationStatistics statistics;
+
+    // A replay instance has no LED matrix, so every frame it shows fails with EFAULT
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    record.timestamp = 1.0;
+    result = SenseHAT_RecorderAppend(recorder, &record);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetGyroscopeRaw(NULL, &rawData);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetGyroscopeRaw(gInstance, NULL);
-    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
 
-    result = SenseHAT_GetOrientation(gInstance, &orientation);
+    memset(frames, 0, sizeof(frames));
+    for (index = 0; index < 5; index++)
+    {
+        frames[index].pixels[index].red = 255;
+        frames[index].duration = 0.02;
+    }
+
+    // Test SenseHAT_AnimationStart and SenseHAT_AnimationGetStatistics
+    result = SenseHAT_AnimationStart(instance, frames, 5, false);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetOrientation(NULL, &orientation);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetOrientation(gInstance, NULL);
-    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_AnimationStart(instance, frames, 5, false);
+    CU_ASSERT_EQUAL(result, EBUSY);
+    result = SenseHAT_AnimationGetStatistics(instance, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_TRUE(statistics.playing);
+    (void)usleep(250000);
+    result = SenseHAT_AnimationGetStatistics(instance, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_FALSE(statistics.playing);
+    CU_ASSERT_EQUAL(statistics.framesShown + statistics.framesDropped, 5);
+    CU_ASSERT_EQUAL(statistics.frameIndex, 4);
+    CU_ASSERT_EQUAL(statistics.lastError, EFAULT);
+    CU_ASSERT_TRUE((statistics.fps > 0.0) && (statistics.fps < 100.0));
 
-    result = SenseHAT_GetOrientationDegrees(gInstance, &orientation);
+    // Test SenseHAT_AnimationStop
+    result = SenseHAT_AnimationStop(instance);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetOrientationDegrees(NULL, &orientation);
+    result = SenseHAT_AnimationStart(instance, frames, 5, true);
+    CU_ASSERT_EQUAL(result, 0);
+    (void)usleep(150000);
+    result = SenseHAT_AnimationStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_AnimationGetStatistics(instance, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_FALSE(statistics.playing);
+    CU_ASSERT_TRUE((statistics.framesShown + statistics.framesDropped) > 5);
+
+    // Bad frames are turned away before anything plays
+    frames[2].duration = 0.0;
+    result = SenseHAT_AnimationStart(instance, frames, 5, false);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetOrientationDegrees(gInstance, NULL);
+    frames[2].duration = 0.02;
+    frames[3].pixels[0].blue = 256;
+    result = SenseHAT_AnimationStart(instance, frames, 5, false);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_AnimationStart(instance, frames, 0, false);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_AnimationGetStatistics(instance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_AnimationStop(NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    result = SenseHAT_GetOrientationRadians(gInstance, &orientation);
+    // Closing the instance stops a playing animation
+    frames[3].pixels[0].blue = 0;
+    result = SenseHAT_AnimationStart(instance, frames, 5, true);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetOrientationRadians(NULL, &orientation);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestCompositorFunctions
+// =================================================================================================
+void TestCompositorFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+    tSenseHAT_Compositor compositor = NULL;
+    tSenseHAT_RGBAPixelArray background;
+    tSenseHAT_RGBAPixelArray overlay;
+    tSenseHAT_LEDPixelArray pixels;
+
+    // Test SenseHAT_CompositorOpen, off screen
+    result = SenseHAT_CompositorOpen(NULL, 0, &compositor);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetOrientationRadians(gInstance, NULL);
+    result = SenseHAT_CompositorOpen(NULL, kSenseHAT_CompositorLayersMax + 1, &compositor);
     CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_CompositorOpen(NULL, 3, &compositor);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[0].red + pixels[63].green + pixels[31].blue, 0);
 
-    result = SenseHAT_GetTemperatureFromHumidity(gInstance, &temperature);
+    // Test SenseHAT_CompositorSetLayer; an opaque red background under a half transparent blue
+    // overlay, which leaves pixel 63 alone
+    for (index = 0; index < 64; index++)
+    {
+        background[index].red = 255;
+        background[index].green = 0;
+        background[index].blue = 0;
+        background[index].alpha = 255;
+        overlay[index].red = 0;
+        overlay[index].green = 0;
+        overlay[index].blue = 255;
+        overlay[index].alpha = (index == 63) ? 0 : 128;
+    }
+    result = SenseHAT_CompositorSetLayer(compositor, 0, background);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetTemperatureFromHumidity(NULL, &temperature);
-    CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetTemperatureFromHumidity(gInstance, NULL);
+    result = SenseHAT_CompositorSetLayer(compositor, 1, overlay);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 63; index++)
+    {
+        CU_ASSERT_EQUAL(pixels[index].red, 127);
+        CU_ASSERT_EQUAL(pixels[index].green, 0);
+        CU_ASSERT_EQUAL(pixels[index].blue, 128);
+    }
+    CU_ASSERT_EQUAL(pixels[63].red, 255);
+    CU_ASSERT_EQUAL(pixels[63].blue, 0);
+
+    // Test SenseHAT_CompositorSetLayerOpacity
+    result = SenseHAT_CompositorSetLayerOpacity(compositor, 1, 0.5);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[5].red, 191);
+    CU_ASSERT_EQUAL(pixels[5].blue, 64);
+    result = SenseHAT_CompositorSetLayerOpacity(compositor, 1, 0.0);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[5].red, 255);
+    CU_ASSERT_EQUAL(pixels[5].blue, 0);
+    result = SenseHAT_CompositorSetLayerOpacity(compositor, 1, 1.5);
     CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_CompositorSetLayerOpacity(compositor, 1, 1.0);
+    CU_ASSERT_EQUAL(result, 0);
 
-    result = SenseHAT_GetTemperatureFromPressure(gInstance, &temperature);
+    // Test SenseHAT_CompositorSetLayerOrder; moving the background to the top hides the overlay
+    result = SenseHAT_CompositorSetLayerOrder(compositor, 0, 10);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetTemperatureFromPressure(NULL, &pressure);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[5].red, 255);
+    CU_ASSERT_EQUAL(pixels[5].blue, 0);
+    result = SenseHAT_CompositorSetLayerOrder(compositor, 0, -1);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_CompositorGetFrame(compositor, pixels);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(pixels[5].red, 127);
+    CU_ASSERT_EQUAL(pixels[5].blue, 128);
+
+    // Bad arguments
+    result = SenseHAT_CompositorSetLayer(compositor, 3, overlay);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetTemperatureFromPressure(gInstance, NULL);
+    result = SenseHAT_CompositorSetLayer(compositor, 0, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_CompositorSetLayerOrder(compositor, 3, 0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_CompositorGetFrame(compositor, NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
 
-    result = SenseHAT_SetIMUConfiguration(gInstance, true, true, true);
+    // Test SenseHAT_CompositorClose
+    result = SenseHAT_CompositorClose(&compositor);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, true, true, false);
+    CU_ASSERT_PTR_NULL(compositor);
+    result = SenseHAT_CompositorClose(&compositor);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    return;
+}
+
+// =================================================================================================
+//  TestColorFunctions
+// =================================================================================================
+void TestColorFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+    uint8_t gamma[kSenseHAT_GammaTableSize];
+    uint8_t rgb[100 * 3];
+    uint16_t output[128];
+    tSenseHAT_ColorTable table;
+    tSenseHAT_LEDPixelArray frames[2];
+
+    // Test SenseHAT_ColorConvertFrames, packing as the Python library does
+    memset(frames, 0, sizeof(frames));
+    frames[0][0].red = 255;
+    frames[0][0].green = 255;
+    frames[0][0].blue = 255;
+    frames[0][1].red = 255;
+    frames[0][2].green = 255;
+    frames[0][3].red = 8;
+    frames[0][3].green = 4;
+    frames[0][3].blue = 8;
+    frames[0][4].red = 7;
+    frames[0][4].green = 3;
+    frames[0][4].blue = 7;
+    frames[1][63].blue = 255;
+    result = SenseHAT_ColorConvertFrames(NULL, frames, 2, output);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, true, false, false);
+    CU_ASSERT_EQUAL(output[0], 0xFFFF);
+    CU_ASSERT_EQUAL(output[1], 0xF800);
+    CU_ASSERT_EQUAL(output[2], 0x07E0);
+    CU_ASSERT_EQUAL(output[3], 0x0821);
+    CU_ASSERT_EQUAL(output[4], 0x0000);
+    CU_ASSERT_EQUAL(output[64 + 63], 0x001F);
+
+    // Test SenseHAT_ColorTableInitialize
+    result = SenseHAT_ColorTableInitialize(&table, NULL, 0.5);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, false, false, false);
+    result = SenseHAT_ColorConvertFrames(&table, frames, 1, output);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, false, false, true);
+    CU_ASSERT_EQUAL(output[0], 0x8410);
+    for (index = 0; index < kSenseHAT_GammaTableSize; index++)
+    {
+        gamma[index] = (uint8_t)(index / 2);
+    }
+    result = SenseHAT_ColorTableInitialize(&table, gamma, 1.0);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, false, true, true);
+    result = SenseHAT_ColorConvertFrames(&table, frames, 1, output);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, false, true, false);
+    CU_ASSERT_EQUAL(output[0], (15 << 11) | (30 << 5) | 15);
+
+    // Test SenseHAT_ColorConvertRGB888; vector and table conversions must agree
+    for (index = 0; index < sizeof(rgb); index++)
+    {
+        rgb[index] = (uint8_t)((index * 37) + 11);
+    }
+    result = SenseHAT_ColorTableInitialize(&table, NULL, 0.7);
     CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_SetIMUConfiguration(gInstance, true, false, true);
+    result = SenseHAT_ColorConvertRGB888(&table, rgb, 100, output);
     CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 100; index++)
+    {
+        CU_ASSERT_EQUAL(output[index], table.red[rgb[index * 3]] | table.green[rgb[(index * 3) + 1]] | table.blue[rgb[(index * 3) + 2]]);
+    }
+
+    // Bad arguments
+    frames[0][10].green = 256;
+    result = SenseHAT_ColorConvertFrames(NULL, frames, 1, output);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    frames[0][10].green = -1;
+    result = SenseHAT_ColorConvertFrames(NULL, frames, 1, output);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_ColorTableInitialize(&table, NULL, 1.5);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    gamma[5] = 32;
+    result = SenseHAT_ColorTableInitialize(&table, gamma, 1.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_ColorConvertRGB888(NULL, NULL, 1, output);
+    CU_ASSERT_EQUAL(result, EINVAL);
 
     return;
 }
 
 // =================================================================================================
-//  TestEventFunctions
+//  TestGammaFunctions
 // =================================================================================================
-void TestEventFunctions (void)
+void TestGammaFunctions (void)
 {
     int32_t result = 0;
-    int32_t count = 0;
-    tSenseHAT_JoystickEvent event;
-    tSenseHAT_JoystickEvent* events = NULL;
+    uint32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    uint8_t gamma[kSenseHAT_GammaTableSize];
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
 
-    // Test SenseHAT_GetEvents
-    result = SenseHAT_GetEvents(gInstance, &count, &events);
+    // A replay instance has no LED matrix framebuffer to send gamma tables to
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    record.timestamp = 1.0;
+    result = SenseHAT_RecorderAppend(recorder, &record);
     CU_ASSERT_EQUAL(result, 0);
-    if (events != NULL)
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    for (index = 0; index < kSenseHAT_GammaTableSize; index++)
     {
-        free((void*)events);
-        events = NULL;
+        gamma[index] = (uint8_t)index;
     }
-    result = SenseHAT_GetEvents(gInstance, &count, NULL);
-    CU_ASSERT_EQUAL(result, 0);
-    result = SenseHAT_GetEvents(NULL, &count, &events);
+    result = SenseHAT_LEDGammaGet(instance, gamma);
+    CU_ASSERT_EQUAL(result, ENODEV);
+    result = SenseHAT_LEDGammaSet(instance, gamma);
+    CU_ASSERT_EQUAL(result, ENODEV);
+    result = SenseHAT_LEDSetLowLight(instance, true);
+    CU_ASSERT_EQUAL(result, ENODEV);
+    result = SenseHAT_LEDSetBrightness(instance, 0.25);
+    CU_ASSERT_EQUAL(result, ENODEV);
+
+    // Bad arguments
+    gamma[31] = 32;
+    result = SenseHAT_LEDGammaSet(instance, gamma);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_GetEvents(gInstance, NULL, &events);
+    result = SenseHAT_LEDGammaGet(instance, NULL);
     CU_ASSERT_EQUAL(result, EINVAL);
-
-    // Test SenseHAT_WaitForEvent
-    result = SenseHAT_WaitForEvent(NULL, true, &event);
+    result = SenseHAT_LEDSetBrightness(instance, 1.5);
     CU_ASSERT_EQUAL(result, EINVAL);
-    result = SenseHAT_WaitForEvent(gInstance, false, NULL);
+    result = SenseHAT_LEDSetLowLight(NULL, false);
     CU_ASSERT_EQUAL(result, EINVAL);
 
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestPaletteFunctions
+// =================================================================================================
+void TestPaletteFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+    tSenseHAT_LEDPixel colors[20];
+    tSenseHAT_Palette palette;
+    tSenseHAT_LEDPixelArray pixels;
+    tSenseHAT_LEDPixelArray expanded;
+    uint8_t indices4[3 * 32];
+    uint8_t indices8[64];
+    uint16_t device[3 * 64];
+    uint16_t converted[64];
+
+    // Test SenseHAT_PaletteInitialize
+    memset(colors, 0, sizeof(colors));
+    for (index = 0; index < 20; index++)
+    {
+        colors[index].red = (int32_t)(index * 12);
+        colors[index].green = 255 - (int32_t)(index * 12);
+        colors[index].blue = (int32_t)((index * 40) % 256);
+    }
+    result = SenseHAT_PaletteInitialize(&palette, colors, 20);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    // Test SenseHAT_PaletteEncodeFrame and SenseHAT_PaletteExpandFrame
+    for (index = 0; index < 64; index++)
+    {
+        pixels[index] = colors[(index * 7) % 16];
+    }
+    result = SenseHAT_PaletteEncodeFrame(&palette, pixels, eSenseHAT_PaletteIndex4Bit, indices4);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(indices4[0], 0x70);
+    result = SenseHAT_PaletteEncodeFrame(&palette, pixels, eSenseHAT_PaletteIndex8Bit, indices8);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(indices8[1], 7);
+    result = SenseHAT_PaletteExpandFrame(&palette, indices4, eSenseHAT_PaletteIndex4Bit, expanded);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(expanded, pixels, sizeof(tSenseHAT_LEDPixelArray)), 0);
+    result = SenseHAT_PaletteExpandFrame(&palette, indices8, eSenseHAT_PaletteIndex8Bit, expanded);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(expanded, pixels, sizeof(tSenseHAT_LEDPixelArray)), 0);
+
+    // Test SenseHAT_PaletteExpandRGB565 against the color conversion
+    result = SenseHAT_ColorConvertFrames(NULL, (const tSenseHAT_LEDPixelArray*)&pixels, 1, converted);
+    CU_ASSERT_EQUAL(result, 0);
+    memcpy(indices4 + 32, indices4, 32);
+    memcpy(indices4 + 64, indices4, 32);
+    indices4[95] = 0xFF;
+    result = SenseHAT_PaletteExpandRGB565(&palette, indices4, eSenseHAT_PaletteIndex4Bit, 3, device);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 64; index++)
+    {
+        CU_ASSERT_EQUAL(device[index], converted[index]);
+        CU_ASSERT_EQUAL(device[64 + index], converted[index]);
+    }
+    CU_ASSERT_EQUAL(device[128 + 61], converted[61]);
+    CU_ASSERT_EQUAL(device[128 + 62], converted[9]);
+    CU_ASSERT_EQUAL(device[128 + 63], converted[9]);
+    result = SenseHAT_PaletteExpandRGB565(&palette, indices8, eSenseHAT_PaletteIndex8Bit, 1, device);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(device, converted, sizeof(converted)), 0);
+
+    // Bad arguments
+    pixels[5].red = 1;
+    result = SenseHAT_PaletteEncodeFrame(&palette, pixels, eSenseHAT_PaletteIndex8Bit, indices8);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    pixels[5] = colors[17];
+    result = SenseHAT_PaletteEncodeFrame(&palette, pixels, eSenseHAT_PaletteIndex4Bit, indices4);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_PaletteEncodeFrame(&palette, pixels, eSenseHAT_PaletteIndex8Bit, indices8);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_PaletteExpandFrame(&palette, indices8, (tSenseHAT_PaletteIndexSize)2, expanded);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    colors[3].blue = 300;
+    result = SenseHAT_PaletteInitialize(&palette, colors, 20);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_PaletteInitialize(&palette, colors, 0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_LEDShowPaletteFrame(NULL, &palette, indices8, eSenseHAT_PaletteIndex8Bit);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    return;
+}
+
+// =================================================================================================
+//  TestClipFunctions
+// =================================================================================================
+void TestClipFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t frame = 0;
+    uint32_t index = 0;
+    uint32_t frameCount = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    uint8_t data[256];
+    double duration = 0.0;
+    struct stat status;
+    tSenseHAT_AnimationFrame* frames = NULL;
+    tSenseHAT_Clip clip = NULL;
+    uint16_t (*converted)[64] = NULL;
+    uint16_t pixels[64];
+    tSenseHAT_LEDPixelArray shown;
+    tSenseHAT_LEDPixelArray background;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    (void)snprintf(path, sizeof(path), "%s/clip.shac", directory);
+
+    // A dot wandering over a still background, with the background changing once
+    frames = (tSenseHAT_AnimationFrame*)calloc(120, sizeof(tSenseHAT_AnimationFrame));
+    converted = (uint16_t (*)[64])calloc(120, sizeof(uint16_t[64]));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(frames);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(converted);
+    for (frame = 0; frame < 120; frame++)
+    {
+        for (index = 0; index < 64; index++)
+        {
+            frames[frame].pixels[index].red = (frame < 90) ? 0 : 40;
+            frames[frame].pixels[index].green = (int32_t)((index / 8) * 16);
+            frames[frame].pixels[index].blue = 32;
+        }
+        frames[frame].pixels[(frame * 5) % 64].red = 255;
+        frames[frame].pixels[(frame * 5) % 64].green = 255;
+        frames[frame].pixels[(frame * 5) % 64].blue = 255;
+        frames[frame].duration = 0.05;
+        result = SenseHAT_ColorConvertFrames(NULL, (const tSenseHAT_LEDPixelArray*)&(frames[frame].pixels), 1, converted[frame]);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+
+    // Test SenseHAT_ClipWrite and SenseHAT_ClipOpen
+    result = SenseHAT_ClipWrite(path, frames, 120, 30);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    CU_ASSERT_EQUAL(stat(path, &status), 0);
+    CU_ASSERT(status.st_size < (off_t)(120 * 64 * sizeof(uint16_t) / 4));
+    result = SenseHAT_ClipOpen(path, &clip);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(clip);
+    result = SenseHAT_ClipGetFrameCount(clip, &frameCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(frameCount, 120);
+
+    // Test SenseHAT_ClipGetFrame, playing forward
+    for (frame = 0; frame < 120; frame++)
+    {
+        result = SenseHAT_ClipGetFrame(clip, frame, pixels, &duration);
+        CU_ASSERT_EQUAL(result, 0);
+        CU_ASSERT_EQUAL(memcmp(pixels, converted[frame], sizeof(pixels)), 0);
+        CU_ASSERT_DOUBLE_EQUAL(duration, 0.05, 0.000001);
+    }
+
+    // Test SenseHAT_ClipGetFrame, seeking
+    result = SenseHAT_ClipGetFrame(clip, 77, pixels, &duration);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(pixels, converted[77], sizeof(pixels)), 0);
+    result = SenseHAT_ClipGetFrame(clip, 5, pixels, &duration);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(pixels, converted[5], sizeof(pixels)), 0);
+    result = SenseHAT_ClipGetFrame(clip, 5, pixels, &duration);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(pixels, converted[5], sizeof(pixels)), 0);
+    result = SenseHAT_ClipGetFrame(clip, 119, pixels, &duration);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(pixels, converted[119], sizeof(pixels)), 0);
+    result = SenseHAT_ClipGetFrame(clip, 120, pixels, &duration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_LEDShowClipFrame over something else on the LED matrix, showing the same frame
+    // twice so the second show has nothing new to decode
+    for (index = 0; index < 64; index++)
+    {
+        background[index].red = 255;
+        background[index].green = 0;
+        background[index].blue = 0;
+    }
+    for (frame = 0; frame < 2; frame++)
+    {
+        result = SenseHAT_LEDSetPixels(gInstance, background);
+        CU_ASSERT_EQUAL(result, 0);
+        result = SenseHAT_LEDShowClipFrame(gInstance, clip, 0);
+        CU_ASSERT_EQUAL(result, 0);
+        result = SenseHAT_LEDGetPixels(gInstance, shown);
+        CU_ASSERT_EQUAL(result, 0);
+        for (index = 0; index < 64; index++)
+        {
+            CU_ASSERT_EQUAL(shown[index].red, (frames[0].pixels[index].red & 0xF8));
+            CU_ASSERT_EQUAL(shown[index].green, (frames[0].pixels[index].green & 0xFC));
+            CU_ASSERT_EQUAL(shown[index].blue, (frames[0].pixels[index].blue & 0xF8));
+        }
+    }
+    result = SenseHAT_LEDShowClipFrame(NULL, clip, 0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_ClipClose(&clip);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_PTR_NULL(clip);
+
+    // Without periodic keyframes
+    result = SenseHAT_ClipWrite(path, frames, 120, 0);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_ClipOpen(path, &clip);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_ClipGetFrame(clip, 100, pixels, &duration);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(memcmp(pixels, converted[100], sizeof(pixels)), 0);
+    (void)SenseHAT_ClipClose(&clip);
+
+    // Truncated and foreign files
+    CU_ASSERT_EQUAL(truncate(path, 100), 0);
+    result = SenseHAT_ClipOpen(path, &clip);
+    CU_ASSERT_EQUAL(result, EPROTO);
+    CU_ASSERT_PTR_NULL(clip);
+    memset(data, 'x', sizeof(data));
+    CU_ASSERT_EQUAL(TestWriteFile(path, data, sizeof(data)), 0);
+    result = SenseHAT_ClipOpen(path, &clip);
+    CU_ASSERT_EQUAL(result, EPROTO);
+    (void)unlink(path);
+
+    // Bad arguments
+    frames[3].duration = 0.0;
+    result = SenseHAT_ClipWrite(path, frames, 120, 30);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    CU_ASSERT_NOT_EQUAL(stat(path, &status), 0);
+    result = SenseHAT_ClipWrite(path, frames, 0, 30);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_ClipOpen(path, &clip);
+    CU_ASSERT_EQUAL(result, ENOENT);
+    result = SenseHAT_ClipClose(&clip);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    free((void*)converted);
+    free((void*)frames);
+    (void)rmdir(directory);
+    return;
+}
+
+// =================================================================================================
+//  TestStreamFunctions
+// =================================================================================================
+void TestStreamFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t frame = 0;
+    uint32_t attempts = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    uint8_t data[10 * 192];
+    int fd = -1;
+    int fds[2] = { -1, -1 };
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_StreamStatistics statistics;
+
+    // A replay instance can't show frames, but still paces and counts them
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    record.timestamp = 1.0;
+    result = SenseHAT_RecorderAppend(recorder, &record);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    for (frame = 0; frame < sizeof(data); frame++)
+    {
+        data[frame] = (uint8_t)frame;
+    }
+
+    // Test a file; it's read as it's shown, so nothing is dropped
+    (void)snprintf(path, sizeof(path), "%s/frames.rgb", directory);
+    CU_ASSERT_EQUAL(TestWriteFile(path, data, (10 * 128) + 5), 0);
+    fd = open(path, O_RDONLY);
+    CU_ASSERT_NOT_EQUAL_FATAL(fd, -1);
+    result = SenseHAT_StreamStart(instance, fd, eSenseHAT_StreamFormatRGB565, 200.0, 2);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_StreamStart(instance, fd, eSenseHAT_StreamFormatRGB565, 200.0, 2);
+    CU_ASSERT_EQUAL(result, EBUSY);
+    do
+    {
+        (void)usleep(10000);
+        result = SenseHAT_StreamGetStatistics(instance, &statistics);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    while (statistics.playing && (++attempts < 200));
+    CU_ASSERT_FALSE(statistics.playing);
+    CU_ASSERT_TRUE(statistics.endOfStream);
+    CU_ASSERT_EQUAL(statistics.framesRead, 10);
+    CU_ASSERT_EQUAL(statistics.framesShown, 10);
+    CU_ASSERT_EQUAL(statistics.framesDropped, 0);
+    CU_ASSERT_EQUAL(statistics.lastError, EFAULT);
+    (void)close(fd);
+
+    // Test a pipe written faster than it's shown; the oldest frames give way
+    CU_ASSERT_EQUAL_FATAL(pipe(fds), 0);
+    result = SenseHAT_StreamStart(instance, fds[0], eSenseHAT_StreamFormatRGB888, 1.0, 2);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(write(fds[1], data, sizeof(data)), (ssize_t)sizeof(data));
+    (void)close(fds[1]);
+    attempts = 0;
+    do
+    {
+        (void)usleep(10000);
+        result = SenseHAT_StreamGetStatistics(instance, &statistics);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    while (!statistics.endOfStream && (++attempts < 200));
+    CU_ASSERT_TRUE(statistics.playing);
+    CU_ASSERT_EQUAL(statistics.framesRead, 10);
+    CU_ASSERT(statistics.framesDropped >= 7);
+    result = SenseHAT_StreamStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_StreamGetStatistics(instance, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_FALSE(statistics.playing);
+    result = SenseHAT_StreamStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test stopping a stream that's waiting for data
+    CU_ASSERT_EQUAL_FATAL(pipe(fds), 0);
+    result = SenseHAT_StreamStart(instance, fds[0], eSenseHAT_StreamFormatRGB888, 50.0, 4);
+    CU_ASSERT_EQUAL(result, 0);
+    (void)usleep(50000);
+    result = SenseHAT_StreamStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_StreamGetStatistics(instance, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(statistics.framesRead, 0);
+    CU_ASSERT(statistics.underruns > 0);
+    (void)close(fds[0]);
+    (void)close(fds[1]);
+
+    // Bad arguments
+    result = SenseHAT_StreamStart(instance, -1, eSenseHAT_StreamFormatRGB888, 30.0, 4);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_StreamStart(instance, 0, (tSenseHAT_StreamFormat)2, 30.0, 4);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_StreamStart(instance, 0, eSenseHAT_StreamFormatRGB888, 0.0, 4);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_StreamStart(instance, 0, eSenseHAT_StreamFormatRGB888, 30.0, kSenseHAT_StreamBufferFramesMax + 1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_StreamGetStatistics(instance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_StreamStop(NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    (void)unlink(path);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+    return;
+}
+
+// =================================================================================================
+//  TestEnvironmentalFunctions
+// =================================================================================================
+void TestEnvironmentalFunctions (void)
+{
+    double humidity = 0.0;
+    double temperature = 0.0;
+    double pressure = 0.0;
+    double heading = 0.0;
+    tSenseHAT_Orientation orientation;
+    tSenseHAT_RawData rawData;
+    int32_t result = 0;
+
+    // High level functions
+    result = SenseHAT_GetHumidity(gInstance, &humidity);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetHumidity(NULL, &humidity);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetHumidity(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetTemperature(gInstance, &temperature);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetTemperature(NULL, &temperature);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetTemperature(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetPressure(gInstance, &pressure);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetPressure(NULL, &pressure);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetPressure(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetCompass(gInstance, &heading);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetCompass(NULL, &heading);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetCompass(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Low level functions
+    result = SenseHAT_GetAccelerometer(gInstance, &orientation);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetAccelerometer(NULL, &orientation);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetAccelerometer(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    
+    result = SenseHAT_GetAccelerometerRaw(gInstance, &rawData);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetAccelerometerRaw(NULL, &rawData);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetAccelerometerRaw(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetCompassRaw(gInstance, &rawData);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetCompassRaw(NULL, &rawData);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetCompassRaw(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetGyroscope(gInstance, &orientation);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetGyroscope(NULL, &orientation);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetGyroscope(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetGyroscopeRaw(gInstance, &rawData);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetGyroscopeRaw(NULL, &rawData);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetGyroscopeRaw(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetOrientation(gInstance, &orientation);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetOrientation(NULL, &orientation);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetOrientation(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetOrientationDegrees(gInstance, &orientation);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetOrientationDegrees(NULL, &orientation);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetOrientationDegrees(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetOrientationRadians(gInstance, &orientation);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetOrientationRadians(NULL, &orientation);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetOrientationRadians(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetTemperatureFromHumidity(gInstance, &temperature);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetTemperatureFromHumidity(NULL, &temperature);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetTemperatureFromHumidity(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_GetTemperatureFromPressure(gInstance, &temperature);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetTemperatureFromPressure(NULL, &pressure);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetTemperatureFromPressure(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    result = SenseHAT_SetIMUConfiguration(gInstance, true, true, true);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, true, true, false);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, true, false, false);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, false, false, false);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, false, false, true);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, false, true, true);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, false, true, false);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetIMUConfiguration(gInstance, true, false, true);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestEventFunctions
+// =================================================================================================
+void TestEventFunctions (void)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+    tSenseHAT_JoystickEvent event;
+    tSenseHAT_JoystickEvent* events = NULL;
+    tSenseHAT_JoystickEvent eventBuffer[16];
+
+    // Test SenseHAT_GetEvents
+    result = SenseHAT_GetEvents(gInstance, &count, &events);
+    CU_ASSERT_EQUAL(result, 0);
+    if (events != NULL)
+    {
+        free((void*)events);
+        events = NULL;
+    }
+    result = SenseHAT_GetEvents(gInstance, &count, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetEvents(NULL, &count, &events);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetEvents(gInstance, NULL, &events);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetEventsInto
+    result = SenseHAT_GetEventsInto(gInstance, eventBuffer, 16, &count);
+    CU_ASSERT((result == 0) || (result == ENOBUFS));
+    CU_ASSERT((count >= 0) && (count <= 16));
+    result = SenseHAT_GetEventsInto(NULL, eventBuffer, 16, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetEventsInto(gInstance, NULL, 16, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetEventsInto(gInstance, eventBuffer, 0, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetEventsInto(gInstance, eventBuffer, 16, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetDroppedEventCount
+    uint64_t droppedCount = 0;
+    result = SenseHAT_GetDroppedEventCount(gInstance, &droppedCount);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetDroppedEventCount(NULL, &droppedCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetDroppedEventCount(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_WaitForEvent
+    result = SenseHAT_WaitForEvent(NULL, true, &event);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_WaitForEvent(gInstance, false, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetNotificationFd
+    int32_t notificationFd = -1;
+    result = SenseHAT_GetNotificationFd(gInstance, &notificationFd);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(notificationFd >= 0);
+    result = SenseHAT_GetNotificationFd(NULL, &notificationFd);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetNotificationFd(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_WaitForSources
+    uint32_t readySources = eSenseHAT_WaitSourceNone;
+    result = SenseHAT_WaitForSources(gInstance, eSenseHAT_WaitSourceJoystick, -1, 0, &readySources);
+    CU_ASSERT((result == 0) || (result == ETIMEDOUT) || (result == ENOTSUP));
+    result = SenseHAT_WaitForSources(NULL, eSenseHAT_WaitSourceJoystick, -1, 0, &readySources);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_WaitForSources(gInstance, eSenseHAT_WaitSourceNone, -1, 0, &readySources);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_WaitForSources(gInstance, eSenseHAT_WaitSourceUser, -1, 0, &readySources);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_WaitForSources(gInstance, eSenseHAT_WaitSourceJoystick, -1, 0, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    return;
+}
+
+// =================================================================================================
+//  TestSamplerFunctions
+// =================================================================================================
+void TestSamplerFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t readySources = eSenseHAT_WaitSourceNone;
+    tSenseHAT_Sample sample;
+    tSenseHAT_Instance instance = NULL;
+
+    // Test SenseHAT_SamplerStart
+    result = SenseHAT_SamplerStart(NULL, eSenseHAT_ChannelAll, 0.1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerStart(gInstance, eSenseHAT_ChannelNone, 0.1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerStart(gInstance, eSenseHAT_ChannelAll, 0.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerStart(gInstance, eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure, 0.1);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerStart(gInstance, eSenseHAT_ChannelAll, 0.1);
+    CU_ASSERT_EQUAL(result, EBUSY);
+
+    // Test SenseHAT_SamplerGetLatest
+    result = SenseHAT_WaitForSources(gInstance, eSenseHAT_WaitSourceSampler, -1, 2000, &readySources);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT((readySources & eSenseHAT_WaitSourceSampler) != 0);
+    result = SenseHAT_SamplerGetLatest(gInstance, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(sample.sequence > 0);
+    CU_ASSERT((sample.channels & ~(eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure)) == 0);
+    result = SenseHAT_SamplerGetLatest(NULL, &sample);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerGetLatest(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_SamplerStop
+    result = SenseHAT_SamplerStop(gInstance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerStop(gInstance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerStop(NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test that a second instance can't take over the interpreter the suite's instance released
+    result = SenseHAT_Open(&instance);
+    CU_ASSERT_EQUAL(result, EBUSY);
+    CU_ASSERT_PTR_NULL(instance);
+
+    return;
+}
+
+// =================================================================================================
+//  TestRollupFunctions
+// =================================================================================================
+void TestRollupFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    uint32_t bucketCount = 0;
+    uint64_t totalCount = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    FILE* file = NULL;
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_RollupBucket buckets[kSenseHAT_RollupBuckets];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    (void)snprintf(path, sizeof(path), "%s/rollups", directory);
+
+    // Record 20 temperatures to replay through the sampler
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    for (index = 0; index < 20; index++)
+    {
+        record.timestamp = 1.0 + index;
+        record.values[0] = 20.0 + index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SamplerSetRollupFile
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SamplerSetRollupFile(instance, "");
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerSetRollupFile(instance, path);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Sample until the log runs out
+    result = SenseHAT_SamplerStart(instance, eSenseHAT_ChannelTemperature, 0.005);
+    CU_ASSERT_EQUAL(result, 0);
+    (void)usleep(500000);
+    result = SenseHAT_SamplerStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SamplerGetRollups
+    result = SenseHAT_SamplerGetRollups(instance, eSenseHAT_ChannelCompass, eSenseHAT_RollupMinute,
+                                        buckets, kSenseHAT_RollupBuckets, &bucketCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerGetRollups(instance, eSenseHAT_ChannelPressure, eSenseHAT_RollupMinute,
+                                        buckets, kSenseHAT_RollupBuckets, &bucketCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(bucketCount, 0);
+    result = SenseHAT_SamplerGetRollups(instance, eSenseHAT_ChannelTemperature, eSenseHAT_RollupSecond,
+                                        buckets, kSenseHAT_RollupBuckets, &bucketCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(bucketCount > 0);
+    for (index = 0; index < (int32_t)bucketCount; index++)
+    {
+        CU_ASSERT(buckets[index].minimum >= 20.0);
+        CU_ASSERT(buckets[index].maximum <= 39.0);
+        CU_ASSERT(buckets[index].minimum <= buckets[index].mean);
+        CU_ASSERT(buckets[index].mean <= buckets[index].maximum);
+        totalCount += buckets[index].count;
+    }
+    CU_ASSERT_EQUAL(totalCount, 20);
+    result = SenseHAT_SamplerGetRollups(instance, eSenseHAT_ChannelTemperature, eSenseHAT_RollupHour,
+                                        buckets, 1, &bucketCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(bucketCount, 1);
+    if (buckets[0].count == 20)
+    {
+        CU_ASSERT_DOUBLE_EQUAL(buckets[0].mean, 29.5, 0.0001);
+        CU_ASSERT_DOUBLE_EQUAL(buckets[0].standardDeviation, sqrt(399.0 / 12.0), 0.0001);
+    }
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test loading the saved rollups
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SamplerSetRollupFile(instance, path);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerGetRollups(instance, eSenseHAT_ChannelTemperature, eSenseHAT_RollupSecond,
+                                        buckets, kSenseHAT_RollupBuckets, &bucketCount);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < (int32_t)bucketCount; index++)
+    {
+        totalCount -= buckets[index].count;
+    }
+    CU_ASSERT_EQUAL(totalCount, 0);
+    file = fopen(path, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    (void)fputs("not rollups", file);
+    (void)fclose(file);
+    result = SenseHAT_SamplerSetRollupFile(instance, path);
+    CU_ASSERT_EQUAL(result, EPROTO);
+    result = SenseHAT_SamplerSetRollupFile(instance, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestFilterFunctions
+// =================================================================================================
+void TestFilterFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char compassDirectory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Filter filter;
+    tSenseHAT_Filter single;
+    tSenseHAT_FilterStage stages[kSenseHAT_FilterStagesMax + 1];
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Sample sample;
+    tSenseHAT_Sample filtered;
+    double input[16];
+    double output[16];
+    double value = 0.0;
+
+    memset(stages, 0, sizeof(stages));
+
+    // Test SenseHAT_FilterInitialize
+    stages[0].type = eSenseHAT_FilterEMA;
+    stages[0].alpha = 0.0;
+    result = SenseHAT_FilterInitialize(&filter, stages, 1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    stages[0].type = eSenseHAT_FilterMedian;
+    stages[0].length = kSenseHAT_FilterTapsMax + 1;
+    result = SenseHAT_FilterInitialize(&filter, stages, 1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_FilterInitialize(&filter, stages, kSenseHAT_FilterStagesMax + 1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_FilterInitialize(NULL, stages, 0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test a median of 3 against a spike
+    stages[0].length = 3;
+    result = SenseHAT_FilterInitialize(&filter, stages, 1);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 8; index++)
+    {
+        input[index] = (index == 4) ? 100.0 : 1.0;
+    }
+    result = SenseHAT_FilterProcess(&filter, input, output, 8);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 8; index++)
+    {
+        CU_ASSERT_DOUBLE_EQUAL(output[index], 1.0, 0.0);
+    }
+
+    // Test an EMA against a step
+    stages[0].type = eSenseHAT_FilterEMA;
+    stages[0].alpha = 0.5;
+    result = SenseHAT_FilterInitialize(&filter, stages, 1);
+    CU_ASSERT_EQUAL(result, 0);
+    input[0] = 0.0;
+    input[1] = 8.0;
+    input[2] = 8.0;
+    result = SenseHAT_FilterProcess(&filter, input, output, 3);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(output[0], 0.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(output[1], 4.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(output[2], 6.0, 0.0);
+
+    // Test a 4 tap moving average followed by a pass-through biquad, in blocks and one value 
+    // at a time
+    stages[0].type = eSenseHAT_FilterFIR;
+    stages[0].length = 4;
+    for (index = 0; index < 4; index++)
+    {
+        stages[0].coefficients[index] = 0.25;
+    }
+    stages[1].type = eSenseHAT_FilterBiquad;
+    stages[1].coefficients[0] = 1.0;
+    result = SenseHAT_FilterInitialize(&filter, stages, 2);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_FilterInitialize(&single, stages, 2);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 16; index++)
+    {
+        input[index] = (double)index;
+    }
+    result = SenseHAT_FilterProcess(&filter, input, output, 16);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(output[0], 0.0, 0.0);
+    CU_ASSERT_DOUBLE_EQUAL(output[1], 0.25, 0.0);
+    for (index = 3; index < 16; index++)
+    {
+        CU_ASSERT_DOUBLE_EQUAL(output[index], index - 1.5, 0.0);
+    }
+    for (index = 0; index < 16; index++)
+    {
+        result = SenseHAT_FilterProcess(&single, &(input[index]), &value, 1);
+        CU_ASSERT_EQUAL(result, 0);
+        CU_ASSERT_DOUBLE_EQUAL(value, output[index], 0.0);
+    }
+
+    // Test SenseHAT_FilterReset, filtering in place
+    result = SenseHAT_FilterReset(&filter);
+    CU_ASSERT_EQUAL(result, 0);
+    memcpy(output, input, sizeof(input));
+    result = SenseHAT_FilterProcess(&filter, output, output, 2);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(output[1], 0.25, 0.0);
+    result = SenseHAT_FilterProcess(&filter, NULL, output, 2);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Record a rising temperature to replay through the sampler
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    for (index = 0; index < 10; index++)
+    {
+        record.timestamp = 1.0 + index;
+        record.values[0] = 20.0 + index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SamplerSetFilter and SenseHAT_SamplerGetFiltered
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SamplerGetFiltered(instance, &filtered);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    stages[0].type = eSenseHAT_FilterEMA;
+    stages[0].alpha = 0.5;
+    result = SenseHAT_SamplerSetFilter(instance, eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure, stages, 1);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerSetFilter(instance, eSenseHAT_ChannelTemperature, stages, 1);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerStart(instance, eSenseHAT_ChannelTemperature, 0.005);
+    CU_ASSERT_EQUAL(result, 0);
+    (void)usleep(300000);
+    result = SenseHAT_SamplerStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerGetLatest(instance, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerGetFiltered(instance, &filtered);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(filtered.sequence, sample.sequence);
+    if ((sample.channels & eSenseHAT_ChannelTemperature) != 0)
+    {
+        CU_ASSERT(filtered.temperature < sample.temperature);
+        CU_ASSERT(filtered.temperature > 20.0);
+    }
+    result = SenseHAT_SamplerSetFilter(instance, eSenseHAT_ChannelTemperature, NULL, 0);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Record a heading swinging either side of north
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(compassDirectory));
+    result = SenseHAT_RecorderOpen(compassDirectory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelCompass;
+    for (index = 0; index < 10; index++)
+    {
+        record.timestamp = 1.0 + index;
+        record.values[0] = ((index & 1) != 0) ? 1.0 : 359.0;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test that the filtered heading wraps around rather than averaging to south
+    result = SenseHAT_OpenReplay(compassDirectory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SamplerSetFilter(instance, eSenseHAT_ChannelCompass, stages, 1);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerStart(instance, eSenseHAT_ChannelCompass, 0.01);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 10; index++)
+    {
+        (void)usleep(20000);
+        if ((SenseHAT_SamplerGetFiltered(instance, &filtered) == 0) &&
+            ((filtered.channels & eSenseHAT_ChannelCompass) != 0))
+        {
+            CU_ASSERT((filtered.compass <= 1.0) || (filtered.compass >= 359.0));
+            break;
+        }
+    }
+    CU_ASSERT(index < 10);
+    result = SenseHAT_SamplerStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestSubscriptionCallback
+// =================================================================================================
+void TestSubscriptionCallback (const tSenseHAT_Notification* notification,
+                               void* context)
+{
+    if ((notification != NULL) && (context == (void*)&gNotificationCount))
+    {
+        gNotificationCount++;
+    }
+    return;
+}
+
+// =================================================================================================
+//  TestSubscriptionFunctions
+// =================================================================================================
+void TestSubscriptionFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    int32_t count = 0;
+    int32_t aboveCount = 0;
+    int32_t changeCount = 0;
+    int32_t rateCount = 0;
+    uint32_t ready = 0;
+    uint32_t aboveId = 0;
+    uint32_t changeId = 0;
+    uint32_t rateId = 0;
+    uint32_t subscriptionId = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_Subscription subscription;
+    tSenseHAT_Notification notifications[64];
+
+    // Record a temperature rising by a degree a second
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    for (index = 0; index < 40; index++)
+    {
+        record.timestamp = 1.0 + index;
+        record.values[0] = 20.0 + index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    // Test SenseHAT_SamplerSubscribe
+    memset(&subscription, 0, sizeof(tSenseHAT_Subscription));
+    subscription.channel = eSenseHAT_ChannelTemperature;
+    subscription.type = eSenseHAT_SubscriptionAbove;
+    subscription.threshold = 25.5;
+    subscription.hysteresis = 0.5;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, TestSubscriptionCallback, &gNotificationCount, &aboveId);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_NOT_EQUAL(aboveId, 0);
+    subscription.type = eSenseHAT_SubscriptionChange;
+    subscription.threshold = 3.5;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, NULL, NULL, &changeId);
+    CU_ASSERT_EQUAL(result, 0);
+    subscription.type = eSenseHAT_SubscriptionRiseRate;
+    subscription.threshold = 1000.0;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, NULL, NULL, &rateId);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    subscription.window = 10.0;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, NULL, NULL, &rateId);
+    CU_ASSERT_EQUAL(result, 0);
+    subscription.type = eSenseHAT_SubscriptionFallRate;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, NULL, NULL, &subscriptionId);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerUnsubscribe(instance, subscriptionId);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerUnsubscribe(instance, subscriptionId);
+    CU_ASSERT_EQUAL(result, ENOENT);
+    subscription.channel = eSenseHAT_ChannelCompass;
+    result = SenseHAT_SamplerSubscribe(instance, &subscription, NULL, NULL, &subscriptionId);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SamplerSubscribe(instance, NULL, NULL, NULL, &subscriptionId);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test the notifications
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceSubscription, -1, 0, &ready);
+    CU_ASSERT_EQUAL(result, ETIMEDOUT);
+    result = SenseHAT_SamplerStart(instance, eSenseHAT_ChannelTemperature, 0.005);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceSubscription, -1, 1000, &ready);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(ready, eSenseHAT_WaitSourceSubscription);
+    (void)usleep(400000);
+    result = SenseHAT_SamplerStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerGetNotifications(instance, notifications, 64, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < count; index++)
+    {
+        CU_ASSERT_EQUAL(notifications[index].channel, eSenseHAT_ChannelTemperature);
+        if (notifications[index].subscriptionId == aboveId)
+        {
+            CU_ASSERT_EQUAL(notifications[index].type, eSenseHAT_SubscriptionAbove);
+            CU_ASSERT(notifications[index].value > 25.5);
+            aboveCount++;
+        }
+        else if (notifications[index].subscriptionId == changeId)
+        {
+            CU_ASSERT(notifications[index].change > 3.5);
+            changeCount++;
+        }
+        else if (notifications[index].subscriptionId == rateId)
+        {
+            CU_ASSERT_DOUBLE_EQUAL(notifications[index].change, 3600.0, 1.0);
+            rateCount++;
+        }
+        else
+        {
+            CU_FAIL("Unexpected subscription");
+        }
+    }
+    CU_ASSERT_EQUAL(aboveCount, 1);
+    CU_ASSERT(changeCount >= 1);
+    CU_ASSERT_EQUAL(rateCount, 1);
+    CU_ASSERT_EQUAL(gNotificationCount, 1);
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceSubscription, -1, 0, &ready);
+    CU_ASSERT_EQUAL(result, ETIMEDOUT);
+    result = SenseHAT_SamplerGetNotifications(instance, NULL, 64, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestCacheFunctions
+// =================================================================================================
+void TestCacheFunctions (void)
+{
+    int32_t result = 0;
+    double temperature = 0.0;
+    tSenseHAT_Sample sample;
+    tSenseHAT_CacheStatistics statistics;
+
+    // Test SenseHAT_SetCacheMaxAge
+    result = SenseHAT_SetCacheMaxAge(gInstance, 10.0);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetCacheMaxAge(NULL, 10.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SetCacheMaxAge(gInstance, -1.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetCacheStatistics
+    result = SenseHAT_GetCacheStatistics(gInstance, true, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetCacheStatistics(NULL, true, &statistics);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetCacheStatistics(gInstance, true, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetChannels
+    result = SenseHAT_GetChannels(gInstance, eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure, 0.0, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(sample.channels, eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure);
+    result = SenseHAT_GetTemperature(gInstance, &temperature);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(temperature, sample.temperature, 0.0001);
+    result = SenseHAT_GetChannels(gInstance, eSenseHAT_ChannelPressure, kSenseHAT_CacheMaxAgeDefault, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetCacheStatistics(gInstance, true, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(statistics.hits, 2);
+    CU_ASSERT_EQUAL(statistics.misses, 2);
+    result = SenseHAT_GetChannels(NULL, eSenseHAT_ChannelTemperature, 0.0, &sample);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetChannels(gInstance, eSenseHAT_ChannelNone, 0.0, &sample);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GetChannels(gInstance, eSenseHAT_ChannelTemperature, 0.0, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Restore the default policy
+    result = SenseHAT_SetCacheMaxAge(gInstance, 0.0);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestRecorderFunctions
+// =================================================================================================
+void TestRecorderFunctions (void)
+{
+    int32_t result = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Reader reader = NULL;
+    tSenseHAT_RecorderStatistics statistics;
+    tSenseHAT_Sample sample;
+    const tSenseHAT_Record* records = NULL;
+    uint64_t recordCount = 0;
+    uint64_t totalCount = 0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    // Test SenseHAT_RecorderOpen
+    result = SenseHAT_RecorderOpen(directory, 0, &recorder);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_RecorderOpen(NULL, 1000, &recorder);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_RecorderOpen(directory, 4, &recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SetRecorder
+    result = SenseHAT_SetRecorder(gInstance, recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetChannels(gInstance, eSenseHAT_ChannelTemperature | eSenseHAT_ChannelCompassRaw, 0.0, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, EBUSY);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(recorder);
+    result = SenseHAT_SetRecorder(gInstance, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetRecorder(NULL, recorder);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_RecorderAppendSample and SenseHAT_RecorderFlush
+    result = SenseHAT_RecorderAppendSample(recorder, &sample);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderAppendSample(recorder, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_RecorderFlush(recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderGetStatistics(recorder, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(statistics.written, 4);
+    CU_ASSERT_EQUAL(statistics.dropped, 0);
+    CU_ASSERT_EQUAL(statistics.segments, 1);
+
+    // Test SenseHAT_RecorderClose
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_PTR_NULL(recorder);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test the reader
+    result = SenseHAT_ReaderOpen(directory, &reader);
+    CU_ASSERT_EQUAL(result, 0);
+    while ((result = SenseHAT_ReaderNextSegment(reader, &records, &recordCount)) == 0)
+    {
+        CU_ASSERT_EQUAL(records[0].channel, eSenseHAT_ChannelTemperature);
+        CU_ASSERT_DOUBLE_EQUAL(records[0].values[0], sample.temperature, 0.0001);
+        totalCount += recordCount;
+    }
+    CU_ASSERT_EQUAL(result, ENODATA);
+    CU_ASSERT_EQUAL(totalCount, 4);
+    result = SenseHAT_ReaderClose(&reader);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_ReaderOpen(NULL, &reader);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    return;
+}
+
+// =================================================================================================
+//  TestGestureFunctions
+// =================================================================================================
+void TestGestureFunctions (void)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+    double deadline = 0.0;
+    tSenseHAT_GestureRecognizer recognizer;
+    tSenseHAT_GestureConfiguration configuration;
+    tSenseHAT_Gesture gestures[kSenseHAT_MaxGestures];
+    tSenseHAT_JoystickEvent event;
+    int32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Instance instance = NULL;
+
+    // Test SenseHAT_GestureInitialize
+    configuration.doubleClickInterval = 0.3;
+    configuration.longPressDuration = 1.0;
+    configuration.repeatDelay = 0.5;
+    configuration.repeatInterval = 0.2;
+    configuration.repeatMinimumInterval = 0.1;
+    configuration.repeatAcceleration = 0.5;
+    result = SenseHAT_GestureInitialize(&recognizer, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GestureInitialize(NULL, &configuration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration.repeatAcceleration = 2.0;
+    result = SenseHAT_GestureInitialize(&recognizer, &configuration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration.repeatAcceleration = 0.5;
+    result = SenseHAT_GestureInitialize(&recognizer, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GestureGetDeadline(&recognizer, &deadline);
+    CU_ASSERT_EQUAL(result, ENODATA);
+
+    // Test a click, which is reported once the double click interval expires
+    event.direction = eSenseHAT_JoystickDirectionUp;
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 10.0;
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 0);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 10.1;
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 0);
+    result = SenseHAT_GestureGetDeadline(&recognizer, &deadline);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(deadline, 10.4, 0.0001);
+    result = SenseHAT_GestureAdvance(&recognizer, 10.5, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureClick);
+    CU_ASSERT_EQUAL(gestures[0].direction, eSenseHAT_JoystickDirectionUp);
+
+    // Test a double click
+    event.direction = eSenseHAT_JoystickDirectionPush;
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 20.0;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 20.1;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 20.2;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 0);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 20.3;
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureDoubleClick);
+
+    // Test repeats while held, which rule out a long press for the rest of the hold
+    event.direction = eSenseHAT_JoystickDirectionDown;
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 30.0;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    result = SenseHAT_GestureAdvance(&recognizer, 30.5, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureRepeat);
+    CU_ASSERT_EQUAL(gestures[0].repeatCount, 1);
+    result = SenseHAT_GestureGetDeadline(&recognizer, &deadline);
+    CU_ASSERT_DOUBLE_EQUAL(deadline, 30.6, 0.0001);
+    result = SenseHAT_GestureAdvance(&recognizer, 30.65, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].repeatCount, 2);
+    result = SenseHAT_GestureAdvance(&recognizer, 30.75, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    result = SenseHAT_GestureAdvance(&recognizer, 31.0, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureRepeat);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 31.05;
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 0);
+    result = SenseHAT_GestureGetDeadline(&recognizer, &deadline);
+    CU_ASSERT_EQUAL(result, ENODATA);
+
+    // Test the same, with the hold only looked at once both are due
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 40.0;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    result = SenseHAT_GestureGetDeadline(&recognizer, &deadline);
+    CU_ASSERT_DOUBLE_EQUAL(deadline, 40.5, 0.0001);
+    result = SenseHAT_GestureAdvance(&recognizer, 41.0, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureRepeat);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 41.05;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+
+    // Test a long press followed by repeats, once the repeats start later
+    configuration.repeatDelay = 1.5;
+    result = SenseHAT_GestureInitialize(&recognizer, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    event.action = eSenseHAT_JoystickActionPressed;
+    event.timestamp = 50.0;
+    (void)SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    result = SenseHAT_GestureAdvance(&recognizer, 51.0, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureLongPress);
+    result = SenseHAT_GestureAdvance(&recognizer, 51.5, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureRepeat);
+    event.action = eSenseHAT_JoystickActionReleased;
+    event.timestamp = 51.55;
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(count, 0);
+
+    // Test argument checking
+    result = SenseHAT_GestureProcessEvent(NULL, &event, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GestureProcessEvent(&recognizer, NULL, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GestureProcessEvent(&recognizer, &event, gestures, 0, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GestureAdvance(&recognizer, 0.0, NULL, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_GestureGetDeadline(&recognizer, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_GetGestures
+    result = SenseHAT_GetGestures(gInstance, &recognizer, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetGestures(NULL, &recognizer, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Record a click up, then a press down five seconds later
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&event, 0, sizeof(tSenseHAT_JoystickEvent));
+    for (index = 0; index < 3; index++)
+    {
+        event.timestamp = (index < 2) ? (100.0 + (index * 0.05)) : 105.0;
+        event.direction = (index < 2) ? eSenseHAT_JoystickDirectionUp : eSenseHAT_JoystickDirectionDown;
+        event.action = (index == 1) ? eSenseHAT_JoystickActionReleased : eSenseHAT_JoystickActionPressed;
+        result = SenseHAT_RecorderAppendEvent(recorder, &event);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test that SenseHAT_GetGestures follows the replay time, so the press doesn't repeat and the
+    // click only completes once the log moves past the double click interval
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_GestureInitialize(&recognizer, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 2; index++)
+    {
+        result = SenseHAT_GetGestures(instance, &recognizer, gestures, kSenseHAT_MaxGestures, &count);
+        CU_ASSERT_EQUAL(result, 0);
+        CU_ASSERT_EQUAL(count, 0);
+    }
+    result = SenseHAT_GetGestures(instance, &recognizer, gestures, kSenseHAT_MaxGestures, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(gestures[0].type, eSenseHAT_GestureClick);
+    CU_ASSERT_EQUAL(gestures[0].direction, eSenseHAT_JoystickDirectionUp);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestMotionCallback
+// =================================================================================================
+void TestMotionCallback (const tSenseHAT_MotionEvent* event,
+                         void* context)
+{
+    if ((event != NULL) && (context == (void*)&gMotionEventCount))
+    {
+        gMotionEventCount++;
+    }
+    return;
+}
+
+// =================================================================================================
+//  TestMotionFunctions
+// =================================================================================================
+void TestMotionFunctions (void)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+    int32_t total = 0;
+    int32_t index = 0;
+    uint32_t ready = 0;
+    double timestamp = 0.0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_MotionDetector detector;
+    tSenseHAT_MotionConfiguration configuration;
+    tSenseHAT_MotionEvent events[kSenseHAT_MaxMotionEvents];
+    tSenseHAT_RawData level = { 0.0, 0.0, 1.0 };
+    tSenseHAT_RawData reading = { 0.0, 0.0, 2.5 };
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
+
+    // Test SenseHAT_MotionInitialize
+    result = SenseHAT_MotionInitialize(&detector, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_MotionInitialize(NULL, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration = detector.configuration;
+    configuration.shakeStrokes = kSenseHAT_MotionShakeStrokesMax + 1;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration.shakeStrokes = 4;
+    configuration.hysteresis = 1.0;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration.hysteresis = 0.2;
+
+    // Test taps, and that the quiet time swallows a second tap
+    configuration.detectors = eSenseHAT_MotionTap;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 100; index++)
+    {
+        timestamp = index * 0.01;
+        result = SenseHAT_MotionProcess(&detector, timestamp,
+                                        ((index == 50) || (index == 55) || (index == 80)) ? &reading : &level,
+                                        events, kSenseHAT_MaxMotionEvents, &count);
+        CU_ASSERT_EQUAL(result, 0);
+        if (count > 0)
+        {
+            CU_ASSERT_EQUAL(count, 1);
+            CU_ASSERT_EQUAL(events[0].type, eSenseHAT_MotionTap);
+            CU_ASSERT_DOUBLE_EQUAL(events[0].magnitude, 1.5, 0.0001);
+            CU_ASSERT((index == 50) || (index == 80));
+            total += count;
+        }
+    }
+    CU_ASSERT_EQUAL(total, 2);
+
+    // Test free-fall, which is reported when entered and when left
+    configuration.detectors = eSenseHAT_MotionFreeFall;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    reading.z = 0.05;
+    total = 0;
+    for (index = 0; index < 100; index++)
+    {
+        timestamp = index * 0.01;
+        result = SenseHAT_MotionProcess(&detector, timestamp, ((index >= 20) && (index < 50)) ? &reading : &level,
+                                        events, kSenseHAT_MaxMotionEvents, &count);
+        CU_ASSERT_EQUAL(result, 0);
+        if (count > 0)
+        {
+            CU_ASSERT_EQUAL(events[0].type, eSenseHAT_MotionFreeFall);
+            CU_ASSERT_EQUAL(events[0].active, (total == 0));
+            if (events[0].active)
+            {
+                CU_ASSERT((index == 30) || (index == 31));
+            }
+            else
+            {
+                CU_ASSERT_EQUAL(index, 50);
+                CU_ASSERT_DOUBLE_EQUAL(events[0].magnitude, 0.3, 0.0001);
+            }
+            total += count;
+        }
+    }
+    CU_ASSERT_EQUAL(total, 2);
+
+    // Test tilt with hysteresis
+    configuration.detectors = eSenseHAT_MotionTilt;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    reading.x = 1.0;
+    reading.z = 0.0;
+    total = 0;
+    for (index = 0; index < 600; index++)
+    {
+        timestamp = index * 0.01;
+        result = SenseHAT_MotionProcess(&detector, timestamp, ((index >= 100) && (index < 300)) ? &reading : &level,
+                                        events, kSenseHAT_MaxMotionEvents, &count);
+        CU_ASSERT_EQUAL(result, 0);
+        if (count > 0)
+        {
+            CU_ASSERT_EQUAL(events[0].type, eSenseHAT_MotionTilt);
+            CU_ASSERT_EQUAL(events[0].active, (total == 0));
+            if (events[0].active)
+            {
+                CU_ASSERT(events[0].magnitude >= 30.0);
+            }
+            else
+            {
+                CU_ASSERT(events[0].magnitude < 24.0);
+            }
+            total += count;
+        }
+    }
+    CU_ASSERT_EQUAL(total, 2);
+
+    // Test shakes: four strokes within a second
+    configuration.detectors = eSenseHAT_MotionShake;
+    result = SenseHAT_MotionInitialize(&detector, &configuration);
+    CU_ASSERT_EQUAL(result, 0);
+    reading.z = 1.0;
+    total = 0;
+    for (index = 0; index < 100; index++)
+    {
+        timestamp = index * 0.01;
+        reading.x = ((index / 10) % 2 == 0) ? 2.0 : -2.0;
+        result = SenseHAT_MotionProcess(&detector, timestamp, 
+                                        ((index >= 50) && (index < 90) && ((index % 10) == 0)) ? &reading : &level,
+                                        events, kSenseHAT_MaxMotionEvents, &count);
+        CU_ASSERT_EQUAL(result, 0);
+        if (count > 0)
+        {
+            CU_ASSERT_EQUAL(events[0].type, eSenseHAT_MotionShake);
+            CU_ASSERT_EQUAL(index, 80);
+            total += count;
+        }
+    }
+    CU_ASSERT_EQUAL(total, 1);
+    result = SenseHAT_MotionProcess(&detector, timestamp, NULL, events, kSenseHAT_MaxMotionEvents, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_MotionProcess(&detector, timestamp, &level, events, 0, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Record a tilted accelerometer to replay through the sampler
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelAccelerometerRaw;
+    record.values[0] = 1.0;
+    for (index = 0; index < 10; index++)
+    {
+        record.timestamp = 1.0 + index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SamplerSetMotionDetection and SenseHAT_SamplerGetMotionEvents
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    configuration.detectors = eSenseHAT_MotionTilt;
+    result = SenseHAT_SamplerSetMotionDetection(instance, &configuration, TestMotionCallback, &gMotionEventCount);
+    CU_ASSERT_EQUAL(result, 0);
+    configuration.tiltThreshold = 0.0;
+    result = SenseHAT_SamplerSetMotionDetection(instance, &configuration, NULL, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceMotion, -1, 0, &ready);
+    CU_ASSERT_EQUAL(result, ETIMEDOUT);
+    result = SenseHAT_SamplerStart(instance, eSenseHAT_ChannelAccelerometerRaw, 0.005);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceMotion, -1, 1000, &ready);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(ready, eSenseHAT_WaitSourceMotion);
+    result = SenseHAT_SamplerStop(instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SamplerGetMotionEvents(instance, events, kSenseHAT_MaxMotionEvents, &count);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(events[0].type, eSenseHAT_MotionTilt);
+    CU_ASSERT(events[0].active);
+    CU_ASSERT_EQUAL(gMotionEventCount, 1);
+    result = SenseHAT_WaitForSources(instance, eSenseHAT_WaitSourceMotion, -1, 0, &ready);
+    CU_ASSERT_EQUAL(result, ETIMEDOUT);
+    result = SenseHAT_SamplerGetMotionEvents(instance, NULL, kSenseHAT_MaxMotionEvents, &count);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestCompassFunctions
+// =================================================================================================
+void TestCompassFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    double heading = 0.0;
+    double expected = 0.0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    const double softIron[3][3] = { { 1.2, 0.1, 0.0 }, { 0.1, 0.9, 0.05 }, { 0.0, 0.05, 1.0 } };
+    tSenseHAT_MagCalibrator calibrator;
+    tSenseHAT_MagCalibration calibration;
+    tSenseHAT_MagCalibration loaded;
+    tSenseHAT_RawData reading;
+    tSenseHAT_RawData corrected;
+    tSenseHAT_RawData level = { 0.0, 0.0, 1.0 };
+    tSenseHAT_RawData tilted;
+    tSenseHAT_RawData field = { 20.0, 5.0, -40.0 };
+    tSenseHAT_RawData turned;
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_Instance instance = NULL;
+
+    // Test SenseHAT_MagCalibratorInitialize and SenseHAT_MagCalibratorAdd
+    result = SenseHAT_MagCalibratorInitialize(&calibrator);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_MagCalibratorInitialize(NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_MagCalibratorAdd(&calibrator, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    reading.x = NAN;
+    reading.y = 0.0;
+    reading.z = 0.0;
+    result = SenseHAT_MagCalibratorAdd(&calibrator, &reading);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_MagCalibratorSolve with too few readings, and with flat readings
+    result = SenseHAT_MagCalibratorSolve(&calibrator, &calibration);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    for (index = 0; index < 100; index++)
+    {
+        reading.x = 40.0 * cos(index * 0.1);
+        reading.y = 40.0 * sin(index * 0.1);
+        reading.z = 0.0;
+        result = SenseHAT_MagCalibratorAdd(&calibrator, &reading);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_MagCalibratorSolve(&calibrator, &calibration);
+    CU_ASSERT_EQUAL(result, EDOM);
+    result = SenseHAT_MagCalibratorSolve(NULL, &calibration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test fitting a 50 µT field seen through soft iron and offset by hard iron
+    (void)SenseHAT_MagCalibratorInitialize(&calibrator);
+    for (index = 0; index < 200; index++)
+    {
+        double z = 1.0 - ((2.0 * index + 1.0) / 200.0);
+        double r = sqrt(1.0 - z * z);
+        double angle = index * 2.399963;
+        double u[3] = { r * cos(angle), r * sin(angle), z };
+
+        reading.x = 10.0 + 50.0 * (softIron[0][0] * u[0] + softIron[0][1] * u[1] + softIron[0][2] * u[2]);
+        reading.y = -5.0 + 50.0 * (softIron[1][0] * u[0] + softIron[1][1] * u[1] + softIron[1][2] * u[2]);
+        reading.z = 20.0 + 50.0 * (softIron[2][0] * u[0] + softIron[2][1] * u[1] + softIron[2][2] * u[2]);
+        result = SenseHAT_MagCalibratorAdd(&calibrator, &reading);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_MagCalibratorSolve(&calibrator, &calibration);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(calibration.offset.x, 10.0, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(calibration.offset.y, -5.0, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(calibration.offset.z, 20.0, 0.001);
+    CU_ASSERT(calibration.fitError < 0.0001);
+
+    // Corrected readings must lie on a sphere of the fitted field strength
+    for (index = 0; index < 6; index++)
+    {
+        double u[3] = { sin(index * 0.5) * cos(index * 1.1), sin(index * 0.5) * sin(index * 1.1), cos(index * 0.5) };
+
+        reading.x = 10.0 + 50.0 * (softIron[0][0] * u[0] + softIron[0][1] * u[1] + softIron[0][2] * u[2]);
+        reading.y = -5.0 + 50.0 * (softIron[1][0] * u[0] + softIron[1][1] * u[1] + softIron[1][2] * u[2]);
+        reading.z = 20.0 + 50.0 * (softIron[2][0] * u[0] + softIron[2][1] * u[1] + softIron[2][2] * u[2]);
+        corrected.x = calibration.matrix[0][0] * (reading.x - 10.0) + calibration.matrix[0][1] * (reading.y + 5.0) + calibration.matrix[0][2] * (reading.z - 20.0);
+        corrected.y = calibration.matrix[1][0] * (reading.x - 10.0) + calibration.matrix[1][1] * (reading.y + 5.0) + calibration.matrix[1][2] * (reading.z - 20.0);
+        corrected.z = calibration.matrix[2][0] * (reading.x - 10.0) + calibration.matrix[2][1] * (reading.y + 5.0) + calibration.matrix[2][2] * (reading.z - 20.0);
+        CU_ASSERT_DOUBLE_EQUAL(sqrt(corrected.x * corrected.x + corrected.y * corrected.y + corrected.z * corrected.z),
+                               calibration.fieldStrength, 0.01);
+    }
+
+    // Test fitting with a hard iron offset larger than the field, so the origin lies outside the
+    // ellipsoid
+    (void)SenseHAT_MagCalibratorInitialize(&calibrator);
+    for (index = 0; index < 200; index++)
+    {
+        double z = 1.0 - ((2.0 * index + 1.0) / 200.0);
+        double r = sqrt(1.0 - z * z);
+        double angle = index * 2.399963;
+        double u[3] = { r * cos(angle), r * sin(angle), z };
+
+        reading.x = 80.0 + 50.0 * (softIron[0][0] * u[0] + softIron[0][1] * u[1] + softIron[0][2] * u[2]);
+        reading.y = 10.0 + 50.0 * (softIron[1][0] * u[0] + softIron[1][1] * u[1] + softIron[1][2] * u[2]);
+        reading.z = -60.0 + 50.0 * (softIron[2][0] * u[0] + softIron[2][1] * u[1] + softIron[2][2] * u[2]);
+        (void)SenseHAT_MagCalibratorAdd(&calibrator, &reading);
+    }
+    result = SenseHAT_MagCalibratorSolve(&calibrator, &loaded);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(loaded.offset.x, 80.0, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(loaded.offset.y, 10.0, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(loaded.offset.z, -60.0, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(loaded.fieldStrength, calibration.fieldStrength, 0.001);
+    CU_ASSERT(loaded.fitError < 0.0001);
+    for (index = 0; index < 3; index++)
+    {
+        CU_ASSERT_DOUBLE_EQUAL(loaded.matrix[index][0], calibration.matrix[index][0], 0.0001);
+        CU_ASSERT_DOUBLE_EQUAL(loaded.matrix[index][1], calibration.matrix[index][1], 0.0001);
+        CU_ASSERT_DOUBLE_EQUAL(loaded.matrix[index][2], calibration.matrix[index][2], 0.0001);
+    }
+
+    // Test SenseHAT_SaveMagCalibration and SenseHAT_LoadMagCalibration
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    (void)snprintf(path, sizeof(path), "%s/compass.cal", directory);
+    result = SenseHAT_SaveMagCalibration(path, &calibration);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_LoadMagCalibration(path, &loaded);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(memcmp(&loaded, &calibration, sizeof(tSenseHAT_MagCalibration)) == 0);
+    result = SenseHAT_LoadMagCalibration(directory, &loaded);
+    CU_ASSERT_NOT_EQUAL(result, 0);
+    result = SenseHAT_SaveMagCalibration(NULL, &calibration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_ComputeHeading level, pointing east, and rolled 30 degrees
+    result = SenseHAT_ComputeHeading(&level, &field, &expected);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(expected, 360.0 - atan2(5.0, 20.0) * 180.0 / M_PI, 0.0001);
+    turned.x = 0.0;
+    turned.y = 20.0;
+    turned.z = -40.0;
+    result = SenseHAT_ComputeHeading(&level, &turned, &heading);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(heading, 270.0, 0.0001);
+    tilted.x = 0.0;
+    tilted.y = sin(M_PI / 6.0);
+    tilted.z = cos(M_PI / 6.0);
+    turned.x = field.x;
+    turned.y = cos(M_PI / 6.0) * field.y + sin(M_PI / 6.0) * field.z;
+    turned.z = -sin(M_PI / 6.0) * field.y + cos(M_PI / 6.0) * field.z;
+    result = SenseHAT_ComputeHeading(&tilted, &turned, &heading);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(heading, expected, 0.0001);
+    reading.x = reading.y = reading.z = 0.0;
+    result = SenseHAT_ComputeHeading(&reading, &field, &heading);
+    CU_ASSERT_EQUAL(result, EDOM);
+    result = SenseHAT_ComputeHeading(&level, &field, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Record a level accelerometer and a magnetometer offset by 10 µT
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    for (index = 0; index < 3; index++)
+    {
+        record.timestamp = 1.0 + index;
+        record.channel = eSenseHAT_ChannelAccelerometerRaw;
+        record.values[0] = 0.0;
+        record.values[1] = 0.0;
+        record.values[2] = 1.0;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+        record.channel = eSenseHAT_ChannelCompassRaw;
+        record.values[0] = 10.0;
+        record.values[1] = 20.0;
+        record.values[2] = -40.0;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test SenseHAT_SetMagCalibration, SenseHAT_GetMagCalibration and SenseHAT_GetHeading
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_GetMagCalibration(instance, &loaded);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    memset(&calibration, 0, sizeof(tSenseHAT_MagCalibration));
+    calibration.offset.x = 10.0;
+    calibration.matrix[0][0] = calibration.matrix[1][1] = calibration.matrix[2][2] = 1.0;
+    calibration.fieldStrength = 44.7;
+    result = SenseHAT_SetMagCalibration(instance, &calibration);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetMagCalibration(instance, &loaded);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(loaded.offset.x, 10.0, 0.0001);
+    result = SenseHAT_GetCompassRaw(instance, &corrected);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(corrected.x, 0.0, 0.0001);
+    CU_ASSERT_DOUBLE_EQUAL(corrected.y, 20.0, 0.0001);
+    CU_ASSERT_DOUBLE_EQUAL(corrected.z, -40.0, 0.0001);
+    result = SenseHAT_GetHeading(instance, &heading);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(heading, 270.0, 0.0001);
+    result = SenseHAT_SetMagCalibration(instance, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_GetMagCalibration(instance, &loaded);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    result = SenseHAT_GetHeading(instance, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_CalibrateCompass(instance, 0.0, 0.01, &calibration);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestSpectrumFunctions
+// =================================================================================================
+void TestSpectrumFunctions (void)
+{
+    int32_t result = 0;
+    uint32_t index = 0;
+    tSenseHAT_SpectrumPlan plan = NULL;
+    tSenseHAT_AxisSpectrum spectrum;
+    tSenseHAT_VibrationConfiguration configuration;
+    tSenseHAT_VibrationCapture capture = NULL;
+    float samples[512];
+    float power[257];
+
+    // A sine of amplitude 1 centred on bin 32, on top of a DC offset
+    for (index = 0; index < 512; index++)
+    {
+        samples[index] = 0.25f + (float)sin((2.0 * M_PI * 32.0 * index) / 512.0);
+    }
+
+    // Test SenseHAT_SpectrumOpen
+    result = SenseHAT_SpectrumOpen(100, eSenseHAT_SpectrumWindowHann, &plan);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumOpen(32, eSenseHAT_SpectrumWindowHann, &plan);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumOpen(512, eSenseHAT_SpectrumWindowHann, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_SpectrumCompute without a window
+    result = SenseHAT_SpectrumOpen(512, eSenseHAT_SpectrumWindowRectangular, &plan);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SpectrumCompute(plan, samples, 1000.0, 4, &spectrum, power);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.mean, 0.25, 0.001);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.rms, sqrt(0.5), 0.001);
+    CU_ASSERT(spectrum.peakCount >= 1);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.peaks[0].frequency, 62.5, 0.1);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.peaks[0].power, 0.5, 0.01);
+    CU_ASSERT_DOUBLE_EQUAL(power[32], 0.5, 0.01);
+    CU_ASSERT(power[0] < 0.0001);
+    CU_ASSERT(power[256] < 0.0001);
+    result = SenseHAT_SpectrumCompute(plan, samples, 0.0, 4, &spectrum, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumCompute(plan, samples, 1000.0, kSenseHAT_SpectrumPeaksMax + 1, &spectrum, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumCompute(plan, NULL, 1000.0, 4, &spectrum, NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumClose(&plan);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_PTR_NULL(plan);
+
+    // Test SenseHAT_SpectrumCompute with a Hann window
+    result = SenseHAT_SpectrumOpen(512, eSenseHAT_SpectrumWindowHann, &plan);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SpectrumCompute(plan, samples, 1000.0, 4, &spectrum, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(spectrum.peakCount >= 1);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.peaks[0].frequency, 62.5, 0.1);
+    CU_ASSERT_DOUBLE_EQUAL(spectrum.peaks[0].power, 0.5, 0.01);
+    result = SenseHAT_SpectrumClose(&plan);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SpectrumClose(&plan);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_SpectrumClose(NULL);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_VibrationOpen argument checking
+    configuration.windowLength = 512;
+    configuration.window = eSenseHAT_SpectrumWindowHann;
+    configuration.fullScale = 3;
+    configuration.peakCount = 4;
+    result = SenseHAT_VibrationOpen(&configuration, &capture);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    configuration.fullScale = 4;
+    configuration.windowLength = 500;
+    result = SenseHAT_VibrationOpen(&configuration, &capture);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_VibrationOpen(NULL, &capture);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_VibrationClose(&capture);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    return;
+}
+
+// =================================================================================================
+//  TestReplayFunctions
+// =================================================================================================
+void TestReplayFunctions (void)
+{
+    int32_t result = 0;
+    int32_t count = 0;
+    int32_t index = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char recordDirectory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Instance instance = NULL;
+    tSenseHAT_Record record;
+    tSenseHAT_JoystickEvent event;
+    tSenseHAT_JoystickEvent* events = NULL;
+    tSenseHAT_JoystickEvent eventBuffer[2];
+    uint64_t droppedCount = 0;
+    double temperature = 0.0;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    // Test SenseHAT_OpenReplay with an empty log
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    CU_ASSERT_PTR_NULL(instance);
+    result = SenseHAT_OpenReplay(directory, -1.0, &instance);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_OpenReplay(NULL, 1.0, &instance);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Record three temperatures one second apart, with a joystick event between the last two
+    result = SenseHAT_RecorderOpen(directory, 2, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(tSenseHAT_Record));
+    record.channel = eSenseHAT_ChannelTemperature;
+    for (index = 0; index < 3; index++)
+    {
+        if (index == 2)
+        {
+            event.timestamp = 2.5;
+            event.direction = eSenseHAT_JoystickDirectionLeft;
+            event.action = eSenseHAT_JoystickActionPressed;
+            result = SenseHAT_RecorderAppendEvent(recorder, &event);
+            CU_ASSERT_EQUAL(result, 0);
+        }
+        record.timestamp = 1.0 + index;
+        record.values[0] = 20.0 + index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test playing the log as fast as possible
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    for (index = 0; index < 3; index++)
+    {
+        result = SenseHAT_GetTemperature(instance, &temperature);
+        CU_ASSERT_EQUAL(result, 0);
+        CU_ASSERT_DOUBLE_EQUAL(temperature, 20.0 + index, 0.0001);
+    }
+    result = SenseHAT_GetTemperature(instance, &temperature);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    result = SenseHAT_GetEvents(instance, &count, &events);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(count, 1);
+    if (events != NULL)
+    {
+        CU_ASSERT_EQUAL(events[0].direction, eSenseHAT_JoystickDirectionLeft);
+        CU_ASSERT_EQUAL(events[0].action, eSenseHAT_JoystickActionPressed);
+        CU_ASSERT_DOUBLE_EQUAL(events[0].timestamp, 2.5, 0.0001);
+        free((void*)events);
+    }
+    result = SenseHAT_WaitForEvent(instance, false, &event);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test playing the log against the clock
+    result = SenseHAT_OpenReplay(directory, 10.0, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_WaitForEvent(instance, false, &event);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(event.direction, eSenseHAT_JoystickDirectionLeft);
+    result = SenseHAT_GetTemperature(instance, &temperature);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_DOUBLE_EQUAL(temperature, 21.0, 0.0001);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // Test that a recorder can't be closed while an instance records to it, only once it's 
+    // detached or the instance is closed
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(recordDirectory));
+    result = SenseHAT_RecorderOpen(recordDirectory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_OpenReplay(directory, kSenseHAT_ReplayAsFastAsPossible, &instance);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    // Test that SenseHAT_GetEventsInto asks for another call whenever it fills the buffer
+    result = SenseHAT_GetEventsInto(instance, eventBuffer, 1, &count);
+    CU_ASSERT_EQUAL(result, ENOBUFS);
+    CU_ASSERT_EQUAL(count, 1);
+    result = SenseHAT_GetEventsInto(instance, eventBuffer, 2, &count);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    CU_ASSERT_EQUAL(count, 0);
+    result = SenseHAT_GetDroppedEventCount(instance, &droppedCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(droppedCount, 0);
+
+    result = SenseHAT_SetRecorder(instance, recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_SetRecorder(instance, recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, EBUSY);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(recorder);
+    result = SenseHAT_SetRecorder(instance, NULL);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_PTR_NULL(recorder);
+    result = SenseHAT_RecorderOpen(recordDirectory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_SetRecorder(instance, recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_Close(&instance);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestCodecFunctions
+// =================================================================================================
+void TestCodecFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    uint32_t recordCount = 0;
+    size_t length = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    tSenseHAT_Encoder encoder;
+    tSenseHAT_Decoder decoder;
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Reader reader = NULL;
+    tSenseHAT_RecorderStatistics statistics;
+    tSenseHAT_Record records[64];
+    tSenseHAT_Record record;
+    const tSenseHAT_Record* segmentRecords = NULL;
+    uint64_t segmentCount = 0;
+    uint8_t buffer[64 * kSenseHAT_EncodedRecordSizeMax];
+
+    // Build a stream of slowly changing readings at 100 Hz, with a few awkward values
+    memset(records, 0, sizeof(records));
+    for (index = 0; index < 64; index += 2)
+    {
+        records[index].timestamp = 1569369600.0 + (index * 0.005);
+        records[index].channel = eSenseHAT_ChannelTemperature;
+        records[index].values[0] = 25.0 + ((index / 16) * 0.125);
+        records[index + 1].timestamp = records[index].timestamp;
+        records[index + 1].channel = eSenseHAT_ChannelAccelerometerRaw;
+        records[index + 1].values[0] = 0.01 * (index % 3);
+        records[index + 1].values[1] = -0.02;
+        records[index + 1].values[2] = 1.0;
+    }
+    records[10].timestamp = 0.1;
+    records[11].values[0] = -0.0;
+    records[20].channel = eSenseHAT_ChannelJoystick;
+    records[20].values[0] = (double)eSenseHAT_JoystickDirectionPush;
+    records[20].values[1] = (double)eSenseHAT_JoystickActionReleased;
+    records[30].values[1] = 1.0e300;
+
+    // Test SenseHAT_EncoderInitialize and SenseHAT_EncoderAppend
+    result = SenseHAT_EncoderInitialize(&encoder, buffer, sizeof(buffer));
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_EncoderInitialize(&encoder, NULL, sizeof(buffer));
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_EncoderInitialize(&encoder, buffer, sizeof(buffer));
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 64; index++)
+    {
+        result = SenseHAT_EncoderAppend(&encoder, &(records[index]));
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    record = records[0];
+    record.channel = eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure;
+    result = SenseHAT_EncoderAppend(&encoder, &record);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_EncoderGetLength
+    result = SenseHAT_EncoderGetLength(&encoder, &length, &recordCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(recordCount, 64);
+    CU_ASSERT(length < (sizeof(records) / 4));
+    result = SenseHAT_EncoderGetLength(&encoder, NULL, &recordCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_DecoderInitialize and SenseHAT_DecoderNext
+    result = SenseHAT_DecoderInitialize(&decoder, buffer, length, recordCount);
+    CU_ASSERT_EQUAL(result, 0);
+    for (index = 0; index < 64; index++)
+    {
+        result = SenseHAT_DecoderNext(&decoder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+        CU_ASSERT_EQUAL(memcmp(&record, &(records[index]), sizeof(tSenseHAT_Record)), 0);
+    }
+    result = SenseHAT_DecoderNext(&decoder, &record);
+    CU_ASSERT_EQUAL(result, ENODATA);
+    result = SenseHAT_DecoderInitialize(&decoder, buffer, length / 2, recordCount);
+    CU_ASSERT_EQUAL(result, 0);
+    while ((result = SenseHAT_DecoderNext(&decoder, &record)) == 0)
+    {
+        // Skip to the end of the data
+    }
+    CU_ASSERT_EQUAL(result, EPROTO);
+    result = SenseHAT_DecoderInitialize(NULL, buffer, length, recordCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test running out of room
+    result = SenseHAT_EncoderInitialize(&encoder, buffer, kSenseHAT_EncodedRecordSizeMax);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_EncoderAppend(&encoder, &(records[0]));
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_EncoderAppend(&encoder, &(records[1]));
+    CU_ASSERT_EQUAL(result, ENOBUFS);
+
+    // Test SenseHAT_RecorderSetCompression
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+    result = SenseHAT_RecorderOpen(directory, 1000, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_RecorderSetCompression(recorder, true);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderSetCompression(NULL, true);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    for (index = 0; index < 64; index++)
+    {
+        result = SenseHAT_RecorderAppend(recorder, &(records[index]));
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    record = records[0];
+    record.channel = eSenseHAT_ChannelTemperature | eSenseHAT_ChannelPressure;
+    result = SenseHAT_RecorderAppend(recorder, &record);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_RecorderFlush(recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    result = SenseHAT_RecorderGetStatistics(recorder, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(statistics.written, 64);
+    CU_ASSERT(statistics.bytes < (sizeof(records) / 2));
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+
+    // The reader decodes compressed segments
+    result = SenseHAT_ReaderOpen(directory, &reader);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    result = SenseHAT_ReaderNextSegment(reader, &segmentRecords, &segmentCount);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_EQUAL(segmentCount, 64);
+    if (segmentCount == 64)
+    {
+        CU_ASSERT_EQUAL(memcmp(segmentRecords, records, sizeof(records)), 0);
+    }
+    result = SenseHAT_ReaderClose(&reader);
+    CU_ASSERT_EQUAL(result, 0);
+
+    return;
+}
+
+// =================================================================================================
+//  TestQueryFunctions
+// =================================================================================================
+void TestQueryFunctions (void)
+{
+    int32_t result = 0;
+    int32_t index = 0;
+    uint32_t recordCount = 0;
+    uint32_t totalCount = 0;
+    char directory[] = "/tmp/sensehat-test-XXXXXX";
+    char path[64];
+    tSenseHAT_Recorder recorder = NULL;
+    tSenseHAT_Query query = NULL;
+    tSenseHAT_QueryParameters parameters;
+    tSenseHAT_QueryStatistics statistics;
+    tSenseHAT_Record record;
+    tSenseHAT_Record records[256];
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(directory));
+
+    // Record 600 seconds of pressure at 10 Hz, half of it compressed
+    result = SenseHAT_RecorderOpen(directory, 4096, &recorder);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    memset(&record, 0, sizeof(record));
+    record.channel = eSenseHAT_ChannelPressure;
+    for (index = 0; index < 6000; index++)
+    {
+        if (index == 3000)
+        {
+            result = SenseHAT_RecorderFlush(recorder);
+            CU_ASSERT_EQUAL(result, 0);
+            result = SenseHAT_RecorderSetCompression(recorder, true);
+            CU_ASSERT_EQUAL(result, 0);
+        }
+        record.timestamp = index * 0.1;
+        record.values[0] = (double)index;
+        result = SenseHAT_RecorderAppend(recorder, &record);
+        CU_ASSERT_EQUAL(result, 0);
+    }
+    result = SenseHAT_RecorderClose(&recorder);
+    CU_ASSERT_EQUAL(result, 0);
+    (void)snprintf(path, sizeof(path), "%s/telemetry-%08u.shi", directory, 0);
+    CU_ASSERT_EQUAL(access(path, R_OK), 0);
+
+    // Test SenseHAT_QueryOpen
+    memset(&parameters, 0, sizeof(parameters));
+    parameters.channels = eSenseHAT_ChannelPressure;
+    parameters.startTime = 100.0;
+    parameters.endTime = 150.0;
+    parameters.valueIndex = 3;
+    parameters.minimumValue = -INFINITY;
+    parameters.maximumValue = INFINITY;
+    result = SenseHAT_QueryOpen(directory, &parameters, &query);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    parameters.valueIndex = 0;
+    result = SenseHAT_QueryOpen(NULL, &parameters, &query);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SenseHAT_QueryOpen(directory, &parameters, &query);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+
+    // Test SenseHAT_QueryNext with a time range
+    while ((result = SenseHAT_QueryNext(query, records, 256, &recordCount)) == 0)
+    {
+        for (index = 0; index < (int32_t)recordCount; index++)
+        {
+            CU_ASSERT_DOUBLE_EQUAL(records[index].values[0], (double)(1000 + totalCount), 0.0);
+            totalCount++;
+        }
+    }
+    CU_ASSERT_EQUAL(result, ENODATA);
+    CU_ASSERT_EQUAL(totalCount, 501);
+    result = SenseHAT_QueryNext(query, NULL, 256, &recordCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test SenseHAT_QueryGetStatistics
+    result = SenseHAT_QueryGetStatistics(query, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(statistics.blocksSkipped > 0);
+    CU_ASSERT(statistics.recordsRead < 6000);
+    CU_ASSERT_EQUAL(statistics.segmentsUnindexed, 0);
+
+    // Test SenseHAT_QueryClose
+    result = SenseHAT_QueryClose(&query);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT_PTR_NULL(query);
+    result = SenseHAT_QueryClose(&query);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Test a threshold query over the compressed segments
+    parameters.startTime = -INFINITY;
+    parameters.endTime = INFINITY;
+    parameters.minimumValue = 5500.0;
+    totalCount = 0;
+    result = SenseHAT_QueryOpen(directory, &parameters, &query);
+    CU_ASSERT_EQUAL_FATAL(result, 0);
+    while ((result = SenseHAT_QueryNext(query, records, 256, &recordCount)) == 0)
+    {
+        for (index = 0; index < (int32_t)recordCount; index++)
+        {
+            CU_ASSERT_DOUBLE_EQUAL(records[index].values[0], (double)(5500 + totalCount), 0.0);
+            totalCount++;
+        }
+    }
+    CU_ASSERT_EQUAL(result, ENODATA);
+    CU_ASSERT_EQUAL(totalCount, 500);
+    result = SenseHAT_QueryGetStatistics(query, &statistics);
+    CU_ASSERT_EQUAL(result, 0);
+    CU_ASSERT(statistics.blocksSkipped > 0);
+    result = SenseHAT_QueryClose(&query);
+    CU_ASSERT_EQUAL(result, 0);
+
     return;
 }
 
@@ -587,8 +3359,30 @@ int main (int argc, const char * argv[])
         if (senseHATTestSuite != NULL)
         {
             CU_ADD_TEST(senseHATTestSuite, TestLEDFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestImageFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestSpriteFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestAnimationFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestCompositorFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestColorFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestGammaFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestPaletteFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestClipFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestStreamFunctions);
             CU_ADD_TEST(senseHATTestSuite, TestEnvironmentalFunctions);
             CU_ADD_TEST(senseHATTestSuite, TestEventFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestSamplerFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestRollupFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestFilterFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestSubscriptionFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestCacheFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestRecorderFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestCodecFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestQueryFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestGestureFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestMotionFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestCompassFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestSpectrumFunctions);
+            CU_ADD_TEST(senseHATTestSuite, TestReplayFunctions);
         }
         else    // CU_add_suite failed
         {